@@ -16,6 +16,7 @@
 #include <QSettings>
 #include <QTranslator>
 #include <QProcessEnvironment>
+#include <QScopedPointer>
 
 #include "QtMainWindow.h"
 
@@ -23,6 +24,7 @@
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
 #include "MarbleTest.h"
+#include "NavigationRecorder.h"
 #include "MarbleLocale.h"
 #include "GeoUriParser.h"
 
@@ -112,6 +114,7 @@ int main(int argc, char *argv[])
         qWarning() << "  --runtimeTrace.............. Show the time spent and other debug info of each layer";
         qWarning() << "  --tile-id................... Write the identifier of texture tiles on top of them";
         qWarning() << "  --timedemo ................. Measure the paint performance while moving the map and quit";
+        qWarning() << "  --record-navigation=<file> . Record all changes of the view to the given file, see tools/navigation-replay";
         qWarning();
         qWarning() << "profile options (note that marble should automatically detect which profile to use. Override that with the options below):";
         qWarning() << "  --highresolution ........... Enforce the profile for devices with high resolution (e.g. desktop computers)";
@@ -223,6 +226,8 @@ int main(int argc, char *argv[])
 //    window->marbleWidget()->rotateTo( 0, 0, -90 );
 //    window->show();
 
+    QScopedPointer<NavigationRecorder> navigationRecorder;
+
     for ( int i = 1; i < args.count(); ++i ) {
         const QString arg = args.at(i);
         if ( arg == "--timedemo" )
@@ -242,9 +247,22 @@ int main(int argc, char *argv[])
         else if( arg == "--runtimeTrace" ) {
             window->marbleControl()->marbleWidget()->setShowRuntimeTrace( true );
         }
+        else if ( arg.startsWith( QLatin1String( "--record-navigation=" ), Qt::CaseInsensitive ) ) {
+            // saved while recording as well, in case Marble does not exit normally
+            navigationRecorder.reset( new NavigationRecorder( window->marbleControl()->marbleWidget() ) );
+            navigationRecorder->setFileName( arg.section( '=', 1 ) );
+            navigationRecorder->start();
+        }
         else if ( i != dataPathIndex && QFile::exists( arg ) )
             window->addGeoDataFile( arg );
     }
 
-    return app.exec();
+    int const result = app.exec();
+    if ( navigationRecorder ) {
+        navigationRecorder->stop();
+        if ( !navigationRecorder->save() ) {
+            qWarning() << "Could not save the navigation trace to" << navigationRecorder->fileName();
+        }
+    }
+    return result;
 }
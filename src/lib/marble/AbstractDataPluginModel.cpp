@@ -19,6 +19,10 @@
 #include <QVariant>
 #include <QAbstractListModel>
 #include <QMetaProperty>
+#include <QMultiMap>
+#include <QPair>
+#include <QSet>
+#include <qmath.h>
 
 // Marble
 #include "MarbleDebug.h"
@@ -50,6 +54,19 @@ const qreal boxComparisonFactor = 16.0;
 // Separator to separate the id of the item from the file type
 const char fileIdSeparator = '_';
 
+// Size of the cells of the spatial item index in degrees
+const int indexCellSize = 1;
+const int indexColumns = 360 / indexCellSize;
+const int indexRows = 180 / indexCellSize;
+
+// Size of the cells used to detect colliding items on the screen in pixels
+const int collisionCellSize = 64;
+
+// Items that were not in view for the longest time get removed when there
+// are more than maximumItemCount items, until minimumItemCount are left.
+const int maximumItemCount = 1000;
+const int minimumItemCount = 750;
+
 class FavoritesModel;
 
 class AbstractDataPluginModelPrivate
@@ -66,6 +83,19 @@ public:
 
     void updateFavoriteItems();
 
+    static int cellIndex( const GeoDataCoordinates &coordinates );
+    void addToIndex( AbstractDataPluginItem *item );
+    void removeFromIndex( AbstractDataPluginItem *item );
+    QList<AbstractDataPluginItem*> itemsInBox( const GeoDataLatLonAltBox &box );
+    void evictItems();
+
+    struct ItemEntry
+    {
+        QString id;
+        int cell;
+        quint32 lastUsed;
+    };
+
     AbstractDataPluginModel *m_parent;
     const QString m_name;
     const MarbleModel *const m_marbleModel;
@@ -77,6 +107,10 @@ public:
     QList<AbstractDataPluginItem*> m_itemSet;
     QHash<QString, AbstractDataPluginItem*> m_downloadingItems;
     QList<AbstractDataPluginItem*> m_displayedItems;
+    QHash<AbstractDataPluginItem*, ItemEntry> m_itemEntries;
+    QHash<QString, AbstractDataPluginItem*> m_itemsById;
+    QHash<int, QList<AbstractDataPluginItem*> > m_cells;
+    quint32 m_frame;
     QTimer m_downloadTimer;
     quint32 m_descriptionFileNumber;
     QHash<QString, QVariant> m_itemSettings;
@@ -121,6 +155,7 @@ AbstractDataPluginModelPrivate::AbstractDataPluginModelPrivate( const QString& n
       m_lastNumber( 0 ),
       m_downloadedNumber( 0 ),
       m_currentPlanetId( marbleModel->planetId() ),
+      m_frame( 0 ),
       m_downloadTimer( m_parent ),
       m_descriptionFileNumber( 0 ),
       m_itemSettings(),
@@ -160,6 +195,142 @@ void AbstractDataPluginModelPrivate::updateFavoriteItems()
     }
 }
 
+int AbstractDataPluginModelPrivate::cellIndex( const GeoDataCoordinates &coordinates )
+{
+    qreal const lon = coordinates.longitude( GeoDataCoordinates::Degree );
+    qreal const lat = coordinates.latitude( GeoDataCoordinates::Degree );
+    int const column = qBound( 0, qFloor( ( lon + 180.0 ) / indexCellSize ), indexColumns - 1 );
+    int const row = qBound( 0, qFloor( ( lat + 90.0 ) / indexCellSize ), indexRows - 1 );
+    return row * indexColumns + column;
+}
+
+void AbstractDataPluginModelPrivate::addToIndex( AbstractDataPluginItem *item )
+{
+    ItemEntry entry;
+    entry.id = item->id();
+    entry.cell = cellIndex( item->coordinate() );
+    entry.lastUsed = m_frame;
+    m_itemEntries.insert( item, entry );
+    m_itemsById.insert( entry.id, item );
+    m_cells[entry.cell].append( item );
+}
+
+void AbstractDataPluginModelPrivate::removeFromIndex( AbstractDataPluginItem *item )
+{
+    // Called for destroyed items as well, so the item must not be dereferenced
+    QHash<AbstractDataPluginItem*, ItemEntry>::iterator const entry = m_itemEntries.find( item );
+    if ( entry == m_itemEntries.end() ) {
+        return;
+    }
+
+    if ( m_itemsById.value( entry->id ) == item ) {
+        m_itemsById.remove( entry->id );
+    }
+
+    QHash<int, QList<AbstractDataPluginItem*> >::iterator const cell = m_cells.find( entry->cell );
+    if ( cell != m_cells.end() ) {
+        cell->removeOne( item );
+        if ( cell->isEmpty() ) {
+            m_cells.erase( cell );
+        }
+    }
+
+    m_itemEntries.erase( entry );
+}
+
+QList<AbstractDataPluginItem*> AbstractDataPluginModelPrivate::itemsInBox( const GeoDataLatLonAltBox &box )
+{
+    // The range is extended by one cell in each direction to catch items
+    // whose icons reach into the view although their position does not.
+    int firstColumn = qFloor( ( box.west( GeoDataCoordinates::Degree ) + 180.0 ) / indexCellSize ) - 1;
+    int lastColumn = qFloor( ( box.east( GeoDataCoordinates::Degree ) + 180.0 ) / indexCellSize ) + 1;
+    if ( box.crossesDateLine() ) {
+        lastColumn += indexColumns;
+    }
+    if ( lastColumn - firstColumn + 1 >= indexColumns ) {
+        firstColumn = 0;
+        lastColumn = indexColumns - 1;
+    }
+    int const firstRow = qMax( 0, qFloor( ( box.south( GeoDataCoordinates::Degree ) + 90.0 ) / indexCellSize ) - 1 );
+    int const lastRow = qMin( indexRows - 1, qFloor( ( box.north( GeoDataCoordinates::Degree ) + 90.0 ) / indexCellSize ) + 1 );
+
+    QList<AbstractDataPluginItem*> result;
+    int const columnCount = lastColumn - firstColumn + 1;
+    if ( columnCount * ( lastRow - firstRow + 1 ) > m_cells.size() ) {
+        // Fewer cells hold items than the box covers, so test those instead
+        QHash<int, QList<AbstractDataPluginItem*> >::const_iterator cell = m_cells.constBegin();
+        QHash<int, QList<AbstractDataPluginItem*> >::const_iterator const end = m_cells.constEnd();
+        for (; cell != end; ++cell ) {
+            int const row = cell.key() / indexColumns;
+            int const column = cell.key() % indexColumns;
+            int const columnOffset = ( column - firstColumn + indexColumns ) % indexColumns;
+            if ( row >= firstRow && row <= lastRow && columnOffset < columnCount ) {
+                result += cell.value();
+            }
+        }
+    } else {
+        for ( int row = firstRow; row <= lastRow; ++row ) {
+            for ( int column = firstColumn; column <= lastColumn; ++column ) {
+                int const key = row * indexColumns + ( column + indexColumns ) % indexColumns;
+                QHash<int, QList<AbstractDataPluginItem*> >::const_iterator const cell = m_cells.constFind( key );
+                if ( cell != m_cells.constEnd() ) {
+                    result += cell.value();
+                }
+            }
+        }
+    }
+
+    foreach ( AbstractDataPluginItem *item, result ) {
+        m_itemEntries[item].lastUsed = m_frame;
+    }
+
+    return result;
+}
+
+void AbstractDataPluginModelPrivate::evictItems()
+{
+    if ( m_itemSet.size() <= maximumItemCount ) {
+        return;
+    }
+
+    // Favorite and sticky items are kept, as well as everything in view
+    QMultiMap<quint32, AbstractDataPluginItem*> evictable;
+    foreach ( AbstractDataPluginItem *item, m_itemSet ) {
+        quint32 const lastUsed = m_itemEntries.value( item ).lastUsed;
+        if ( lastUsed != m_frame && !item->isFavorite() && !item->isSticky() ) {
+            evictable.insert( lastUsed, item );
+        }
+    }
+
+    QSet<AbstractDataPluginItem*> evicted;
+    QMultiMap<quint32, AbstractDataPluginItem*>::const_iterator i = evictable.constBegin();
+    for (; i != evictable.constEnd() && m_itemSet.size() - evicted.size() > minimumItemCount; ++i ) {
+        evicted.insert( i.value() );
+        removeFromIndex( i.value() );
+        i.value()->deleteLater();
+    }
+
+    QList<AbstractDataPluginItem*> remaining;
+    remaining.reserve( m_itemSet.size() - evicted.size() );
+    foreach ( AbstractDataPluginItem *item, m_itemSet ) {
+        if ( !evicted.contains( item ) ) {
+            remaining.append( item );
+        }
+    }
+    m_itemSet = remaining;
+
+    QHash<QString, AbstractDataPluginItem*>::iterator download = m_downloadingItems.begin();
+    while ( download != m_downloadingItems.end() ) {
+        if ( evicted.contains( download.value() ) ) {
+            download = m_downloadingItems.erase( download );
+        } else {
+            ++download;
+        }
+    }
+
+    mDebug() << "Removed" << evicted.size() << "items of" << m_name << "that were not shown for a while";
+}
+
 void AbstractDataPluginModel::themeChanged()
 {
     if ( d->m_currentPlanetId != d->m_marbleModel->planetId() ) {
@@ -287,7 +458,12 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
     Q_ASSERT( !d->m_displayedItems.contains( 0 ) && "Null item in m_displayedItems. Please report a bug to marble-devel@kde.org" );
     Q_ASSERT( !d->m_itemSet.contains( 0 ) && "Null item in m_itemSet. Please report a bug to marble-devel@kde.org" );
 
-    QList<AbstractDataPluginItem*> candidates = d->m_displayedItems + d->m_itemSet;
+    ++d->m_frame;
+
+    // Only items in the current view are candidates, in the same order as m_itemSet
+    QList<AbstractDataPluginItem*> visibleItems = d->itemsInBox( currentBox );
+    qSort( visibleItems.begin(), visibleItems.end(), lessThanByPointer );
+    QList<AbstractDataPluginItem*> candidates = d->m_displayedItems + visibleItems;
 
     if ( d->m_needsSorting ) {
         // Both the candidates list and the list of all items need to be sorted
@@ -296,6 +472,11 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
         d->m_needsSorting =  false;
     }
 
+    QSet<AbstractDataPluginItem*> const displayedItems = d->m_displayedItems.toSet();
+    QSet<AbstractDataPluginItem*> listedItems;
+    // Bounding rects of the listed items, by the collision grid cells they touch
+    QHash<QPair<int, int>, QVector<QRectF> > listedRects;
+
     QList<AbstractDataPluginItem*>::const_iterator i = candidates.constBegin();
     QList<AbstractDataPluginItem*>::const_iterator end = candidates.constEnd();
 
@@ -316,19 +497,32 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
             continue;
         }
 
-        if ( list.contains( *i ) ) {
+        if ( listedItems.contains( *i ) ) {
             continue;
         }
 
         // If the item was added initially at a nearer position, they don't have priority,
         // because we zoomed out since then.
-        bool const alreadyDisplayed = d->m_displayedItems.contains( *i );
+        bool const alreadyDisplayed = displayedItems.contains( *i );
         if ( !alreadyDisplayed || (*i)->addedAngularResolution() >= viewport->angularResolution() || (*i)->isSticky() ) {
+            QList<QRectF> const itemRects = (*i)->boundingRects();
+            QVector<QPair<int, int> > cells;
+            foreach( const QRectF &itemRect, itemRects ) {
+                int const left = qFloor( itemRect.left() / collisionCellSize );
+                int const right = qFloor( itemRect.right() / collisionCellSize );
+                int const top = qFloor( itemRect.top() / collisionCellSize );
+                int const bottom = qFloor( itemRect.bottom() / collisionCellSize );
+                for ( int x = left; x <= right; ++x ) {
+                    for ( int y = top; y <= bottom; ++y ) {
+                        cells.append( qMakePair( x, y ) );
+                    }
+                }
+            }
+
             bool collides = false;
-            int const length = list.length();
-            for ( int j=0; !collides && j<length; ++j ) {
-                foreach( const QRectF &rect, list[j]->boundingRects() ) {
-                    foreach( const QRectF &itemRect, (*i)->boundingRects() ) {
+            for ( int j=0; !collides && j<cells.size(); ++j ) {
+                foreach( const QRectF &rect, listedRects.value( cells[j] ) ) {
+                    foreach( const QRectF &itemRect, itemRects ) {
                         if ( rect.intersects( itemRect ) )
                             collides = true;
                     }
@@ -337,6 +531,11 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
 
             if ( !collides ) {
                 list.append( *i );
+                listedItems.insert( *i );
+                d->m_itemEntries[*i].lastUsed = d->m_frame;
+                for ( int j=0; j<cells.size(); ++j ) {
+                    listedRects[cells[j]] += itemRects.toVector();
+                }
                 (*i)->setSettings( d->m_itemSettings );
 
                 // We want to save the angular resolution of the first time the item got added.
@@ -345,12 +544,12 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
                 }
             }
         }
-        // TODO: Do we have to cleanup at some point? The list of all items keeps growing
     }
 
     d->m_lastBox = currentBox;
     d->m_lastNumber = number;
     d->m_displayedItems = list;
+    d->evictItems();
     return list;
 }
 
@@ -420,7 +619,7 @@ void AbstractDataPluginModel::addItemsToList( const QList<AbstractDataPluginItem
         }
 
         // If the item is already in our list, don't add it.
-        if ( d->m_itemSet.contains( item ) ) {
+        if ( d->m_itemEntries.contains( item ) ) {
             continue;
         }
 
@@ -438,9 +637,12 @@ void AbstractDataPluginModel::addItemsToList( const QList<AbstractDataPluginItem
                                                                   lessThanByPointer );
         // Insert the item on the right position in the list
         d->m_itemSet.insert( i, item );
+        d->addToIndex( item );
 
         connect( item, SIGNAL(stickyChanged()), this, SLOT(scheduleItemSort()) );
         connect( item, SIGNAL(destroyed(QObject*)), this, SLOT(removeItem(QObject*)) );
+        connect( item, SIGNAL(updated()), this, SLOT(updateItemIndex()) );
+        connect( item, SIGNAL(idChanged()), this, SLOT(updateItemIndex()) );
         connect( item, SIGNAL(updated()), this, SIGNAL(itemsUpdated()) );
         connect( item, SIGNAL(favoriteChanged(QString,bool)), this,
                  SLOT(favoriteItemChanged(QString,bool)) );
@@ -546,18 +748,12 @@ QString AbstractDataPluginModelPrivate::generateFilepath( const QString& id, con
 
 AbstractDataPluginItem *AbstractDataPluginModel::findItem( const QString& id ) const
 {
-    foreach ( AbstractDataPluginItem *item, d->m_itemSet ) {
-        if( item->id() == id ) {
-            return item;
-        }
-    }
-    
-    return 0;
+    return d->m_itemsById.value( id, 0 );
 }
 
 bool AbstractDataPluginModel::itemExists( const QString& id ) const
 {
-    return findItem( id );
+    return d->m_itemsById.contains( id );
 }
 
 void AbstractDataPluginModel::setItemSettings( QHash<QString,QVariant> itemSettings )
@@ -643,13 +839,47 @@ void AbstractDataPluginModel::processFinishedJob( const QString& relativeUrlStri
 
 void AbstractDataPluginModel::removeItem( QObject *item )
 {
-    AbstractDataPluginItem * pluginItem = qobject_cast<AbstractDataPluginItem*>( item );
+    // The item is being destroyed already, so qobject_cast() does not work anymore
+    AbstractDataPluginItem * pluginItem = static_cast<AbstractDataPluginItem*>( item );
+    d->removeFromIndex( pluginItem );
     d->m_itemSet.removeAll( pluginItem );
-    QHash<QString, AbstractDataPluginItem *>::iterator i;
-    for( i = d->m_downloadingItems.begin(); i != d->m_downloadingItems.end(); ++i ) {
+    d->m_displayedItems.removeAll( pluginItem );
+    QHash<QString, AbstractDataPluginItem *>::iterator i = d->m_downloadingItems.begin();
+    while ( i != d->m_downloadingItems.end() ) {
         if( *i == pluginItem ) {
             i = d->m_downloadingItems.erase( i );
+        } else {
+            ++i;
+        }
+    }
+}
+
+void AbstractDataPluginModel::updateItemIndex()
+{
+    AbstractDataPluginItem *item = qobject_cast<AbstractDataPluginItem*>( sender() );
+    QHash<AbstractDataPluginItem*, AbstractDataPluginModelPrivate::ItemEntry>::iterator const entry = d->m_itemEntries.find( item );
+    if ( entry == d->m_itemEntries.end() ) {
+        return;
+    }
+
+    if ( entry->id != item->id() ) {
+        if ( d->m_itemsById.value( entry->id ) == item ) {
+            d->m_itemsById.remove( entry->id );
+        }
+        entry->id = item->id();
+        d->m_itemsById.insert( entry->id, item );
+    }
+
+    // Some items only know their position once their data is downloaded
+    int const cell = AbstractDataPluginModelPrivate::cellIndex( item->coordinate() );
+    if ( entry->cell != cell ) {
+        QList<AbstractDataPluginItem*> &oldCell = d->m_cells[entry->cell];
+        oldCell.removeOne( item );
+        if ( oldCell.isEmpty() ) {
+            d->m_cells.remove( entry->cell );
         }
+        entry->cell = cell;
+        d->m_cells[cell].append( item );
     }
 }
 
@@ -662,6 +892,9 @@ void AbstractDataPluginModel::clear()
         (*iter)->deleteLater();
     }
     d->m_itemSet.clear();
+    d->m_itemEntries.clear();
+    d->m_itemsById.clear();
+    d->m_cells.clear();
     d->m_lastBox = GeoDataLatLonAltBox();
     d->m_downloadedBox = GeoDataLatLonAltBox();
     d->m_downloadedNumber = 0;
@@ -178,6 +178,11 @@ public Q_SLOTS:
      */
     void removeItem( QObject *item );
 
+    /**
+     * @brief Updates the id and position of the sending item in the item index.
+     */
+    void updateItemIndex();
+
     void favoriteItemChanged( const QString& id, bool isFavorite );
 
     void scheduleItemSort();
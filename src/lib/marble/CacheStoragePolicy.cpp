@@ -40,6 +40,7 @@ bool CacheStoragePolicy::updateFile( const QString &fileName, const QByteArray &
         return false;
     }
 
+    emit fileUpdated( fileName, data.size() );
     return true;
 }
 
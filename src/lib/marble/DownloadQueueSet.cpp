@@ -75,7 +75,7 @@ bool DownloadQueueSet::canAcceptJob( const QUrl& sourceUrl,
 
 void DownloadQueueSet::addJob( HttpJob * const job )
 {
-    m_jobs.push( job );
+    m_jobs.insert( job );
     mDebug() << "addJob: new job queue size:" << m_jobs.count();
     emit jobAdded();
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
@@ -87,7 +87,7 @@ void DownloadQueueSet::activateJobs()
     while ( !m_jobs.isEmpty()
             && m_activeJobs.count() < m_downloadPolicy.maximumConnections() )
     {
-        HttpJob * const job = m_jobs.pop();
+        HttpJob * const job = m_jobs.take();
         activateJob( job );
     }
 }
@@ -96,6 +96,7 @@ void DownloadQueueSet::retryJobs()
 {
     while ( !m_retryQueue.isEmpty() ) {
         HttpJob * const job = m_retryQueue.dequeue();
+        m_retryQueueContent.remove( job->destinationFileName() );
         mDebug() << "Requeuing" << job->destinationFileName();
         // FIXME: addJob calls activateJobs every time
         addJob( job );
@@ -106,22 +107,84 @@ void DownloadQueueSet::purgeJobs()
 {
     // purge all waiting jobs
     while( !m_jobs.isEmpty() ) {
-        HttpJob * const job = m_jobs.pop();
+        HttpJob * const job = m_jobs.take();
         job->deleteLater();
     }
 
     // purge all retry jobs
     qDeleteAll( m_retryQueue );
     m_retryQueue.clear();
+    m_retryQueueContent.clear();
 
     // cancel all current jobs
     while( !m_activeJobs.isEmpty() ) {
-        deactivateJob( m_activeJobs.first() );
+        cancelJob( m_activeJobs.begin().value() );
     }
 
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
 }
 
+void DownloadQueueSet::setJobPriorities( const QString& initiatorPrefix,
+                                         const QHash<QString, int>& priorities )
+{
+    int removedJobs = 0;
+
+    foreach ( HttpJob * const job, m_jobs.jobs() ) {
+        if ( !job->initiatorId().startsWith( initiatorPrefix ) ) {
+            continue;
+        }
+        QHash<QString, int>::const_iterator const pos = priorities.constFind( job->initiatorId() );
+        if ( pos == priorities.constEnd() ) {
+            m_jobs.remove( job );
+            emit jobCanceled( job->initiatorId() );
+            job->deleteLater();
+            ++removedJobs;
+        } else {
+            m_jobs.setPriority( job, pos.value() );
+        }
+    }
+
+    foreach ( HttpJob * const job, m_activeJobs ) {
+        if ( job->initiatorId().startsWith( initiatorPrefix ) ) {
+            QHash<QString, int>::const_iterator const pos = priorities.constFind( job->initiatorId() );
+            if ( pos == priorities.constEnd() ) {
+                emit jobCanceled( job->initiatorId() );
+                cancelJob( job );
+                ++removedJobs;
+            } else {
+                job->setPriority( pos.value() );
+            }
+        }
+    }
+
+    // jobs waiting for retry already emitted jobRemoved()
+    QQueue<HttpJob*>::iterator pos = m_retryQueue.begin();
+    while ( pos != m_retryQueue.end() ) {
+        HttpJob * const job = *pos;
+        if ( job->initiatorId().startsWith( initiatorPrefix ) ) {
+            QHash<QString, int>::const_iterator const priority = priorities.constFind( job->initiatorId() );
+            if ( priority == priorities.constEnd() ) {
+                m_retryQueueContent.remove( job->destinationFileName() );
+                pos = m_retryQueue.erase( pos );
+                emit jobCanceled( job->initiatorId() );
+                job->deleteLater();
+                continue;
+            }
+            job->setPriority( priority.value() );
+        }
+        ++pos;
+    }
+
+    if ( removedJobs > 0 ) {
+        mDebug() << "Canceled" << removedJobs << "downloads which are not needed anymore";
+        for ( int i = 0; i < removedJobs; ++i ) {
+            emit jobRemoved();
+        }
+        emit progressChanged( m_activeJobs.size(), m_jobs.count() );
+        activateJobs();
+    }
+}
+
 void DownloadQueueSet::finishJob( HttpJob * job, const QByteArray& data )
 {
     mDebug() << "finishJob: " << job->sourceUrl() << job->destinationFileName();
@@ -147,7 +210,7 @@ void DownloadQueueSet::redirectJob( HttpJob * job, const QUrl& newSourceUrl )
 void DownloadQueueSet::retryOrBlacklistJob( HttpJob * job, const int errorCode )
 {
     Q_ASSERT( errorCode != 0 );
-    Q_ASSERT( !m_retryQueue.contains( job ));
+    Q_ASSERT( !m_retryQueueContent.contains( job->destinationFileName() ));
 
     deactivateJob( job );
     emit jobRemoved();
@@ -156,6 +219,7 @@ void DownloadQueueSet::retryOrBlacklistJob( HttpJob * job, const int errorCode )
         mDebug() << QString( "Download of %1 to %2 failed, but trying again soon" )
             .arg( job->sourceUrl().toString() ).arg( job->destinationFileName() );
         m_retryQueue.enqueue( job );
+        m_retryQueueContent.insert( job->destinationFileName() );
         emit jobRetry();
     }
     else {
@@ -175,7 +239,7 @@ void DownloadQueueSet::retryOrBlacklistJob( HttpJob * job, const int errorCode )
 
 void DownloadQueueSet::activateJob( HttpJob * const job )
 {
-    m_activeJobs.push_back( job );
+    m_activeJobs.insert( job->destinationFileName(), job );
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
 
     connect( job, SIGNAL(jobDone(HttpJob*,int)),
@@ -200,22 +264,27 @@ void DownloadQueueSet::deactivateJob( HttpJob * const job )
     const bool disconnected = job->disconnect();
     Q_ASSERT( disconnected );
     Q_UNUSED( disconnected ); // for Q_ASSERT in release mode
-    const bool removed = m_activeJobs.removeOne( job );
+    const bool removed = m_activeJobs.remove( job->destinationFileName() ) == 1;
     Q_ASSERT( removed );
     Q_UNUSED( removed ); // for Q_ASSERT in release mode
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
 }
 
+/**
+   pre condition: - job is in m_activeJobs
+   post condition: - job is deactivated, its download is aborted and it
+                     will be deleted
+ */
+void DownloadQueueSet::cancelJob( HttpJob * const job )
+{
+    deactivateJob( job );
+    job->abort();
+    job->deleteLater();
+}
+
 bool DownloadQueueSet::jobIsActive( QString const & destinationFileName ) const
 {
-    QList<HttpJob*>::const_iterator pos = m_activeJobs.constBegin();
-    QList<HttpJob*>::const_iterator const end = m_activeJobs.constEnd();
-    for (; pos != end; ++pos) {
-        if ( (*pos)->destinationFileName() == destinationFileName ) {
-            return true;
-        }
-    }
-    return false;
+    return m_activeJobs.contains( destinationFileName );
 }
 
 inline bool DownloadQueueSet::jobIsQueued( QString const & destinationFileName ) const
@@ -225,14 +294,7 @@ inline bool DownloadQueueSet::jobIsQueued( QString const & destinationFileName )
 
 bool DownloadQueueSet::jobIsWaitingForRetry( QString const & destinationFileName ) const
 {
-    QList<HttpJob*>::const_iterator pos = m_retryQueue.constBegin();
-    QList<HttpJob*>::const_iterator const end = m_retryQueue.constEnd();
-    for (; pos != end; ++pos) {
-        if ( (*pos)->destinationFileName() == destinationFileName ) {
-            return true;
-        }
-    }
-    return false;
+    return m_retryQueueContent.contains( destinationFileName );
 }
 
 bool DownloadQueueSet::jobIsBlackListed( const QUrl& sourceUrl ) const
@@ -243,36 +305,71 @@ bool DownloadQueueSet::jobIsBlackListed( const QUrl& sourceUrl ) const
 }
 
 
-inline bool DownloadQueueSet::JobStack::contains( const QString& destinationFileName ) const
+DownloadQueueSet::JobQueue::JobQueue()
+    : m_sequence( 0 )
 {
-    return m_jobsContent.contains( destinationFileName );
 }
 
-inline int DownloadQueueSet::JobStack::count() const
+inline bool DownloadQueueSet::JobQueue::contains( const QString& destinationFileName ) const
+{
+    return m_keys.contains( destinationFileName );
+}
+
+inline int DownloadQueueSet::JobQueue::count() const
 {
     return m_jobs.count();
 }
 
-inline bool DownloadQueueSet::JobStack::isEmpty() const
+inline bool DownloadQueueSet::JobQueue::isEmpty() const
 {
     return m_jobs.isEmpty();
 }
 
-inline HttpJob * DownloadQueueSet::JobStack::pop()
+inline QList<HttpJob*> DownloadQueueSet::JobQueue::jobs() const
 {
-    HttpJob * const job = m_jobs.pop();
-    bool const removed = m_jobsContent.remove( job->destinationFileName() );
+    return m_jobs.values();
+}
+
+inline HttpJob * DownloadQueueSet::JobQueue::take()
+{
+    QMap<Key, HttpJob*>::iterator last = m_jobs.end();
+    --last;
+    HttpJob * const job = last.value();
+    m_jobs.erase( last );
+    bool const removed = m_keys.remove( job->destinationFileName() );
     Q_UNUSED( removed ); // for Q_ASSERT in release mode
     Q_ASSERT( removed );
     return job;
 }
 
-inline void DownloadQueueSet::JobStack::push( HttpJob * const job )
+inline void DownloadQueueSet::JobQueue::insert( HttpJob * const job )
 {
-    m_jobs.push( job );
-    m_jobsContent.insert( job->destinationFileName() );
+    Key const key( job->priority(), m_sequence++ );
+    m_jobs.insert( key, job );
+    m_keys.insert( job->destinationFileName(), key );
+}
+
+inline void DownloadQueueSet::JobQueue::remove( HttpJob * const job )
+{
+    Key const key = m_keys.take( job->destinationFileName() );
+    bool const removed = m_jobs.remove( key ) == 1;
+    Q_UNUSED( removed ); // for Q_ASSERT in release mode
+    Q_ASSERT( removed );
 }
 
+inline void DownloadQueueSet::JobQueue::setPriority( HttpJob * const job, int priority )
+{
+    if ( job->priority() == priority ) {
+        return;
+    }
+
+    QHash<QString, Key>::iterator const pos = m_keys.find( job->destinationFileName() );
+    Q_ASSERT( pos != m_keys.end() );
+    m_jobs.remove( pos.value() );
+    job->setPriority( priority );
+    pos.value().first = priority;
+    m_jobs.insert( pos.value(), job );
+}
 
 }
 
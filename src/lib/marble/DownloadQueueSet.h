@@ -16,11 +16,13 @@
 #ifndef MARBLE_DOWNLOADQUEUESET_H
 #define MARBLE_DOWNLOADQUEUESET_H
 
+#include <QHash>
 #include <QList>
+#include <QMap>
+#include <QPair>
 #include <QQueue>
 #include <QObject>
 #include <QSet>
-#include <QStack>
 #include <QUrl>
 
 #include "DownloadPolicy.h"
@@ -37,7 +39,9 @@ class HttpJob;
      the HttpJob is put into the m_jobQueue where it waits for "activation"
      signal jobAdded is emitted
    - Job is activated
-     Job is moved from m_jobQueue to m_activeJobs and signals of the job
+     The job with the highest priority (the most recently added one if
+     several jobs have the same priority) is moved from m_jobQueue to
+     m_activeJobs and signals of the job
      are connected to slots (local or HttpDownloadManager)
      Job is executed by calling the jobs execute() method
 
@@ -57,6 +61,10 @@ class HttpJob;
       Job is removed from m_activeJobs, disconnected and destroyed
       signal jobRemoved is emitted
 
+   4) Job is canceled by setJobPriorities() because it is not needed anymore
+      Job is aborted, disconnected and destroyed
+      signal jobRemoved is emitted
+
    so we can conclude following rules:
    - Job is only connected to signals when in "active" state
 
@@ -89,10 +97,19 @@ class DownloadQueueSet: public QObject
     void retryJobs();
     void purgeJobs();
 
+    /**
+     * Reorders the jobs whose initiator id starts with @p initiatorPrefix
+     * according to @p priorities, which maps initiator ids to priorities.
+     * Jobs with a matching prefix which are missing in @p priorities are
+     * canceled, even if they are being downloaded already.
+     */
+    void setJobPriorities( const QString& initiatorPrefix, const QHash<QString, int>& priorities );
+
  Q_SIGNALS:
     void jobAdded();
     void jobRemoved();
     void jobRetry();
+    void jobCanceled( const QString& id );
     void jobFinished( const QByteArray& data, const QString& destinationFileName,
                       const QString& id );
     void jobRedirected( const QUrl& newSourceUrl, const QString& destinationFileName,
@@ -107,6 +124,7 @@ class DownloadQueueSet: public QObject
  private:
     void activateJob( HttpJob * const job );
     void deactivateJob( HttpJob * const job );
+    void cancelJob( HttpJob * const job );
     bool jobIsActive( const QString& destinationFileName ) const;
     bool jobIsQueued( const QString& destinationFileName ) const;
     bool jobIsWaitingForRetry( const QString& destinationFileName ) const;
@@ -117,27 +135,35 @@ class DownloadQueueSet: public QObject
     /** This is the first stage a job enters, from this queue it will get
      *  into the activatedJobs container.
      */
-    class JobStack
+    class JobQueue
     {
     public:
+        JobQueue();
         bool contains( const QString& destinationFileName ) const;
         int count() const;
         bool isEmpty() const;
-        HttpJob * pop();
-        void push( HttpJob * const );
+        QList<HttpJob*> jobs() const;
+        HttpJob * take();
+        void insert( HttpJob * const );
+        void remove( HttpJob * const );
+        void setPriority( HttpJob * const, int priority );
     private:
-        QStack<HttpJob*> m_jobs;
-        QSet<QString> m_jobsContent;
+        /// priority and insertion sequence number, the last key is taken first
+        typedef QPair<int, quint64> Key;
+        QMap<Key, HttpJob*> m_jobs;
+        QHash<QString, Key> m_keys;
+        quint64 m_sequence;
     };
-    JobStack m_jobs;
+    JobQueue m_jobs;
 
-    /// Contains the jobs which are currently being downloaded.
-    QList<HttpJob*> m_activeJobs;
+    /// Contains the jobs which are currently being downloaded, by destination file name.
+    QHash<QString, HttpJob*> m_activeJobs;
 
     /** Contains jobs which failed to download and which are scheduled for
      *  retry according to retry settings.
      */
     QQueue<HttpJob*> m_retryQueue;
+    QSet<QString> m_retryQueueContent;
 
     /// Contains the blacklisted source urls
     QSet<QString> m_jobBlackList;
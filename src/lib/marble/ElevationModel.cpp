@@ -23,12 +23,23 @@
 #include "TileId.h"
 #include "PluginManager.h"
 
+#include <QCache>
+#include <QFutureWatcher>
 #include <QLabel>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrentRun>
 #include <qmath.h>
 
 namespace Marble
 {
 
+namespace {
+    // invalidElevationData as stored in a decoded tile
+    qint16 const noData = -32768;
+}
+
 class ElevationModelPrivate
 {
 public:
@@ -36,9 +47,12 @@ public:
         : q( _q ),
           m_tileLoader( downloadManager, pluginManager ),
           m_textureLayer( 0 ),
-          m_srtmTheme(0)
+          m_srtmTheme( 0 ),
+          m_tileLevel( -1 ),
+          m_numTilesX( 0 ),
+          m_numTilesY( 0 )
     {
-        m_cache.setMaxCost( 10 ); //keep 10 tiles in memory (~17MB)
+        m_cache.setMaxCost( 20 ); //keep 20 decoded tiles in memory (~17MB)
 
         m_srtmTheme = MapThemeManager::loadMapTheme( "earth/srtm2/srtm2.dgml" );
         if ( !m_srtmTheme ) {
@@ -61,127 +75,320 @@ public:
 
     ~ElevationModelPrivate()
     {
-       delete m_srtmTheme;
-    }
+        // loads in progress use the tile loader
+        foreach ( const PendingTile &pending, m_pendingTiles ) {
+            pending.watcher->waitForFinished();
+        }
 
-    void tileCompleted( const TileId & tileId, const QImage &image )
-    {
-        m_cache.insert( tileId, new QImage( image ) );
-        emit q->updateAvailable();
+        delete m_srtmTheme;
     }
 
+    bool initRaster();
+
+    QVector<qint16> tile( const TileId &id );
+
+    qint16 sample( int x, int y );
+
+    void startLoading( const TileId &id );
+
+    void loadRequestedTiles();
+
+    void startDecoding( const TileId &id, const QFuture<QVector<qint16> > &future );
+
+    QVector<qint16> load( const TileId &id );
+
+    static QVector<qint16> decode( const QImage &image );
+
+    static qreal interpolate( const qint16 samples[4], qreal fx, qreal fy );
+
+    void tileCompleted( const TileId &tileId, const QImage &image );
+
+    void tilesDecoded();
+
 public:
+    struct PendingTile
+    {
+        TileId id;
+        QFutureWatcher<QVector<qint16> >* watcher;
+    };
+
     ElevationModel *q;
 
     TileLoader m_tileLoader;
     const GeoSceneTextureTileDataset *m_textureLayer;
-    QCache<TileId, const QImage> m_cache;
     GeoSceneDocument *m_srtmTheme;
+
+    int m_tileLevel;
+    QSize m_tileSize;
+    int m_numTilesX;
+    int m_numTilesY;
+
+    QCache<TileId, const QVector<qint16> > m_cache;
+    QList<PendingTile> m_pendingTiles;
+    QList<TileId> m_requestedTiles; // by other threads, to be loaded in the thread of the model
+    QMutex m_cacheMutex; // guards the raster, m_cache and m_requestedTiles
+    QMutex m_loaderMutex;
 };
 
-ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent ) :
-    QObject( parent ),
-    d( new ElevationModelPrivate( this, downloadManager, pluginManager ) )
+bool ElevationModelPrivate::initRaster()
 {
-    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
-             this, SLOT(tileCompleted(TileId,QImage)) );
+    if ( !m_textureLayer ) {
+        return false;
+    }
+
+    QMutexLocker locker( &m_cacheMutex );
+    if ( m_tileLevel < 0 ) {
+        m_tileLevel = TileLoader::maximumTileLevel( *m_textureLayer );
+        Q_ASSERT( m_tileLevel == 9 );
+
+        m_tileSize = m_textureLayer->tileSize();
+        m_numTilesX = TileLoaderHelper::levelToColumn( m_textureLayer->levelZeroColumns(), m_tileLevel );
+        m_numTilesY = TileLoaderHelper::levelToRow( m_textureLayer->levelZeroRows(), m_tileLevel );
+        Q_ASSERT( m_numTilesX > 0 );
+        Q_ASSERT( m_numTilesY > 0 );
+    }
+
+    return true;
 }
 
-ElevationModel::~ElevationModel()
+QVector<qint16> ElevationModelPrivate::tile( const TileId &id )
 {
-    delete d;
+    QMutexLocker locker( &m_cacheMutex );
+    const QVector<qint16> *result = m_cache.object( id );
+    if ( result ) {
+        // a shallow copy, it stays valid if the tile is evicted meanwhile
+        return *result;
+    }
+
+    if ( QThread::currentThread() != q->thread() ) {
+        // the watchers of the loads belong to the thread of the model
+        if ( m_requestedTiles.isEmpty() ) {
+            QMetaObject::invokeMethod( q, "loadRequestedTiles", Qt::QueuedConnection );
+        }
+        if ( !m_requestedTiles.contains( id ) ) {
+            m_requestedTiles << id;
+        }
+        return QVector<qint16>();
+    }
+
+    locker.unlock();
+    startLoading( id );
+    return QVector<qint16>();
 }
 
+qint16 ElevationModelPrivate::sample( int x, int y )
+{
+    const int width = m_tileSize.width();
+    const int height = m_tileSize.height();
+    x %= m_numTilesX * width;
+    y %= m_numTilesY * height;
 
-qreal ElevationModel::height( qreal lon, qreal lat ) const
+    const QVector<qint16> heights = tile( TileId( 0, m_tileLevel, x / width, y / height ) );
+    return heights.isEmpty() ? noData : heights.at( ( y % height ) * width + x % width );
+}
+
+void ElevationModelPrivate::startLoading( const TileId &id )
 {
-    if ( !d->m_textureLayer ) {
-        return invalidElevationData;
+    foreach ( const PendingTile &pending, m_pendingTiles ) {
+        if ( pending.id == id ) {
+            return;
+        }
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    Q_ASSERT( tileZoomLevel == 9 );
+    startDecoding( id, QtConcurrent::run( this, &ElevationModelPrivate::load, id ) );
+}
+
+void ElevationModelPrivate::loadRequestedTiles()
+{
+    QList<TileId> requested;
+    {
+        QMutexLocker locker( &m_cacheMutex );
+        foreach ( const TileId &id, m_requestedTiles ) {
+            if ( !m_cache.contains( id ) ) {
+                requested << id;
+            }
+        }
+        m_requestedTiles.clear();
+    }
+
+    foreach ( const TileId &id, requested ) {
+        startLoading( id );
+    }
+}
+
+void ElevationModelPrivate::startDecoding( const TileId &id, const QFuture<QVector<qint16> > &future )
+{
+    PendingTile pending;
+    pending.id = id;
+    pending.watcher = new QFutureWatcher<QVector<qint16> >( q );
+    QObject::connect( pending.watcher, SIGNAL(finished()), q, SLOT(tilesDecoded()) );
+    pending.watcher->setFuture( future );
+    m_pendingTiles << pending;
+}
 
-    const int width = d->m_textureLayer->tileSize().width();
-    const int height = d->m_textureLayer->tileSize().height();
+QVector<qint16> ElevationModelPrivate::load( const TileId &id )
+{
+    QImage image;
+    {
+        // the texture layer hands out its download urls round robin, so
+        // concurrent loads would race on it
+        QMutexLocker locker( &m_loaderMutex );
+        image = m_tileLoader.loadTileImage( m_textureLayer, id, DownloadBrowse );
+    }
 
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-    const int numTilesY = TileLoaderHelper::levelToRow( d->m_textureLayer->levelZeroRows(), tileZoomLevel );
-    Q_ASSERT( numTilesX > 0 );
-    Q_ASSERT( numTilesY > 0 );
+    return decode( image );
+}
 
-    qreal textureX = 180 + lon;
-    textureX *= numTilesX * width / 360;
+QVector<qint16> ElevationModelPrivate::decode( const QImage &image )
+{
+    QImage const rgb = image.format() == QImage::Format_RGB32 ? image : image.convertToFormat( QImage::Format_ARGB32 );
+
+    QVector<qint16> result( rgb.width() * rgb.height() );
+    qint16 *target = result.data();
+    for ( int y = 0; y < rgb.height(); ++y ) {
+        const QRgb *line = reinterpret_cast<const QRgb*>( rgb.constScanLine( y ) );
+        for ( int x = 0; x < rgb.width(); ++x ) {
+            // 16 valid bits of a signed value
+            *target++ = static_cast<qint16>( line[x] & 0xffff );
+        }
+    }
 
-    qreal textureY = 90 - lat;
-    textureY *= numTilesY * height / 180;
+    return result;
+}
 
-    qreal ret = 0;
-    bool hasHeight = false;
-    qreal noData = 0;
+qreal ElevationModelPrivate::interpolate( const qint16 samples[4], qreal fx, qreal fy )
+{
+    qreal const weights[4] = { ( 1 - fx ) * ( 1 - fy ), fx * ( 1 - fy ), ( 1 - fx ) * fy, fx * fy };
 
+    qreal result = 0;
+    qreal weight = 0;
     for ( int i = 0; i < 4; ++i ) {
-        const int x = static_cast<int>( textureX + ( i % 2 ) );
-        const int y = static_cast<int>( textureY + ( i / 2 ) );
+        if ( samples[i] != noData ) {
+            result += samples[i] * weights[i];
+            weight += weights[i];
+        }
+    }
 
-        //mDebug() << "x" << x << ( x / width );
-        //mDebug() << "y" << y << ( y / height );
+    // samples without data are compensated by the others
+    return weight > 0 ? result / weight : qreal( invalidElevationData );
+}
 
-        const TileId id( 0, tileZoomLevel, ( x % ( numTilesX * width ) ) / width, ( y % ( numTilesY * height ) ) / height );
-        //mDebug() << "LAT" << lat << "LON" << lon << "tile" << ( x % ( numTilesX * width ) ) / width << ( y % ( numTilesY * height ) ) / height;
+void ElevationModelPrivate::tileCompleted( const TileId &tileId, const QImage &image )
+{
+    // downloaded tiles carry the hash of the source directory, queries don't
+    TileId const id( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
+    startDecoding( id, QtConcurrent::run( &ElevationModelPrivate::decode, image ) );
+}
 
-        const QImage *image = d->m_cache[id];
-        if ( image == 0 ) {
-            image = new QImage( d->m_tileLoader.loadTileImage( d->m_textureLayer, id, DownloadBrowse ) );
-            d->m_cache.insert( id, image );
-        }
-        Q_ASSERT( image );
-        Q_ASSERT( !image->isNull() );
-        Q_ASSERT( width == image->width() );
-        Q_ASSERT( height == image->height() );
-
-        const qreal dx = ( textureX > ( qreal )x ) ? textureX - ( qreal )x : ( qreal )x - textureX;
-        const qreal dy = ( textureY > ( qreal )y ) ? textureY - ( qreal )y : ( qreal )y - textureY;
-
-        Q_ASSERT( 0 <= dx && dx <= 1 );
-        Q_ASSERT( 0 <= dy && dy <= 1 );
-        unsigned int pixel = image->pixel( x % width, y % height ) & 0xffff; // 16 valid bits
-        short int elevation = (short int) pixel; // and signed type, so just cast it
-        //mDebug() << "(1-dx)" << (1-dx) << "(1-dy)" << (1-dy);
-        if ( pixel != invalidElevationData ) { //no data?
-            //mDebug() << "got at x" << x % width << "y" << y % height << "a height of" << pixel << "** RGB" << qRed(pixel) << qGreen(pixel) << qBlue(pixel);
-            ret += ( qreal )elevation * ( 1 - dx ) * ( 1 - dy );
-            hasHeight = true;
-        } else {
-            //mDebug() << "no data at" <<  x % width << "y" << y % height;
-            noData += ( 1 - dx ) * ( 1 - dy );
+void ElevationModelPrivate::tilesDecoded()
+{
+    // in order of request, so that a download supersedes an earlier load
+    bool updated = false;
+    while ( !m_pendingTiles.isEmpty() && m_pendingTiles.first().watcher->isFinished() ) {
+        PendingTile const pending = m_pendingTiles.takeFirst();
+        QVector<qint16> *heights = new QVector<qint16>( pending.watcher->result() );
+        pending.watcher->deleteLater();
+
+        if ( heights->size() != m_tileSize.width() * m_tileSize.height() ) {
+            mDebug() << "Unexpected size of elevation tile" << pending.id;
+            heights->fill( noData, m_tileSize.width() * m_tileSize.height() );
         }
+
+        QMutexLocker locker( &m_cacheMutex );
+        m_cache.insert( pending.id, heights );
+        updated = true;
+    }
+
+    if ( updated ) {
+        emit q->updateAvailable();
     }
+}
 
-    if ( !hasHeight ) {
-        ret = invalidElevationData; //no data
-    } else {
-        if ( noData ) {
-            //mDebug() << "NO DATA" << noData;
-            ret += ( ret / ( 1 - noData ) ) * noData;
+ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent ) :
+    QObject( parent ),
+    d( new ElevationModelPrivate( this, downloadManager, pluginManager ) )
+{
+    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
+             this, SLOT(tileCompleted(TileId,QImage)) );
+}
+
+ElevationModel::~ElevationModel()
+{
+    delete d;
+}
+
+
+qreal ElevationModel::height( qreal lon, qreal lat ) const
+{
+    QVector<GeoDataCoordinates> const coordinates( 1, GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree ) );
+    return heights( coordinates.constBegin(), coordinates.constEnd() ).first();
+}
+
+QVector<qreal> ElevationModel::heights( QVector<GeoDataCoordinates>::const_iterator begin,
+                                        QVector<GeoDataCoordinates>::const_iterator end ) const
+{
+    QVector<qreal> result( static_cast<int>( end - begin ), invalidElevationData );
+    if ( result.isEmpty() || !d->initRaster() ) {
+        return result;
+    }
+
+    const int width = d->m_tileSize.width();
+    const int height = d->m_tileSize.height();
+    const int rasterWidth = d->m_numTilesX * width;
+    const int rasterHeight = d->m_numTilesY * height;
+
+    // group the queries by the tile of their upper left sample
+    QVector<QPointF> positions( result.size() );
+    QHash<TileId, QVector<int> > queries;
+    for ( int i = 0; i < result.size(); ++i ) {
+        const GeoDataCoordinates &coordinates = begin[i];
+        QPointF const position( ( 180 + coordinates.longitude( GeoDataCoordinates::Degree ) ) * rasterWidth / 360,
+                                ( 90 - coordinates.latitude( GeoDataCoordinates::Degree ) ) * rasterHeight / 180 );
+        positions[i] = position;
+
+        const int x = static_cast<int>( position.x() ) % rasterWidth;
+        const int y = static_cast<int>( position.y() ) % rasterHeight;
+        queries[TileId( 0, d->m_tileLevel, x / width, y / height )].append( i );
+    }
+
+    QHash<TileId, QVector<int> >::const_iterator group = queries.constBegin();
+    for ( ; group != queries.constEnd(); ++group ) {
+        const QVector<qint16> tile = d->tile( group.key() );
+
+        foreach ( int i, group.value() ) {
+            const int x = static_cast<int>( positions[i].x() );
+            const int y = static_cast<int>( positions[i].y() );
+            const int column = ( x % rasterWidth ) % width;
+            const int row = ( y % rasterHeight ) % height;
+
+            qint16 samples[4];
+            if ( !tile.isEmpty() && column + 1 < width && row + 1 < height ) {
+                const qint16 *sample = tile.constData() + row * width + column;
+                samples[0] = sample[0];
+                samples[1] = sample[1];
+                samples[2] = sample[width];
+                samples[3] = sample[width + 1];
+            } else {
+                // the samples lie in neighboring tiles as well, or the tile is still loading
+                for ( int j = 0; j < 4; ++j ) {
+                    samples[j] = d->sample( x + j % 2, y + j / 2 );
+                }
+            }
+
+            result[i] = ElevationModelPrivate::interpolate( samples, positions[i].x() - x, positions[i].y() - y );
         }
     }
 
-    //mDebug() << ">>>" << lat << lon << "returning an elevation of" << ret;
-    return ret;
+    return result;
 }
 
 QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const
 {
-    if ( !d->m_textureLayer ) {
+    if ( !d->initRaster() ) {
         return QList<GeoDataCoordinates>();
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    const int width = d->m_textureLayer->tileSize().width();
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-
-    qreal distPerPixel = ( qreal )360 / ( width * numTilesX );
+    qreal distPerPixel = ( qreal )360 / ( d->m_tileSize.width() * d->m_numTilesX );
     //mDebug() << "heightProfile" << fromLat << fromLon << toLat << toLon << "distPerPixel" << distPerPixel;
 
     qreal lat = fromLat;
@@ -192,13 +399,10 @@ QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fr
     //mDebug() << "fromLon" << fromLon << "fromLat" << fromLat;
     //mDebug() << "diff lon" << ( fromLon - toLon ) << "diff lat" << ( fromLat - toLat );
     //mDebug() << "dirLon" << QString::number(dirLon) << "dirLat" << QString::number(dirLat) << "k" << k;
-    QList<GeoDataCoordinates> ret;
+    QVector<GeoDataCoordinates> samples;
     while ( lat*dirLat <= toLat*dirLat && lon*dirLon <= toLon * dirLon ) {
         //mDebug() << lat << lon;
-        qreal h = height( lon, lat );
-        if ( h < 32000 ) {
-            ret << GeoDataCoordinates( lon, lat, h, GeoDataCoordinates::Degree );
-        }
+        samples << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
         if ( k < 0.5 ) {
             //mDebug() << "lon(x) += distPerPixel";
             lat += distPerPixel * k * dirLat;
@@ -209,6 +413,16 @@ QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fr
             lon += distPerPixel / k * dirLon;
         }
     }
+
+    QVector<qreal> const elevations = heights( samples.constBegin(), samples.constEnd() );
+    QList<GeoDataCoordinates> ret;
+    for ( int i = 0; i < samples.size(); ++i ) {
+        if ( elevations[i] < 32000 ) {
+            GeoDataCoordinates coordinates = samples[i];
+            coordinates.setAltitude( elevations[i] );
+            ret << coordinates;
+        }
+    }
     //mDebug() << ret;
     return ret;
 }
@@ -16,8 +16,8 @@
 #include "marble_export.h"
 
 #include <QObject>
-#include <QCache>
 #include <QImage>
+#include <QVector>
 
 namespace Marble
 {
@@ -38,7 +38,24 @@ public:
     explicit ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent = 0 );
     ~ElevationModel();
 
+    /**
+     * Returns the elevation in meters at the given position (in degree), or
+     * invalidElevationData if there is no data. Tiles which are not in memory
+     * yet are loaded in the background and updateAvailable() is emitted once
+     * they are; until then invalidElevationData is returned for them.
+     */
     qreal height( qreal lon, qreal lat ) const;
+
+    /**
+     * Returns the elevations of all coordinates in the range [@p begin, @p end)
+     * like height() does. Queries are grouped by elevation tile, making this
+     * much faster than calling height() for each coordinate.
+     *
+     * Unlike the rest of the model, this may be called from any thread.
+     */
+    QVector<qreal> heights( QVector<GeoDataCoordinates>::const_iterator begin,
+                            QVector<GeoDataCoordinates>::const_iterator end ) const;
+
     QList<GeoDataCoordinates> heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const;
 
 Q_SIGNALS:
@@ -50,6 +67,8 @@ Q_SIGNALS:
 
 private:
     Q_PRIVATE_SLOT( d, void tileCompleted( TileId, QImage ) )
+    Q_PRIVATE_SLOT( d, void tilesDecoded() )
+    Q_PRIVATE_SLOT( d, void loadRequestedTiles() )
 
 private:
     friend class ElevationModelPrivate;
@@ -10,10 +10,12 @@
 
 #include "FileLoader.h"
 
+#include <QAtomicInt>
 #include <QBuffer>
 #include <QDataStream>
 #include <QDateTime>
 #include <QFile>
+#include <QMutex>
 #include <QThread>
 
 #include "GeoDataParser.h"
@@ -22,6 +24,8 @@
 #include "GeoDataPlacemark.h"
 #include "GeoDataData.h"
 #include "GeoDataExtendedData.h"
+#include "GeoDataNetworkLinkControl.h"
+#include "GeoDataSchema.h"
 #include "GeoDataStyleMap.h"
 #include "GeoDataPolyStyle.h"
 #include "GeoDataLineStyle.h"
@@ -31,7 +35,9 @@
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
 #include "MarbleModel.h"
-#include "ParsingRunnerManager.h"
+#include "ParseRunnerPlugin.h"
+#include "ParsingRunner.h"
+#include "PluginManager.h"
 
 namespace Marble
 {
@@ -42,7 +48,9 @@ public:
     FileLoaderPrivate( FileLoader* parent, const PluginManager *pluginManager, bool recenter,
                        const QString& file, const QString& property, const GeoDataStyle::Ptr &style, DocumentRole role, int renderOrder )
         : q( parent),
-          m_runner( pluginManager ),
+          m_pluginManager( pluginManager ),
+          m_parsingRunner( 0 ),
+          m_canceled( 0 ),
           m_recenter( recenter ),
           m_filepath ( file ),
           m_property( property ),
@@ -61,13 +69,16 @@ public:
     FileLoaderPrivate( FileLoader* parent, const PluginManager *pluginManager,
                        const QString& contents, const QString& file, DocumentRole role )
         : q( parent ),
-          m_runner( pluginManager ),
+          m_pluginManager( pluginManager ),
+          m_parsingRunner( 0 ),
+          m_canceled( 0 ),
           m_recenter( false ),
           m_filepath ( file ),
           m_contents ( contents ),
           m_documentRole ( role ),
           m_styleMap( 0 ),
-          m_document( 0 )
+          m_document( 0 ),
+          m_renderOrder( 0 )
     {
     }
 
@@ -76,15 +87,25 @@ public:
         delete m_styleMap;
     }
 
+    void parseFile( const QString &fileName );
+    void prepareFeatures( const QVector<GeoDataFeature*> &features );
+    void applyRenderOrder( GeoDataPlacemark *placemark ) const;
     void createFilterProperties( GeoDataContainer *container );
+    void createFilterProperties( QVector<GeoDataFeature*>::ConstIterator i, QVector<GeoDataFeature*>::ConstIterator const end );
     static int cityPopIdx( qint64 population );
     static int spacePopIdx( qint64 population );
     static int areaPopIdx( qreal area );
 
     void documentParsed( GeoDataDocument *doc, const QString& error);
+    void streamFeatures( GeoDataContainer *container, const QVector<GeoDataFeature*> &features );
+    void parsingProgress( qint64 bytesRead, qint64 bytesTotal );
+    void mergeStreamedDocument( GeoDataDocument *doc );
 
     FileLoader *q;
-    ParsingRunnerManager m_runner;
+    const PluginManager *const m_pluginManager;
+    QMutex m_runnerMutex;
+    ParsingRunner *m_parsingRunner;
+    QAtomicInt m_canceled;
     bool m_recenter;
     QString m_filepath;
     QString m_contents;
@@ -131,6 +152,16 @@ QString FileLoader::error() const
     return d->m_error;
 }
 
+void FileLoader::cancel()
+{
+    d->m_canceled.store( 1 );
+
+    QMutexLocker locker( &d->m_runnerMutex );
+    if ( d->m_parsingRunner ) {
+        d->m_parsingRunner->cancel();
+    }
+}
+
 void FileLoader::run()
 {
     if ( d->m_contents.isEmpty() ) {
@@ -167,10 +198,8 @@ void FileLoader::run()
         if ( QFile::exists( defaultSourceName ) ) {
             mDebug() << "No recent Default Placemark Cache File available!";
 
-            // use runners: pnt, gpx, osm
-            connect( &d->m_runner, SIGNAL(parsingFinished(GeoDataDocument*,QString)),
-                    this, SLOT(documentParsed(GeoDataDocument*,QString)) );
-            d->m_runner.parseFile( defaultSourceName, d->m_documentRole );
+            // use runners: kml, pnt, gpx, osm
+            d->parseFile( defaultSourceName );
         }
         else {
             mDebug() << "No Default Placemark Source File for " << name;
@@ -212,10 +241,117 @@ bool FileLoader::recenter() const
     return d->m_recenter;
 }
 
+void FileLoaderPrivate::parseFile( const QString &fileName )
+{
+    QList<const ParseRunnerPlugin*> plugins = m_pluginManager->parsingRunnerPlugins();
+    const QFileInfo fileInfo( fileName );
+    const QString suffix = fileInfo.suffix().toLower();
+    const QString completeSuffix = fileInfo.completeSuffix().toLower();
+
+    // The runners are used one after another in this thread, as streaming
+    // runners hand off their document while parsing
+    GeoDataDocument *document = 0;
+    QString error;
+    foreach( const ParseRunnerPlugin *plugin, plugins ) {
+        QStringList const extensions = plugin->fileExtensions();
+        if ( !extensions.isEmpty() && !extensions.contains( suffix ) && !extensions.contains( completeSuffix ) ) {
+            continue;
+        }
+
+        ParsingRunner *runner = plugin->newRunner();
+        runner->setStreaming( true );
+        QObject::connect( runner, SIGNAL(featuresParsed(GeoDataContainer*,QVector<GeoDataFeature*>)),
+                          q, SLOT(streamFeatures(GeoDataContainer*,QVector<GeoDataFeature*>)), Qt::DirectConnection );
+        QObject::connect( runner, SIGNAL(parsingProgress(qint64,qint64)),
+                          q, SLOT(parsingProgress(qint64,qint64)), Qt::DirectConnection );
+
+        m_runnerMutex.lock();
+        m_parsingRunner = runner;
+        if ( m_canceled.load() ) {
+            runner->cancel();
+        }
+        m_runnerMutex.unlock();
+
+        document = runner->parseFile( fileName, m_documentRole, error );
+
+        m_runnerMutex.lock();
+        m_parsingRunner = 0;
+        m_runnerMutex.unlock();
+        delete runner;
+
+        // a partially streamed document cannot be parsed by another runner
+        if ( document || m_document || m_canceled.load() ) {
+            break;
+        }
+    }
+
+    QMetaObject::invokeMethod( q, "documentParsed", Qt::QueuedConnection,
+                               Q_ARG( GeoDataDocument*, document ), Q_ARG( QString, error ) );
+}
+
+void FileLoaderPrivate::streamFeatures( GeoDataContainer *container, const QVector<GeoDataFeature*> &features )
+{
+    if ( !container ) {
+        // streaming runners hand off the document before its features
+        Q_ASSERT( features.size() == 1 );
+        m_document = static_cast<GeoDataDocument*>( features.first() );
+        m_document->setProperty( m_property );
+        if ( m_style ) {
+            m_document->addStyleMap( *m_styleMap );
+            m_document->addStyle( m_style );
+        }
+        return;
+    }
+
+    prepareFeatures( features );
+    emit q->featuresParsed( q, container, features );
+}
+
+void FileLoaderPrivate::parsingProgress( qint64 bytesRead, qint64 bytesTotal )
+{
+    emit q->progressChanged( q, bytesRead, bytesTotal );
+}
+
+void FileLoaderPrivate::prepareFeatures( const QVector<GeoDataFeature*> &features )
+{
+    if ( m_renderOrder != 0 ) {
+        foreach ( GeoDataFeature *feature, features ) {
+            if ( feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+                applyRenderOrder( static_cast<GeoDataPlacemark*>( feature ) );
+            }
+        }
+    }
+
+    createFilterProperties( features.constBegin(), features.constEnd() );
+}
+
+void FileLoaderPrivate::applyRenderOrder( GeoDataPlacemark *placemark ) const
+{
+    if (placemark->geometry() && placemark->geometry()->nodeType() == GeoDataTypes::GeoDataPolygonType) {
+        GeoDataPolygon *polygon = static_cast<GeoDataPolygon*>(placemark->geometry());
+        polygon->setRenderOrder(m_renderOrder);
+    }
+}
+
 void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& error )
 {
+    if ( m_canceled.load() ) {
+        delete doc;
+        return;
+    }
+
+    // run() returns right after scheduling this call
+    q->wait();
+
     m_error = error;
-    if ( doc ) {
+    if ( m_document ) {
+        // A broken file leaves the partially streamed document to the
+        // receiver, which discards it due to the error
+        if ( doc ) {
+            mergeStreamedDocument( doc );
+            emit q->newGeoDataDocumentAdded( m_document );
+        }
+    } else if ( doc ) {
         m_document = doc;
         doc->setProperty( m_property );
         if( m_style ) {
@@ -225,10 +361,7 @@ void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& err
 
         if (m_renderOrder != 0) {
             foreach (GeoDataPlacemark* placemark, doc->placemarkList()) {
-                if (placemark->geometry() && placemark->geometry()->nodeType() == GeoDataTypes::GeoDataPolygonType) {
-                    GeoDataPolygon *polygon = static_cast<GeoDataPolygon*>(placemark->geometry());
-                    polygon->setRenderOrder(m_renderOrder);
-                }
+                applyRenderOrder( placemark );
             }
         }
 
@@ -238,10 +371,48 @@ void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& err
     emit q->loaderFinished( q );
 }
 
+void FileLoaderPrivate::mergeStreamedDocument( GeoDataDocument *doc )
+{
+    if ( !doc->name().isEmpty() ) {
+        m_document->setName( doc->name() );
+    }
+    if ( !doc->description().isEmpty() ) {
+        m_document->setDescription( doc->description() );
+    }
+    if ( !( doc->networkLinkControl() == GeoDataNetworkLinkControl() ) ) {
+        m_document->setNetworkLinkControl( doc->networkLinkControl() );
+    }
+
+    // Re-adding styles makes the streamed document their new parent
+    foreach ( const GeoDataStyle::Ptr &style, doc->styles() ) {
+        m_document->addStyle( style );
+    }
+    foreach ( const GeoDataStyleMap &styleMap, doc->styleMaps() ) {
+        m_document->addStyleMap( styleMap );
+    }
+    foreach ( const GeoDataSchema &schema, doc->schemas() ) {
+        m_document->addSchema( schema );
+    }
+
+    // Hand off remaining features which could not be streamed
+    QVector<GeoDataFeature*> features = doc->featureList();
+    while ( doc->size() > 0 ) {
+        doc->remove( doc->size() - 1 );
+    }
+    if ( !features.isEmpty() ) {
+        prepareFeatures( features );
+        emit q->featuresParsed( q, m_document, features );
+    }
+    delete doc;
+}
+
 void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
 {
-    QVector<GeoDataFeature*>::Iterator i = container->begin();
-    QVector<GeoDataFeature*>::Iterator const end = container->end();
+    createFilterProperties( container->constBegin(), container->constEnd() );
+}
+
+void FileLoaderPrivate::createFilterProperties( QVector<GeoDataFeature*>::ConstIterator i, QVector<GeoDataFeature*>::ConstIterator const end )
+{
     for (; i != end; ++i ) {
         if ( (*i)->nodeType() == GeoDataTypes::GeoDataFolderType
              || (*i)->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
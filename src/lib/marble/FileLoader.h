@@ -15,6 +15,7 @@
 
 #include <QThread>
 #include <QString>
+#include <QVector>
 
 namespace Marble
 {
@@ -38,12 +39,33 @@ class FileLoader : public QThread
         GeoDataDocument *document();
         QString error() const;
 
+        /**
+         * Asks the loader to stop as soon as possible and to discard the
+         * parsed data. Can be called from any thread.
+         * @see ParsingRunner::cancel()
+         */
+        void cancel();
+
     Q_SIGNALS:
         void loaderFinished( FileLoader* );
         void newGeoDataDocumentAdded( GeoDataDocument* );
 
+        /**
+         * Emitted while a file is parsed by a streaming runner with a batch
+         * of completed features of @p container, which is document() or a
+         * folder or document handed off by an earlier batch. The features
+         * are not yet contained in @p container and should be appended to
+         * it by the receiver, which takes ownership of them.
+         */
+        void featuresParsed( FileLoader*, GeoDataContainer *container, const QVector<GeoDataFeature*> &features );
+
+        /** Emitted while a file is parsed by a streaming runner with the number of bytes read so far */
+        void progressChanged( FileLoader*, qint64 bytesRead, qint64 bytesTotal );
+
 private:
         Q_PRIVATE_SLOT ( d, void documentParsed( GeoDataDocument *, QString) )
+        Q_PRIVATE_SLOT ( d, void streamFeatures( GeoDataContainer *, const QVector<GeoDataFeature*> & ) )
+        Q_PRIVATE_SLOT ( d, void parsingProgress( qint64, qint64 ) )
 
         friend class FileLoaderPrivate;
 
@@ -11,8 +11,10 @@
 
 #include "FileManager.h"
 
+#include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
+#include <QThread>
 #include <QTime>
 #include <QMessageBox>
 
@@ -40,20 +42,26 @@ public:
         m_treeModel( treeModel ),
         m_pluginManager( pluginManager )
     {
+        qRegisterMetaType<GeoDataContainer*>( "GeoDataContainer*" );
+        qRegisterMetaType<QVector<GeoDataFeature*> >( "QVector<GeoDataFeature*>" );
     }
 
     ~FileManagerPrivate()
     {
         foreach ( FileLoader *loader, m_loaderList ) {
             if ( loader ) {
-                loader->wait();
+                discardLoader( loader );
             }
         }
     }
 
+    void discardLoader( FileLoader *loader );
+
     void appendLoader( FileLoader *loader );
     void closeFile( const QString &key );
     void cleanupLoader( FileLoader *loader );
+    void addFeatures( FileLoader *loader, GeoDataContainer *container, const QVector<GeoDataFeature*> &features );
+    void updateProgress( FileLoader *loader, qint64 bytesRead, qint64 bytesTotal );
 
     FileManager *const q;
     GeoDataTreeModel *const m_treeModel;
@@ -106,6 +114,10 @@ void FileManagerPrivate::appendLoader( FileLoader *loader )
 {
     QObject::connect( loader, SIGNAL(loaderFinished(FileLoader*)),
              q, SLOT(cleanupLoader(FileLoader*)) );
+    QObject::connect( loader, SIGNAL(featuresParsed(FileLoader*,GeoDataContainer*,QVector<GeoDataFeature*>)),
+             q, SLOT(addFeatures(FileLoader*,GeoDataContainer*,QVector<GeoDataFeature*>)) );
+    QObject::connect( loader, SIGNAL(progressChanged(FileLoader*,qint64,qint64)),
+             q, SLOT(updateProgress(FileLoader*,qint64,qint64)) );
 
     m_loaderList.append( loader );
     loader->start();
@@ -115,10 +127,8 @@ void FileManager::removeFile( const QString& key )
 {
     foreach ( FileLoader *loader, d->m_loaderList ) {
         if ( loader->path() == key ) {
-            disconnect( loader, 0, this, 0 );
-            loader->wait();
             d->m_loaderList.removeAll( loader );
-            delete loader->document();
+            d->discardLoader( loader );
             return;
         }
     }
@@ -130,6 +140,21 @@ void FileManager::removeFile( const QString& key )
     mDebug() << "could not identify " << key;
 }
 
+void FileManagerPrivate::discardLoader( FileLoader *loader )
+{
+    QObject::disconnect( loader, 0, q, 0 );
+    loader->cancel();
+    loader->wait();
+
+    GeoDataDocument *document = loader->document();
+    if ( document && document->parent() ) {
+        // partially loaded document
+        m_treeModel->removeDocument( document );
+    }
+    delete document;
+    delete loader;
+}
+
 void FileManagerPrivate::closeFile( const QString& key )
 {
     mDebug() << "FileManager::closeFile " << key;
@@ -186,18 +211,56 @@ int FileManager::pendingFiles() const
     return d->m_loaderList.size();
 }
 
+void FileManagerPrivate::addFeatures( FileLoader *loader, GeoDataContainer *container, const QVector<GeoDataFeature*> &features )
+{
+    if ( !m_loaderList.contains( loader ) ) {
+        // the file was removed while loading
+        qDeleteAll( features );
+        return;
+    }
+
+    GeoDataDocument *doc = loader->document();
+    if ( !doc->parent() ) {
+        m_treeModel->addDocument( doc );
+    }
+    m_treeModel->addFeatures( container, features );
+}
+
+void FileManagerPrivate::updateProgress( FileLoader *loader, qint64 bytesRead, qint64 bytesTotal )
+{
+    if ( m_loaderList.contains( loader ) ) {
+        emit q->fileLoadingProgress( loader->path(), bytesRead, bytesTotal );
+    }
+}
+
 void FileManagerPrivate::cleanupLoader( FileLoader* loader )
 {
+    if ( !m_loaderList.contains( loader ) ) {
+        // the file was removed while loading
+        return;
+    }
+
     GeoDataDocument *doc = loader->document();
     m_loaderList.removeAll( loader );
     if ( loader->isFinished() ) {
+        if ( doc && !loader->error().isEmpty() ) {
+            // features of a broken file may have been streamed already
+            if ( doc->parent() ) {
+                m_treeModel->removeDocument( doc );
+            }
+            delete doc;
+            doc = 0;
+        }
         if ( doc ) {
             if ( doc->name().isEmpty() && !doc->fileName().isEmpty() )
             {
                 QFileInfo file( doc->fileName() );
                 doc->setName( file.baseName() );
             }
-            m_treeModel->addDocument( doc );
+            if ( !doc->parent() ) {
+                // streamed documents are added along with their first features
+                m_treeModel->addDocument( doc );
+            }
             m_fileItemHash.insert( loader->path(), doc );
             emit q->fileAdded( loader->path() );
             if( loader->recenter() ) {
@@ -205,11 +268,14 @@ void FileManagerPrivate::cleanupLoader( FileLoader* loader )
             }
         }
         if ( !loader->error().isEmpty() ) {
-            QMessageBox errorBox;
-            errorBox.setWindowTitle( QObject::tr("File Parsing Error"));
-            errorBox.setText( loader->error() );
-            errorBox.setIcon( QMessageBox::Warning );
-            errorBox.exec();
+            // models of headless renderers live in threads that cannot show widgets
+            if ( QThread::currentThread() == QCoreApplication::instance()->thread() ) {
+                QMessageBox errorBox;
+                errorBox.setWindowTitle( QObject::tr("File Parsing Error"));
+                errorBox.setText( loader->error() );
+                errorBox.setIcon( QMessageBox::Warning );
+                errorBox.exec();
+            }
             qWarning() << "File Parsing error " << loader->error();
         }
         delete loader;
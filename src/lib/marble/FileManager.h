@@ -58,7 +58,7 @@ class FileManager : public QObject
 
 
     /**
-    * removes an existing file from the manager
+    * removes an existing file from the manager, canceling it if it is still loading
     */
     void removeFile( const QString &fileName );
 
@@ -81,9 +81,17 @@ class FileManager : public QObject
     void fileRemoved( const QString &key );
     void centeredDocument( const GeoDataLatLonBox& );
 
+    /**
+     * Emitted periodically while a file is loaded incrementally.
+     * The loaded part of the file is already available in the tree model.
+     */
+    void fileLoadingProgress( const QString &key, qint64 bytesRead, qint64 bytesTotal );
+
  private:
 
     Q_PRIVATE_SLOT( d, void cleanupLoader( FileLoader *loader ) )
+    Q_PRIVATE_SLOT( d, void addFeatures( FileLoader *loader, GeoDataContainer *container, const QVector<GeoDataFeature*> &features ) )
+    Q_PRIVATE_SLOT( d, void updateProgress( FileLoader *loader, qint64 bytesRead, qint64 bytesTotal ) )
 
     Q_DISABLE_COPY( FileManager )
 
@@ -17,6 +17,7 @@
 #include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
+#include <QRunnable>
 
 // Marble
 #include "MarbleDebug.h"
@@ -25,66 +26,191 @@
 
 using namespace Marble;
 
+// Bytes waiting to be written before updateFile() rejects files
+static const qint64 defaultMaximumBacklog = 32 * 1024 * 1024;
+
+// Several models of a process, e.g. the workers of a tile renderer, may
+// store into the same directory, their writers take turns
+static QMutex s_writeMutex;
+
+typedef QPair<QString, QByteArray> QueuedFile;
+
+class FileStoragePolicy::WriteTask : public QRunnable
+{
+public:
+    explicit WriteTask( FileStoragePolicy *policy ) :
+        m_policy( policy )
+    {
+    }
+
+    void run()
+    {
+        m_policy->writeQueuedFiles();
+    }
+
+private:
+    FileStoragePolicy *const m_policy;
+};
+
 FileStoragePolicy::FileStoragePolicy( const QString &dataDirectory, QObject *parent )
     : StoragePolicy( parent ),
-      m_dataDirectory( dataDirectory )
+      m_dataDirectory( dataDirectory ),
+      m_backlog( 0 ),
+      m_maximumBacklog( defaultMaximumBacklog ),
+      m_writing( false )
 {
     if ( m_dataDirectory.isEmpty() )
         m_dataDirectory = MarbleDirs::localPath() + "/cache/";
 
     if ( !QDir( m_dataDirectory ).exists() ) 
         QDir::root().mkpath( m_dataDirectory );
+
+    m_writerPool.setMaxThreadCount( 1 );
 }
 
 FileStoragePolicy::~FileStoragePolicy()
 {
+    flush();
 }
 
 bool FileStoragePolicy::fileExists( const QString &fileName ) const
 {
-    const QString fullName( m_dataDirectory + '/' + fileName );
+    const QString fullName = filePath( fileName );
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( m_queuedFiles.contains( fullName ) ) {
+            return true;
+        }
+    }
+
     return QFile::exists( fullName );
 }
 
 bool FileStoragePolicy::updateFile( const QString &fileName, const QByteArray &data )
 {
-    QFileInfo const dirInfo( fileName );
-    QString const fullName = dirInfo.isAbsolute() ? fileName : m_dataDirectory + '/' + fileName;
+    const QString fullName = filePath( fileName );
+    QMutexLocker locker( &m_mutex );
+
+    // Keep the memory used by a download burst bounded. Waiting for the
+    // writer would block the GUI thread, so the file is not stored in the
+    // cache instead and will be downloaded again when it is needed.
+    if ( m_backlog > 0 && m_backlog + data.size() > m_maximumBacklog ) {
+        m_errorMsg = QString( "%1: Too much data waiting to be written" ).arg( fullName );
+        return false;
+    }
+
+    m_queue.enqueue( qMakePair( fullName, data ) );
+    ++m_queuedFiles[ fullName ];
+    m_backlog += data.size();
+
+    if ( !m_writing ) {
+        m_writing = true;
+        m_writerPool.start( new WriteTask( this ) );
+    }
+
+    return true;
+}
+
+QString FileStoragePolicy::filePath( const QString &fileName ) const
+{
+    return QDir::cleanPath( QFileInfo( fileName ).isAbsolute() ? fileName : m_dataDirectory + '/' + fileName );
+}
+
+void FileStoragePolicy::setMaximumBacklog( qint64 bytes )
+{
+    QMutexLocker locker( &m_mutex );
+    m_maximumBacklog = bytes;
+}
+
+qint64 FileStoragePolicy::backlog() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_backlog;
+}
+
+void FileStoragePolicy::flush()
+{
+    m_writerPool.waitForDone();
+}
+
+void FileStoragePolicy::writeQueuedFiles()
+{
+    forever {
+        QQueue<QueuedFile> batch;
+        {
+            QMutexLocker locker( &m_mutex );
+            if ( m_queue.isEmpty() ) {
+                m_writing = false;
+                return;
+            }
+            batch.swap( m_queue );
+        }
+
+        qint64 written = 0;
+        foreach ( const QueuedFile &file, batch ) {
+            writeFile( file.first, file.second );
+            written += file.second.size();
+        }
 
+        QMutexLocker locker( &m_mutex );
+        foreach ( const QueuedFile &file, batch ) {
+            QHash<QString, int>::iterator const pos = m_queuedFiles.find( file.first );
+            if ( --pos.value() == 0 ) {
+                m_queuedFiles.erase( pos );
+            }
+        }
+        m_backlog -= written;
+    }
+}
+
+bool FileStoragePolicy::writeFile( const QString &fullName, const QByteArray &data )
+{
     // Create directory if it doesn't exist yet...
     QFileInfo info( fullName );
 
-    const QDir localFileDir = info.dir();
-    const QString localFileDirPath = localFileDir.absolutePath();
+    const QString localFileDirPath = info.absolutePath();
 
-    if ( !QDir( localFileDirPath ).exists() )
+    if ( !m_directories.contains( localFileDirPath ) ) {
         QDir::root().mkpath( localFileDirPath );
+        m_directories.insert( localFileDirPath );
+    }
 
     // ... and save the file content
+    QMutexLocker writeLocker( &s_writeMutex );
     QFile file( fullName );
     if ( !file.open( QIODevice::WriteOnly ) ) {
+        // The directory might have been removed meanwhile
+        m_directories.remove( localFileDirPath );
+        QMutexLocker locker( &m_mutex );
         m_errorMsg = QString( "%1: %2" ).arg( fullName ).arg( file.errorString() );
         qCritical() << "file.open" << m_errorMsg;
+        emit fileUpdateFailed( fullName );
         return false;
     }
 
     quint64 oldSize = file.size();
 
     if ( !file.write( data ) ) {
+        QMutexLocker locker( &m_mutex );
         m_errorMsg = QString( "%1: %2" ).arg( fullName ).arg( file.errorString() );
         qCritical() << "file.write" << m_errorMsg;
         emit sizeChanged( file.size() - oldSize );
+        emit fileUpdateFailed( fullName );
         return false;
     }
 
     emit sizeChanged( file.size() - oldSize );
     file.close();
+    emit fileUpdated( fullName, data.size() );
 
     return true;
 }
 
 void FileStoragePolicy::clearCache()
 {
+    // Queued files would be written after the cache was cleared otherwise
+    flush();
+
     if ( m_dataDirectory.isEmpty() || !m_dataDirectory.endsWith(QLatin1String( "data" )) )
     {
         mDebug() << "Error: Refusing to erase files under unknown conditions for safety reasons!";
@@ -117,16 +243,14 @@ void FileStoragePolicy::clearCache()
                     QString filePath = itTile.filePath();
                     QString lowerCase = filePath.toLower();
 
-                    // We try to be very careful and just delete images
-                    // FIXME, when vectortiling I suppose also vector tiles will have
-                    // to be deleted
+                    // We try to be very careful and just delete images and vector tiles
                     if ( lowerCase.endsWith( QLatin1String( ".jpg" ) ) 
                       || lowerCase.endsWith( QLatin1String( ".png" ) )
                       || lowerCase.endsWith( QLatin1String( ".gif" ) )
                       || lowerCase.endsWith( QLatin1String( ".svg" ) )
+                      || lowerCase.endsWith( QLatin1String( ".o5m" ) )
                     )
                     {
-                        // We cannot emit clear, because we don't make a full clear
                         QFile file( filePath );
                         emit sizeChanged( -file.size() );
                         file.remove();
@@ -135,10 +259,15 @@ void FileStoragePolicy::clearCache()
             }
         }
     }
+
+    // Only the tiles above the base levels are gone, FileStorageWatcher
+    // rescans the cache to find out what is left.
+    emit cleared();
 }
 
 QString FileStoragePolicy::lastErrorMessage() const
 {
+    QMutexLocker locker( &m_mutex );
     return m_errorMsg;
 }
 
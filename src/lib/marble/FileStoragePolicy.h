@@ -12,11 +12,30 @@
 #define MARBLE_FILESTORAGEPOLICY_H
 
 #include "StoragePolicy.h"
+#include "marble_export.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
+#include <QThreadPool>
 
 namespace Marble
 {
 
-class FileStoragePolicy : public StoragePolicy
+/**
+ * Stores files below a data directory.
+ *
+ * Files are written behind by a background thread: updateFile() only
+ * queues the data and returns, the writer creates the directories and
+ * writes all queued files in batches and emits fileUpdated() for each
+ * of them. If too much data is waiting to be written, updateFile()
+ * rejects further files until the writer caught up, it never blocks
+ * the caller.
+ */
+class MARBLE_EXPORT FileStoragePolicy : public StoragePolicy
 {
     Q_OBJECT
     
@@ -29,20 +48,43 @@ class FileStoragePolicy : public StoragePolicy
         explicit FileStoragePolicy( const QString &dataDirectory = QString(), QObject *parent = 0 );
 
         /**
-         * Destroys the cache storage policy.
+         * Destroys the cache storage policy after writing all queued files.
          */
         ~FileStoragePolicy();
 
         /**
-         * Returns whether the @p fileName exists already.
+         * Returns whether the @p fileName exists already or is queued for writing.
          */
         bool fileExists( const QString &fileName ) const;
 
         /**
-         * Updates the @p fileName with the given @p data.
+         * Queues the @p fileName to be updated with the given @p data.
+         * Returns false without queuing if the backlog is full. A file is
+         * always queued if nothing else is waiting to be written.
          */
         bool updateFile( const QString &fileName, const QByteArray &data );
 
+        /**
+         * Returns the absolute path of @p fileName below the data directory,
+         * absolute file names are only cleaned.
+         */
+        QString filePath( const QString &fileName ) const;
+
+        /**
+         * Sets the number of bytes which may wait to be written, 32 MB by default.
+         */
+        void setMaximumBacklog( qint64 bytes );
+
+        /**
+         * Returns the number of bytes waiting to be written.
+         */
+        qint64 backlog() const;
+
+        /**
+         * Blocks until all queued files are written.
+         */
+        void flush();
+
         /**
          * Clears the cache.
          */
@@ -55,9 +97,26 @@ class FileStoragePolicy : public StoragePolicy
 
     private:
 	Q_DISABLE_COPY( FileStoragePolicy )
+
+        class WriteTask;
+
+        void writeQueuedFiles();
+        bool writeFile( const QString &fullName, const QByteArray &data );
 	
         QString m_dataDirectory;
         QString m_errorMsg;
+
+        mutable QMutex m_mutex;
+        // Absolute file names and data waiting to be written
+        QQueue<QPair<QString, QByteArray> > m_queue;
+        QHash<QString, int> m_queuedFiles;
+        qint64 m_backlog;
+        qint64 m_maximumBacklog;
+        bool m_writing;
+
+        // Directories known to exist, only used by the writer
+        QSet<QString> m_directories;
+        QThreadPool m_writerPool;
 };
 
 }
@@ -12,9 +12,11 @@
 #include "FileStorageWatcher.h"
 
 // Qt
+#include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <QTimer>
 
 // Marble
@@ -29,14 +31,44 @@ using namespace Marble;
 static const int maxFilesDelete = 20;
 static const int softLimitPercent = 5;
 
+// The manifest starts with a header, followed by the journal records
+static const quint32 manifestMagic = 0x4d54434d; // "MTCM"
+static const qint32 manifestVersion = 1;
+static const char manifestFileName[] = "tilecache.manifest";
+static const char manifestLockFileName[] = "tilecache.manifest.lock";
+
+// Records are written to the manifest at most once in this interval
+static const int manifestFlushInterval = 2000;
+
+// Watchers without the manifest try to take it over in this interval
+static const int manifestLockRetryInterval = 60000;
+
+// Beyond this many files written without the manifest, the cache is crawled on takeover
+static const int maxPendingEntries = 100000;
+
+enum ManifestRecord {
+    UpdateRecord = 1,
+    AccessRecord = 2,
+    RemoveRecord = 3
+};
+
 
 // Methods of FileStorageWatcherThread
 FileStorageWatcherThread::FileStorageWatcherThread( const QString &dataDirectory, QObject *parent )
     : QObject( parent ),
       m_dataDirectory( dataDirectory ),
+      m_mapsDirectory( QDir::cleanPath( dataDirectory + "/maps" ) + '/' ),
+      m_manifestLock( dataDirectory + '/' + manifestLockFileName ),
+      m_pendingOverflow( false ),
+      m_journalRecords( 0 ),
+      m_flushScheduled( false ),
+      m_currentCacheSize( 0 ),
       m_deleting( false ),
       m_willQuit( false )
 {
+    // Only a crashed instance leaves a stale lock, however long the owner runs
+    m_manifestLock.setStaleLockTime( 0 );
+
     // For now setting cache limit to 0. This won't delete anything
     setCacheLimit( 0 );
     
@@ -48,6 +80,7 @@ FileStorageWatcherThread::FileStorageWatcherThread( const QString &dataDirectory
 
 FileStorageWatcherThread::~FileStorageWatcherThread()
 {
+    m_journalFile.close();
 }
 
 quint64 FileStorageWatcherThread::cacheLimit()
@@ -55,6 +88,16 @@ quint64 FileStorageWatcherThread::cacheLimit()
     return m_cacheLimit;
 }
 
+quint64 FileStorageWatcherThread::currentCacheSize() const
+{
+    return m_currentCacheSize;
+}
+
+bool FileStorageWatcherThread::ownsManifest() const
+{
+    return m_manifestLock.isLocked();
+}
+
 void FileStorageWatcherThread::setCacheLimit( quint64 bytes )
 {
     m_limitMutex.lock();
@@ -77,10 +120,87 @@ void FileStorageWatcherThread::addToCurrentSize( qint64 bytes )
 
 void FileStorageWatcherThread::resetCurrentSize()
 {
+    m_pendingEntries.clear();
+    m_pendingOverflow = false;
+    if ( !m_manifestLock.isLocked() ) {
+        return;
+    }
+
+    m_entries.clear();
+    m_accessOrder.clear();
     m_currentCacheSize = 0;
+    crawlCache();
+    if ( !m_willQuit ) {
+        writeManifest();
+    }
     emit variableChanged();
 }
 
+void FileStorageWatcherThread::updateFile( const QString &fileName, qint64 size )
+{
+    QString const key = cacheKey( fileName );
+    if ( key.isEmpty() ) {
+        return;
+    }
+
+    CacheEntry entry;
+    entry.size = size;
+    entry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+    entry.theme = key.section( '/', 0, 1 );
+    entry.type = key.endsWith( QLatin1String( ".o5m" ), Qt::CaseInsensitive ) ? VectorTile : TextureTile;
+
+    if ( !m_manifestLock.isLocked() ) {
+        // Recorded once this watcher takes the manifest over
+        if ( !m_pendingOverflow && ( m_pendingEntries.size() < maxPendingEntries || m_pendingEntries.contains( key ) ) ) {
+            m_pendingEntries.insert( key, entry );
+        } else {
+            m_pendingOverflow = true;
+            m_pendingEntries.clear();
+        }
+        return;
+    }
+
+    recordEntry( key, entry );
+    emit variableChanged();
+}
+
+void FileStorageWatcherThread::touchFile( const QString &fileName )
+{
+    QString const key = cacheKey( fileName );
+    if ( key.isEmpty() ) {
+        return;
+    }
+
+    if ( !m_manifestLock.isLocked() ) {
+        QHash<QString, CacheEntry>::iterator const pending = m_pendingEntries.find( key );
+        if ( pending != m_pendingEntries.end() ) {
+            pending->lastAccess = QDateTime::currentMSecsSinceEpoch();
+        }
+        return;
+    }
+
+    QHash<QString, CacheEntry>::iterator const pos = m_entries.find( key );
+    if ( pos == m_entries.end() ) {
+        // Written while nobody was watching, adopt it.
+        QFileInfo const info( m_mapsDirectory + key );
+        if ( info.exists() ) {
+            updateFile( info.absoluteFilePath(), info.size() );
+        }
+        return;
+    }
+
+    qint64 const now = QDateTime::currentMSecsSinceEpoch();
+    m_accessOrder.remove( pos->lastAccess, key );
+    pos->lastAccess = now;
+    m_accessOrder.insert( now, key );
+
+    if ( m_journalFile.isOpen() ) {
+        m_journal << quint8( AccessRecord ) << key << now;
+        ++m_journalRecords;
+        scheduleFlush();
+    }
+}
+
 void FileStorageWatcherThread::prepareQuit()
 {
     m_willQuit = true;
@@ -88,35 +208,281 @@ void FileStorageWatcherThread::prepareQuit()
 
 void FileStorageWatcherThread::getCurrentCacheSize()
 {
+    if ( m_manifestLock.isLocked() ) {
+        return;
+    }
+
+    if ( !m_manifestLock.tryLock( 0 ) ) {
+        // Several models, e.g. in different processes, share the cache.
+        // Only the one keeping the manifest sizes and evicts the cache,
+        // others would delete files behind its back. Once it is gone,
+        // this one takes over.
+        mDebug() << "FileStorageWatcher: Cache manifest is in use, leaving the cache to its owner";
+        if ( !m_willQuit ) {
+            QTimer::singleShot( manifestLockRetryInterval, this, SLOT(getCurrentCacheSize()) );
+        }
+        return;
+    }
+
+    if ( !m_pendingOverflow && loadManifest() ) {
+        mDebug() << "FileStorageWatcher: Read cache manifest," << m_entries.size()
+                 << "tiles," << m_currentCacheSize << "bytes";
+        openJournal();
+        recordPendingEntries();
+        emit variableChanged();
+        return;
+    }
+
     mDebug() << "FileStorageWatcher: Creating cache size";
-    quint64 dataSize = 0;
-    QString basePath = m_dataDirectory + "/maps";
-    QDirIterator it( basePath,
+    m_entries.clear();
+    m_accessOrder.clear();
+    m_currentCacheSize = 0;
+    m_pendingEntries.clear();
+    m_pendingOverflow = false;
+    crawlCache();
+    if ( !m_willQuit ) {
+        writeManifest();
+    }
+    emit variableChanged();
+}
+
+void FileStorageWatcherThread::crawlCache()
+{
+    QDirIterator it( m_mapsDirectory,
                      QDir::Files | QDir::Writable,
                      QDirIterator::Subdirectories );
-    
-    int basePathDepth = basePath.split('/').size();
+
     while( it.hasNext() && !m_willQuit ) {
         it.next();
-        QFileInfo file = it.fileInfo();
-        // We try to be very careful and just delete images
-        // FIXME, when vectortiling I suppose also vector tiles will have
-        // to be deleted
-        QString suffix = file.suffix().toLower();
-        QStringList path = file.path().split('/');
-
-        // planet/theme/tilelevel should be deeper than 4
-        if ( ( path.size() > basePathDepth + 3 ) &&
-             ( path[basePathDepth + 2].toInt() >= maxBaseTileLevel ) &&
-               ( ( suffix == "jpg"
-                || suffix == "png"
-                || suffix == "gif"
-                || suffix == "svg" ) ) ) {
-            dataSize += file.size();
-            m_filesCache.insert(file.lastModified(), file.absoluteFilePath());
+        QFileInfo const file = it.fileInfo();
+        QString const key = cacheKey( file.absoluteFilePath() );
+        if ( key.isEmpty() ) {
+            continue;
+        }
+
+        CacheEntry entry;
+        entry.size = file.size();
+        entry.lastAccess = file.lastModified().toMSecsSinceEpoch();
+        entry.theme = key.section( '/', 0, 1 );
+        entry.type = file.suffix().toLower() == QLatin1String( "o5m" ) ? VectorTile : TextureTile;
+        insertEntry( key, entry );
+    }
+}
+
+QString FileStorageWatcherThread::cacheKey( const QString &fileName ) const
+{
+    QString const path = QDir::isAbsolutePath( fileName ) ? QDir::cleanPath( fileName )
+                                                          : QDir::cleanPath( m_dataDirectory + '/' + fileName );
+    if ( !path.startsWith( m_mapsDirectory ) ) {
+        return QString();
+    }
+
+    // We try to be very careful and just delete images and vector tiles
+    QString const suffix = path.section( '.', -1 ).toLower();
+    if ( suffix != QLatin1String( "jpg" ) && suffix != QLatin1String( "png" )
+         && suffix != QLatin1String( "gif" ) && suffix != QLatin1String( "svg" )
+         && suffix != QLatin1String( "o5m" ) ) {
+        return QString();
+    }
+
+    // planet/theme/tilelevel/x/y.suffix, the base tile levels are kept
+    QString const key = path.mid( m_mapsDirectory.size() );
+    if ( key.count( '/' ) < 4 || key.section( '/', 2, 2 ).toInt() < maxBaseTileLevel ) {
+        return QString();
+    }
+
+    return key;
+}
+
+void FileStorageWatcherThread::insertEntry( const QString &key, const CacheEntry &entry )
+{
+    removeEntry( key );
+
+    CacheEntry shared = entry;
+    // Share the theme strings, there are only a few of them
+    shared.theme = *m_themes.insert( entry.theme );
+
+    m_entries.insert( key, shared );
+    m_accessOrder.insert( shared.lastAccess, key );
+    m_currentCacheSize += shared.size;
+}
+
+void FileStorageWatcherThread::recordEntry( const QString &key, const CacheEntry &entry )
+{
+    insertEntry( key, entry );
+
+    if ( m_journalFile.isOpen() ) {
+        m_journal << quint8( UpdateRecord ) << key << entry.size << entry.lastAccess
+                  << entry.theme << quint8( entry.type );
+        ++m_journalRecords;
+        scheduleFlush();
+    }
+}
+
+void FileStorageWatcherThread::recordPendingEntries()
+{
+    QHash<QString, CacheEntry>::const_iterator pos = m_pendingEntries.constBegin();
+    QHash<QString, CacheEntry>::const_iterator const end = m_pendingEntries.constEnd();
+    for (; pos != end; ++pos ) {
+        // Removed meanwhile by the previous owner, or the cache was cleared
+        if ( QFile::exists( m_mapsDirectory + pos.key() ) ) {
+            recordEntry( pos.key(), pos.value() );
         }
     }
-    m_currentCacheSize = dataSize;
+    m_pendingEntries.clear();
+}
+
+void FileStorageWatcherThread::removeEntry( const QString &key )
+{
+    QHash<QString, CacheEntry>::iterator const pos = m_entries.find( key );
+    if ( pos == m_entries.end() ) {
+        return;
+    }
+
+    m_accessOrder.remove( pos->lastAccess, key );
+    m_currentCacheSize -= qMin<quint64>( m_currentCacheSize, pos->size );
+    m_entries.erase( pos );
+}
+
+bool FileStorageWatcherThread::loadManifest()
+{
+    QFile file( m_dataDirectory + '/' + manifestFileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    quint32 magic;
+    qint32 version;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != manifestMagic || version != manifestVersion ) {
+        mDebug() << "FileStorageWatcher: Ignoring invalid cache manifest" << file.fileName();
+        return false;
+    }
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    int records = 0;
+    bool complete = true;
+    while ( !stream.atEnd() && !m_willQuit ) {
+        quint8 type;
+        QString key;
+        stream >> type >> key;
+
+        if ( type == UpdateRecord ) {
+            CacheEntry entry;
+            quint8 tileType;
+            stream >> entry.size >> entry.lastAccess >> entry.theme >> tileType;
+            entry.type = TileType( tileType );
+            if ( stream.status() == QDataStream::Ok ) {
+                insertEntry( key, entry );
+            }
+        } else if ( type == AccessRecord ) {
+            qint64 lastAccess;
+            stream >> lastAccess;
+            QHash<QString, CacheEntry>::iterator const pos = m_entries.find( key );
+            if ( stream.status() == QDataStream::Ok && pos != m_entries.end() ) {
+                m_accessOrder.remove( pos->lastAccess, key );
+                pos->lastAccess = lastAccess;
+                m_accessOrder.insert( lastAccess, key );
+            }
+        } else if ( type == RemoveRecord ) {
+            if ( stream.status() == QDataStream::Ok ) {
+                removeEntry( key );
+            }
+        } else {
+            stream.setStatus( QDataStream::ReadCorruptData );
+        }
+
+        if ( stream.status() != QDataStream::Ok ) {
+            // The last records were not written completely, e.g. because of a crash
+            mDebug() << "FileStorageWatcher: Cache manifest is truncated after" << records << "records";
+            complete = false;
+            break;
+        }
+        ++records;
+    }
+
+    if ( m_willQuit ) {
+        return false;
+    }
+
+    m_journalRecords = records;
+    if ( !complete ) {
+        // Appending to a truncated manifest would corrupt it
+        file.close();
+        writeManifest();
+    }
+
+    return true;
+}
+
+void FileStorageWatcherThread::writeManifest()
+{
+    m_journalFile.close();
+
+    if ( !m_manifestLock.isLocked() ) {
+        return;
+    }
+
+    QSaveFile file( m_dataDirectory + '/' + manifestFileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "FileStorageWatcher: Cannot write cache manifest" << file.fileName();
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream << manifestMagic << manifestVersion;
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    // Written from the least to the most recently used tile, so that
+    // the access order survives the entries with the same access time
+    QMultiMap<qint64, QString>::const_iterator pos = m_accessOrder.constBegin();
+    QMultiMap<qint64, QString>::const_iterator const end = m_accessOrder.constEnd();
+    for (; pos != end; ++pos ) {
+        CacheEntry const &entry = m_entries[ pos.value() ];
+        stream << quint8( UpdateRecord ) << pos.value() << entry.size << entry.lastAccess
+               << entry.theme << quint8( entry.type );
+    }
+
+    if ( !file.commit() ) {
+        mDebug() << "FileStorageWatcher: Cannot write cache manifest" << file.fileName();
+        return;
+    }
+
+    m_journalRecords = m_entries.size();
+    openJournal();
+}
+
+void FileStorageWatcherThread::openJournal()
+{
+    m_journalFile.setFileName( m_dataDirectory + '/' + manifestFileName );
+    if ( !m_journalFile.open( QIODevice::WriteOnly | QIODevice::Append ) ) {
+        mDebug() << "FileStorageWatcher: Cannot open cache manifest" << m_journalFile.fileName();
+        return;
+    }
+    m_journal.setDevice( &m_journalFile );
+    m_journal.setVersion( QDataStream::Qt_5_0 );
+}
+
+void FileStorageWatcherThread::scheduleFlush()
+{
+    if ( !m_flushScheduled ) {
+        m_flushScheduled = true;
+        QTimer::singleShot( manifestFlushInterval, this, SLOT(flushManifest()) );
+    }
+}
+
+void FileStorageWatcherThread::flushManifest()
+{
+    m_flushScheduled = false;
+
+    // Most records are accesses of the same tiles over and over
+    // again, rewrite the manifest before it grows too large.
+    if ( m_journalRecords > 2 * m_entries.size() + 1024 ) {
+        writeManifest();
+    } else {
+        m_journalFile.flush();
+    }
 }
 
 void FileStorageWatcherThread::ensureCacheSize()
@@ -130,6 +496,7 @@ void FileStorageWatcherThread::ensureCacheSize()
 	     || ( m_deleting && ( m_currentCacheSize > m_cacheSoftLimit ) ) )
 	&& ( m_cacheLimit != 0 )
 	&& ( m_cacheSoftLimit != 0 )
+	&& m_manifestLock.isLocked()
     && !m_willQuit ) {
 
         mDebug() << "Deleting extra cached tiles";
@@ -138,17 +505,21 @@ void FileStorageWatcherThread::ensureCacheSize()
         // We have not reached our soft limit, yet.
         m_deleting = true;
 
-        QMultiMap<QDateTime, QString>::iterator it= m_filesCache.begin();
-        while ( it != m_filesCache.end() &&
+        // Least recently used tiles first
+        while ( !m_accessOrder.isEmpty() &&
                 keepDeleting() ) {
-            QString filePath = it.value();
-            QFileInfo info( filePath );
+            QString const key = m_accessOrder.begin().value();
 
             m_filesDeleted++;
-            m_currentCacheSize -= info.size();
-            it = m_filesCache.erase(it);
-            QFile::remove( filePath );
+            removeEntry( key );
+            QFile::remove( m_mapsDirectory + key );
+
+            if ( m_journalFile.isOpen() ) {
+                m_journal << quint8( RemoveRecord ) << key;
+                ++m_journalRecords;
+            }
         }
+        scheduleFlush();
 
         // We have deleted enough files.
         // Perhaps there are changes.
@@ -193,6 +564,7 @@ FileStorageWatcher::FileStorageWatcher( const QString &dataDirectory, QObject *
     
     m_started = false;
     m_limitMutex = new QMutex();
+    m_limit = 0;
     
     m_thread = 0;
     m_quitting = false;
@@ -247,6 +619,16 @@ void FileStorageWatcher::resetCurrentSize()
     emit cleared();
 }
 
+void FileStorageWatcher::updateFile( const QString &fileName, qint64 size )
+{
+    emit fileUpdated( fileName, size );
+}
+
+void FileStorageWatcher::touchFile( const QString &fileName )
+{
+    emit fileAccessed( fileName );
+}
+
 void FileStorageWatcher::run()
 {
     m_thread = new FileStorageWatcherThread( m_dataDirectory );
@@ -256,12 +638,18 @@ void FileStorageWatcher::run()
         m_started = true;
         m_limitMutex->unlock();
 
-        m_thread->getCurrentCacheSize();
-
+        // Connect first, changes made while reading the manifest
+        // are queued until the event loop runs.
         connect( this, SIGNAL(sizeChanged(qint64)),
                  m_thread, SLOT(addToCurrentSize(qint64)) );
         connect( this, SIGNAL(cleared()),
                  m_thread, SLOT(resetCurrentSize()) );
+        connect( this, SIGNAL(fileUpdated(QString,qint64)),
+                 m_thread, SLOT(updateFile(QString,qint64)) );
+        connect( this, SIGNAL(fileAccessed(QString)),
+                 m_thread, SLOT(touchFile(QString)) );
+
+        m_thread->getCurrentCacheSize();
 
         // Make sure that we don't want to stop process.
         // The thread wouldn't exit from event loop.
@@ -14,13 +14,32 @@
 #include <QThread>
 #include <QMutex>
 #include <QMultiMap>
-#include <QDateTime>
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QLockFile>
+#include <QSet>
+
+#include "marble_export.h"
 
 namespace Marble
 {
     
-// Lives inside the new Thread
-class FileStorageWatcherThread : public QObject
+/**
+ * Lives inside the new Thread.
+ *
+ * The cached tiles are kept in a manifest, which records size, last access,
+ * map theme and tile type of every tile. The manifest is a journal of
+ * changes appended while files are written and read, and rewritten in
+ * compact form from time to time. This way the cache size is known at
+ * startup without crawling the cache directory, and tiles can be evicted
+ * by their last access.
+ *
+ * Only one watcher keeps the manifest of a cache directory at a time. The
+ * others remember the files they write and take the manifest over once
+ * its owner is gone.
+ */
+class MARBLE_EXPORT FileStorageWatcherThread : public QObject
 {
     Q_OBJECT
     
@@ -31,6 +50,16 @@ class FileStorageWatcherThread : public QObject
     
 	quint64 cacheLimit();
 	
+	/**
+	 * Returns the size of the cached tiles as recorded in the manifest.
+	 */
+	quint64 currentCacheSize() const;
+	
+	/**
+	 * Returns true if this watcher keeps the manifest and evicts tiles.
+	 */
+	bool ownsManifest() const;
+	
     Q_SIGNALS:
 	/**
 	 * Is emitted when a variable has changed.
@@ -50,17 +79,32 @@ class FileStorageWatcherThread : public QObject
 	void addToCurrentSize( qint64 bytes );
 	
 	/**
-	 * Setting current cache size to 0.
+	 * Rebuilds the manifest from the files on the disc, e.g. after the
+	 * cache has been cleared.
 	 */
 	void resetCurrentSize();
 	
+	/**
+	 * Records that @p fileName has been written with @p size bytes.
+	 */
+	void updateFile( const QString &fileName, qint64 size );
+	
+	/**
+	 * Records that @p fileName has been read.
+	 */
+	void touchFile( const QString &fileName );
+	
 	/**
 	 * Stop doing things that take a long time to quit.
 	 */
 	void prepareQuit();
 	
 	/**
-	 * Getting the current size of the data stored on the disc
+	 * Getting the current size of the data stored on the disc.
+	 * Reads the manifest, the cache directory is only crawled if
+	 * there is no valid manifest yet. If another watcher keeps the
+	 * manifest, this is tried again later, only one watcher sizes and
+	 * evicts the cache at a time.
 	 */
 	void getCurrentCacheSize();
 
@@ -69,17 +113,62 @@ class FileStorageWatcherThread : public QObject
 	 * Ensures that the cache doesn't exceed limits.
 	 */
 	void ensureCacheSize();
+	
+	/**
+	 * Writes the buffered manifest records to the disc.
+	 */
+	void flushManifest();
     
     private:
 	Q_DISABLE_COPY( FileStorageWatcherThread )
 	
+	enum TileType {
+	    TextureTile,
+	    VectorTile
+	};
+	
+	struct CacheEntry
+	{
+	    qint64 size;
+	    qint64 lastAccess; // msecs since epoch
+	    QString theme;
+	    TileType type;
+	};
+	
 	/**
 	 * Returns true if it is necessary to delete files.
 	 */
 	bool keepDeleting() const;
 	
+	/**
+	 * Returns the path of @p fileName relative to the maps directory, or
+	 * an empty string if @p fileName is not a tile which may be deleted.
+	 */
+	QString cacheKey( const QString &fileName ) const;
+	
+	void crawlCache();
+	bool loadManifest();
+	void writeManifest();
+	void openJournal();
+	void scheduleFlush();
+	
+	void insertEntry( const QString &key, const CacheEntry &entry );
+	void removeEntry( const QString &key );
+	void recordEntry( const QString &key, const CacheEntry &entry );
+	void recordPendingEntries();
+	
 	QString m_dataDirectory;
-    QMultiMap<QDateTime,QString> m_filesCache;
+	QString m_mapsDirectory;
+	QHash<QString, CacheEntry> m_entries;
+	QMultiMap<qint64, QString> m_accessOrder;
+	QSet<QString> m_themes;
+	QHash<QString, CacheEntry> m_pendingEntries; // written while another watcher keeps the manifest
+	bool m_pendingOverflow;
+	QLockFile m_manifestLock;
+	QFile m_journalFile;
+	QDataStream m_journal;
+	int m_journalRecords;
+	bool m_flushScheduled;
     quint64 m_cacheLimit;
 	quint64 m_cacheSoftLimit;
     quint64 m_currentCacheSize;
@@ -125,14 +214,27 @@ class FileStorageWatcher : public QThread
 	void addToCurrentSize( qint64 bytes );
 	
 	/**
-	 * Setting current cache size to 0.
+	 * Rebuilds the cache manifest from the files on the disc.
 	 */
 	void resetCurrentSize();
 	
+	/**
+	 * Records that @p fileName has been written with @p size bytes.
+	 */
+	void updateFile( const QString &fileName, qint64 size );
+	
+	/**
+	 * Records that @p fileName has been read, which makes it the most
+	 * recently used file of the cache.
+	 */
+	void touchFile( const QString &fileName );
+	
 
     Q_SIGNALS:
 	void sizeChanged( qint64 bytes );
 	void cleared();
+	void fileUpdated( const QString &fileName, qint64 size );
+	void fileAccessed( const QString &fileName );
 	
     protected:
 	/**
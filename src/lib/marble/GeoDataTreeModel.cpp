@@ -46,7 +46,7 @@ class Q_DECL_HIDDEN GeoDataTreeModel::Private {
     Private( QAbstractItemModel* model );
     ~Private();
 
-    static void checkParenting( GeoDataObject *object );
+    static void checkParenting( GeoDataContainer *container, GeoDataFeature *child );
 
     GeoDataDocument* m_rootDocument;
     bool             m_ownsRootDocument;
@@ -68,17 +68,13 @@ GeoDataTreeModel::Private::~Private()
     }
 }
 
-void GeoDataTreeModel::Private::checkParenting( GeoDataObject *object )
+void GeoDataTreeModel::Private::checkParenting( GeoDataContainer *container, GeoDataFeature *child )
 {
-    if(    object->nodeType() == GeoDataTypes::GeoDataDocumentType
-        || object->nodeType() == GeoDataTypes::GeoDataFolderType ) {
-        GeoDataContainer *container = static_cast<GeoDataContainer*>( object );
-        foreach( GeoDataFeature *child, container->featureList() ) {
-            if ( child->parent() != container ) {
-                qWarning() << "Parenting mismatch for " << child->name();
-                Q_ASSERT( 0 );
-            }
-        }
+    // Only the inserted child is checked, checking all siblings would make
+    // adding n features to a container O(n^2)
+    if ( child->parent() != container ) {
+        qWarning() << "Parenting mismatch for " << child->name();
+        Q_ASSERT( 0 );
     }
 }
 
@@ -321,8 +317,8 @@ QVariant GeoDataTreeModel::data( const QModelIndex &index, int role ) const
                 GeoDataFolder *folder = static_cast<GeoDataFolder *>( object );
                 if ( folder->style()->listStyle().listItemType() == GeoDataListStyle::RadioFolder) {
                     bool anyVisible = false;
-                    QVector<GeoDataFeature *>::Iterator i = folder->begin();
-                    for (; i < folder->end(); ++i) {
+                    QVector<GeoDataFeature *>::ConstIterator i = folder->constBegin();
+                    for (; i < folder->constEnd(); ++i) {
                         if ((*i)->isVisible()) {
                             anyVisible = true;
                             break;
@@ -334,10 +330,10 @@ QVariant GeoDataTreeModel::data( const QModelIndex &index, int role ) const
                         return QVariant( Qt::Unchecked );
                     }
                 } else if ( folder->style()->listStyle().listItemType() == GeoDataListStyle::CheckOffOnly) {
-                    QVector<GeoDataFeature *>::Iterator i = folder->begin();
+                    QVector<GeoDataFeature *>::ConstIterator i = folder->constBegin();
                     bool anyVisible = false;
                     bool allVisible = true;
-                    for (; i < folder->end(); ++i) {
+                    for (; i < folder->constEnd(); ++i) {
                         if ((*i)->isVisible()) {
                             anyVisible = true;
                         } else {
@@ -567,8 +563,8 @@ bool GeoDataTreeModel::setData ( const QModelIndex & index, const QVariant & val
                 GeoDataFolder *pfolder = static_cast<GeoDataFolder *>(feature->parent());
                 if ( pfolder->style()->listStyle().listItemType() == GeoDataListStyle::RadioFolder) {
                     if ( bValue ) {
-                        QVector< GeoDataFeature * >::Iterator i = pfolder->begin();
-                        for(; i < pfolder->end(); ++i) {
+                        QVector< GeoDataFeature * >::ConstIterator i = pfolder->constBegin();
+                        for(; i < pfolder->constEnd(); ++i) {
                             (*i)->setVisible( false );
                         }
                     }
@@ -580,8 +576,8 @@ bool GeoDataTreeModel::setData ( const QModelIndex & index, const QVariant & val
                 } else {
                     if ( folder->style()->listStyle().listItemType() == GeoDataListStyle::RadioFolder 
                       || folder->style()->listStyle().listItemType() == GeoDataListStyle::CheckOffOnly ) {
-                        QVector< GeoDataFeature * >::Iterator i = folder->begin();
-                        for(; i < folder->end(); ++i) {
+                        QVector< GeoDataFeature * >::ConstIterator i = folder->constBegin();
+                        for(; i < folder->constEnd(); ++i) {
                             (*i)->setVisible( false );
                         }
                         folder->setVisible( false );
@@ -639,9 +635,9 @@ Qt::ItemFlags GeoDataTreeModel::flags ( const QModelIndex & index ) const
         if ( folder->style()->listStyle().listItemType() == GeoDataListStyle::RadioFolder) {
             return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable | Qt::ItemIsEditable; 
         } else if ( folder->style()->listStyle().listItemType() == GeoDataListStyle::CheckOffOnly ) {
-            QVector<GeoDataFeature *>::Iterator i = folder->begin();
+            QVector<GeoDataFeature *>::ConstIterator i = folder->constBegin();
             bool allVisible = true;
-            for(; i < folder->end(); ++i) {
+            for(; i < folder->constEnd(); ++i) {
                 if( ! (*i)->isVisible() ) {
                     allVisible = false;
                     break;
@@ -703,6 +699,7 @@ QModelIndex GeoDataTreeModel::index( GeoDataObject *object ) const
     Q_ASSERT( ( object->nodeType() == GeoDataTypes::GeoDataFolderType )
               || ( object->nodeType() == GeoDataTypes::GeoDataDocumentType )
               || ( object->nodeType() == GeoDataTypes::GeoDataPlacemarkType )
+              || ( object->nodeType() == GeoDataTypes::GeoDataGroundOverlayType )
               || ( object->nodeType() == GeoDataTypes::GeoDataTourType )
               || ( ( object->nodeType() == GeoDataTypes::GeoDataPlaylistType )
                    && ( object->parent()->nodeType() == GeoDataTypes::GeoDataTourType ) )
@@ -763,15 +760,13 @@ QModelIndex GeoDataTreeModel::index( GeoDataObject *object ) const
                 itdown = index( 0, 0, itdown );
             } else if ( ( parent->nodeType() == GeoDataTypes::GeoDataPlaylistType ) ) {
                 GeoDataPlaylist *playlist = static_cast<GeoDataPlaylist*>( parent );
-                for ( int i=0; i< playlist->size(); i++ )
-                {
-                    if ( playlist->primitive(i) == ancestors.last() )
-                    {
-                        ancestors.removeLast();
-                        itdown = index( i, 0, itdown );
-                        break;
-                    }
+                int const row = playlist->primitivePosition( static_cast<GeoDataTourPrimitive*>( ancestors.last() ) );
+                if ( row < 0 ) {
+                    itdown = QModelIndex();
+                    break;
                 }
+                ancestors.removeLast();
+                itdown = index( row, 0, itdown );
             }
             else  {   //If the element is not found on the tree, it will be added under m_rootDocument
                 itdown = QModelIndex();
@@ -804,7 +799,7 @@ int GeoDataTreeModel::addFeature( GeoDataContainer *parent, GeoDataFeature *feat
             }
             beginInsertRows( modelindex , row , row );
             parent->insert( row, feature );
-            d->checkParenting( parent );
+            d->checkParenting( parent, feature );
             endInsertRows();
             emit added(feature);
         }
@@ -816,6 +811,31 @@ int GeoDataTreeModel::addFeature( GeoDataContainer *parent, GeoDataFeature *feat
     return row; //-1 if it failed, the relative index otherwise.
 }
 
+int GeoDataTreeModel::addFeatures( GeoDataContainer *parent, const QVector<GeoDataFeature*> &features )
+{
+    if ( !parent || features.isEmpty() ) {
+        return -1;
+    }
+
+    QModelIndex const modelindex = index( parent );
+    if ( parent != d->m_rootDocument && !modelindex.isValid() ) {
+        qWarning() << "GeoDataTreeModel::addFeatures (parent " << parent << ") : parent not found on the TreeModel";
+        return -1;
+    }
+
+    int const first = parent->size();
+    beginInsertRows( modelindex, first, first + features.size() - 1 );
+    foreach ( GeoDataFeature *feature, features ) {
+        parent->append( feature );
+    }
+    endInsertRows();
+
+    foreach ( GeoDataFeature *feature, features ) {
+        emit added( feature );
+    }
+    return first;
+}
+
 int GeoDataTreeModel::addDocument( GeoDataDocument *document )
 {
     return addFeature( d->m_rootDocument, document );
@@ -14,6 +14,7 @@
 #include "marble_export.h"
 
 #include <QAbstractItemModel>
+#include <QVector>
 
 class QItemSelectionModel;
 
@@ -77,6 +78,14 @@ class MARBLE_EXPORT GeoDataTreeModel : public QAbstractItemModel
 
     GeoDataDocument *rootDocument();
 
+    /**
+     * Appends all @p features to @p parent using a single row insertion.
+     * This is much cheaper than calling addFeature() for each of them when
+     * large batches of features are added to a container in the model.
+     * @return the row of the first added feature, or -1 if nothing was added
+     */
+    int addFeatures( GeoDataContainer *parent, const QVector<GeoDataFeature*> &features );
+
 public Q_SLOTS:
 
     /**
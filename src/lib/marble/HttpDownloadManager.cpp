@@ -12,8 +12,10 @@
 
 #include "HttpDownloadManager.h"
 
+#include <QHash>
 #include <QList>
 #include <QMap>
+#include <QSet>
 #include <QTimer>
 #include <QNetworkAccessManager>
 
@@ -28,6 +30,8 @@ using namespace Marble;
 // Time before a failed download job is requeued in ms
 const quint32 requeueTime = 60000;
 
+typedef QHash<QString, int> JobPriorities;
+
 class Q_DECL_HIDDEN HttpDownloadManager::Private
 {
   public:
@@ -38,8 +42,12 @@ class Q_DECL_HIDDEN HttpDownloadManager::Private
     void connectQueueSet( DownloadQueueSet * );
     bool hasDownloadPolicy( const DownloadPolicy& policy ) const;
     void finishJob( const QByteArray&, const QString&, const QString& id );
+    void fileUpdated( const QString& filePath );
+    void fileUpdateFailed( const QString& filePath );
     void requeue();
     void startRetryTimer();
+    void applyJobPriorities( const QString &idPrefix );
+    void removeJobOwner( QObject *owner );
 
     DownloadQueueSet *findQueues( const QString& hostName, const DownloadUsage usage );
 
@@ -53,6 +61,12 @@ class Q_DECL_HIDDEN HttpDownloadManager::Private
     QList<QPair<DownloadPolicyKey, DownloadQueueSet *> > m_queueSets;
     QMap<DownloadUsage, DownloadQueueSet *> m_defaultQueueSets;
     StoragePolicy *const m_storagePolicy;
+    /// The destination file names and ids of downloaded files which the
+    /// storage policy did not write yet, by the path the policy writes to
+    QMultiHash<QString, QPair<QString, QString> > m_unsavedFiles;
+    /// The job priorities reported by each owner, by job id prefix
+    QHash<QString, QHash<QObject *, JobPriorities> > m_jobPriorities;
+    QSet<QObject *> m_jobOwners;
     QNetworkAccessManager m_networkAccessManager;
     bool m_acceptJobs;
 
@@ -109,6 +123,11 @@ HttpDownloadManager::HttpDownloadManager( StoragePolicy *policy )
     d->m_requeueTimer.setInterval( requeueTime );
     connect( &d->m_requeueTimer, SIGNAL(timeout()), this, SLOT(requeue()) );
     d->connectDefaultQueueSets();
+
+    if ( policy ) {
+        connect( policy, SIGNAL(fileUpdated(QString,qint64)), this, SLOT(fileUpdated(QString)) );
+        connect( policy, SIGNAL(fileUpdateFailed(QString)), this, SLOT(fileUpdateFailed(QString)) );
+    }
 }
 
 HttpDownloadManager::~HttpDownloadManager()
@@ -116,6 +135,11 @@ HttpDownloadManager::~HttpDownloadManager()
     delete d;
 }
 
+StoragePolicy *HttpDownloadManager::storagePolicy() const
+{
+    return d->m_storagePolicy;
+}
+
 void HttpDownloadManager::setDownloadEnabled( const bool enable )
 {
     d->m_networkAccessManager.setNetworkAccessible( enable ? QNetworkAccessManager::Accessible : QNetworkAccessManager::NotAccessible );
@@ -156,22 +180,98 @@ void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFile
     }
 }
 
+void HttpDownloadManager::setJobPriorities( QObject *owner, const QString &idPrefix, const QHash<QString, int> &priorities )
+{
+    if ( owner && !d->m_jobOwners.contains( owner ) ) {
+        d->m_jobOwners.insert( owner );
+        connect( owner, SIGNAL(destroyed(QObject*)), this, SLOT(removeJobOwner(QObject*)) );
+    }
+    d->m_jobPriorities[ idPrefix ][ owner ] = priorities;
+    d->applyJobPriorities( idPrefix );
+}
+
+void HttpDownloadManager::Private::applyJobPriorities( const QString &idPrefix )
+{
+    // A job is needed as long as one of the owners needs it
+    JobPriorities priorities;
+    foreach ( const JobPriorities &ownerPriorities, m_jobPriorities.value( idPrefix ) ) {
+        JobPriorities::const_iterator pos = ownerPriorities.constBegin();
+        JobPriorities::const_iterator const end = ownerPriorities.constEnd();
+        for (; pos != end; ++pos ) {
+            JobPriorities::iterator const merged = priorities.find( pos.key() );
+            if ( merged == priorities.end() ) {
+                priorities.insert( pos.key(), pos.value() );
+            } else if ( merged.value() < pos.value() ) {
+                merged.value() = pos.value();
+            }
+        }
+    }
+
+    m_defaultQueueSets[ DownloadBrowse ]->setJobPriorities( idPrefix, priorities );
+
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator pos = m_queueSets.begin();
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator const end = m_queueSets.end();
+    for (; pos != end; ++pos ) {
+        if ( pos->first.usage() == DownloadBrowse ) {
+            pos->second->setJobPriorities( idPrefix, priorities );
+        }
+    }
+}
+
+void HttpDownloadManager::Private::removeJobOwner( QObject *owner )
+{
+    m_jobOwners.remove( owner );
+    foreach ( const QString &idPrefix, m_jobPriorities.keys() ) {
+        QHash<QObject *, JobPriorities> &owners = m_jobPriorities[ idPrefix ];
+        if ( owners.remove( owner ) == 0 ) {
+            continue;
+        }
+
+        if ( owners.isEmpty() ) {
+            // nobody reports priorities anymore, leave the jobs as they are
+            m_jobPriorities.remove( idPrefix );
+        } else {
+            // jobs only the destroyed owner needed are canceled
+            applyJobPriorities( idPrefix );
+        }
+    }
+}
+
 void HttpDownloadManager::Private::finishJob( const QByteArray& data, const QString& destinationFileName,
                                      const QString& id )
 {
     mDebug() << "emitting downloadComplete( QByteArray, " << id << ")";
     emit m_downloadManager->downloadComplete( data, id );
     if ( m_storagePolicy ) {
+        // The policy might write in the background, downloadComplete( QString, QString )
+        // is emitted by fileUpdated() once the file is there
+        QString const filePath = m_storagePolicy->filePath( destinationFileName );
+        QPair<QString, QString> const job( destinationFileName, id );
+        m_unsavedFiles.insert( filePath, job );
         const bool saved = m_storagePolicy->updateFile( destinationFileName, data );
-        if ( saved ) {
-            mDebug() << "emitting downloadComplete( " << destinationFileName << ", " << id << ")";
-            emit m_downloadManager->downloadComplete( destinationFileName, id );
-        } else {
-            qWarning() << "Could not save:" << destinationFileName;
+        if ( !saved ) {
+            m_unsavedFiles.remove( filePath, job );
+            qWarning() << "Could not save:" << destinationFileName << m_storagePolicy->lastErrorMessage();
         }
     }
 }
 
+void HttpDownloadManager::Private::fileUpdated( const QString& filePath )
+{
+    typedef QPair<QString, QString> Job;
+    foreach ( const Job &job, m_unsavedFiles.values( filePath ) ) {
+        mDebug() << "emitting downloadComplete( " << job.first << ", " << job.second << ")";
+        emit m_downloadManager->downloadComplete( job.first, job.second );
+    }
+    m_unsavedFiles.remove( filePath );
+}
+
+void HttpDownloadManager::Private::fileUpdateFailed( const QString& filePath )
+{
+    qWarning() << "Could not save:" << filePath;
+    m_unsavedFiles.remove( filePath );
+}
+
 void HttpDownloadManager::Private::requeue()
 {
     m_requeueTimer.stop();
@@ -202,6 +302,7 @@ void HttpDownloadManager::Private::connectQueueSet( DownloadQueueSet * queueSet
     connect( queueSet, SIGNAL(jobFinished(QByteArray,QString,QString)),
              m_downloadManager, SLOT(finishJob(QByteArray,QString,QString)));
     connect( queueSet, SIGNAL(jobRetry()), m_downloadManager, SLOT(startRetryTimer()));
+    connect( queueSet, SIGNAL(jobCanceled(QString)), m_downloadManager, SIGNAL(downloadCanceled(QString)) );
     connect( queueSet, SIGNAL(jobRedirected(QUrl,QString,QString,DownloadUsage)),
              m_downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage)));
     // relay jobAdded/jobRemoved signals (interesting for progress bar)
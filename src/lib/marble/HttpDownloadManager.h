@@ -17,6 +17,7 @@
 #ifndef MARBLE_HTTPDOWNLOADMANAGER_H
 #define MARBLE_HTTPDOWNLOADMANAGER_H
 
+#include <QHash>
 #include <QObject>
 
 #include "MarbleGlobal.h"
@@ -64,6 +65,12 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
      * Switches loading on/off, useful for offline mode.
      */
     void setDownloadEnabled( const bool enable );
+
+    /**
+     * Returns the storage policy downloaded files are stored with, if any.
+     */
+    StoragePolicy *storagePolicy() const;
+
     void addDownloadPolicy( const DownloadPolicy& );
 
     static QByteArray userAgent(const QString &platform, const QString &plugin);
@@ -76,6 +83,20 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     void addJob( const QUrl& sourceUrl, const QString& destFilename, const QString &id,
                  const DownloadUsage usage );
 
+    /**
+     * Reorders the pending browse downloads of all jobs whose id starts with
+     * @p idPrefix. @p priorities maps job ids to priorities, jobs with a
+     * higher priority are downloaded first. Pending and running downloads
+     * of jobs with a matching prefix that are missing in @p priorities are
+     * canceled. Bulk downloads are not affected.
+     *
+     * Several @p owner, e.g. the tile loaders of several maps, may share
+     * the jobs of a prefix. A job is only canceled if none of the owners
+     * needs it, and gets the highest priority any of them requested. The
+     * priorities of an owner are dropped when it is destroyed.
+     */
+    void setJobPriorities( QObject *owner, const QString &idPrefix, const QHash<QString, int> &priorities );
+
 
  Q_SIGNALS:
     void downloadComplete( QString, QString );
@@ -83,7 +104,8 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     /**
      * This signal is emitted if a file is downloaded and the data argument
      * contains the files content. The HttpDownloadManager takes care to save
-     * it using the given storage policy.
+     * it using the given storage policy, the signal above is emitted once the
+     * file is saved.
      */
     void downloadComplete( QByteArray data, QString initiatorId );
 
@@ -98,11 +120,23 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
      */
     void jobRemoved();
 
+    /**
+     * The download with the given @p initiatorId was canceled because it is
+     * not needed anymore, see setJobPriorities().
+     */
+    void downloadCanceled( const QString &initiatorId );
+
     /**
       * A job was queued, activated or removed (finished, failed)
       */
     void progressChanged( int active, int queued );
 
+    /**
+     * A cached file was read. Tile loaders report their reads through
+     * this signal so that the cache can be evicted by last access.
+     */
+    void fileAccessed( const QString &fileName );
+
  private:
     Q_DISABLE_COPY( HttpDownloadManager )
 
@@ -110,8 +144,11 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     Private * const d;
 
     Q_PRIVATE_SLOT( d, void finishJob( const QByteArray&, const QString&, const QString& id ) )
+    Q_PRIVATE_SLOT( d, void fileUpdated( const QString& ) )
+    Q_PRIVATE_SLOT( d, void fileUpdateFailed( const QString& ) )
     Q_PRIVATE_SLOT( d, void requeue() )
     Q_PRIVATE_SLOT( d, void startRetryTimer() )
+    Q_PRIVATE_SLOT( d, void removeJobOwner( QObject* ) )
 };
 
 }
@@ -24,11 +24,8 @@
 #include <QAbstractItemModel>
 #include <QSet>
 #include <QItemSelectionModel>
-#include <QSortFilterProxyModel>
 #include <QTextDocument>
 
-#include "kdescendantsproxymodel.h"
-
 #include "MapThemeManager.h"
 #include "MarbleGlobal.h"
 #include "MarbleDebug.h"
@@ -59,6 +56,7 @@
 #include "MarbleDirs.h"
 #include "FileManager.h"
 #include "GeoDataTreeModel.h"
+#include "PlacemarkIndexModel.h"
 #include "PlacemarkPositionProviderPlugin.h"
 #include "Planet.h"
 #include "PlanetFactory.h"
@@ -91,8 +89,8 @@ class MarbleModelPrivate
           m_downloadManager( &m_storagePolicy ),
           m_storageWatcher( MarbleDirs::localPath() ),
           m_treeModel(),
-          m_descendantProxy(),
-          m_placemarkProxyModel(),
+          m_placemarkIndexModel(),
+          m_groundOverlayIndexModel(),
           m_placemarkSelectionModel( 0 ),
           m_fileManager( &m_treeModel, &m_pluginManager ),
           m_positionTracking( &m_treeModel ),
@@ -103,15 +101,10 @@ class MarbleModelPrivate
           m_workOffline( false ),
           m_elevationModel( &m_downloadManager, &m_pluginManager )
     {
-        m_descendantProxy.setSourceModel( &m_treeModel );
-
-        m_placemarkProxyModel.setFilterFixedString( GeoDataTypes::GeoDataPlacemarkType );
-        m_placemarkProxyModel.setFilterKeyColumn( 1 );
-        m_placemarkProxyModel.setSourceModel( &m_descendantProxy );
+        m_placemarkIndexModel.setSourceModel( &m_treeModel );
 
-        m_groundOverlayProxyModel.setFilterFixedString( GeoDataTypes::GeoDataGroundOverlayType );
-        m_groundOverlayProxyModel.setFilterKeyColumn( 1 );
-        m_groundOverlayProxyModel.setSourceModel( &m_descendantProxy );
+        m_groundOverlayIndexModel.setFeatureType( GeoDataTypes::GeoDataGroundOverlayType );
+        m_groundOverlayIndexModel.setSourceModel( &m_treeModel );
     }
 
     ~MarbleModelPrivate()
@@ -169,9 +162,8 @@ class MarbleModelPrivate
 
     // Places on the map
     GeoDataTreeModel         m_treeModel;
-    KDescendantsProxyModel   m_descendantProxy;
-    QSortFilterProxyModel    m_placemarkProxyModel;
-    QSortFilterProxyModel    m_groundOverlayProxyModel;
+    PlacemarkIndexModel      m_placemarkIndexModel;
+    PlacemarkIndexModel      m_groundOverlayIndexModel;
 
     // Selection handling
     QItemSelectionModel      m_placemarkSelectionModel;
@@ -196,11 +188,14 @@ MarbleModel::MarbleModel( QObject *parent )
     : QObject( parent ),
       d( new MarbleModelPrivate() )
 {
-    // connect the StoragePolicy used by the download manager to the FileStorageWatcher
+    // connect the StoragePolicy used by the download manager and the tile
+    // reads reported by it to the FileStorageWatcher
     connect( &d->m_storagePolicy, SIGNAL(cleared()),
              &d->m_storageWatcher, SLOT(resetCurrentSize()) );
-    connect( &d->m_storagePolicy, SIGNAL(sizeChanged(qint64)),
-             &d->m_storageWatcher, SLOT(addToCurrentSize(qint64)) );
+    connect( &d->m_storagePolicy, SIGNAL(fileUpdated(QString,qint64)),
+             &d->m_storageWatcher, SLOT(updateFile(QString,qint64)) );
+    connect( &d->m_downloadManager, SIGNAL(fileAccessed(QString)),
+             &d->m_storageWatcher, SLOT(touchFile(QString)) );
 
     connect( &d->m_fileManager, SIGNAL(fileAdded(QString)),
              this, SLOT(assignFillColors(QString)) );
@@ -483,8 +478,8 @@ void MarbleModelPrivate::assignNewStyle( const QString &filePath, const GeoDataS
 
     addHighlightStyle( doc );
 
-    QVector<GeoDataFeature*>::iterator iter = doc->begin();
-    QVector<GeoDataFeature*>::iterator const end = doc->end();
+    QVector<GeoDataFeature*>::ConstIterator iter = doc->constBegin();
+    QVector<GeoDataFeature*>::ConstIterator const end = doc->constEnd();
 
     for ( ; iter != end; ++iter ) {
         if ( (*iter)->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
@@ -543,22 +538,22 @@ const GeoDataTreeModel *MarbleModel::treeModel() const
 
 QAbstractItemModel *MarbleModel::placemarkModel()
 {
-    return &d->m_placemarkProxyModel;
+    return &d->m_placemarkIndexModel;
 }
 
 const QAbstractItemModel *MarbleModel::placemarkModel() const
 {
-    return &d->m_placemarkProxyModel;
+    return &d->m_placemarkIndexModel;
 }
 
 QAbstractItemModel *MarbleModel::groundOverlayModel()
 {
-    return &d->m_groundOverlayProxyModel;
+    return &d->m_groundOverlayIndexModel;
 }
 
 const QAbstractItemModel *MarbleModel::groundOverlayModel() const
 {
-    return &d->m_groundOverlayProxyModel;
+    return &d->m_groundOverlayIndexModel;
 }
 
 QItemSelectionModel *MarbleModel::placemarkSelectionModel()
@@ -674,7 +669,6 @@ void MarbleModel::setPersistentTileCacheLimit(quint64 kiloBytes)
     {
         d->m_storageWatcher.quit();
     }
-    // TODO: trigger update
 }
 
 void MarbleModel::setTrackedPlacemark( const GeoDataPlacemark *placemark )
@@ -831,8 +825,8 @@ void MarbleModelPrivate::assignFillColors( const QString &filePath ) {
 
                         if ( !colors.isEmpty() ) {
                             qreal alpha = data->alpha();
-                            QVector<GeoDataFeature*>::iterator it = doc->begin();
-                            QVector<GeoDataFeature*>::iterator const itEnd = doc->end();
+                            QVector<GeoDataFeature*>::ConstIterator it = doc->constBegin();
+                            QVector<GeoDataFeature*>::ConstIterator const itEnd = doc->constEnd();
                             for ( ; it != itEnd; ++it ) {
                                 GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>( *it );
                                 if ( placemark ) {
@@ -874,8 +868,8 @@ void MarbleModelPrivate::assignFillColors( const QString &filePath ) {
                             doc->addStyle( style );
                             doc->addStyleMap( styleMap );
 
-                            QVector<GeoDataFeature*>::iterator iter = doc->begin();
-                            QVector<GeoDataFeature*>::iterator const end = doc->end();
+                            QVector<GeoDataFeature*>::ConstIterator iter = doc->constBegin();
+                            QVector<GeoDataFeature*>::ConstIterator const end = doc->constEnd();
 
                             for ( ; iter != end; ++iter ) {
                                 if ( (*iter)->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
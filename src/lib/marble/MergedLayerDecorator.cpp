@@ -342,7 +342,7 @@ RenderState MergedLayerDecorator::renderState( const TileId &stackedTileId ) con
         const TileId tileId( layer->sourceDir(), stackedTileId.zoomLevel(),
                              stackedTileId.x(), stackedTileId.y() );
         RenderStatus tileStatus = Complete;
-        switch ( TileLoader::tileStatus( layer, tileId ) ) {
+        switch ( d->m_tileLoader->tileStatus( layer, tileId ) ) {
         case TileLoader::Available:
             tileStatus = Complete;
             break;
@@ -389,12 +389,19 @@ void MergedLayerDecorator::downloadStackedTile( const TileId &id, DownloadUsage
     const QVector<const GeoSceneTextureTileDataset *> textureLayers = d->findRelevantTextureLayers( id );
 
     foreach ( const GeoSceneTextureTileDataset *textureLayer, textureLayers ) {
-        if ( TileLoader::tileStatus( textureLayer, id ) != TileLoader::Available || usage == DownloadBrowse ) {
+        if ( d->m_tileLoader->tileStatus( textureLayer, id ) != TileLoader::Available || usage == DownloadBrowse ) {
             d->m_tileLoader->downloadTile( textureLayer, id, usage );
         }
     }
 }
 
+void MergedLayerDecorator::setVisibleStackedTiles( const QVector<TileId> &stackedTileIds, const GeoDataCoordinates &center )
+{
+    foreach ( const GeoSceneTextureTileDataset *textureLayer, d->m_textureLayers ) {
+        d->m_tileLoader->setVisibleTiles( textureLayer, stackedTileIds, center );
+    }
+}
+
 void MergedLayerDecorator::setShowSunShading( bool show )
 {
     d->m_showSunShading = show;
@@ -29,6 +29,7 @@ class QString;
 namespace Marble
 {
 
+class GeoDataCoordinates;
 class GeoDataGroundOverlay;
 class SunLocator;
 class StackedTile;
@@ -67,6 +68,12 @@ class MergedLayerDecorator
 
     void downloadStackedTile( const TileId &id, DownloadUsage usage );
 
+    /**
+     * Reports the stacked tiles on display to the tile loader, which reorders
+     * or cancels pending downloads of all texture layers accordingly.
+     */
+    void setVisibleStackedTiles( const QVector<TileId> &stackedTileIds, const GeoDataCoordinates &center );
+
     void setShowSunShading( bool show );
     bool showSunShading() const;
 
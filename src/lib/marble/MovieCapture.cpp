@@ -10,11 +10,18 @@
 //
 
 #include "MovieCapture.h"
+#include "GeoPainter.h"
+#include "MarbleMap.h"
 #include "MarbleWidget.h"
 #include "MarbleDebug.h"
+#include "MovieCaptureWriter.h"
 
-#include <QProcess>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
 #include <QMessageBox>
+#include <QProcess>
+#include <QThread>
 
 namespace Marble
 {
@@ -23,9 +30,28 @@ class MovieCapturePrivate
 {
 public:
     explicit MovieCapturePrivate(MarbleWidget *widget) :
-        marbleWidget(widget), method(MovieCapture::TimeDriven)
+        marbleWidget(widget), map(0), writer(0), method(MovieCapture::TimeDriven)
     {}
 
+    ~MovieCapturePrivate()
+    {
+        if (writer) {
+            writer->cancel();
+            writer->wait();
+            delete writer;
+        }
+        delete map;
+    }
+
+    /**
+     * Renders the current view of the widget with a map of its own on the
+     * model of the widget, so repaints and animations of the widget do not
+     * end up in the movie. Data driven recordings wait until all tiles and
+     * data of the frame are loaded, which makes each fixed timestep of the
+     * tour result in the same frame.
+     */
+    QImage renderFrame();
+
     /**
      * @brief This gets called when user doesn't have avconv/ffmpeg installed
      */
@@ -41,13 +67,62 @@ public:
 
     QTimer frameTimer;
     MarbleWidget *marbleWidget;
+    MarbleMap *map;
     QString encoderExec;
     QString destinationFile;
-    QProcess process;
+    MovieCaptureWriter *writer;
+    QElapsedTimer rateTimer;
+    qint64 rateBytesWritten;
     MovieCapture::SnapshotMethod method;
     int fps;
 };
 
+QImage MovieCapturePrivate::renderFrame()
+{
+    if (!map) {
+        map = new MarbleMap(marbleWidget->model());
+    }
+
+    if (map->mapThemeId() != marbleWidget->mapThemeId()) {
+        map->setMapThemeId(marbleWidget->mapThemeId());
+    }
+    map->setSize(marbleWidget->size());
+    map->setProjection(marbleWidget->projection());
+    map->setRadius(marbleWidget->radius());
+    map->centerOn(marbleWidget->centerLongitude(), marbleWidget->centerLatitude());
+    map->setShowAtmosphere(marbleWidget->showAtmosphere());
+    map->setShowClouds(marbleWidget->showClouds());
+    map->setShowSunShading(marbleWidget->showSunShading());
+    map->setShowCityLights(marbleWidget->showCityLights());
+    map->setShowGrid(marbleWidget->showGrid());
+    map->setShowCrosshairs(marbleWidget->showCrosshairs());
+    map->setShowCompass(marbleWidget->showCompass());
+    map->setShowScaleBar(marbleWidget->showScaleBar());
+    map->setShowOverviewMap(marbleWidget->showOverviewMap());
+    map->setMapQualityForViewContext(marbleWidget->mapQuality(Still), Still);
+    map->setViewContext(Still);
+
+    QImage frame(map->size(), QImage::Format_RGB32);
+    frame.fill(Qt::black);
+    {
+        GeoPainter painter(&frame, map->viewport(), map->mapQuality());
+        map->paint(painter, QRect());
+    }
+
+    // tiles and data arrive through the event loop
+    QElapsedTimer wait;
+    wait.start();
+    while (method == MovieCapture::DataDriven && map->renderStatus() != Complete && wait.elapsed() < 10000) {
+        QThread::msleep(10);
+        QCoreApplication::processEvents();
+        frame.fill(Qt::black);
+        GeoPainter painter(&frame, map->viewport(), map->mapQuality());
+        map->paint(painter, QRect());
+    }
+
+    return frame;
+}
+
 MovieCapture::MovieCapture(MarbleWidget *widget, QObject *parent) :
     QObject(parent),
     d_ptr(new MovieCapturePrivate(widget))
@@ -125,7 +200,12 @@ QList<MovieFormat> MovieCapture::availableFormats()
             }
         }
     }
-    return availableFormats;
+
+    // written by Marble itself, available without avconv/ffmpeg
+    QList<MovieFormat> formats = availableFormats;
+    formats << MovieFormat( "yuv4mpegpipe", tr( "YUV4MPEG2 (uncompressed)" ), "y4m" );
+    formats << MovieFormat( "image2", tr( "PNG image sequence" ), "png" );
+    return formats;
 }
 
 MovieCapture::SnapshotMethod MovieCapture::snapshotMethod() const
@@ -160,32 +240,31 @@ bool MovieCapture::checkToolsAvailability()
 void MovieCapture::recordFrame()
 {
     Q_D(MovieCapture);
-    QImage const screenshot = d->marbleWidget->mapScreenShot().toImage().convertToFormat(QImage::Format_RGB888);
-    if (d->process.state() == QProcess::NotRunning) {
-        QStringList const arguments = QStringList()
-                << "-y"
-                << "-r" << QString::number(fps())
-                << "-f" << "rawvideo"
-                << "-pix_fmt" << "rgb24"
-                << "-s" << QString("%1x%2").arg( screenshot.width() ).arg( screenshot.height() )
-                << "-i" << "pipe:"
-                << "-b" << "2000k"
-                << d->destinationFile;
-        d->process.start( d->encoderExec, arguments );
-        connect(&d->process, SIGNAL(finished(int)), this, SLOT(processWrittenMovie(int)));
-    }
-    d->process.write( (char*) screenshot.bits(), screenshot.byteCount() );
-
-    for (int i=0; i<30 && d->process.bytesToWrite()>0; ++i) {
-        QTime t;
-        int then = d->process.bytesToWrite();
-        t.start();
-        d->process.waitForBytesWritten( 100 );
-        int span = t.elapsed();
-        int now = d->process.bytesToWrite();
-        int bytesWritten = then - now;
-        double rate = ( bytesWritten * 1000.0 ) / ( qMax(1, span) * 1024 );
+
+    if (!d->writer) {
+        d->writer = new MovieCaptureWriter(d->destinationFile, d->encoderExec, fps());
+        connect(d->writer, SIGNAL(finished()), this, SLOT(finishWriting()));
+        d->writer->start();
+        d->rateTimer.start();
+        d->rateBytesWritten = 0;
+    }
+
+    // The conversion to the pixel format of the output happens in the
+    // writer thread.
+    QImage const frame = d->renderFrame();
+    if (!d->writer) {
+        // canceled while waiting for data
+        return;
+    }
+    d->writer->enqueue(frame);
+
+    qint64 const elapsed = d->rateTimer.elapsed();
+    if (elapsed >= 500) {
+        qint64 const bytesWritten = d->writer->bytesWritten();
+        double const rate = ( ( bytesWritten - d->rateBytesWritten ) * 1000.0 ) / ( elapsed * 1024 );
         emit rateCalculated( rate );
+        d->rateBytesWritten = bytesWritten;
+        d->rateTimer.restart();
     }
 }
 
@@ -193,15 +272,24 @@ bool MovieCapture::startRecording()
 {
     Q_D(MovieCapture);
 
-    if( !checkToolsAvailability() ) {
+    if( MovieCaptureWriter::output(d->destinationFile) == MovieCaptureWriter::Encoder
+        && !checkToolsAvailability() ) {
         d->missingToolsWarning();
         return false;
     }
 
+    if (d->writer) {
+        // a previous recording which was not stopped ends here, the new
+        // one starts once its remaining frames are written
+        d->writer->finish();
+        d->writer->wait();
+        finishWriting();
+    }
+
     if( d->method == MovieCapture::TimeDriven ){
         d->frameTimer.start();
+        recordFrame();
     }
-    recordFrame();
     return true;
 }
 
@@ -210,7 +298,9 @@ void MovieCapture::stopRecording()
     Q_D(MovieCapture);
 
     d->frameTimer.stop();
-    d->process.closeWriteChannel();
+    if (d->writer) {
+        d->writer->finish();
+    }
 }
 
 void MovieCapture::cancelRecording()
@@ -218,8 +308,12 @@ void MovieCapture::cancelRecording()
     Q_D(MovieCapture);
 
     d->frameTimer.stop();
-    d->process.close();
-    QFile::remove( d->destinationFile );
+    if (d->writer) {
+        d->writer->cancel();
+        d->writer->wait();
+        delete d->writer;
+        d->writer = 0;
+    }
 }
 
 void MovieCapture::processWrittenMovie(int exitCode)
@@ -230,6 +324,21 @@ void MovieCapture::processWrittenMovie(int exitCode)
     }
 }
 
+void MovieCapture::finishWriting()
+{
+    Q_D(MovieCapture);
+
+    if (d->writer && d->writer->isFinished()) {
+        bool const failed = d->writer->hasFailed();
+        int const exitCode = d->writer->exitCode();
+        delete d->writer;
+        d->writer = 0;
+        if (failed) {
+            processWrittenMovie(exitCode != 0 ? exitCode : -1);
+        }
+    }
+}
+
 } // namespace Marble
 
 #include "moc_MovieCapture.cpp"
@@ -67,6 +67,7 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void processWrittenMovie(int exitCode);
+    void finishWriting();
 
 Q_SIGNALS:
     void rateCalculated( double );
@@ -0,0 +1,351 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "MovieCaptureWriter.h"
+
+#include "MarbleDebug.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QProcess>
+
+namespace Marble
+{
+
+    MovieCaptureWriter( const QString &destination, const QString &encoderExec, int fps );
+
+    static Output output( const QString &destination );
+
+    /** Queues @p frame, blocks while the queue is full. */
+    bool enqueue( const QImage &frame );
+
+    /** Writes the queued frames, then stops. */
+    void finish();
+
+    /** Stops as soon as possible and removes everything written so far. */
+    void cancel();
+
+    bool hasFailed() const;
+    int exitCode() const;
+    qint64 bytesWritten() const;
+
+protected:
+    void run();
+
+private:
+    bool takeFrame( QImage *frame );
+    void fail( int exitCode );
+    void addBytesWritten( qint64 bytes );
+
+    bool writeToEncoder( QProcess &process, const QImage &frame );
+    bool writeY4M( QFile &file, const QImage &frame );
+    bool writeImage( const QImage &frame, int index );
+    QString imageFileName( int index ) const;
+
+    static const int maximumQueueSize = 8;
+
+    QString const m_destination;
+    QString const m_encoderExec;
+    int const m_fps;
+    Output const m_output;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_frameAvailable;
+    QWaitCondition m_spaceAvailable;
+    QQueue<QImage> m_frames;
+    bool m_finishing;
+    bool m_canceled;
+    bool m_failed;
+    int m_exitCode;
+    qint64 m_bytesWritten;
+};
+
+MovieCaptureWriter::MovieCaptureWriter( const QString &destination, const QString &encoderExec, int fps ) :
+    m_destination( destination ),
+    m_encoderExec( encoderExec ),
+    m_fps( fps ),
+    m_output( output( destination ) ),
+    m_finishing( false ),
+    m_canceled( false ),
+    m_failed( false ),
+    m_exitCode( 0 ),
+    m_bytesWritten( 0 )
+{
+    // nothing to do
+}
+
+MovieCaptureWriter::Output MovieCaptureWriter::output( const QString &destination )
+{
+    QString const suffix = QFileInfo( destination ).suffix().toLower();
+    if ( suffix == "y4m" ) {
+        return Y4M;
+    } else if ( suffix == "png" ) {
+        return ImageSequence;
+    }
+    return Encoder;
+}
+
+bool MovieCaptureWriter::enqueue( const QImage &frame )
+{
+    QMutexLocker locker( &m_mutex );
+    while ( m_frames.size() >= maximumQueueSize && !m_failed && !m_canceled ) {
+        m_spaceAvailable.wait( &m_mutex );
+    }
+
+    if ( m_failed || m_canceled || m_finishing ) {
+        return false;
+    }
+
+    m_frames.enqueue( frame );
+    m_frameAvailable.wakeOne();
+    return true;
+}
+
+void MovieCaptureWriter::finish()
+{
+    QMutexLocker locker( &m_mutex );
+    m_finishing = true;
+    m_frameAvailable.wakeOne();
+}
+
+void MovieCaptureWriter::cancel()
+{
+    QMutexLocker locker( &m_mutex );
+    m_canceled = true;
+    m_frames.clear();
+    m_frameAvailable.wakeOne();
+    m_spaceAvailable.wakeAll();
+}
+
+bool MovieCaptureWriter::hasFailed() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_failed;
+}
+
+int MovieCaptureWriter::exitCode() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_exitCode;
+}
+
+qint64 MovieCaptureWriter::bytesWritten() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_bytesWritten;
+}
+
+bool MovieCaptureWriter::takeFrame( QImage *frame )
+{
+    QMutexLocker locker( &m_mutex );
+    while ( m_frames.isEmpty() && !m_finishing && !m_canceled ) {
+        m_frameAvailable.wait( &m_mutex );
+    }
+
+    if ( m_frames.isEmpty() || m_canceled ) {
+        return false;
+    }
+
+    *frame = m_frames.dequeue();
+    m_spaceAvailable.wakeOne();
+    return true;
+}
+
+void MovieCaptureWriter::fail( int exitCode )
+{
+    QMutexLocker locker( &m_mutex );
+    m_failed = true;
+    m_exitCode = exitCode;
+    m_frames.clear();
+    m_spaceAvailable.wakeAll();
+}
+
+void MovieCaptureWriter::addBytesWritten( qint64 bytes )
+{
+    QMutexLocker locker( &m_mutex );
+    m_bytesWritten += bytes;
+}
+
+void MovieCaptureWriter::run()
+{
+    QProcess process;
+    QFile file( m_destination );
+    QSize size;
+    int index = 0;
+
+    QImage frame;
+    while ( takeFrame( &frame ) ) {
+        if ( size.isEmpty() ) {
+            // the first frame determines the size of the movie
+            size = frame.size();
+            if ( m_output == Encoder ) {
+                QStringList const arguments = QStringList()
+                        << "-y"
+                        << "-r" << QString::number( m_fps )
+                        << "-f" << "rawvideo"
+                        << "-pix_fmt" << "rgb24"
+                        << "-s" << QString( "%1x%2" ).arg( size.width() ).arg( size.height() )
+                        << "-i" << "pipe:"
+                        << "-b" << "2000k"
+                        << m_destination;
+                process.start( m_encoderExec, arguments );
+                if ( !process.waitForStarted() ) {
+                    mDebug() << "Cannot start" << m_encoderExec;
+                    fail( -1 );
+                    return;
+                }
+            } else if ( m_output == Y4M && !file.open( QIODevice::WriteOnly ) ) {
+                mDebug() << "Cannot write" << m_destination;
+                fail( -1 );
+                return;
+            }
+        } else if ( frame.size() != size ) {
+            // neither of the outputs can change the size on the fly
+            frame = frame.scaled( size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+        }
+
+        bool written = false;
+        switch ( m_output ) {
+        case Encoder:
+            written = writeToEncoder( process, frame );
+            break;
+        case Y4M:
+            written = writeY4M( file, frame );
+            break;
+        case ImageSequence:
+            written = writeImage( frame, index );
+            break;
+        }
+        ++index;
+
+        if ( !written ) {
+            fail( m_output == Encoder && process.state() == QProcess::NotRunning ? process.exitCode() : -1 );
+            break;
+        }
+    }
+
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( m_canceled ) {
+            locker.unlock();
+            process.kill();
+            process.waitForFinished();
+            file.close();
+            QFile::remove( m_destination );
+            for ( int i = 0; i < index; ++i ) {
+                QFile::remove( imageFileName( i ) );
+            }
+            return;
+        }
+    }
+
+    if ( process.state() != QProcess::NotRunning ) {
+        process.closeWriteChannel();
+        process.waitForFinished( -1 );
+        if ( !hasFailed() && ( process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0 ) ) {
+            fail( process.exitStatus() == QProcess::NormalExit ? process.exitCode() : -1 );
+        }
+    }
+}
+
+bool MovieCaptureWriter::writeToEncoder( QProcess &process, const QImage &frame )
+{
+    QImage const rgb = frame.convertToFormat( QImage::Format_RGB888 );
+    int const lineLength = rgb.width() * 3;
+    for ( int y = 0; y < rgb.height(); ++y ) {
+        // scan lines are padded to four bytes, the encoder expects them packed
+        if ( process.write( reinterpret_cast<const char*>( rgb.constScanLine( y ) ), lineLength ) != lineLength ) {
+            return false;
+        }
+    }
+
+    while ( process.bytesToWrite() > 0 ) {
+        if ( !process.waitForBytesWritten( 1000 ) && process.state() == QProcess::NotRunning ) {
+            return false;
+        }
+    }
+
+    addBytesWritten( qint64( lineLength ) * rgb.height() );
+    return true;
+}
+
+bool MovieCaptureWriter::writeY4M( QFile &file, const QImage &frame )
+{
+    int const width = frame.width();
+    int const height = frame.height();
+    int const chromaWidth = ( width + 1 ) / 2;
+    int const chromaHeight = ( height + 1 ) / 2;
+
+    QByteArray data;
+    if ( file.pos() == 0 ) {
+        data += QString( "YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C420jpeg\n" )
+                .arg( width ).arg( height ).arg( m_fps ).toLatin1();
+    }
+    data += "FRAME\n";
+    int const headerSize = data.size();
+    data.resize( headerSize + width * height + 2 * chromaWidth * chromaHeight );
+
+    QImage const rgb = frame.convertToFormat( QImage::Format_RGB32 );
+
+    // ITU-R BT.601 with studio swing, chroma is averaged over 2x2 pixels
+    uchar *luma = reinterpret_cast<uchar*>( data.data() ) + headerSize;
+    for ( int y = 0; y < height; ++y ) {
+        const QRgb *line = reinterpret_cast<const QRgb*>( rgb.constScanLine( y ) );
+        for ( int x = 0; x < width; ++x ) {
+            QRgb const pixel = line[x];
+            *luma++ = ( ( 66 * qRed( pixel ) + 129 * qGreen( pixel ) + 25 * qBlue( pixel ) + 128 ) >> 8 ) + 16;
+        }
+    }
+
+    uchar *cb = luma;
+    uchar *cr = cb + chromaWidth * chromaHeight;
+    for ( int y = 0; y < height; y += 2 ) {
+        const QRgb *line0 = reinterpret_cast<const QRgb*>( rgb.constScanLine( y ) );
+        const QRgb *line1 = reinterpret_cast<const QRgb*>( rgb.constScanLine( qMin( y + 1, height - 1 ) ) );
+        for ( int x = 0; x < width; x += 2 ) {
+            int const x1 = qMin( x + 1, width - 1 );
+            int const red = ( qRed( line0[x] ) + qRed( line0[x1] ) + qRed( line1[x] ) + qRed( line1[x1] ) + 2 ) / 4;
+            int const green = ( qGreen( line0[x] ) + qGreen( line0[x1] ) + qGreen( line1[x] ) + qGreen( line1[x1] ) + 2 ) / 4;
+            int const blue = ( qBlue( line0[x] ) + qBlue( line0[x1] ) + qBlue( line1[x] ) + qBlue( line1[x1] ) + 2 ) / 4;
+            *cb++ = ( ( -38 * red - 74 * green + 112 * blue + 128 ) >> 8 ) + 128;
+            *cr++ = ( ( 112 * red - 94 * green - 18 * blue + 128 ) >> 8 ) + 128;
+        }
+    }
+
+    if ( file.write( data ) != data.size() ) {
+        return false;
+    }
+
+    addBytesWritten( data.size() );
+    return true;
+}
+
+bool MovieCaptureWriter::writeImage( const QImage &frame, int index )
+{
+    QString const fileName = imageFileName( index );
+    if ( !frame.save( fileName, "PNG" ) ) {
+        mDebug() << "Cannot write" << fileName;
+        return false;
+    }
+
+    addBytesWritten( QFileInfo( fileName ).size() );
+    return true;
+}
+
+QString MovieCaptureWriter::imageFileName( int index ) const
+{
+    // tour.png becomes tour_000000.png, tour_000001.png, ...
+    QFileInfo const info( m_destination );
+    return QString( "%1/%2_%3.%4" ).arg( info.path() ).arg( info.completeBaseName() )
+            .arg( index, 6, 10, QLatin1Char( '0' ) ).arg( info.suffix() );
+}
+
+}
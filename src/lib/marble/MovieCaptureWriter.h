@@ -0,0 +1,46 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_MOVIECAPTUREWRITER_H
+#define MARBLE_MOVIECAPTUREWRITER_H
+
+#include "marble_export.h"
+
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+class QFile;
+class QProcess;
+
+namespace Marble
+{
+
+/**
+ * Converts and writes the recorded frames in a thread of its own.
+ *
+ * Frames are passed through a bounded queue: recording blocks once the
+ * writer falls behind by more than a few frames, so no frame is dropped
+ * and memory use stays constant.
+ */
+class MARBLE_EXPORT MovieCaptureWriter : public QThread
+{
+public:
+    enum Output {
+        Encoder,        ///< rgb24 frames piped to avconv/ffmpeg
+        Y4M,            ///< uncompressed YUV 4:2:0 in a YUV4MPEG2 stream
+        ImageSequence   ///< one image file per frame
+    };
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "NavigationRecorder.h"
+
+#include "MarbleDebug.h"
+#include "MarbleWidget.h"
+#include "ViewportParams.h"
+
+namespace Marble
+{
+
+NavigationRecorder::NavigationRecorder( MarbleWidget *widget, QObject *parent ) :
+    QObject( parent ),
+    m_widget( widget ),
+    m_recording( false ),
+    m_unsaved( false )
+{
+    m_saveTimer.setInterval( 5000 );
+    connect( &m_saveTimer, SIGNAL(timeout()), this, SLOT(save()) );
+
+    // the visible box changes with the center, radius and size of the map
+    connect( widget, SIGNAL(visibleLatLonAltBoxChanged(GeoDataLatLonAltBox)), this, SLOT(recordFrame()) );
+    connect( widget, SIGNAL(projectionChanged(Projection)), this, SLOT(recordFrame()) );
+    connect( widget, SIGNAL(themeChanged(QString)), this, SLOT(recordFrame()) );
+}
+
+bool NavigationRecorder::isRecording() const
+{
+    return m_recording;
+}
+
+const NavigationTrace &NavigationRecorder::trace() const
+{
+    return m_trace;
+}
+
+void NavigationRecorder::setFileName( const QString &fileName )
+{
+    m_fileName = fileName;
+    m_unsaved = !m_trace.frames().isEmpty();
+    if ( m_recording && !m_fileName.isEmpty() ) {
+        m_saveTimer.start();
+    } else {
+        m_saveTimer.stop();
+    }
+}
+
+QString NavigationRecorder::fileName() const
+{
+    return m_fileName;
+}
+
+void NavigationRecorder::start()
+{
+    m_trace.clear();
+    m_timer.start();
+    m_recording = true;
+    if ( !m_fileName.isEmpty() ) {
+        m_saveTimer.start();
+    }
+    recordFrame();
+}
+
+void NavigationRecorder::stop()
+{
+    m_recording = false;
+    m_saveTimer.stop();
+}
+
+bool NavigationRecorder::save()
+{
+    if ( m_fileName.isEmpty() ) {
+        return false;
+    }
+    if ( !m_unsaved ) {
+        return true;
+    }
+
+    if ( !m_trace.save( m_fileName ) ) {
+        mDebug() << "Failed to save the navigation trace to" << m_fileName;
+        return false;
+    }
+    m_unsaved = false;
+    return true;
+}
+
+void NavigationRecorder::recordFrame()
+{
+    if ( !m_recording || !m_widget ) {
+        return;
+    }
+
+    const ViewportParams *viewport = m_widget->viewport();
+    NavigationTrace::Frame frame;
+    frame.msecs = m_timer.elapsed();
+    frame.lon = viewport->centerLongitude() * RAD2DEG;
+    frame.lat = viewport->centerLatitude() * RAD2DEG;
+    frame.radius = viewport->radius();
+    frame.projection = viewport->projection();
+    frame.size = viewport->size();
+    frame.mapThemeId = m_widget->mapThemeId();
+
+    // several signals are emitted for a single change of the view
+    if ( !m_trace.frames().isEmpty() && m_trace.frames().last() == frame ) {
+        return;
+    }
+
+    m_trace.append( frame );
+    m_unsaved = true;
+}
+
+}
+
+#include "moc_NavigationRecorder.cpp"
@@ -0,0 +1,74 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_NAVIGATIONRECORDER_H
+#define MARBLE_NAVIGATIONRECORDER_H
+
+#include "marble_export.h"
+#include "NavigationTrace.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+namespace Marble
+{
+
+class MarbleWidget;
+
+/**
+ * Records every change of the view of a MarbleWidget, be it caused by
+ * input handlers, kinetic scrolling or animations, into a NavigationTrace.
+ */
+class MARBLE_EXPORT NavigationRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NavigationRecorder( MarbleWidget *widget, QObject *parent = 0 );
+
+    bool isRecording() const;
+    const NavigationTrace &trace() const;
+
+    /**
+     * Sets the file the trace is saved to. While recording, new frames are
+     * saved every few seconds, so that the trace survives a crash.
+     */
+    void setFileName( const QString &fileName );
+    QString fileName() const;
+
+public Q_SLOTS:
+    /** Clears the trace and starts recording with the current view. */
+    void start();
+    void stop();
+
+    /**
+     * Saves the trace to fileName() unless it did not change since it was
+     * saved last. Returns false if the trace could not be saved.
+     */
+    bool save();
+
+private Q_SLOTS:
+    void recordFrame();
+
+private:
+    QPointer<MarbleWidget> m_widget;
+    NavigationTrace m_trace;
+    QElapsedTimer m_timer;
+    bool m_recording;
+    QString m_fileName;
+    QTimer m_saveTimer;
+    bool m_unsaved;
+};
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "NavigationReplayer.h"
+
+#include "GeoPainter.h"
+#include "MarbleMap.h"
+#include "NavigationTrace.h"
+#include "RenderState.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QThread>
+#include <qmath.h>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+namespace
+{
+    /**
+     * Adds the stacked tiles of @p state that wait for any of their texture
+     * layers to @p tiles, and other layers waiting for data to @p other.
+     * Stacked tiles are named after MergedLayerDecorator::renderState().
+     */
+    void countMissing( const RenderState &state, int &tiles, int &other )
+    {
+        if ( state.name().startsWith( QLatin1String( "Tile " ) ) ) {
+            tiles += state.status() == WaitingForData ? 1 : 0;
+            return;
+        }
+
+        if ( state.children() == 0 ) {
+            other += state.status() == WaitingForData ? 1 : 0;
+            return;
+        }
+
+        for ( int i = 0; i < state.children(); ++i ) {
+            countMissing( state.childAt( i ), tiles, other );
+        }
+    }
+}
+
+NavigationReplayer::NavigationReplayer( MarbleMap *map ) :
+    m_map( map ),
+    m_incompleteFrames( 0 ),
+    m_tileMisses( 0 )
+{
+    // nothing to do
+}
+
+void NavigationReplayer::replay( const NavigationTrace &trace, bool waitForData )
+{
+    m_frameTimes.clear();
+    m_frameTimes.reserve( trace.frames().size() );
+    m_incompleteFrames = 0;
+    m_tileMisses = 0;
+
+    QImage image;
+    QElapsedTimer timer;
+    foreach ( const NavigationTrace::Frame &frame, trace.frames() ) {
+        if ( !frame.mapThemeId.isEmpty() && frame.mapThemeId != m_map->mapThemeId() ) {
+            m_map->setMapThemeId( frame.mapThemeId );
+        }
+        if ( image.size() != frame.size ) {
+            image = QImage( frame.size, QImage::Format_ARGB32_Premultiplied );
+        }
+
+        timer.start();
+        m_map->setSize( frame.size );
+        m_map->setProjection( frame.projection );
+        m_map->setRadius( frame.radius );
+        m_map->centerOn( frame.lon, frame.lat );
+        {
+            GeoPainter painter( &image, m_map->viewport(), m_map->mapQuality() );
+            m_map->paint( painter, QRect() );
+        }
+        m_frameTimes << timer.nsecsElapsed() / 1000000.0;
+
+        int tiles = 0;
+        int other = 0;
+        countMissing( m_map->renderState(), tiles, other );
+        if ( tiles + other > 0 ) {
+            ++m_incompleteFrames;
+            m_tileMisses += tiles;
+        }
+
+        // tiles and data arrive through the event loop
+        QCoreApplication::processEvents();
+        QElapsedTimer wait;
+        wait.start();
+        while ( waitForData && m_map->renderStatus() != Complete && wait.elapsed() < 10000 ) {
+            QThread::msleep( 10 );
+            QCoreApplication::processEvents();
+            GeoPainter painter( &image, m_map->viewport(), m_map->mapQuality() );
+            m_map->paint( painter, QRect() );
+        }
+    }
+
+    m_sortedFrameTimes = m_frameTimes;
+    std::sort( m_sortedFrameTimes.begin(), m_sortedFrameTimes.end() );
+}
+
+const QVector<qreal> &NavigationReplayer::frameTimes() const
+{
+    return m_frameTimes;
+}
+
+qreal NavigationReplayer::percentile( qreal percent ) const
+{
+    if ( m_sortedFrameTimes.isEmpty() ) {
+        return 0.0;
+    }
+
+    // nearest rank
+    int const rank = qCeil( qBound<qreal>( 0.0, percent, 100.0 ) / 100.0 * m_sortedFrameTimes.size() );
+    return m_sortedFrameTimes.at( qBound( 0, rank - 1, m_sortedFrameTimes.size() - 1 ) );
+}
+
+int NavigationReplayer::incompleteFrames() const
+{
+    return m_incompleteFrames;
+}
+
+int NavigationReplayer::tileMisses() const
+{
+    return m_tileMisses;
+}
+
+}
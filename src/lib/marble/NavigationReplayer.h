@@ -0,0 +1,65 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_NAVIGATIONREPLAYER_H
+#define MARBLE_NAVIGATIONREPLAYER_H
+
+#include "marble_export.h"
+
+#include <QVector>
+
+namespace Marble
+{
+
+class MarbleMap;
+class NavigationTrace;
+
+/**
+ * Paints all frames of a NavigationTrace with a MarbleMap as fast as
+ * possible, ignoring the recorded timestamps, and measures each frame.
+ */
+class MARBLE_EXPORT NavigationReplayer
+{
+public:
+    explicit NavigationReplayer( MarbleMap *map );
+
+    /**
+     * Replays @p trace. If @p waitForData is set, the event loop runs until
+     * all tiles of a frame are loaded before the next one is painted, which
+     * makes the output deterministic but the timings include loading.
+     */
+    void replay( const NavigationTrace &trace, bool waitForData = false );
+
+    /** Paint times of all frames of the last replay in ms. */
+    const QVector<qreal> &frameTimes() const;
+
+    /** Returns the paint time in ms that @p percent of all frames did not exceed. */
+    qreal percentile( qreal percent ) const;
+
+    /** Number of frames painted while some of their tiles or data were missing. */
+    int incompleteFrames() const;
+
+    /**
+     * Sum of the tiles that were missing, over all frames. A tile counts once,
+     * no matter how many of its texture layers were missing.
+     */
+    int tileMisses() const;
+
+private:
+    MarbleMap *const m_map;
+    QVector<qreal> m_frameTimes;
+    QVector<qreal> m_sortedFrameTimes;
+    int m_incompleteFrames;
+    int m_tileMisses;
+};
+
+}
+
+#endif
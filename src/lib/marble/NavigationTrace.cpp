@@ -0,0 +1,208 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "NavigationTrace.h"
+
+#include "MarbleDebug.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+namespace Marble
+{
+
+namespace
+{
+    quint32 const traceMagic = 0x4d4e5654; // "MNVT"
+    quint16 const traceVersion = 1;
+
+    // which properties are stored in a frame record
+    enum FrameField {
+        CenterField = 0x01,
+        RadiusField = 0x02,
+        ProjectionField = 0x04,
+        SizeField = 0x08,
+        MapThemeField = 0x10
+    };
+}
+
+NavigationTrace::Frame::Frame() :
+    msecs( 0 ),
+    lon( 0.0 ),
+    lat( 0.0 ),
+    radius( 0 ),
+    projection( Spherical )
+{
+    // nothing to do
+}
+
+bool NavigationTrace::Frame::operator==( const Frame &other ) const
+{
+    return lon == other.lon && lat == other.lat
+        && radius == other.radius
+        && projection == other.projection
+        && size == other.size
+        && mapThemeId == other.mapThemeId;
+}
+
+void NavigationTrace::append( const Frame &frame )
+{
+    m_frames.append( frame );
+}
+
+const QVector<NavigationTrace::Frame> &NavigationTrace::frames() const
+{
+    return m_frames;
+}
+
+void NavigationTrace::clear()
+{
+    m_frames.clear();
+}
+
+qint64 NavigationTrace::duration() const
+{
+    return m_frames.isEmpty() ? 0 : m_frames.last().msecs - m_frames.first().msecs;
+}
+
+bool NavigationTrace::save( QIODevice *device ) const
+{
+    QDataStream stream( device );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream << traceMagic << traceVersion << quint32( m_frames.size() );
+
+    Frame previous;
+    previous.radius = -1;
+    foreach ( const Frame &frame, m_frames ) {
+        quint8 fields = 0;
+        if ( frame.lon != previous.lon || frame.lat != previous.lat ) {
+            fields |= CenterField;
+        }
+        if ( frame.radius != previous.radius ) {
+            fields |= RadiusField;
+        }
+        if ( frame.projection != previous.projection ) {
+            fields |= ProjectionField;
+        }
+        if ( frame.size != previous.size ) {
+            fields |= SizeField;
+        }
+        if ( frame.mapThemeId != previous.mapThemeId ) {
+            fields |= MapThemeField;
+        }
+
+        stream << fields << quint32( qBound<qint64>( 0, frame.msecs - previous.msecs, 0xffffffff ) );
+        if ( fields & CenterField ) {
+            stream << double( frame.lon ) << double( frame.lat );
+        }
+        if ( fields & RadiusField ) {
+            stream << qint32( frame.radius );
+        }
+        if ( fields & ProjectionField ) {
+            stream << quint8( frame.projection );
+        }
+        if ( fields & SizeField ) {
+            stream << quint16( frame.size.width() ) << quint16( frame.size.height() );
+        }
+        if ( fields & MapThemeField ) {
+            stream << frame.mapThemeId;
+        }
+
+        previous = frame;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool NavigationTrace::save( const QString &fileName ) const
+{
+    // a trace saved while recording must not be lost if saving is interrupted
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) || !save( &file ) || !file.commit() ) {
+        mDebug() << "Cannot write navigation trace" << fileName << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool NavigationTrace::load( QIODevice *device )
+{
+    m_frames.clear();
+
+    QDataStream stream( device );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    quint32 magic;
+    quint16 version;
+    quint32 count;
+    stream >> magic >> version >> count;
+    if ( stream.status() != QDataStream::Ok || magic != traceMagic || version != traceVersion ) {
+        mDebug() << "Not a navigation trace of a supported version";
+        return false;
+    }
+
+    // The count comes from the file, so it only reserves what the remaining
+    // data can hold: each frame takes at least its fields and time delta.
+    qint64 const minimumFrameSize = sizeof( quint8 ) + sizeof( quint32 );
+    m_frames.reserve( int( qMin<qint64>( count, device->bytesAvailable() / minimumFrameSize ) ) );
+    Frame frame;
+    for ( quint32 i = 0; i < count; ++i ) {
+        quint8 fields;
+        quint32 delta;
+        stream >> fields >> delta;
+        frame.msecs += delta;
+        if ( fields & CenterField ) {
+            double lon, lat;
+            stream >> lon >> lat;
+            frame.lon = lon;
+            frame.lat = lat;
+        }
+        if ( fields & RadiusField ) {
+            qint32 radius;
+            stream >> radius;
+            frame.radius = radius;
+        }
+        if ( fields & ProjectionField ) {
+            quint8 projection;
+            stream >> projection;
+            frame.projection = Projection( projection );
+        }
+        if ( fields & SizeField ) {
+            quint16 width, height;
+            stream >> width >> height;
+            frame.size = QSize( width, height );
+        }
+        if ( fields & MapThemeField ) {
+            stream >> frame.mapThemeId;
+        }
+
+        if ( stream.status() != QDataStream::Ok ) {
+            mDebug() << "Truncated navigation trace";
+            m_frames.clear();
+            return false;
+        }
+        m_frames.append( frame );
+    }
+
+    return true;
+}
+
+bool NavigationTrace::load( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        mDebug() << "Cannot read navigation trace" << fileName;
+        return false;
+    }
+    return load( &file );
+}
+
+}
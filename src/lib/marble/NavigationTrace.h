@@ -0,0 +1,68 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_NAVIGATIONTRACE_H
+#define MARBLE_NAVIGATIONTRACE_H
+
+#include "marble_export.h"
+#include "MarbleGlobal.h"
+
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+namespace Marble
+{
+
+/**
+ * A recorded sequence of views of the map, see NavigationRecorder and
+ * NavigationReplayer.
+ *
+ * Traces are stored in a compact binary format: each frame holds only the
+ * properties that differ from the previous frame.
+ */
+class MARBLE_EXPORT NavigationTrace
+{
+public:
+    struct Frame
+    {
+        Frame();
+        bool operator==( const Frame &other ) const;
+
+        qint64 msecs;           ///< time since the start of the recording
+        qreal lon;              ///< center longitude in degrees
+        qreal lat;              ///< center latitude in degrees
+        int radius;
+        Projection projection;
+        QSize size;
+        QString mapThemeId;
+    };
+
+    void append( const Frame &frame );
+    const QVector<Frame> &frames() const;
+    void clear();
+
+    /** Returns the time between the first and last frame in ms. */
+    qint64 duration() const;
+
+    bool save( QIODevice *device ) const;
+    bool save( const QString &fileName ) const;
+    bool load( QIODevice *device );
+    bool load( const QString &fileName );
+
+private:
+    QVector<Frame> m_frames;
+};
+
+}
+
+#endif
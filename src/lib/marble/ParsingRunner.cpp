@@ -13,11 +13,43 @@ namespace Marble
 {
 
 ParsingRunner::ParsingRunner( QObject *parent )
-    : QObject( parent )
+    : QObject( parent ),
+      m_streaming( false ),
+      m_canceled( 0 )
 {
     // nothing to do
 }
 
+GeoDataDocument *ParsingRunner::parseRegion( const QString &fileName, const GeoDataLatLonBox &region, qreal resolution,
+                                             DocumentRole role, QString &error )
+{
+    Q_UNUSED( region );
+    Q_UNUSED( resolution );
+    Q_UNUSED( role );
+    error = QString( "Parsing regions of %1 is not supported" ).arg( fileName );
+    return 0;
+}
+
+void ParsingRunner::setStreaming( bool streaming )
+{
+    m_streaming = streaming;
+}
+
+bool ParsingRunner::isStreaming() const
+{
+    return m_streaming;
+}
+
+void ParsingRunner::cancel()
+{
+    m_canceled.store( 1 );
+}
+
+bool ParsingRunner::isCanceled() const
+{
+    return m_canceled.load() != 0;
+}
+
 }
 
 #include "moc_ParsingRunner.cpp"
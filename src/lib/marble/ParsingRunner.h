@@ -12,7 +12,9 @@
 #ifndef MARBLE_PARSINGRUNNER_H
 #define MARBLE_PARSINGRUNNER_H
 
+#include <QAtomicInt>
 #include <QObject>
+#include <QVector>
 #include "marble_export.h"
 
 #include "GeoDataDocument.h"
@@ -20,6 +22,10 @@
 namespace Marble
 {
 
+class GeoDataContainer;
+class GeoDataFeature;
+class GeoDataLatLonBox;
+
 class MARBLE_EXPORT ParsingRunner : public QObject
 {
     Q_OBJECT
@@ -33,6 +39,48 @@ public:
       * plugin capabilities, otherwise MarbleRunnerManager will ignore the plugin
       */
     virtual GeoDataDocument* parseFile( const QString &fileName, DocumentRole role, QString& error ) = 0;
+
+    /**
+      * Parse only the features of a file which intersect @p region, e.g. to
+      * serve a single file as vector tiles. Geometries may be simplified to
+      * @p resolution, given in degree, or kept exact if it is 0.
+      * The default implementation does not support regions and returns 0.
+      */
+    virtual GeoDataDocument* parseRegion( const QString &fileName, const GeoDataLatLonBox &region, qreal resolution,
+                                          DocumentRole role, QString& error );
+
+    /**
+      * Asks parseFile() to hand off completed features via featuresParsed()
+      * while the file is still being read. Runners which cannot stream
+      * ignore it. Disabled by default.
+      */
+    void setStreaming( bool streaming );
+    bool isStreaming() const;
+
+    /**
+      * Asks a running parseFile() to stop as soon as possible, in which case
+      * it returns 0. Can be called from any thread.
+      */
+    void cancel();
+    bool isCanceled() const;
+
+Q_SIGNALS:
+    /**
+      * Emitted by streaming runners with completed @p features of
+      * @p container, a container handed off before. The features are not
+      * part of the document returned by parseFile() and the receiver takes
+      * ownership of them. A null @p container hands off the parsed document
+      * itself before any of its features; parseFile() then returns a new
+      * document with the remaining data, e.g. styles, to merge into it.
+      */
+    void featuresParsed( GeoDataContainer *container, const QVector<GeoDataFeature*> &features );
+
+    /** Emitted by streaming runners with the number of bytes read so far */
+    void parsingProgress( qint64 bytesRead, qint64 bytesTotal );
+
+private:
+    bool m_streaming;
+    QAtomicInt m_canceled;
 };
 
 }
@@ -0,0 +1,674 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+// Own
+#include "PlacemarkIndexModel.h"
+
+// Qt
+#include <QHash>
+#include <QMap>
+#include <QReadWriteLock>
+
+// Std
+#include <algorithm>
+
+// Marble
+#include "GeoDataChildPositionIndex_p.h"
+#include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "GeoDataTypes.h"
+#include "MarblePlacemarkModel.h"
+
+namespace Marble
+{
+
+/**
+ * The indexed features below one child of the tree model's root document.
+ * Ranges are kept in the order of the root document's children, @c first
+ * is the row of the first feature of the range in the flat model.
+ */
+struct DocumentRange
+{
+    DocumentRange() : first( 0 ) {}
+
+    int first;
+    QVector<GeoDataFeature*> features;
+    GeoDataChildPositionIndex<GeoDataFeature> positions;
+};
+
+struct IndexEntry
+{
+    DocumentRange *range;
+    QString name;
+};
+
+/// Orders ranges by their first row, for std::upper_bound()
+struct RangeStartsAfter
+{
+    bool operator()( int row, const DocumentRange *range ) const
+    {
+        return row < range->first;
+    }
+};
+
+struct MorePopular
+{
+    bool operator()( const GeoDataPlacemark *a, const GeoDataPlacemark *b ) const
+    {
+        return a->popularity() > b->popularity();
+    }
+};
+
+class Q_DECL_HIDDEN PlacemarkIndexModel::Private
+{
+ public:
+    explicit Private( PlacemarkIndexModel *parent );
+    ~Private();
+
+    void addRows( const QModelIndex &parent, int first, int last );
+    void removeRows( const QModelIndex &parent, int first, int last );
+    void changeRows( const QModelIndex &topLeft, const QModelIndex &bottomRight );
+    void beginReset();
+    void endReset();
+
+    void clear();
+    void build();
+
+    void collect( GeoDataFeature *feature, QVector<GeoDataFeature*> &features ) const;
+    GeoDataContainer *container( const QModelIndex &index ) const;
+    DocumentRange *range( GeoDataFeature *feature ) const;
+    int rangeIndex( int row ) const;
+
+    void insertRange( int index, GeoDataFeature *topLevel );
+    void removeRange( int index );
+    void appendFeatures( DocumentRange *range, const QVector<GeoDataFeature*> &features );
+    void removeFeatures( DocumentRange *range, const QVector<GeoDataFeature*> &features );
+    void shiftRanges( int from, int delta );
+
+    QString indexName( const GeoDataFeature *feature ) const;
+    void addToIndex( DocumentRange *range, const QVector<GeoDataFeature*> &features );
+    void removeFromIndex( const QVector<GeoDataFeature*> &features );
+    void updateIndex( const QVector<GeoDataFeature*> &features );
+
+    PlacemarkIndexModel *const q;
+    GeoDataTreeModel *m_treeModel;
+    const char *m_featureType;
+    int m_rowCount;
+    QVector<DocumentRange*> m_ranges;
+    QHash<const GeoDataFeature*, IndexEntry> m_entries;
+
+    /// placemarks by normalized name, guarded by m_nameLock for findPlacemarks()
+    QMultiMap<QString, GeoDataPlacemark*> m_names;
+    mutable QReadWriteLock m_nameLock;
+};
+
+PlacemarkIndexModel::Private::Private( PlacemarkIndexModel *parent ) :
+    q( parent ),
+    m_treeModel( 0 ),
+    m_featureType( GeoDataTypes::GeoDataPlacemarkType ),
+    m_rowCount( 0 )
+{
+}
+
+PlacemarkIndexModel::Private::~Private()
+{
+    qDeleteAll( m_ranges );
+}
+
+void PlacemarkIndexModel::Private::clear()
+{
+    qDeleteAll( m_ranges );
+    m_ranges.clear();
+    m_entries.clear();
+    m_rowCount = 0;
+
+    QWriteLocker locker( &m_nameLock );
+    m_names.clear();
+}
+
+void PlacemarkIndexModel::Private::build()
+{
+    if ( !m_treeModel ) {
+        return;
+    }
+
+    GeoDataDocument *root = m_treeModel->rootDocument();
+    m_ranges.reserve( root->size() );
+    foreach ( GeoDataFeature *topLevel, root->featureList() ) {
+        DocumentRange *range = new DocumentRange;
+        range->first = m_rowCount;
+        collect( topLevel, range->features );
+        addToIndex( range, range->features );
+        m_rowCount += range->features.size();
+        m_ranges.append( range );
+    }
+}
+
+void PlacemarkIndexModel::Private::collect( GeoDataFeature *feature, QVector<GeoDataFeature*> &features ) const
+{
+    if ( feature->nodeType() == m_featureType ) {
+        features.append( feature );
+    } else if ( feature->nodeType() == GeoDataTypes::GeoDataFolderType
+                || feature->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
+        GeoDataContainer *container = static_cast<GeoDataContainer*>( feature );
+        QVector<GeoDataFeature*>::ConstIterator it = container->constBegin();
+        QVector<GeoDataFeature*>::ConstIterator const end = container->constEnd();
+        for ( ; it != end; ++it ) {
+            collect( *it, features );
+        }
+    }
+}
+
+GeoDataContainer *PlacemarkIndexModel::Private::container( const QModelIndex &index ) const
+{
+    if ( !index.isValid() ) {
+        return m_treeModel->rootDocument();
+    }
+
+    GeoDataObject *object = static_cast<GeoDataObject*>( index.internalPointer() );
+    if ( object->nodeType() == GeoDataTypes::GeoDataFolderType
+         || object->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
+        return static_cast<GeoDataContainer*>( object );
+    }
+
+    // placemarks, multi geometries and tours do not contain features
+    return 0;
+}
+
+DocumentRange *PlacemarkIndexModel::Private::range( GeoDataFeature *feature ) const
+{
+    GeoDataDocument *root = m_treeModel->rootDocument();
+    GeoDataObject *topLevel = feature;
+    while ( topLevel && topLevel->parent() != root ) {
+        topLevel = topLevel->parent();
+    }
+
+    if ( !topLevel ) {
+        return 0;
+    }
+
+    int const index = root->childPosition( static_cast<GeoDataFeature*>( topLevel ) );
+    return index >= 0 && index < m_ranges.size() ? m_ranges.at( index ) : 0;
+}
+
+int PlacemarkIndexModel::Private::rangeIndex( int row ) const
+{
+    // Empty ranges share their first row with the following range, so the
+    // last range starting at or before row is the one containing it.
+    QVector<DocumentRange*>::ConstIterator it = std::upper_bound( m_ranges.constBegin(), m_ranges.constEnd(), row,
+        RangeStartsAfter() );
+    return int( it - m_ranges.constBegin() ) - 1;
+}
+
+void PlacemarkIndexModel::Private::shiftRanges( int from, int delta )
+{
+    for ( int i = from; i < m_ranges.size(); ++i ) {
+        m_ranges[i]->first += delta;
+    }
+}
+
+void PlacemarkIndexModel::Private::insertRange( int index, GeoDataFeature *topLevel )
+{
+    index = qBound( 0, index, m_ranges.size() );
+    DocumentRange *range = new DocumentRange;
+    range->first = index < m_ranges.size() ? m_ranges.at( index )->first : m_rowCount;
+    collect( topLevel, range->features );
+
+    int const count = range->features.size();
+    if ( count > 0 ) {
+        q->beginInsertRows( QModelIndex(), range->first, range->first + count - 1 );
+    }
+
+    addToIndex( range, range->features );
+    m_ranges.insert( index, range );
+    shiftRanges( index + 1, count );
+    m_rowCount += count;
+
+    if ( count > 0 ) {
+        q->endInsertRows();
+    }
+}
+
+void PlacemarkIndexModel::Private::removeRange( int index )
+{
+    if ( index < 0 || index >= m_ranges.size() ) {
+        return;
+    }
+
+    DocumentRange *range = m_ranges.at( index );
+
+    int const count = range->features.size();
+    if ( count > 0 ) {
+        q->beginRemoveRows( QModelIndex(), range->first, range->first + count - 1 );
+    }
+
+    removeFromIndex( range->features );
+    m_ranges.remove( index );
+    shiftRanges( index, -count );
+    m_rowCount -= count;
+    delete range;
+
+    if ( count > 0 ) {
+        q->endRemoveRows();
+    }
+}
+
+void PlacemarkIndexModel::Private::appendFeatures( DocumentRange *range, const QVector<GeoDataFeature*> &features )
+{
+    if ( features.isEmpty() ) {
+        return;
+    }
+
+    int const size = range->features.size();
+    int const first = range->first + size;
+    q->beginInsertRows( QModelIndex(), first, first + features.size() - 1 );
+    range->features += features;
+    addToIndex( range, features );
+    range->positions.inserted( range->features, size );
+    shiftRanges( m_ranges.indexOf( range ) + 1, features.size() );
+    m_rowCount += features.size();
+    q->endInsertRows();
+}
+
+void PlacemarkIndexModel::Private::removeFeatures( DocumentRange *range, const QVector<GeoDataFeature*> &features )
+{
+    QVector<int> positions;
+    QVector<GeoDataFeature*> removed;
+    positions.reserve( features.size() );
+    removed.reserve( features.size() );
+    foreach ( GeoDataFeature *feature, features ) {
+        int const position = range->positions.position( range->features, feature );
+        if ( position >= 0 ) {
+            positions.append( position );
+            removed.append( feature );
+        }
+    }
+
+    if ( positions.isEmpty() ) {
+        return;
+    }
+
+    removeFromIndex( removed );
+
+    // Remove contiguous runs of rows, starting at the end of the range so
+    // that the positions of the remaining runs stay valid.
+    std::sort( positions.begin(), positions.end() );
+    int const rangeIndex = m_ranges.indexOf( range );
+    int last = positions.size() - 1;
+    while ( last >= 0 ) {
+        int first = last;
+        while ( first > 0 && positions.at( first - 1 ) == positions.at( first ) - 1 ) {
+            --first;
+        }
+
+        int const position = positions.at( first );
+        int const count = last - first + 1;
+        q->beginRemoveRows( QModelIndex(), range->first + position, range->first + position + count - 1 );
+        if ( count == 1 ) {
+            GeoDataFeature *feature = range->features.at( position );
+            range->features.remove( position );
+            range->positions.removed( range->features, position, feature );
+        } else {
+            range->features.remove( position, count );
+            range->positions.invalidate();
+        }
+        shiftRanges( rangeIndex + 1, -count );
+        m_rowCount -= count;
+        q->endRemoveRows();
+
+        last = first - 1;
+    }
+}
+
+QString PlacemarkIndexModel::Private::indexName( const GeoDataFeature *feature ) const
+{
+    if ( m_featureType != GeoDataTypes::GeoDataPlacemarkType ) {
+        return QString();
+    }
+
+    const GeoDataPlacemark *placemark = static_cast<const GeoDataPlacemark*>( feature );
+    // same as the display role of GeoDataTreeModel
+    QString const countryCode = placemark->countryCode();
+    return normalizedName( countryCode.isEmpty() ? placemark->name()
+                                                 : QString( "%1 (%2)" ).arg( placemark->name() ).arg( countryCode ) );
+}
+
+void PlacemarkIndexModel::Private::addToIndex( DocumentRange *range, const QVector<GeoDataFeature*> &features )
+{
+    foreach ( GeoDataFeature *feature, features ) {
+        IndexEntry &entry = m_entries[feature];
+        entry.range = range;
+        entry.name = indexName( feature );
+    }
+
+    if ( m_featureType != GeoDataTypes::GeoDataPlacemarkType || features.isEmpty() ) {
+        return;
+    }
+
+    // searches wait for the lock, so it is taken once per batch
+    QWriteLocker locker( &m_nameLock );
+    foreach ( GeoDataFeature *feature, features ) {
+        m_names.insert( m_entries.value( feature ).name, static_cast<GeoDataPlacemark*>( feature ) );
+    }
+}
+
+void PlacemarkIndexModel::Private::removeFromIndex( const QVector<GeoDataFeature*> &features )
+{
+    if ( m_featureType != GeoDataTypes::GeoDataPlacemarkType || features.isEmpty() ) {
+        foreach ( GeoDataFeature *feature, features ) {
+            m_entries.remove( feature );
+        }
+        return;
+    }
+
+    QWriteLocker locker( &m_nameLock );
+    foreach ( GeoDataFeature *feature, features ) {
+        m_names.remove( m_entries.take( feature ).name, static_cast<GeoDataPlacemark*>( feature ) );
+    }
+}
+
+void PlacemarkIndexModel::Private::updateIndex( const QVector<GeoDataFeature*> &features )
+{
+    if ( m_featureType != GeoDataTypes::GeoDataPlacemarkType ) {
+        return;
+    }
+
+    QVector<GeoDataFeature*> renamed;
+    QVector<QString> names;
+    foreach ( GeoDataFeature *feature, features ) {
+        QHash<const GeoDataFeature*, IndexEntry>::ConstIterator const entry = m_entries.constFind( feature );
+        if ( entry != m_entries.constEnd() ) {
+            QString const name = indexName( feature );
+            if ( name != entry->name ) {
+                renamed.append( feature );
+                names.append( name );
+            }
+        }
+    }
+
+    if ( renamed.isEmpty() ) {
+        return;
+    }
+
+    QWriteLocker locker( &m_nameLock );
+    for ( int i = 0; i < renamed.size(); ++i ) {
+        GeoDataPlacemark *placemark = static_cast<GeoDataPlacemark*>( renamed.at( i ) );
+        IndexEntry &entry = m_entries[placemark];
+        m_names.remove( entry.name, placemark );
+        entry.name = names.at( i );
+        m_names.insert( entry.name, placemark );
+    }
+}
+
+void PlacemarkIndexModel::Private::addRows( const QModelIndex &parent, int first, int last )
+{
+    GeoDataContainer *parentContainer = container( parent );
+    if ( !parentContainer ) {
+        return;
+    }
+
+    if ( parentContainer == m_treeModel->rootDocument() ) {
+        for ( int i = first; i <= last; ++i ) {
+            insertRange( i, parentContainer->child( i ) );
+        }
+        return;
+    }
+
+    DocumentRange *documentRange = range( parentContainer );
+    if ( !documentRange ) {
+        return;
+    }
+
+    // Features added below a top level document are appended to its range,
+    // the rows do not necessarily follow the order of the tree.
+    QVector<GeoDataFeature*> features;
+    for ( int i = first; i <= last; ++i ) {
+        collect( parentContainer->child( i ), features );
+    }
+    appendFeatures( documentRange, features );
+}
+
+void PlacemarkIndexModel::Private::removeRows( const QModelIndex &parent, int first, int last )
+{
+    GeoDataContainer *parentContainer = container( parent );
+    if ( !parentContainer ) {
+        return;
+    }
+
+    if ( parentContainer == m_treeModel->rootDocument() ) {
+        for ( int i = last; i >= first; --i ) {
+            removeRange( i );
+        }
+        return;
+    }
+
+    DocumentRange *documentRange = range( parentContainer );
+    if ( !documentRange ) {
+        return;
+    }
+
+    QVector<GeoDataFeature*> features;
+    for ( int i = first; i <= last; ++i ) {
+        collect( parentContainer->child( i ), features );
+    }
+    removeFeatures( documentRange, features );
+}
+
+void PlacemarkIndexModel::Private::changeRows( const QModelIndex &topLeft, const QModelIndex &bottomRight )
+{
+    GeoDataContainer *parentContainer = container( topLeft.parent() );
+    if ( !parentContainer ) {
+        return;
+    }
+
+    QVector<GeoDataFeature*> features;
+    for ( int i = topLeft.row(); i <= bottomRight.row() && i < parentContainer->size(); ++i ) {
+        collect( parentContainer->child( i ), features );
+    }
+    updateIndex( features );
+
+    foreach ( const GeoDataFeature *feature, features ) {
+        int const row = q->row( feature );
+        if ( row >= 0 ) {
+            emit q->dataChanged( q->index( row ), q->index( row ) );
+        }
+    }
+}
+
+void PlacemarkIndexModel::Private::beginReset()
+{
+    q->beginResetModel();
+    clear();
+}
+
+void PlacemarkIndexModel::Private::endReset()
+{
+    build();
+    q->endResetModel();
+}
+
+PlacemarkIndexModel::PlacemarkIndexModel( QObject *parent ) :
+    QAbstractListModel( parent ),
+    d( new Private( this ) )
+{
+}
+
+PlacemarkIndexModel::~PlacemarkIndexModel()
+{
+    delete d;
+}
+
+void PlacemarkIndexModel::setSourceModel( GeoDataTreeModel *treeModel )
+{
+    if ( d->m_treeModel == treeModel ) {
+        return;
+    }
+
+    d->beginReset();
+    if ( d->m_treeModel ) {
+        disconnect( d->m_treeModel, 0, this, 0 );
+    }
+
+    d->m_treeModel = treeModel;
+
+    if ( d->m_treeModel ) {
+        connect( d->m_treeModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                 this, SLOT(addRows(QModelIndex,int,int)) );
+        connect( d->m_treeModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                 this, SLOT(removeRows(QModelIndex,int,int)) );
+        connect( d->m_treeModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                 this, SLOT(changeRows(QModelIndex,QModelIndex)) );
+        connect( d->m_treeModel, SIGNAL(modelAboutToBeReset()),
+                 this, SLOT(beginReset()) );
+        connect( d->m_treeModel, SIGNAL(modelReset()),
+                 this, SLOT(endReset()) );
+    }
+    d->endReset();
+}
+
+GeoDataTreeModel *PlacemarkIndexModel::sourceModel() const
+{
+    return d->m_treeModel;
+}
+
+void PlacemarkIndexModel::setFeatureType( const char *nodeType )
+{
+    if ( d->m_featureType == nodeType ) {
+        return;
+    }
+
+    d->beginReset();
+    d->m_featureType = nodeType;
+    d->endReset();
+}
+
+const char *PlacemarkIndexModel::featureType() const
+{
+    return d->m_featureType;
+}
+
+int PlacemarkIndexModel::rowCount( const QModelIndex &parent ) const
+{
+    return parent.isValid() ? 0 : d->m_rowCount;
+}
+
+QVariant PlacemarkIndexModel::data( const QModelIndex &index, int role ) const
+{
+    GeoDataFeature *object = feature( index.row() );
+    if ( !index.isValid() || !object ) {
+        return QVariant();
+    }
+
+    if ( role == MarblePlacemarkModel::ObjectPointerRole ) {
+        return qVariantFromValue<GeoDataObject*>( object );
+    }
+
+    return d->m_treeModel->data( d->m_treeModel->index( object ), role );
+}
+
+bool PlacemarkIndexModel::setData( const QModelIndex &index, const QVariant &value, int role )
+{
+    GeoDataFeature *object = feature( index.row() );
+    if ( !index.isValid() || !object ) {
+        return false;
+    }
+
+    return d->m_treeModel->setData( d->m_treeModel->index( object ), value, role );
+}
+
+Qt::ItemFlags PlacemarkIndexModel::flags( const QModelIndex &index ) const
+{
+    GeoDataFeature *object = feature( index.row() );
+    if ( !index.isValid() || !object ) {
+        return Qt::NoItemFlags;
+    }
+
+    return d->m_treeModel->flags( d->m_treeModel->index( object ) );
+}
+
+GeoDataFeature *PlacemarkIndexModel::feature( int row ) const
+{
+    if ( row < 0 || row >= d->m_rowCount ) {
+        return 0;
+    }
+
+    const DocumentRange *range = d->m_ranges.at( d->rangeIndex( row ) );
+    return range->features.at( row - range->first );
+}
+
+int PlacemarkIndexModel::row( const GeoDataFeature *feature ) const
+{
+    QHash<const GeoDataFeature*, IndexEntry>::ConstIterator const entry = d->m_entries.constFind( feature );
+    if ( entry == d->m_entries.constEnd() ) {
+        return -1;
+    }
+
+    const DocumentRange *range = entry->range;
+    return range->first + range->positions.position( range->features, feature );
+}
+
+QVector<GeoDataPlacemark*> PlacemarkIndexModel::findPlacemarks( const QString &prefix, const GeoDataLatLonBox &box, int limit ) const
+{
+    QVector<GeoDataPlacemark*> result;
+    if ( d->m_featureType != GeoDataTypes::GeoDataPlacemarkType || limit == 0 ) {
+        return result;
+    }
+
+    QString const key = normalizedName( prefix );
+    bool const searchEverywhere = box.isEmpty();
+
+    // The lock keeps the placemarks alive until they are copied, they are
+    // removed from the index before the tree model deletes them.
+    QReadLocker locker( &d->m_nameLock );
+
+    QVector<GeoDataPlacemark*> matches;
+    QMultiMap<QString, GeoDataPlacemark*>::ConstIterator it = d->m_names.lowerBound( key );
+    QMultiMap<QString, GeoDataPlacemark*>::ConstIterator const end = d->m_names.constEnd();
+    for ( ; it != end && it.key().startsWith( key ); ++it ) {
+        if ( searchEverywhere || box.contains( it.value()->coordinate() ) ) {
+            matches.append( it.value() );
+        }
+    }
+
+    MorePopular const morePopular;
+    if ( limit > 0 && limit < matches.size() ) {
+        std::partial_sort( matches.begin(), matches.begin() + limit, matches.end(), morePopular );
+        matches.resize( limit );
+    } else {
+        std::stable_sort( matches.begin(), matches.end(), morePopular );
+    }
+
+    result.reserve( matches.size() );
+    foreach ( const GeoDataPlacemark *placemark, matches ) {
+        result.append( new GeoDataPlacemark( *placemark ) );
+    }
+
+    return result;
+}
+
+QString PlacemarkIndexModel::normalizedName( const QString &name )
+{
+    QString const decomposed = name.normalized( QString::NormalizationForm_KD );
+    QString result;
+    result.reserve( decomposed.size() );
+    foreach ( const QChar &character, decomposed ) {
+        if ( character.category() != QChar::Mark_NonSpacing ) {
+            result.append( character );
+        }
+    }
+
+    return result.toCaseFolded();
+}
+
+}
+
+#include "moc_PlacemarkIndexModel.cpp"
@@ -0,0 +1,116 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_PLACEMARKINDEXMODEL_H
+#define MARBLE_PLACEMARKINDEXMODEL_H
+
+#include "marble_export.h"
+
+#include <QAbstractListModel>
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataFeature;
+class GeoDataLatLonBox;
+class GeoDataPlacemark;
+class GeoDataTreeModel;
+
+/**
+ * @short A flat list of all features of one type in a GeoDataTreeModel.
+ *
+ * The model keeps a vector of feature pointers, grouped in one range per
+ * top level document of the tree model. Insertions and removals in the
+ * tree model only touch the range of the affected document, so loading
+ * or unloading a document does not require to remap the whole tree.
+ * Placemarks are additionally indexed by their normalized name for
+ * searching with findPlacemarks(). Renamed placemarks are indexed again
+ * when the tree model announces the change, either with
+ * GeoDataTreeModel::updateFeature() or with dataChanged().
+ *
+ * By default the model indexes placemarks, see setFeatureType().
+ * The rows can be shown in views like any list model, all roles
+ * are taken from the tree model.
+ */
+class MARBLE_EXPORT PlacemarkIndexModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+ public:
+    explicit PlacemarkIndexModel( QObject *parent = 0 );
+
+    ~PlacemarkIndexModel();
+
+    /**
+     * Sets the tree model to index. Ownership remains with the caller.
+     */
+    void setSourceModel( GeoDataTreeModel *treeModel );
+
+    GeoDataTreeModel *sourceModel() const;
+
+    /**
+     * Restricts the model to features whose nodeType() is @p nodeType,
+     * e.g. GeoDataTypes::GeoDataGroundOverlayType. Resets the model.
+     */
+    void setFeatureType( const char *nodeType );
+
+    const char *featureType() const;
+
+    int rowCount( const QModelIndex &parent = QModelIndex() ) const;
+
+    QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const;
+
+    bool setData( const QModelIndex &index, const QVariant &value, int role = Qt::EditRole );
+
+    Qt::ItemFlags flags( const QModelIndex &index ) const;
+
+    /**
+     * Returns the feature at @p row, or 0 if @p row is out of range.
+     */
+    GeoDataFeature *feature( int row ) const;
+
+    /**
+     * Returns the row of @p feature, or -1 if it is not part of the model.
+     */
+    int row( const GeoDataFeature *feature ) const;
+
+    /**
+     * Returns copies of the placemarks whose name starts with @p prefix,
+     * ignoring case and diacritics, ordered by decreasing popularity.
+     * The caller takes ownership of the copies.
+     * @param box if not empty, only placemarks inside @p box are returned
+     * @param limit the maximum number of results, or -1 for all of them
+     * @note This method can be called from any thread.
+     */
+    QVector<GeoDataPlacemark*> findPlacemarks( const QString &prefix, const GeoDataLatLonBox &box, int limit = -1 ) const;
+
+    /**
+     * Returns @p name in the form used by findPlacemarks(): case folded,
+     * with diacritics removed.
+     */
+    static QString normalizedName( const QString &name );
+
+ private:
+    Q_PRIVATE_SLOT( d, void addRows( const QModelIndex &parent, int first, int last ) )
+    Q_PRIVATE_SLOT( d, void removeRows( const QModelIndex &parent, int first, int last ) )
+    Q_PRIVATE_SLOT( d, void changeRows( const QModelIndex &topLeft, const QModelIndex &bottomRight ) )
+    Q_PRIVATE_SLOT( d, void beginReset() )
+    Q_PRIVATE_SLOT( d, void endReset() )
+
+    Q_DISABLE_COPY( PlacemarkIndexModel )
+    class Private;
+    friend class Private;
+    Private* const d;
+};
+
+}
+
+#endif
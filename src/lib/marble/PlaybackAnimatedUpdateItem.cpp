@@ -129,8 +129,8 @@ GeoDataFeature* PlaybackAnimatedUpdateItem::findFeature(GeoDataFeature* feature,
 
     GeoDataContainer *container = dynamic_cast<GeoDataContainer*>( feature );
     if ( container ){
-        QVector<GeoDataFeature*>::Iterator end = container->end();
-        QVector<GeoDataFeature*>::Iterator iter = container->begin();
+        QVector<GeoDataFeature*>::ConstIterator end = container->constEnd();
+        QVector<GeoDataFeature*>::ConstIterator iter = container->constBegin();
         for( ; iter != end; ++iter ){
             GeoDataFeature *foundFeature = findFeature( *iter, id );
             if ( foundFeature ){
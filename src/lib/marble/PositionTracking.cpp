@@ -29,11 +29,32 @@
 #include "MarbleDirs.h"
 #include "PositionProviderPlugin.h"
 
+#include <QDataStream>
 #include <QFile>
 
+#include <cmath>
+
 namespace Marble
 {
 
+namespace
+{
+    // Older points deviating less than this from the line between their
+    // neighbors are dropped when the track is thinned out, about 5 m on Earth.
+    const qreal simplificationTolerance = 8e-7;
+
+    const quint32 journalMagic = 0x4d54524a; // "MTRJ"
+    const quint16 journalVersion = 1;
+
+    enum JournalRecord {
+        JournalSegment = 0,
+        JournalPoint = 1
+    };
+
+    // the journal is written to disk in chunks of this size
+    const int journalBufferSize = 64 * 1024;
+}
+
 class PositionTrackingPrivate
 {
  public:
@@ -46,7 +67,9 @@ class PositionTrackingPrivate
         m_document(),
         m_currentTrack( 0 ),
         m_positionProvider( 0 ),
-        m_length( 0.0 )
+        m_length( 0.0 ),
+        m_maximumTrackPoints( 0 ),
+        m_journalSegmentOpen( false )
     {
     }
 
@@ -54,8 +77,20 @@ class PositionTrackingPrivate
 
     void updateStatus();
 
+    void startTrack();
+
+    void simplifyTrack();
+
+    bool thinOutHistory( int historySize, bool force );
+
+    void journalPoint( const QDateTime &timestamp, const GeoDataCoordinates &position );
+
+    void flushJournal();
+
     static QString statusFile();
 
+    static qreal deviation( const GeoDataCoordinates &point, const GeoDataCoordinates &previous, const GeoDataCoordinates &next );
+
     PositionTracking *const q;
 
     GeoDataTreeModel *const m_treeModel;
@@ -71,6 +106,12 @@ class PositionTrackingPrivate
     PositionProviderPlugin* m_positionProvider;
 
     qreal m_length;
+
+    int m_maximumTrackPoints;
+
+    QString m_journalFile;
+    QByteArray m_journalBuffer;
+    bool m_journalSegmentOpen;
 };
 
 void PositionTrackingPrivate::updatePosition()
@@ -87,6 +128,11 @@ void PositionTrackingPrivate::updatePosition()
                 m_length += distanceSphere( m_currentTrack->coordinatesAt( m_currentTrack->size() - 1 ), position );
             }
             m_currentTrack->addPoint( timestamp, position );
+            journalPoint( timestamp, position );
+
+            if ( m_maximumTrackPoints > 0 && m_currentTrack->size() > m_maximumTrackPoints ) {
+                simplifyTrack();
+            }
         }
 
         //if the position has moved then update the current position
@@ -111,11 +157,118 @@ void PositionTrackingPrivate::updateStatus()
         m_treeModel->removeFeature( m_currentTrackPlacemark );
         m_trackSegments->append( m_currentTrack );
         m_treeModel->addFeature( &m_document, m_currentTrackPlacemark );
+        startTrack();
+    } else {
+        flushJournal();
     }
 
     emit q->statusChanged( status );
 }
 
+void PositionTrackingPrivate::startTrack()
+{
+    // the next point in the journal starts a new segment
+    m_journalSegmentOpen = false;
+}
+
+void PositionTrackingPrivate::simplifyTrack()
+{
+    // The most recent half of the points is kept at full resolution. In
+    // the history before it every second point is dropped unless it marks
+    // a turn. As each pass thins out the history again, older parts of the
+    // track end up with fewer points than recent ones.
+    int historySize = m_currentTrack->size() - m_maximumTrackPoints / 2;
+    if ( !thinOutHistory( historySize, false ) ) {
+        // too many turns, e.g. while standing still with a noisy fix. The
+        // first pass shrank the track already, so the history is shorter.
+        historySize = m_currentTrack->size() - m_maximumTrackPoints / 2;
+        thinOutHistory( historySize, true );
+    }
+}
+
+bool PositionTrackingPrivate::thinOutHistory( int historySize, bool force )
+{
+    GeoDataTrack const history = *m_currentTrack;
+    QList<GeoDataCoordinates> const coordinates = history.coordinatesList();
+
+    m_currentTrack->clear();
+    m_currentTrack->addPoint( history.whenAt( 0 ), coordinates.first() );
+    int previous = 0;
+    for ( int i = 1; i < coordinates.size(); ++i ) {
+        bool const candidate = i < historySize && previous == i - 1;
+        if ( candidate && ( force || deviation( coordinates.at( i ), coordinates.at( previous ), coordinates.at( i + 1 ) ) < simplificationTolerance ) ) {
+            continue;
+        }
+
+        m_currentTrack->addPoint( history.whenAt( i ), coordinates.at( i ) );
+        previous = i;
+    }
+
+    // enough progress to not thin out again for a while
+    return 4 * ( coordinates.size() - m_currentTrack->size() ) >= historySize;
+}
+
+qreal PositionTrackingPrivate::deviation( const GeoDataCoordinates &point, const GeoDataCoordinates &previous, const GeoDataCoordinates &next )
+{
+    // distance of point to the segment between its neighbors on the unit
+    // sphere, using an equirectangular approximation around point
+    qreal const cosLat = cos( point.latitude() );
+    qreal const ax = ( previous.longitude() - point.longitude() ) * cosLat;
+    qreal const ay = previous.latitude() - point.latitude();
+    qreal const dx = ( next.longitude() - previous.longitude() ) * cosLat;
+    qreal const dy = next.latitude() - previous.latitude();
+
+    qreal const length2 = dx * dx + dy * dy;
+    qreal const t = length2 > 0 ? qBound<qreal>( 0.0, -( ax * dx + ay * dy ) / length2, 1.0 ) : 0.0;
+    return sqrt( ( ax + t * dx ) * ( ax + t * dx ) + ( ay + t * dy ) * ( ay + t * dy ) );
+}
+
+void PositionTrackingPrivate::journalPoint( const QDateTime &timestamp, const GeoDataCoordinates &position )
+{
+    if ( m_journalFile.isEmpty() ) {
+        return;
+    }
+
+    QDataStream stream( &m_journalBuffer, QIODevice::WriteOnly | QIODevice::Append );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    if ( !m_journalSegmentOpen ) {
+        stream << quint8( JournalSegment );
+        m_journalSegmentOpen = true;
+    }
+
+    stream << quint8( JournalPoint )
+           << qint64( timestamp.isValid() ? timestamp.toMSecsSinceEpoch() : -1 )
+           << double( position.longitude() ) << double( position.latitude() ) << double( position.altitude() );
+
+    if ( m_journalBuffer.size() >= journalBufferSize ) {
+        flushJournal();
+    }
+}
+
+void PositionTrackingPrivate::flushJournal()
+{
+    if ( m_journalFile.isEmpty() || m_journalBuffer.isEmpty() ) {
+        return;
+    }
+
+    QFile file( m_journalFile );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Append ) ) {
+        mDebug() << "Cannot write track journal" << m_journalFile;
+        return;
+    }
+
+    if ( file.size() == 0 ) {
+        QDataStream stream( &file );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        stream << journalMagic << journalVersion;
+    }
+
+    if ( file.write( m_journalBuffer ) != m_journalBuffer.size() ) {
+        mDebug() << "Cannot write track journal" << m_journalFile;
+    }
+    m_journalBuffer.clear();
+}
+
 QString PositionTrackingPrivate::statusFile()
 {
     QString const subdir = "tracking";
@@ -177,6 +330,7 @@ PositionTracking::PositionTracking( GeoDataTreeModel *model )
 
 PositionTracking::~PositionTracking()
 {
+    d->flushJournal();
     d->m_treeModel->removeDocument( &d->m_document );
     delete d;
 }
@@ -293,6 +447,85 @@ void PositionTracking::clearTrack()
     d->m_trackSegments->append( d->m_currentTrack );
     d->m_treeModel->addFeature( &d->m_document, d->m_currentTrackPlacemark );
     d->m_length = 0.0;
+    d->startTrack();
+}
+
+void PositionTracking::setMaximumTrackPoints( int count )
+{
+    d->m_maximumTrackPoints = count > 0 ? qMax( 4, count ) : 0;
+    if ( d->m_maximumTrackPoints > 0 && d->m_currentTrack->size() > d->m_maximumTrackPoints ) {
+        d->simplifyTrack();
+    }
+}
+
+int PositionTracking::maximumTrackPoints() const
+{
+    return d->m_maximumTrackPoints;
+}
+
+void PositionTracking::setTrackJournal( const QString &fileName )
+{
+    d->flushJournal();
+    d->m_journalFile = fileName;
+    d->m_journalSegmentOpen = false;
+}
+
+QString PositionTracking::trackJournal() const
+{
+    return d->m_journalFile;
+}
+
+bool PositionTracking::readTrackJournal( const QString &fileName, GeoDataMultiTrack *tracks )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        mDebug() << "Cannot read track journal" << fileName;
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    quint32 magic;
+    quint16 version;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != journalMagic || version != journalVersion ) {
+        mDebug() << "Not a track journal of a supported version:" << fileName;
+        return false;
+    }
+
+    GeoDataTrack *track = 0;
+    while ( !stream.atEnd() ) {
+        quint8 record;
+        stream >> record;
+        if ( record == JournalSegment ) {
+            track = new GeoDataTrack;
+            tracks->append( track );
+        } else if ( record == JournalPoint ) {
+            qint64 msecs;
+            double lon, lat, alt;
+            stream >> msecs >> lon >> lat >> alt;
+            if ( stream.status() != QDataStream::Ok ) {
+                break;
+            }
+            if ( !track ) {
+                track = new GeoDataTrack;
+                tracks->append( track );
+            }
+            QDateTime const when = msecs < 0 ? QDateTime() : QDateTime::fromMSecsSinceEpoch( msecs, Qt::UTC );
+            track->addPoint( when, GeoDataCoordinates( lon, lat, alt ) );
+        } else {
+            mDebug() << "Corrupt track journal" << fileName;
+            return false;
+        }
+    }
+
+    if ( stream.status() != QDataStream::Ok ) {
+        // the last record may be incomplete if writing was interrupted
+        mDebug() << "Truncated track journal" << fileName;
+    }
+
+    return true;
 }
 
 void PositionTracking::readSettings()
@@ -363,6 +596,7 @@ void PositionTracking::readSettings()
 
 void PositionTracking::writeSettings()
 {
+    d->flushJournal();
     saveTrack( d->statusFile() );
 }
 
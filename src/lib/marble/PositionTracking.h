@@ -24,6 +24,7 @@ namespace Marble
 class GeoDataAccuracy;
 class GeoDataDocument;
 class GeoDataCoordinates;
+class GeoDataMultiTrack;
 class GeoDataTreeModel;
 class PositionProviderPlugin;
 class PositionTrackingPrivate;
@@ -91,6 +92,36 @@ public:
      */
     qreal length( qreal planetRadius ) const;
 
+    /**
+     * @brief Limits the number of points kept for the current track segment
+     *
+     * Once the segment grows beyond @p count points, the older half of it is
+     * thinned out. Points close to the line between their neighbors are
+     * dropped first, so repeatedly thinned, older parts of the track keep
+     * their shape with fewer points. Recent points keep their full resolution.
+     * Use a track journal to keep all positions. 0, the default, disables
+     * the limit.
+     */
+    void setMaximumTrackPoints( int count );
+    int maximumTrackPoints() const;
+
+    /**
+     * @brief Appends all recorded positions to a journal file
+     *
+     * Positions are written in batches in a compact binary format, including
+     * the ones dropped by setMaximumTrackPoints(). An empty file name, the
+     * default, disables the journal.
+     * @see readTrackJournal
+     */
+    void setTrackJournal( const QString &fileName );
+    QString trackJournal() const;
+
+    /**
+     * @brief Appends the track segments stored in the journal @p fileName to @p tracks
+     * @return false if the file cannot be read or is no track journal
+     */
+    static bool readTrackJournal( const QString &fileName, GeoDataMultiTrack *tracks );
+
     void readSettings();
 
     void writeSettings();
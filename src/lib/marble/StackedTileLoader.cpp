@@ -206,6 +206,15 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
     }
 }
 
+void StackedTileLoader::removeTile( TileId const &tileId )
+{
+    const TileId stackedTileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
+
+    d->m_cacheLock.lockForWrite();
+    d->m_tileCache.remove( stackedTileId );
+    d->m_cacheLock.unlock();
+}
+
 RenderState StackedTileLoader::renderState() const
 {
     RenderState renderState( "Stacked Tiles" );
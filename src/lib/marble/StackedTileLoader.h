@@ -131,6 +131,12 @@ class StackedTileLoader : public QObject
          */
         void updateTile(TileId const & tileId, QImage const &tileImage );
 
+        /**
+         * Drops the tile from the cache of invisible tiles, so that it is
+         * loaded again once it becomes visible.
+         */
+        void removeTile( TileId const & tileId );
+
         RenderState renderState() const;
 
     Q_SIGNALS:
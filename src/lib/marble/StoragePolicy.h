@@ -34,10 +34,18 @@ class StoragePolicy : public QObject
         virtual bool fileExists( const QString &fileName ) const = 0;
 
         /**
-         * Return true if file was written successfully.
+         * Return true if file was written successfully, or if it was queued
+         * for writing by a policy which writes in the background.
+         * fileUpdated() is emitted as soon as the file is written.
          */
         virtual bool updateFile( const QString &fileName, const QByteArray &data ) = 0;
 
+        /**
+         * Returns the path @p fileName, as passed to updateFile(), is stored
+         * at. fileUpdated() and fileUpdateFailed() report this path.
+         */
+        virtual QString filePath( const QString &fileName ) const { return fileName; }
+
 	virtual void clearCache() = 0;
 
         virtual QString lastErrorMessage() const = 0;
@@ -45,6 +53,18 @@ class StoragePolicy : public QObject
     Q_SIGNALS:
 	void cleared();
 	void sizeChanged( qint64 );
+
+	/**
+	 * Is emitted when @p fileName, as returned by filePath(), has been
+	 * written, @p size is its new size.
+	 */
+	void fileUpdated( const QString &fileName, qint64 size );
+
+	/**
+	 * Is emitted when writing @p fileName, as returned by filePath(), in
+	 * the background failed.
+	 */
+	void fileUpdateFailed( const QString &fileName );
 	
     private:
 	Q_DISABLE_COPY( StoragePolicy )
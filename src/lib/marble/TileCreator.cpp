@@ -14,14 +14,18 @@
 
 #include <cmath>
 
+#include <QAtomicInt>
 #include <QDir>
+#include <QFile>
 #include <QRect>
 #include <QSize>
 #include <QVector>
 #include <QApplication>
 #include <QImage>
 #include <QImageReader>
-#include <QPainter>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
 
 #include "MarbleGlobal.h"
 #include "MarbleDirs.h"
@@ -34,29 +38,59 @@ namespace Marble
 class TileCreatorPrivate
 {
  public:
-    TileCreatorPrivate( TileCreatorSource *source,
+    TileCreatorPrivate( TileCreator *parent, TileCreatorSource *source,
                         const QString& dem, const QString& targetDir=QString() )
-       : m_dem( dem ),
+       : q( parent ),
+         m_dem( dem ),
          m_targetDir( targetDir ),
          m_cancelled( false ),
          m_tileFormat( "jpg" ),
          m_resume( false ),
          m_verify( false ),
-         m_source( source )
+         m_source( source ),
+         m_writeSlots( 4 * QThread::idealThreadCount() ),
+         m_writeFailed( 0 ),
+         m_totalTileCount( 0 ),
+         m_createdTilesCount( 0 )
      {
         if ( m_dem == "true" ) {
             m_tileQuality = 70;
         } else {
             m_tileQuality = 85;
         }
+
+        for ( int cnt = 0; cnt <= 255; ++cnt ) {
+            m_grayScalePalette.insert( cnt, qRgb( cnt, cnt, cnt ) );
+        }
     }
 
     ~TileCreatorPrivate()
     {
+        m_threadPool.waitForDone();
         delete m_source;
     }
 
+    QString tileName( int level, int n, int m ) const;
+
+    /**
+     * Returns whether tiles are written without losing information.
+     */
+    bool isLossless() const;
+
+    /**
+     * Saves a complete row of tiles and merges it into the row of the
+     * next lower level. Returns false if a tile could not be written.
+     */
+    bool finishRow( int level, int n, const QVector<QImage> &row );
+
+    /**
+     * Samples every second pixel of @p child into one quarter of @p parent.
+     */
+    void downsample( const QImage &child, QImage &parent, int quarterX, int quarterY ) const;
+
  public:
+    TileCreator *const q;
+
     QString  m_dem;
     QString  m_targetDir;
     bool     m_cancelled;
@@ -66,24 +100,227 @@ class TileCreatorPrivate
     bool     m_verify;
 
     TileCreatorSource  *m_source;
+
+    QVector<QRgb> m_grayScalePalette;
+
+    // Encoding and writing runs in m_threadPool. The number of tiles
+    // waiting to be written is limited by m_writeSlots to keep memory
+    // usage bounded when the disk is slower than the source.
+    QThreadPool m_threadPool;
+    QSemaphore m_writeSlots;
+    QAtomicInt m_writeFailed;
+
+    // The tiles of the lower levels are assembled here while the rows
+    // of the level above them are created, indexed by level.
+    QVector< QVector<QImage> > m_pendingRows;
+
+    int m_totalTileCount;
+    int m_createdTilesCount;
 };
 
+class TileWriteJob : public QRunnable
+{
+public:
+    TileWriteJob( TileCreatorPrivate *creator, const QImage &tile, const QString &fileName );
+
+    virtual void run();
+
+private:
+    void verify() const;
+
+    TileCreatorPrivate *const m_creator;
+    const QImage m_tile;
+    const QString m_fileName;
+};
+
+TileWriteJob::TileWriteJob( TileCreatorPrivate *creator, const QImage &tile, const QString &fileName )
+    : m_creator( creator ),
+      m_tile( tile ),
+      m_fileName( fileName )
+{
+}
+
+void TileWriteJob::run()
+{
+    bool  ok = m_tile.save( m_fileName, m_creator->m_tileFormat.toLatin1().data(), m_creator->m_tileQuality );
+    if ( !ok ) {
+        mDebug() << "Error while writing Tile: " << m_fileName;
+        m_creator->m_writeFailed.storeRelease( 1 );
+    } else if ( m_creator->m_verify ) {
+        verify();
+    }
+
+    m_creator->m_writeSlots.release();
+}
+
+void TileWriteJob::verify() const
+{
+    QImage writtenTile( m_fileName );
+    Q_ASSERT( writtenTile.size() == m_tile.size() );
+    for ( int i=0; i < writtenTile.size().width(); ++i) {
+        for ( int j=0; j < writtenTile.size().height(); ++j) {
+            if ( writtenTile.pixel( i, j ) != m_tile.pixel( i, j ) ) {
+                unsigned int  pixel = m_tile.pixel( i, j);
+                unsigned int  writtenPixel = writtenTile.pixel( i, j);
+                qWarning() << "***** pixel" << i << j << "is off by" << (pixel - writtenPixel) << "pixel" << pixel << "writtenPixel" << writtenPixel;
+                QByteArray baPixel((char*)&pixel, sizeof(unsigned int));
+                qWarning() << "pixel" << baPixel.size() << "0x" << baPixel.toHex();
+                QByteArray baWrittenPixel((char*)&writtenPixel, sizeof(unsigned int));
+                qWarning() << "writtenPixel" << baWrittenPixel.size() << "0x" << baWrittenPixel.toHex();
+                Q_ASSERT(false);
+            }
+        }
+    }
+}
+
+QString TileCreatorPrivate::tileName( int level, int n, int m ) const
+{
+    return m_targetDir + ( QString("%1/%2/%2_%3.%4")
+                           .arg( level )
+                           .arg( n, tileDigits, 10, QChar('0') )
+                           .arg( m, tileDigits, 10, QChar('0') ) )
+                           .arg( m_tileFormat );
+}
+
+bool TileCreatorPrivate::isLossless() const
+{
+    QString const format = m_tileFormat.toLower();
+    return format != "jpg" && format != "jpeg";
+}
+
+bool TileCreatorPrivate::finishRow( int level, int n, const QVector<QImage> &row )
+{
+    if ( m_writeFailed.loadAcquire() ) {
+        return false;
+    }
+
+    QString  dirName( m_targetDir
+                      + ( QString("%1/%2")
+                          .arg( level )
+                          .arg( n, tileDigits, 10, QChar('0') ) ) );
+    if ( !QDir( dirName ).exists() )
+        ( QDir::root() ).mkpath( dirName );
+
+    for ( int m = 0; m < row.size(); ++m ) {
+        QString const name = tileName( level, n, m );
+        if ( QFile::exists( name ) && m_resume ) {
+            //mDebug() << name << "exists already";
+        } else {
+            m_writeSlots.acquire();
+            m_threadPool.start( new TileWriteJob( this, row.at( m ), name ) );
+        }
+
+        // Don't exceed 99% as this would cancel the thread unexpectedly
+        int const percentCompleted = (int) ( 99 * (qreal)(++m_createdTilesCount)
+                                             / (qreal)(m_totalTileCount) );
+        emit q->progress( percentCompleted );
+    }
+
+    mDebug() << "tileLevel: " << level << "row" << n << "queued for writing.";
+
+    if ( level == 0 ) {
+        return true;
+    }
+
+    // Two rows of this level make up one row of the next lower level.
+    QVector<QImage> &parentRow = m_pendingRows[level - 1];
+    if ( n % 2 == 0 ) {
+        QImage::Format const format = m_dem == "true" ? QImage::Format_Indexed8 : QImage::Format_ARGB32;
+        parentRow.fill( QImage(), TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, level - 1 ) );
+        for ( int m = 0; m < parentRow.size(); ++m ) {
+            parentRow[m] = QImage( c_defaultTileSize, c_defaultTileSize, format );
+            if ( m_dem == "true" ) {
+                parentRow[m].setColorTable( m_grayScalePalette );
+            }
+        }
+    }
+
+    for ( int m = 0; m < row.size(); ++m ) {
+        downsample( row.at( m ), parentRow[m / 2], m % 2, n % 2 );
+    }
+
+    if ( n % 2 == 1 ) {
+        QVector<QImage> const completeRow = parentRow;
+        parentRow.clear();
+        return finishRow( level - 1, n / 2, completeRow );
+    }
+
+    return true;
+}
+
+void TileCreatorPrivate::downsample( const QImage &child, QImage &parent, int quarterX, int quarterY ) const
+{
+    // The tile size is odd, the quarters on the left and top are one pixel smaller.
+    uint const half = c_defaultTileSize / 2;
+    uint const xStart = quarterX * half;
+    uint const xEnd = quarterX ? c_defaultTileSize : half;
+    uint const yStart = quarterY * half;
+    uint const yEnd = quarterY ? c_defaultTileSize : half;
+
+    if ( parent.depth() == 8 ) {
+        for ( uint y = yStart; y < yEnd; ++y ) {
+            uchar *destLine = parent.scanLine( y );
+            const uchar *srcLine = child.constScanLine( 2 * ( y - yStart ) );
+            for ( uint x = xStart; x < xEnd; ++x )
+                destLine[x] = srcLine[ 2 * ( x - xStart ) ];
+        }
+    }
+    else {
+        QImage const source = child.depth() == 32 ? child : child.convertToFormat( QImage::Format_ARGB32 );
+        for ( uint y = yStart; y < yEnd; ++y ) {
+            QRgb *destLine = (QRgb*) parent.scanLine( y );
+            const QRgb *srcLine = (const QRgb*) source.constScanLine( 2 * ( y - yStart ) );
+            for ( uint x = xStart; x < xEnd; ++x )
+                destLine[x] = srcLine[ 2 * ( x - xStart ) ];
+        }
+    }
+}
+
+/**
+ * Reads the source image row by row where possible:
+ * - Binary PPM and PGM files with 8 bits per channel are read row by row
+ *   straight from the file, so they can be of any size. This is the format
+ *   to convert very large images to.
+ * - Images of other formats are decoded as a whole if they are no larger
+ *   than 21600x10800 pixels.
+ * - Larger images are decoded in bands if the format supports clip rects,
+ *   e.g. JPEG. Decoders start at the top of the image for every band, so
+ *   this takes a multiple of the time of decoding the image once.
+ */
 class TileCreatorSourceImage : public TileCreatorSource
 {
 public:
     explicit TileCreatorSourceImage( const QString &sourcePath )
-        : m_sourceImage( QImage( sourcePath ) ),
+        : m_sourcePath( sourcePath ),
+          m_reader( WholeImage ),
+          m_channels( 0 ),
+          m_dataOffset( 0 ),
+          m_bandTop( 0 ),
           m_cachedRowNum( -1 )
     {
+        if ( openNetpbm() ) {
+            m_reader = NetpbmRows;
+            return;
+        }
+
+        QImageReader reader( sourcePath );
+        m_imageSize = reader.size();
+        if ( reader.supportsOption( QImageIOHandler::ClipRect ) && m_imageSize.isValid()
+             && ( m_imageSize.width() > 21600 || m_imageSize.height() > 10800 ) ) {
+            m_reader = ClipRectBands;
+        } else {
+            m_sourceImage = reader.read();
+            m_imageSize = m_sourceImage.size();
+        }
     }
 
     virtual QSize fullImageSize() const
     {
-        if ( m_sourceImage.size().width() > 21600 || m_sourceImage.height() > 10800 ) {
+        if ( m_reader == WholeImage && ( m_imageSize.width() > 21600 || m_imageSize.height() > 10800 ) ) {
             qDebug("Install map too large!");
             return QSize();
         }
-        return m_sourceImage.size();
+        return m_imageSize;
     }
 
     virtual QImage tile(int n, int m, int maxTileLevel)
@@ -91,8 +328,8 @@ public:
         int  mmax = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, maxTileLevel );
         int  nmax = TileLoaderHelper::levelToRow( defaultLevelZeroRows, maxTileLevel );
 
-        int imageHeight = m_sourceImage.height();
-        int imageWidth = m_sourceImage.width();
+        int imageHeight = m_imageSize.height();
+        int imageWidth = m_imageSize.width();
 
         // If the image size of the image source does not match the expected
         // geometry we need to smooth-scale the image in advance to match
@@ -124,8 +361,17 @@ public:
             QRect   sourceRowRect( 0, (int)( (qreal)( n * imageHeight ) / (qreal)( nmax )),
                                 imageWidth,(int)( (qreal)( imageHeight ) / (qreal)( nmax ) ) );
 
-
-            row = m_sourceImage.copy( sourceRowRect );
+            switch ( m_reader ) {
+            case NetpbmRows:
+                row = netpbmRows( sourceRowRect );
+                break;
+            case ClipRectBands:
+                row = band( sourceRowRect ).copy( sourceRowRect.translated( 0, -m_bandTop ) );
+                break;
+            case WholeImage:
+                row = m_sourceImage.copy( sourceRowRect );
+                break;
+            }
 
             if ( needsScaling ) {
                 // Pick the current row and smooth scale it
@@ -151,8 +397,143 @@ public:
     }
 
 private:
+    enum Reader {
+        WholeImage,
+        NetpbmRows,
+        ClipRectBands
+    };
+
+    /**
+     * Reads the header of a binary PPM (P6) or PGM (P5) file with a maximum
+     * value of 255 and leaves m_file open at the start of the pixel data.
+     */
+    bool openNetpbm()
+    {
+        m_file.setFileName( m_sourcePath );
+        if ( !m_file.open( QIODevice::ReadOnly ) ) {
+            return false;
+        }
+
+        QByteArray const magic = m_file.read( 2 );
+        int const width = magic == "P5" || magic == "P6" ? readNetpbmNumber() : -1;
+        int const height = width > 0 ? readNetpbmNumber() : -1;
+        int const maxValue = height > 0 ? readNetpbmNumber() : -1;
+        m_channels = magic == "P6" ? 3 : 1;
+        m_dataOffset = m_file.pos();
+
+        if ( maxValue != 255 || m_file.size() < m_dataOffset + qint64( width ) * height * m_channels ) {
+            m_file.close();
+            return false;
+        }
+
+        m_imageSize = QSize( width, height );
+        return true;
+    }
+
+    /**
+     * Reads a decimal number of a netpbm header including the single
+     * whitespace character following it. Returns -1 on errors.
+     */
+    int readNetpbmNumber()
+    {
+        char c;
+        forever {
+            if ( !m_file.getChar( &c ) ) {
+                return -1;
+            }
+            if ( c == '#' ) {
+                // comments run to the end of the line
+                while ( c != '\n' && m_file.getChar( &c ) ) {
+                }
+            } else if ( !QChar( c ).isSpace() ) {
+                break;
+            }
+        }
+
+        int value = 0;
+        while ( c >= '0' && c <= '9' && value < 10000000 ) {
+            value = 10 * value + c - '0';
+            if ( !m_file.getChar( &c ) ) {
+                return -1;
+            }
+        }
+
+        return QChar( c ).isSpace() ? value : -1;
+    }
+
+    /**
+     * Reads the rows of @p rowRect from the netpbm file.
+     */
+    QImage netpbmRows( const QRect &rowRect )
+    {
+        qint64 const lineLength = qint64( m_imageSize.width() ) * m_channels;
+        if ( !m_file.seek( m_dataOffset + rowRect.top() * lineLength ) ) {
+            return QImage();
+        }
+
+        QImage rows( m_imageSize.width(), rowRect.height(), QImage::Format_RGB32 );
+        QByteArray line( lineLength, 0 );
+        for ( int y = 0; y < rowRect.height(); ++y ) {
+            if ( m_file.read( line.data(), lineLength ) != lineLength ) {
+                mDebug() << "Cannot read" << m_sourcePath << m_file.errorString();
+                return QImage();
+            }
+
+            const uchar *source = reinterpret_cast<const uchar*>( line.constData() );
+            QRgb *destination = reinterpret_cast<QRgb*>( rows.scanLine( y ) );
+            for ( int x = 0; x < m_imageSize.width(); ++x ) {
+                if ( m_channels == 3 ) {
+                    destination[x] = qRgb( source[3 * x], source[3 * x + 1], source[3 * x + 2] );
+                } else {
+                    destination[x] = qRgb( source[x], source[x], source[x] );
+                }
+            }
+        }
+
+        return rows;
+    }
+
+    /**
+     * Returns a band of the source image which contains @p rowRect. As many
+     * rows as fit into bandSize bytes are decoded at once, as decoders may
+     * have to start at the top of the image for every band.
+     */
+    const QImage &band( const QRect &rowRect )
+    {
+        if ( !m_band.isNull() && rowRect.top() >= m_bandTop
+             && rowRect.bottom() < m_bandTop + m_band.height() ) {
+            return m_band;
+        }
+
+        qint64 const bandSize = 512 * 1024 * 1024;
+        qint64 const rowSize = 4 * qint64( rowRect.width() ) * qMax( 1, rowRect.height() );
+        int const rowCount = qMax<qint64>( 1, bandSize / rowSize );
+        int const height = qMin( rowCount * rowRect.height(), m_imageSize.height() - rowRect.top() );
+
+        m_band = QImage();
+        m_bandTop = rowRect.top();
+
+        QImageReader reader( m_sourcePath );
+        reader.setClipRect( QRect( 0, m_bandTop, m_imageSize.width(), height ) );
+        if ( !reader.read( &m_band ) ) {
+            mDebug() << "Cannot read" << m_sourcePath << reader.errorString();
+        }
+
+        return m_band;
+    }
+
+    QString const m_sourcePath;
+    Reader m_reader;
+    QSize m_imageSize;
     QImage m_sourceImage;
 
+    QFile m_file;
+    int m_channels;
+    qint64 m_dataOffset;
+
+    QImage m_band;
+    int m_bandTop;
+
     QImage m_rowCache;
     int m_cachedRowNum;
 };
@@ -161,7 +542,7 @@ private:
 TileCreator::TileCreator(const QString& sourceDir, const QString& installMap,
                          const QString& dem, const QString& targetDir)
     : QThread(0),
-      d( new TileCreatorPrivate( 0, dem, targetDir ) )
+      d( new TileCreatorPrivate( this, 0, dem, targetDir ) )
 
 {
     mDebug() << "Prefix: " << sourceDir
@@ -195,7 +576,7 @@ TileCreator::TileCreator(const QString& sourceDir, const QString& installMap,
 
 TileCreator::TileCreator( TileCreatorSource* source, const QString& dem, const QString& targetDir )
     : QThread(0),
-      d( new TileCreatorPrivate( source, dem, targetDir ) )
+      d( new TileCreatorPrivate( this, source, dem, targetDir ) )
 {
     setTerminationEnabled( true );
 }
@@ -212,21 +593,11 @@ void TileCreator::cancelTileCreation()
 
 void TileCreator::run()
 {
-    if ( d->m_resume && d->m_tileFormat == "jpg" && d->m_tileQuality != 100 ) {
-        qWarning() << "Resuming jpegs is only supported with tileQuality 100";
-        return;
-    }
-
     if ( !d->m_targetDir.endsWith('/') )
         d->m_targetDir += '/';
 
     mDebug() << "Installing tiles to: " << d->m_targetDir;
 
-    QVector<QRgb> grayScalePalette;
-    for ( int cnt = 0; cnt <= 255; ++cnt ) {
-        grayScalePalette.insert(cnt, qRgb(cnt, cnt, cnt));
-    }
-
     QSize fullImageSize = d->m_source->fullImageSize();
     int  imageWidth  = fullImageSize.width();
     int  imageHeight = fullImageSize.height();
@@ -275,304 +646,75 @@ void TileCreator::run()
     int  mmax = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, maxTileLevel );
     int  nmax = TileLoaderHelper::levelToRow( defaultLevelZeroRows, maxTileLevel );
 
-    // Loading each row at highest spatial resolution and cropping tiles
-    int      percentCompleted = 0;
-    int      createdTilesCount = 0;
-    QString  tileName;
-
-    // Creating directory structure for the highest level
-    QString  dirName( d->m_targetDir
-                      + QString("%1").arg(maxTileLevel) );
-    if ( !QDir( dirName ).exists() ) 
-        ( QDir::root() ).mkpath( dirName );
+    d->m_totalTileCount = totalTileCount;
+    d->m_createdTilesCount = 0;
+    d->m_writeFailed.storeRelease( 0 );
+    d->m_pendingRows.fill( QVector<QImage>(), qMax( 0, maxTileLevel ) );
 
+    // Each row at highest spatial resolution is cropped into tiles which
+    // are written in the background. Meanwhile they get downsampled into
+    // the rows of the lower levels, so no tile is ever read back from disk.
+    // The source is only accessed from this thread.
+    QSize const expectedSize( c_defaultTileSize, c_defaultTileSize );
     for ( int n = 0; n < nmax; ++n ) {
-        QString dirName( d->m_targetDir
-                         + QString("%1/%2").arg(maxTileLevel).arg( n, tileDigits, 10, QChar('0') ) );
-        if ( !QDir( dirName ).exists() ) 
-            ( QDir::root() ).mkpath( dirName );
-    }
 
-    for ( int n = 0; n < nmax; ++n ) {
+        QVector<QImage> row( mmax );
 
         for ( int m = 0; m < mmax; ++m ) {
 
             mDebug() << "** tile" << m << "x" << n;
 
-            if ( d->m_cancelled ) 
+            if ( d->m_cancelled ) {
+                d->m_threadPool.waitForDone();
                 return;
+            }
 
-            tileName = d->m_targetDir + ( QString("%1/%2/%2_%3.%4")
-                                       .arg( maxTileLevel )
-                                       .arg( n, tileDigits, 10, QChar('0') )
-                                       .arg( m, tileDigits, 10, QChar('0') ) )
-                                       .arg( d->m_tileFormat );
-
-            if ( QFile::exists( tileName ) && d->m_resume ) {
-
-                //mDebug() << tileName << "exists already";
-
-            } else {
-
-                QImage tile = d->m_source->tile( n, m, maxTileLevel );
+            QImage tile;
 
-                if ( tile.isNull() ) {
-                    mDebug() << "Read-Error! Null QImage!";
-                    return;
-                }
-
-                if ( d->m_dem == "true" ) {
-                    tile = tile.convertToFormat(QImage::Format_Indexed8,
-                                                grayScalePalette,
-                                                Qt::ThresholdDither);
-                }
+            // Tiles of an earlier run are still needed for the lower levels.
+            // Lossy tiles are taken from the source again, the lower levels
+            // would differ from the ones of an uninterrupted run otherwise.
+            QString const tileName = d->tileName( maxTileLevel, n, m );
+            if ( d->m_resume && d->isLossless() && QFile::exists( tileName ) ) {
+                tile = QImage( tileName );
+            }
 
-                bool  ok = tile.save( tileName, d->m_tileFormat.toLatin1().data(), d->m_tileFormat == "jpg" ? 100 : d->m_tileQuality );
-                if ( !ok )
-                    mDebug() << "Error while writing Tile: " << tileName;
-
-                mDebug() << tileName << "size" << QFile( tileName ).size();
-
-                if ( d->m_verify ) {
-                    QImage writtenTile(tileName);
-                    Q_ASSERT( writtenTile.size() == tile.size() );
-                    for ( int i=0; i < writtenTile.size().width(); ++i) {
-                        for ( int j=0; j < writtenTile.size().height(); ++j) {
-                            if ( writtenTile.pixel( i, j ) != tile.pixel( i, j ) ) {
-                                unsigned int  pixel = tile.pixel( i, j);
-                                unsigned int  writtenPixel = writtenTile.pixel( i, j);
-                                qWarning() << "***** pixel" << i << j << "is off by" << (pixel - writtenPixel) << "pixel" << pixel << "writtenPixel" << writtenPixel;
-                                QByteArray baPixel((char*)&pixel, sizeof(unsigned int));
-                                qWarning() << "pixel" << baPixel.size() << "0x" << baPixel.toHex();
-                                QByteArray baWrittenPixel((char*)&writtenPixel, sizeof(unsigned int));
-                                qWarning() << "writtenPixel" << baWrittenPixel.size() << "0x" << baWrittenPixel.toHex();
-                                Q_ASSERT(false);
-                            }
-                        }
-                    }
-                }
+            if ( tile.size() != expectedSize ) {
+                tile = d->m_source->tile( n, m, maxTileLevel );
+            }
 
+            if ( tile.size() != expectedSize ) {
+                mDebug() << "Read-Error! Null QImage!";
+                d->m_threadPool.waitForDone();
+                return;
             }
 
-            percentCompleted =  (int) ( 90 * (qreal)(createdTilesCount) 
-                                        / (qreal)(totalTileCount) );	
-            createdTilesCount++;
+            if ( d->m_dem == "true" ) {
+                tile = tile.convertToFormat(QImage::Format_Indexed8,
+                                            d->m_grayScalePalette,
+                                            Qt::ThresholdDither);
+            }
 
-            mDebug() << "percentCompleted" << percentCompleted;
-            emit progress( percentCompleted );
+            row[m] = tile;
         }
-    }
-
-    mDebug() << "tileLevel: " << maxTileLevel << " successfully created.";
-
-    tileLevel = maxTileLevel;
-
-    // Now that we have the tiles at the highest resolution lets build
-    // them together four by four.
-
-    while( tileLevel > 0 ) {
-        tileLevel--;
-
-        int  nmaxit =  TileLoaderHelper::levelToRow( defaultLevelZeroRows, tileLevel );
-
-        for ( int n = 0; n < nmaxit; ++n ) {
-            QString  dirName( d->m_targetDir
-                              + ( QString("%1/%2")
-                                  .arg(tileLevel)
-                                  .arg( n, tileDigits, 10, QChar('0') ) ) );
-
-            // mDebug() << "dirName: " << dirName;
-            if ( !QDir( dirName ).exists() ) 
-                ( QDir::root() ).mkpath( dirName );
 
-            int   mmaxit = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, tileLevel );
-            for ( int m = 0; m < mmaxit; ++m ) {
-
-                if ( d->m_cancelled )
-                    return;
-
-                QString newTileName = d->m_targetDir + ( QString("%1/%2/%2_%3.%4")
-                                           .arg( tileLevel )
-                                           .arg( n, tileDigits, 10, QChar('0') )
-                                           .arg( m, tileDigits, 10, QChar('0') ) )
-                                           .arg( d->m_tileFormat );
-
-                if ( QFile::exists( newTileName ) && d->m_resume ) {
-                    //mDebug() << newTileName << "exists already";
-                } else {
-                    tileName = d->m_targetDir + ( QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg( 2*n, tileDigits, 10, QChar('0') )
-                                            .arg( 2*m, tileDigits, 10, QChar('0') ) )
-                                            .arg( d->m_tileFormat );
-                    QImage  img_topleft( tileName );
-
-                    tileName = d->m_targetDir + ( QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg( 2*n, tileDigits, 10, QChar('0') )
-                                            .arg( 2*m+1, tileDigits, 10, QChar('0') ) )
-                                            .arg( d->m_tileFormat );
-                    QImage  img_topright( tileName );
-
-                    tileName = d->m_targetDir + ( QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg( 2*n+1, tileDigits, 10, QChar('0') )
-                                            .arg( 2*m, tileDigits, 10, QChar('0') ) )
-                                            .arg( d->m_tileFormat );
-                    QImage  img_bottomleft( tileName );
-
-                    tileName = d->m_targetDir + ( QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg( 2*n+1, tileDigits, 10, QChar('0') )
-                                            .arg( 2*m+1, tileDigits, 10, QChar('0') ) )
-                                            .arg( d->m_tileFormat );
-                    QImage  img_bottomright( tileName );
-
-                    QSize const expectedSize( c_defaultTileSize, c_defaultTileSize );
-                    if ( img_topleft.size() != expectedSize ||
-                         img_topright.size() != expectedSize ||
-                         img_bottomleft.size() != expectedSize ||
-                         img_bottomright.size() != expectedSize ) {
-                        mDebug() << "Tile write failure. Missing write permissions?";
-                        emit progress( 100 );
-                        return;
-                    }
-                    QImage  tile = img_topleft;
-
-                    if ( d->m_dem == "true" ) {
-
-                        tile.setColorTable( grayScalePalette );
-                        uchar* destLine;
-
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_topleft.scanLine( 2 * y );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[x] = srcLine[ 2*x ];
-                        }
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_topright.scanLine( 2 * y );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2 * ( x - c_defaultTileSize / 2 ) ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_bottomleft.scanLine( 2 * ( y - c_defaultTileSize / 2 ) );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[ x ] = srcLine[ 2 * x ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_bottomright.scanLine( 2 * ( y - c_defaultTileSize/2 ) );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2 * ( x - c_defaultTileSize / 2 ) ];
-                        }
-                    }
-                    else {
-
-                        // tile.depth() != 8
-
-                        img_topleft = img_topleft.convertToFormat( QImage::Format_ARGB32 );
-                        img_topright = img_topright.convertToFormat( QImage::Format_ARGB32 );
-                        img_bottomleft = img_bottomleft.convertToFormat( QImage::Format_ARGB32 );
-                        img_bottomright = img_bottomright.convertToFormat( QImage::Format_ARGB32 );
-                        tile = img_topleft;
-
-                        QRgb* destLine;
-
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_topleft.scanLine( 2 * y );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[x] = srcLine[ 2 * x ];
-                        }
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_topright.scanLine( 2 * y );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2 * ( x - c_defaultTileSize / 2 ) ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_bottomleft.scanLine( 2 * ( y-c_defaultTileSize/2 ) );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[x] = srcLine[ 2 * x ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_bottomright.scanLine( 2 * ( y-c_defaultTileSize / 2 ) );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2*( x-c_defaultTileSize / 2 ) ];
-                        }
-                    }
-
-                    mDebug() << newTileName;
-
-                    // Saving at 100% JPEG quality to have a high-quality
-                    // version to create the remaining needed tiles from.
-                    bool  ok = tile.save( newTileName, d->m_tileFormat.toLatin1().data(), d->m_tileFormat == "jpg" ? 100 : d->m_tileQuality );
-                    if ( ! ok )
-                        mDebug() << "Error while writing Tile: " << newTileName;
-                }
-
-                percentCompleted =  (int) ( 90 * (qreal)(createdTilesCount)
-                                            / (qreal)(totalTileCount) );	
-                createdTilesCount++;
-						
-                emit progress( percentCompleted );
-                mDebug() << "percentCompleted" << percentCompleted;
-            }
+        if ( !d->finishRow( maxTileLevel, n, row ) ) {
+            break;
         }
-        mDebug() << "tileLevel: " << tileLevel << " successfully created.";
     }
-    mDebug() << "Tile creation completed.";
-
-    if ( d->m_tileFormat == "jpg" && d->m_tileQuality != 100 ) {
-
-        // Applying correct lower JPEG compression now that we created all tiles
-        int savedTilesCount = 0;
-
-        tileLevel = 0;
-        while ( tileLevel <= maxTileLevel ) {
-            int nmaxit =  TileLoaderHelper::levelToRow( defaultLevelZeroRows, tileLevel );
-            for ( int n = 0; n < nmaxit; ++n) {
-                int mmaxit =  TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, tileLevel );
-                for ( int m = 0; m < mmaxit; ++m) {
 
-                    if ( d->m_cancelled )
-                        return;
+    d->m_threadPool.waitForDone();
+    d->m_pendingRows.clear();
 
-                    savedTilesCount++;
-
-                    tileName = d->m_targetDir + ( QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel )
-                                            .arg( n, tileDigits, 10, QChar('0') )
-                                            .arg( m, tileDigits, 10, QChar('0') ) )
-                                            .arg( d->m_tileFormat );
-                    QImage tile( tileName );
-
-                    bool ok;
-
-                    ok = tile.save( tileName, d->m_tileFormat.toLatin1().data(), d->m_tileQuality );
-
-                    if ( !ok )
-                        mDebug() << "Error while writing Tile: " << tileName;
-                    // Don't exceed 99% as this would cancel the thread unexpectedly
-                    percentCompleted = 90 + (int)( 9 * (qreal)(savedTilesCount)
-                                                / (qreal)(totalTileCount) );
-                    emit progress( percentCompleted );
-                    mDebug() << "percentCompleted" << percentCompleted;
-                    //mDebug() << "Saving Tile #" << savedTilesCount
-                    //         << " of " << totalTileCount
-                    //         << " Percent: " << percentCompleted;
-                }
-            }
-            tileLevel++;
-        }
+    if ( d->m_writeFailed.loadAcquire() ) {
+        mDebug() << "Tile write failure. Missing write permissions?";
+        emit progress( 100 );
+        return;
     }
 
-    percentCompleted = 100;
+    mDebug() << "Tile creation completed.";
+
+    int percentCompleted = 100;
     emit progress( percentCompleted );
 
     mDebug() << "percentCompleted: " << percentCompleted;
@@ -24,6 +24,7 @@
 #include <QFileInfo>
 #include <QMetaType>
 #include <QImage>
+#include <qmath.h>
 
 #include "GeoSceneTextureTileDataset.h"
 #include "GeoSceneTileDataset.h"
@@ -31,12 +32,14 @@
 #include "GeoSceneVectorTileDataset.h"
 #include "GeoDataDocument.h"
 #include "GeoDataContainer.h"
+#include "GeoDataLatLonBox.h"
 #include "HttpDownloadManager.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "TileLoaderHelper.h"
 #include "ParseRunnerPlugin.h"
 #include "ParsingRunner.h"
+#include "StoragePolicy.h"
 
 Q_DECLARE_METATYPE( Marble::DownloadUsage )
 
@@ -44,15 +47,22 @@ namespace Marble
 {
 
 TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const PluginManager *pluginManager) :
-    m_pluginManager(pluginManager)
+    m_pluginManager(pluginManager),
+    m_storagePolicy(downloadManager->storagePolicy())
 {
     qRegisterMetaType<DownloadUsage>( "DownloadUsage" );
     connect( this, SIGNAL(downloadTile(QUrl,QString,QString,DownloadUsage)),
              downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage)));
+    connect( this, SIGNAL(downloadPrioritiesChanged(QObject*,QString,QHash<QString,int>)),
+             downloadManager, SLOT(setJobPriorities(QObject*,QString,QHash<QString,int>)));
+    connect( this, SIGNAL(fileAccessed(QString)),
+             downloadManager, SIGNAL(fileAccessed(QString)));
     connect( downloadManager, SIGNAL(downloadComplete(QString,QString)),
              SLOT(updateTile(QString,QString)));
     connect( downloadManager, SIGNAL(downloadComplete(QByteArray,QString)),
              SLOT(updateTile(QByteArray,QString)));
+    connect( downloadManager, SIGNAL(downloadCanceled(QString)),
+             SLOT(cancelTile(QString)));
 }
 
 TileLoader::~TileLoader()
@@ -82,6 +92,7 @@ QImage TileLoader::loadTileImage( GeoSceneTextureTileDataset const *textureLayer
         QImage const image( fileName );
         if ( !image.isNull() ) {
             // file is there, so create and return a tile object in any case
+            emit fileAccessed( fileName );
             return image;
         }
     }
@@ -102,6 +113,15 @@ GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTileDataset const
 {
     // FIXME: textureLayer->fileFormat() could be used in the future for use just that parser, instead of all available parsers
 
+    // A dataset whose source is a single file, e.g. a large shapefile, is
+    // served by parsing only the region of the requested tile from it.
+    QString const sourceFile = singleSourceFile( textureLayer );
+    if ( !sourceFile.isEmpty() ) {
+        GeoDataLatLonBox const region = tileId.toLatLonBox( textureLayer );
+        qreal const resolution = region.width( GeoDataCoordinates::Degree ) / textureLayer->tileSize().width();
+        return openVectorFile( sourceFile, region, resolution );
+    }
+
     QString const fileName = tileFileName( textureLayer, tileId );
 
     TileStatus status = tileStatus( textureLayer, tileId );
@@ -122,6 +142,7 @@ GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTileDataset const
             // File is ready, so parse and return the vector data in any case
             GeoDataDocument* document = openVectorFile(fileName);
             if (document) {
+                emit fileAccessed( fileName );
                 return document;
             }
         }
@@ -143,6 +164,31 @@ void TileLoader::downloadTile( GeoSceneTileDataset const *tileData, TileId const
     triggerDownload( tileData, tileId, usage );
 }
 
+void TileLoader::setVisibleTiles( GeoSceneTileDataset const *tileData, QVector<TileId> const &tiles,
+                                  GeoDataCoordinates const &center )
+{
+    QString const prefix = downloadIdPrefix( tileData );
+
+    // Called for every frame, the download queues only need to change when
+    // other tiles become visible. The priorities are not updated while the
+    // view moves within the same tiles.
+    QSet<TileId> const visibleTiles = tiles.toList().toSet();
+    QSet<TileId> &lastVisibleTiles = m_visibleTiles[ prefix ];
+    if ( lastVisibleTiles == visibleTiles ) {
+        return;
+    }
+    lastVisibleTiles = visibleTiles;
+
+    QHash<QString, int> priorities;
+    priorities.reserve( tiles.size() );
+    foreach ( TileId const &id, tiles ) {
+        QString const idStr = prefix + QString( "%1:%2:%3" ).arg( id.zoomLevel() ).arg( id.x() ).arg( id.y() );
+        priorities.insert( idStr, downloadPriority( tileData, id, center ) );
+    }
+
+    emit downloadPrioritiesChanged( this, prefix, priorities );
+}
+
 int TileLoader::maximumTileLevel( GeoSceneTileDataset const & tileData )
 {
     // if maximum tile level is configured in the DGML files,
@@ -196,12 +242,15 @@ bool TileLoader::baseTilesAvailable( GeoSceneTileDataset const & tileData )
     return result;
 }
 
-TileLoader::TileStatus TileLoader::tileStatus( GeoSceneTileDataset const *tileData, const TileId &tileId )
+TileLoader::TileStatus TileLoader::tileStatus( GeoSceneTileDataset const *tileData, const TileId &tileId ) const
 {
     QString const fileName = tileFileName( tileData, tileId );
     QFileInfo fileInfo( fileName );
     if ( !fileInfo.exists() ) {
-        return Missing;
+        // Downloaded tiles are written behind, only the storage policy
+        // knows about those which are not written yet
+        bool const queued = m_storagePolicy && m_storagePolicy->fileExists( tileData->relativeTileFileName( tileId ) );
+        return queued ? Available : Missing;
     }
 
     const QDateTime lastModified = fileInfo.lastModified();
@@ -252,6 +301,25 @@ void TileLoader::updateTile(const QString &fileName, const QString &idStr)
     }
 }
 
+void TileLoader::cancelTile( QString const & idStr )
+{
+    // all tile loaders share the download manager
+    QStringList const components = idStr.split( ':', QString::SkipEmptyParts );
+    if ( components.size() != 5 ) {
+        return;
+    }
+
+    QString const origin = components[0];
+    QString const sourceDir = components[ 1 ];
+    int const zoomLevel = components[ 2 ].toInt();
+    int const tileX = components[ 3 ].toInt();
+    int const tileY = components[ 4 ].toInt();
+
+    if ( origin == GeoSceneTypes::GeoSceneTextureTileType ) {
+        emit tileDownloadCanceled( TileId( sourceDir, zoomLevel, tileX, tileY ) );
+    }
+}
+
 QString TileLoader::tileFileName( GeoSceneTileDataset const * tileData, TileId const & tileId )
 {
     QString const fileName = tileData->relativeTileFileName( tileId );
@@ -271,10 +339,30 @@ void TileLoader::triggerDownload( GeoSceneTileDataset const *tileData, TileId co
 
     QUrl const sourceUrl = tileData->downloadUrl( id );
     QString const destFileName = tileData->relativeTileFileName( id );
-    QString const idStr = QString( "%1:%2:%3:%4:%5" ).arg( tileData->nodeType()).arg( tileData->sourceDir() ).arg( id.zoomLevel() ).arg( id.x() ).arg( id.y() );
+    QString const idStr = downloadIdPrefix( tileData ) + QString( "%1:%2:%3" ).arg( id.zoomLevel() ).arg( id.x() ).arg( id.y() );
     emit downloadTile( sourceUrl, destFileName, idStr, usage );
 }
 
+QString TileLoader::downloadIdPrefix( GeoSceneTileDataset const * tileData )
+{
+    return QString( "%1:%2:" ).arg( tileData->nodeType() ).arg( tileData->sourceDir() );
+}
+
+int TileLoader::downloadPriority( GeoSceneTileDataset const * tileData, TileId const &id, GeoDataCoordinates const &center )
+{
+    // Distance of the tile center to the view center, measured in tiles
+    GeoDataLatLonBox const box = id.toLatLonBox( tileData );
+    GeoDataCoordinates const tileCenter = box.center();
+    qreal const dx = GeoDataCoordinates::normalizeLon( tileCenter.longitude() - center.longitude() ) / box.width();
+    qreal const dy = ( tileCenter.latitude() - center.latitude() ) / box.height();
+    int const distance = qMin( 0xffff, qRound( 16 * qSqrt( dx * dx + dy * dy ) ) );
+
+    // Tiles of lower levels cover more of the screen, they are needed first.
+    // The priority is negative so that jobs which were not prioritized
+    // yet, i.e. tiles requested for the current view, keep the precedence.
+    return -( ( id.zoomLevel() << 16 ) + distance );
+}
+
 QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTileDataset * textureData, TileId const & id )
 {
     mDebug() << Q_FUNC_INFO << id;
@@ -319,7 +407,14 @@ QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTileDataset * text
     return QImage();
 }
 
-GeoDataDocument *TileLoader::openVectorFile(const QString &fileName) const
+QString TileLoader::singleSourceFile( GeoSceneTileDataset const * tileData )
+{
+    QString const source = tileData->themeStr();
+    QString const path = QFileInfo( source ).isAbsolute() ? source : MarbleDirs::path( source );
+    return !path.isEmpty() && QFileInfo( path ).isFile() ? path : QString();
+}
+
+ParsingRunner *TileLoader::newParsingRunner( const QString &fileName ) const
 {
     QList<const ParseRunnerPlugin*> plugins = m_pluginManager->parsingRunnerPlugins();
     const QFileInfo fileInfo( fileName );
@@ -329,21 +424,47 @@ GeoDataDocument *TileLoader::openVectorFile(const QString &fileName) const
     foreach( const ParseRunnerPlugin *plugin, plugins ) {
         QStringList const extensions = plugin->fileExtensions();
         if ( extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
-            ParsingRunner* runner = plugin->newRunner();
-            QString error;
-            GeoDataDocument* document = runner->parseFile(fileName, UserDocument, error);
-            if (!document && !error.isEmpty()) {
-                mDebug() << QString("Failed to open vector tile %1: %2").arg(fileName).arg(error);
-            }
-            delete runner;
-            return document;
+            return plugin->newRunner();
+        }
+    }
+
+    return nullptr;
+}
+
+GeoDataDocument *TileLoader::openVectorFile(const QString &fileName) const
+{
+    ParsingRunner* runner = newParsingRunner( fileName );
+    if ( runner ) {
+        QString error;
+        GeoDataDocument* document = runner->parseFile(fileName, UserDocument, error);
+        if (!document && !error.isEmpty()) {
+            mDebug() << QString("Failed to open vector tile %1: %2").arg(fileName).arg(error);
         }
+        delete runner;
+        return document;
     }
 
     mDebug() << "Unable to open vector tile " << fileName << ": No suitable plugin registered to parse this file format";
     return nullptr;
 }
 
+GeoDataDocument *TileLoader::openVectorFile( const QString &fileName, const GeoDataLatLonBox &region, qreal resolution ) const
+{
+    ParsingRunner* runner = newParsingRunner( fileName );
+    if ( runner ) {
+        QString error;
+        GeoDataDocument* document = runner->parseRegion( fileName, region, resolution, UserDocument, error );
+        if ( !document && !error.isEmpty() ) {
+            mDebug() << QString( "Failed to open vector tile region of %1: %2" ).arg( fileName ).arg( error );
+        }
+        delete runner;
+        return document;
+    }
+
+    mDebug() << "Unable to open vector tile region of " << fileName << ": No suitable plugin registered to parse this file format";
+    return nullptr;
+}
+
 }
 
 #include "moc_TileLoader.cpp"
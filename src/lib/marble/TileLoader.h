@@ -20,9 +20,12 @@
 #ifndef MARBLE_TILELOADER_H
 #define MARBLE_TILELOADER_H
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QImage>
+#include <QVector>
 
 #include "TileId.h"
 #include "GeoDataContainer.h"
@@ -36,11 +39,15 @@ class QUrl;
 namespace Marble
 {
 class HttpDownloadManager;
+class GeoDataCoordinates;
 class GeoDataDocument;
+class GeoDataLatLonBox;
 class GeoSceneTileDataset;
 class GeoSceneTextureTileDataset;
 class GeoSceneVectorTileDataset;
+class ParsingRunner;
 class ParsingRunnerManager;
+class StoragePolicy;
 
 class TileLoader: public QObject
 {
@@ -60,6 +67,17 @@ class TileLoader: public QObject
     GeoDataDocument* loadTileVectorData( GeoSceneVectorTileDataset const *vectorData, TileId const & tileId, DownloadUsage const usage );
     void downloadTile( GeoSceneTileDataset const *tileData, TileId const &, DownloadUsage const );
 
+    /**
+     * Reports the tiles of @p tileData which are currently visible. Pending
+     * downloads of these tiles are reordered such that tiles of lower levels
+     * and tiles close to @p center are downloaded first. Pending downloads
+     * of other tiles of @p tileData are canceled unless another tile loader
+     * sharing the download manager still needs them. The priorities are
+     * only computed again once the set of visible tiles changes.
+     */
+    void setVisibleTiles( GeoSceneTileDataset const *tileData, QVector<TileId> const &tiles,
+                          GeoDataCoordinates const &center );
+
     static int maximumTileLevel( GeoSceneTileDataset const & tileData );
 
     /**
@@ -72,30 +90,53 @@ class TileLoader: public QObject
       * Returns the status of the downloaded tile file:
       * - Missing when it has not been downloaded
       * - Expired when it has been downloaded, but is too old (as per .dgml expiration time)
-      * - Available when it has been downloaded and is not expired
+      * - Available when it has been downloaded and is not expired, or when
+      *   the storage policy did not write it yet
       */
-    static TileStatus tileStatus( GeoSceneTileDataset const *tileData, const TileId &tileId );
+    TileStatus tileStatus( GeoSceneTileDataset const *tileData, const TileId &tileId ) const;
 
  private Q_SLOTS:
     void updateTile( QByteArray const & imageData, QString const & tileId );
     void updateTile( QString const & fileName, QString const & idStr );
+    void cancelTile( QString const & idStr );
 
  Q_SIGNALS:
     void downloadTile( QUrl const & sourceUrl, QString const & destinationFileName,
                        QString const & id, DownloadUsage );
 
+    void downloadPrioritiesChanged( QObject * owner, QString const & idPrefix, QHash<QString, int> const & priorities );
+
+    void fileAccessed( QString const & fileName );
+
     void tileCompleted( TileId const & tileId, QImage const & tileImage );
 
     void tileCompleted( TileId const & tileId, GeoDataDocument * document );
 
+    /**
+     * The download of the texture tile @p tileId was canceled because the
+     * tile left the view. A scaled replacement shown for it must not be
+     * reused, otherwise the download is not started again.
+     */
+    void tileDownloadCanceled( TileId const & tileId );
+
  private:
     static QString tileFileName( GeoSceneTileDataset const * tileData, TileId const & );
+    static QString downloadIdPrefix( GeoSceneTileDataset const * tileData );
+    static int downloadPriority( GeoSceneTileDataset const * tileData, TileId const &, GeoDataCoordinates const &center );
     void triggerDownload( GeoSceneTileDataset const *tileData, TileId const &, DownloadUsage const );
     static QImage scaledLowerLevelTile( GeoSceneTextureTileDataset const * textureData, TileId const & );
+    static QString singleSourceFile( GeoSceneTileDataset const * tileData );
+    ParsingRunner* newParsingRunner( const QString &fileName ) const;
     GeoDataDocument* openVectorFile(const QString &filename) const;
+    GeoDataDocument* openVectorFile( const QString &fileName, const GeoDataLatLonBox &region, qreal resolution ) const;
 
     // For vectorTile parsing
     PluginManager const * m_pluginManager;
+
+    StoragePolicy const * m_storagePolicy;
+
+    // The visible tiles last reported, by download id prefix
+    QHash<QString, QSet<TileId> > m_visibleTiles;
 };
 
 }
@@ -161,7 +161,7 @@ void TourCaptureDialog::recordNextFrame()
         m_recorder->recordFrame();
         updateProgress( m_current_position * 100 );
         m_current_position += shift;
-        QTimer::singleShot(1, this, SLOT(recordNextFrame()));
+        QTimer::singleShot(0, this, SLOT(recordNextFrame()));
     } else {
         m_recorder->stopRecording();
         ui->progressBar->setValue(duration*100);
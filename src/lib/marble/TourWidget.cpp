@@ -399,8 +399,8 @@ GeoDataTour *TourWidgetPrivate::findTour( GeoDataFeature *feature ) const
 
     GeoDataContainer *container = dynamic_cast<GeoDataContainer*>( feature );
     if ( container ) {
-        QVector<GeoDataFeature*>::Iterator end = container->end();
-        QVector<GeoDataFeature*>::Iterator iter = container->begin();
+        QVector<GeoDataFeature*>::ConstIterator end = container->constEnd();
+        QVector<GeoDataFeature*>::ConstIterator iter = container->constBegin();
         for( ; iter != end; ++iter ) {
             GeoDataTour *tour = findTour( *iter );
             if ( tour ) {
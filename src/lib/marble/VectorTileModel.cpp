@@ -134,6 +134,8 @@ void VectorTileModel::setViewport( const GeoDataLatLonBox &bbox, int radius )
                               qMin<unsigned int>( lat2tileY( bbox.south(GeoDataCoordinates::Degree), maxTileY ),
                                     maxTileY ) );
 
+    m_visibleTiles.clear();
+
     bool left  = minX < maxTileX;
     bool right = maxX > 0;
     bool up    = minY < maxTileY;
@@ -161,6 +163,10 @@ void VectorTileModel::setViewport( const GeoDataLatLonBox &bbox, int radius )
 
     }
 
+    if ( !m_visibleTiles.isEmpty() ) {
+        m_loader->setVisibleTiles( m_layer, m_visibleTiles, bbox.center() );
+    }
+
     removeTilesOutOfView(bbox);
 }
 
@@ -233,6 +239,7 @@ void VectorTileModel::setViewport( int tileZoomLevel,
     for ( unsigned int x = minTileX; x <= maxTileX; ++x ) {
         for ( unsigned int y = minTileY; y <= maxTileY; ++y ) {
            const TileId tileId = TileId( 0, tileZoomLevel, x, y );
+           m_visibleTiles << tileId;
            if ( !m_documents.contains( tileId ) && !m_pendingDocuments.contains( tileId ) ) {
                m_pendingDocuments << tileId;
                TileRunner *job = new TileRunner( m_loader, m_layer, tileId );
@@ -16,6 +16,7 @@
 #include <QRunnable>
 
 #include <QMap>
+#include <QVector>
 
 #include "TileId.h"
 
@@ -109,6 +110,7 @@ private:
     int m_tileLoadLevel;
     int m_tileZoomLevel;
     QList<TileId> m_pendingDocuments;
+    QVector<TileId> m_visibleTiles;
     QList<GeoDataDocument*> m_garbageQueue;
     QMap<TileId, QSharedPointer<CacheDocument> > m_documents;
 };
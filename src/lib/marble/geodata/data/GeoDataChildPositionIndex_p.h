@@ -0,0 +1,135 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_GEODATACHILDPOSITIONINDEX_P_H
+#define MARBLE_GEODATACHILDPOSITIONINDEX_P_H
+
+#include <QHash>
+
+namespace Marble
+{
+
+/**
+ * Maps the children of a GeoData container class to their position.
+ *
+ * The index is built on the first lookup and kept up to date by the
+ * notification methods afterwards, so looking up the position of a child
+ * is O(1) instead of a linear scan. Each lookup is verified against the
+ * actual children and a stale index, e.g. after children were replaced
+ * through non-const iterators, is rebuilt transparently. Thus looking up
+ * objects which are not contained is O(n).
+ *
+ * Like the item models which look up positions, the index is meant to be
+ * used from a single thread, even though lookups are const.
+ */
+template<class T>
+class GeoDataChildPositionIndex
+{
+public:
+    GeoDataChildPositionIndex()
+        : m_valid( false )
+    {
+    }
+
+    /** Copies are built again on their first lookup */
+    GeoDataChildPositionIndex( const GeoDataChildPositionIndex & )
+        : m_valid( false )
+    {
+    }
+
+    GeoDataChildPositionIndex &operator=( const GeoDataChildPositionIndex & )
+    {
+        invalidate();
+        return *this;
+    }
+
+    /**
+     * Returns the position of @p child in @p children, or -1 if it is not
+     * contained.
+     */
+    template<class Container>
+    int position( const Container &children, const T *child ) const
+    {
+        if ( !m_valid ) {
+            rebuild( children );
+        }
+
+        int row = m_positions.value( child, -1 );
+        if ( row < 0 || row >= children.size() || children.at( row ) != child ) {
+            rebuild( children );
+            row = m_positions.value( child, -1 );
+        }
+
+        return row;
+    }
+
+    /** Call after a child was inserted at @p index */
+    template<class Container>
+    void inserted( const Container &children, int index )
+    {
+        if ( m_valid ) {
+            update( children, index );
+        }
+    }
+
+    /** Call after @p child was removed from @p index */
+    template<class Container>
+    void removed( const Container &children, int index, const T *child )
+    {
+        if ( m_valid ) {
+            m_positions.remove( child );
+            update( children, index );
+        }
+    }
+
+    /** Call after the children at @p indexA and @p indexB were swapped */
+    template<class Container>
+    void swapped( const Container &children, int indexA, int indexB )
+    {
+        if ( m_valid ) {
+            m_positions.insert( children.at( indexA ), indexA );
+            m_positions.insert( children.at( indexB ), indexB );
+        }
+    }
+
+    /** Drops the index, it is rebuilt on the next lookup */
+    void invalidate()
+    {
+        m_valid = false;
+        m_positions.clear();
+    }
+
+private:
+    template<class Container>
+    void update( const Container &children, int from )
+    {
+        for ( int i = from; i < children.size(); ++i ) {
+            m_positions.insert( children.at( i ), i );
+        }
+    }
+
+    template<class Container>
+    void rebuild( const Container &children ) const
+    {
+        m_positions.clear();
+        m_positions.reserve( children.size() );
+        for ( int i = 0; i < children.size(); ++i ) {
+            m_positions.insert( children.at( i ), i );
+        }
+        m_valid = true;
+    }
+
+    mutable QHash<const T*, int> m_positions;
+    mutable bool m_valid;
+};
+
+}
+
+#endif
@@ -252,14 +252,7 @@ const GeoDataFeature* GeoDataContainer::child( int i ) const
  */
 int GeoDataContainer::childPosition( const GeoDataFeature* object ) const
 {
-    for ( int i=0; i< p()->m_vector.size(); i++ )
-    {
-        if ( p()->m_vector.at( i ) == object )
-        {
-            return i;
-        }
-    }
-    return -1;
+    return p()->m_childPositions.position( p()->m_vector, object );
 }
 
 
@@ -273,6 +266,7 @@ void GeoDataContainer::insert( int index, GeoDataFeature *feature )
     detach();
     feature->setParent(this);
     p()->m_vector.insert( index, feature );
+    p()->m_childPositions.inserted( p()->m_vector, index );
 }
 
 void GeoDataContainer::append( GeoDataFeature *other )
@@ -280,13 +274,16 @@ void GeoDataContainer::append( GeoDataFeature *other )
     detach();
     other->setParent(this);
     p()->m_vector.append( other );
+    p()->m_childPositions.inserted( p()->m_vector, p()->m_vector.size() - 1 );
 }
 
 
 void GeoDataContainer::remove( int index )
 {
     detach();
+    const GeoDataFeature *feature = p()->m_vector.at( index );
     p()->m_vector.remove( index );
+    p()->m_childPositions.removed( p()->m_vector, index, feature );
 }
 
 int GeoDataContainer::size() const
@@ -332,6 +329,7 @@ void GeoDataContainer::clear()
     GeoDataContainer::detach();
     qDeleteAll(p()->m_vector);
     p()->m_vector.clear();
+    p()->m_childPositions.invalidate();
 }
 
 QVector<GeoDataFeature*>::Iterator GeoDataContainer::begin()
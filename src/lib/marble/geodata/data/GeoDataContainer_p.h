@@ -13,6 +13,8 @@
 
 #include "GeoDataFeature_p.h"
 
+#include "GeoDataChildPositionIndex_p.h"
+
 #include "GeoDataTypes.h"
 
 namespace Marble
@@ -34,6 +36,8 @@ class GeoDataContainerPrivate : public GeoDataFeaturePrivate
     {
         GeoDataFeaturePrivate::operator=( other );
         qDeleteAll( m_vector );
+        m_vector.clear();
+        m_childPositions.invalidate();
         foreach( GeoDataFeature *feature, other.m_vector )
         {
             m_vector.append( new GeoDataFeature( *feature ) );
@@ -59,6 +63,7 @@ class GeoDataContainerPrivate : public GeoDataFeaturePrivate
     }
 
     QVector<GeoDataFeature*> m_vector;
+    GeoDataChildPositionIndex<GeoDataFeature> m_childPositions;
 };
 
 } // namespace Marble
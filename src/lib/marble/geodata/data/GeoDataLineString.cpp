@@ -277,6 +277,117 @@ void GeoDataLineStringPrivate::optimize (GeoDataLineString& lineString) const
     lineString.last().setDetail(startLevel);
 }
 
+namespace
+{
+    // Distance of @p point from the chord between @p a and @p b in radians,
+    // approximated in an equirectangular projection centered on the chord.
+    qreal chordDistance( const GeoDataCoordinates &a, const GeoDataCoordinates &b,
+                         const GeoDataCoordinates &point )
+    {
+        qreal const scale = cos( 0.5 * ( a.latitude() + b.latitude() ) );
+        qreal const bx = remainder( b.longitude() - a.longitude(), 2 * M_PI ) * scale;
+        qreal const by = b.latitude() - a.latitude();
+        qreal const px = remainder( point.longitude() - a.longitude(), 2 * M_PI ) * scale;
+        qreal const py = point.latitude() - a.latitude();
+
+        qreal const length = bx * bx + by * by;
+        qreal const t = length > 0.0 ? qBound<qreal>( 0.0, ( px * bx + py * by ) / length, 1.0 ) : 0.0;
+        qreal const dx = px - t * bx;
+        qreal const dy = py - t * by;
+        return sqrt( dx * dx + dy * dy );
+    }
+}
+
+void GeoDataLineStringPrivate::updateNodeLevels( bool closed ) const
+{
+    if ( !m_dirtyLevels ) {
+        return;
+    }
+
+    m_dirtyLevels = false;
+    m_significantNodes = QVector<QVector<int> >( maximumLevel + 1 );
+    m_builtLevels = 0;
+
+    int const size = m_vector.size();
+    m_nodeLevels = QVector<quint8>( size, maximumLevel );
+    if ( size < 3 ) {
+        return;
+    }
+
+    // Detail values from the data, e.g. .pn2 files, are shared by
+    // adjacent polygons and preserve the borders between them.
+    if ( m_vector.first().detail() != 0 ) {
+        for ( int i = 0; i < size; ++i ) {
+            m_nodeLevels[i] = qBound( 1, m_vector.at( i ).detail(), int( maximumLevel ) );
+        }
+        return;
+    }
+
+    // Douglas-Peucker: each node gets the level of the resolution at which it
+    // is the farthest node from the chord of its parent segment. Levels never
+    // exceed the parent's, so every level is a valid simplification.
+    struct Segment {
+        int first;
+        int last;   // may be size for the closing segment of a ring
+        qreal bound;
+    };
+
+    int end = size - 1;
+    m_nodeLevels[0] = 1;
+    if ( closed ) {
+        // split the ring at the node farthest from its first node
+        qreal maximum = -1.0;
+        for ( int i = 1; i < size; ++i ) {
+            qreal const distance = distanceSphere( m_vector.at( 0 ), m_vector.at( i ) );
+            if ( distance > maximum ) {
+                maximum = distance;
+                end = i;
+            }
+        }
+    }
+    m_nodeLevels[end] = 1;
+
+    QVector<Segment> stack;
+    Segment const initial = { 0, end, M_PI };
+    stack.append( initial );
+    if ( closed && end < size ) {
+        Segment const closing = { end, size, M_PI };
+        stack.append( closing );
+    }
+
+    while ( !stack.isEmpty() ) {
+        Segment const segment = stack.last();
+        stack.removeLast();
+        if ( segment.last - segment.first < 2 ) {
+            continue;
+        }
+
+        const GeoDataCoordinates &a = m_vector.at( segment.first );
+        const GeoDataCoordinates &b = m_vector.at( segment.last % size );
+        int farthest = segment.first + 1;
+        qreal maximum = -1.0;
+        for ( int i = segment.first + 1; i < segment.last; ++i ) {
+            qreal const distance = chordDistance( a, b, m_vector.at( i ) );
+            if ( distance > maximum ) {
+                maximum = distance;
+                farthest = i;
+            }
+        }
+
+        if ( maximum < resolutionForLevel( maximumLevel ) ) {
+            // nothing in between is visible at any level
+            continue;
+        }
+
+        qreal const bound = qMin( maximum, segment.bound );
+        m_nodeLevels[farthest] = levelForResolution( bound );
+        Segment const left = { segment.first, farthest, bound };
+        Segment const right = { farthest, segment.last, bound };
+        stack.append( left );
+        stack.append( right );
+    }
+}
+
 bool GeoDataLineString::isEmpty() const
 {
     return p()->m_vector.isEmpty();
@@ -292,6 +403,7 @@ GeoDataCoordinates& GeoDataLineString::at( int pos )
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    p()->m_dirtyLevels = true;
     return p()->m_vector[ pos ];
 }
 
@@ -305,6 +417,7 @@ GeoDataCoordinates& GeoDataLineString::operator[]( int pos )
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    p()->m_dirtyLevels = true;
     return p()->m_vector[ pos ];
 }
 
@@ -318,12 +431,14 @@ GeoDataCoordinates& GeoDataLineString::last()
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    p()->m_dirtyLevels = true;
     return p()->m_vector.last();
 }
 
 GeoDataCoordinates& GeoDataLineString::first()
 {
     GeoDataGeometry::detach();
+    p()->m_dirtyLevels = true;
     return p()->m_vector.first();
 }
 
@@ -340,6 +455,7 @@ const GeoDataCoordinates& GeoDataLineString::first() const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::begin()
 {
     GeoDataGeometry::detach();
+    p()->m_dirtyLevels = true;
     return p()->m_vector.begin();
 }
 
@@ -351,6 +467,7 @@ QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::begin() const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::end()
 {
     GeoDataGeometry::detach();
+    p()->m_dirtyLevels = true;
     return p()->m_vector.end();
 }
 
@@ -377,6 +494,7 @@ void GeoDataLineString::insert( int index, const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
     d->m_vector.insert( index, value );
 }
 
@@ -388,6 +506,7 @@ void GeoDataLineString::append ( const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
     d->m_vector.append( value );
 }
 
@@ -399,6 +518,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& va
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
     d->m_vector.append( value );
     return *this;
 }
@@ -411,6 +531,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataLineString& val
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
 
     QVector<GeoDataCoordinates>::const_iterator itCoords = value.constBegin();
     QVector<GeoDataCoordinates>::const_iterator itEnd = value.constEnd();
@@ -461,6 +582,7 @@ void GeoDataLineString::clear()
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
 
     d->m_vector.clear();
 }
@@ -775,6 +897,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
     return d->m_vector.erase( pos );
 }
 
@@ -787,6 +910,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
     return d->m_vector.erase( begin, end );
 }
 
@@ -796,6 +920,7 @@ void GeoDataLineString::remove ( int i )
     GeoDataLineStringPrivate* d = p();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->m_dirtyLevels = true;
     d->m_vector.remove( i );
 }
 
@@ -812,6 +937,33 @@ GeoDataLineString GeoDataLineString::optimized () const
     }
 }
 
+QVector<int> GeoDataLineString::significantNodes( int level ) const
+{
+    const GeoDataLineStringPrivate *d = p();
+    d->updateNodeLevels( isClosed() );
+
+    level = qBound( 1, level, int( GeoDataLineStringPrivate::maximumLevel ) );
+    if ( !( d->m_builtLevels & ( 1u << level ) ) ) {
+        int const size = d->m_nodeLevels.size();
+        QVector<int> nodes;
+        for ( int i = 0; i < size; ++i ) {
+            if ( d->m_nodeLevels.at( i ) <= level || i == 0 || i == size - 1 ) {
+                nodes.append( i );
+            }
+        }
+
+        if ( nodes.size() == size ) {
+            nodes.clear();
+        } else {
+            nodes.squeeze();
+        }
+        d->m_significantNodes[level] = nodes;
+        d->m_builtLevels |= 1u << level;
+    }
+
+    return d->m_significantNodes.at( level );
+}
+
 void GeoDataLineString::pack( QDataStream& stream ) const
 {
     GeoDataGeometry::pack( stream );
@@ -359,6 +359,21 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
     */
     GeoDataLineString optimized() const;
 
+    /*!
+        \brief Returns the positions of the nodes needed at a detail level.
+
+        A node is needed at @p level (1 to 17, see GeoDataCoordinates::detail())
+        if leaving it out would move the line by more than the angular
+        resolution of that level. The first and last node are always needed.
+
+        Line strings with detail values, e.g. from .pn2 files, use those.
+        Other line strings are simplified with the Douglas-Peucker algorithm
+        once; the result is cached until the line string changes.
+
+        Returns an empty vector if all nodes are needed at @p level.
+    */
+    QVector<int> significantNodes( int level ) const;
+
     // Serialization
 /*!
     \brief Serialize the LineString to a stream.
@@ -27,14 +27,20 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
            m_dirtyBox( true ),
            m_tessellationFlags( f ),
            m_previousResolution( -1 ),
-           m_level( -1 )
+           m_level( -1 ),
+           m_dirtyLevels( true ),
+           m_builtLevels( 0 )
     {
     }
 
     GeoDataLineStringPrivate()
          : m_rangeCorrected( 0 ),
            m_dirtyRange( true ),
-           m_dirtyBox( true )
+           m_dirtyBox( true ),
+           m_previousResolution( -1 ),
+           m_level( -1 ),
+           m_dirtyLevels( true ),
+           m_builtLevels( 0 )
     {
     }
 
@@ -51,6 +57,7 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
         m_dirtyRange = true;
         m_dirtyBox = other.m_dirtyBox;
         m_tessellationFlags = other.m_tessellationFlags;
+        m_dirtyLevels = true;
         return *this;
     }
 
@@ -91,6 +98,13 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     qreal resolutionForLevel(int level) const;
     void optimize(GeoDataLineString& lineString) const;
 
+    /**
+     * Assigns a detail level to each node, see GeoDataLineString::significantNodes().
+     */
+    void updateNodeLevels( bool closed ) const;
+
+    enum { maximumLevel = 17 };
+
     QVector<GeoDataCoordinates> m_vector;
 
     mutable GeoDataLineString*  m_rangeCorrected;
@@ -101,7 +115,13 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
                                             // been calculated. Saves performance. 
     TessellationFlags           m_tessellationFlags;
     mutable qreal  m_previousResolution;
-    mutable qreal  m_level;};
+    mutable qreal  m_level;
+
+    mutable bool                   m_dirtyLevels;
+    mutable QVector<quint8>        m_nodeLevels;
+    mutable QVector<QVector<int> > m_significantNodes;  // per level, built on demand
+    mutable quint32                m_builtLevels;       // bit mask of the levels in m_significantNodes
+};
 
 } // namespace Marble
 
@@ -174,14 +174,7 @@ const GeoDataGeometry* GeoDataMultiGeometry::child( int i ) const
  */
 int GeoDataMultiGeometry::childPosition( const GeoDataGeometry *object ) const
 {
-    for ( int i=0; i< p()->m_vector.size(); i++ )
-    {
-        if ( p()->m_vector.at( i ) == object )
-        {
-            return i;
-        }
-    }
-    return -1;
+    return p()->m_childPositions.position( p()->m_vector, object );
 }
 
 /**
@@ -192,6 +185,7 @@ void GeoDataMultiGeometry::append( GeoDataGeometry *other )
     detach();
     other->setParent( this );
     p()->m_vector.append( other );
+    p()->m_childPositions.inserted( p()->m_vector, p()->m_vector.size() - 1 );
 }
 
 
@@ -201,6 +195,7 @@ GeoDataMultiGeometry& GeoDataMultiGeometry::operator << ( const GeoDataGeometry&
     GeoDataGeometry *g = new GeoDataGeometry( value );
     g->setParent( this );
     p()->m_vector.append( g );
+    p()->m_childPositions.inserted( p()->m_vector, p()->m_vector.size() - 1 );
     return *this;
 }
 
@@ -209,6 +204,7 @@ void GeoDataMultiGeometry::clear()
     detach();
     qDeleteAll(p()->m_vector);
     p()->m_vector.clear();
+    p()->m_childPositions.invalidate();
 }
 
 void GeoDataMultiGeometry::pack( QDataStream& stream ) const
@@ -13,6 +13,8 @@
 
 #include "GeoDataGeometry_p.h"
 
+#include "GeoDataChildPositionIndex_p.h"
+
 #include "GeoDataPoint.h"
 #include "GeoDataPolygon.h"
 #include "GeoDataTrack.h"
@@ -43,6 +45,8 @@ class GeoDataMultiGeometryPrivate : public GeoDataGeometryPrivate
         GeoDataGeometryPrivate::operator=( other );
 
         qDeleteAll( m_vector );
+        m_vector.clear();
+        m_childPositions.invalidate();
         foreach( GeoDataGeometry *geometry, other.m_vector ) {
             GeoDataGeometry *newGeometry;
 
@@ -90,6 +94,7 @@ class GeoDataMultiGeometryPrivate : public GeoDataGeometryPrivate
         return GeoDataMultiGeometryId;
     }
     QVector<GeoDataGeometry*>  m_vector;
+    GeoDataChildPositionIndex<GeoDataGeometry> m_childPositions;
 };
 
 } // namespace Marble
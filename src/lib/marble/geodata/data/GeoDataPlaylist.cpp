@@ -9,6 +9,7 @@
 //
 
 #include "GeoDataPlaylist.h"
+#include "GeoDataChildPositionIndex_p.h"
 #include "GeoDataSoundCue.h"
 #include "GeoDataAnimatedUpdate.h"
 #include "GeoDataTourControl.h"
@@ -20,6 +21,33 @@
 namespace Marble
 {
 
+GeoDataPlaylist::GeoDataPlaylist() :
+    m_primitivePositions( new GeoDataChildPositionIndex<GeoDataTourPrimitive> )
+{
+    // nothing to do
+}
+
+GeoDataPlaylist::GeoDataPlaylist( const GeoDataPlaylist &other ) :
+    GeoDataObject( other ),
+    m_primitives( other.m_primitives ),
+    m_primitivePositions( new GeoDataChildPositionIndex<GeoDataTourPrimitive> )
+{
+    // nothing to do
+}
+
+GeoDataPlaylist::~GeoDataPlaylist()
+{
+    delete m_primitivePositions;
+}
+
+GeoDataPlaylist &GeoDataPlaylist::operator=( const GeoDataPlaylist &other )
+{
+    GeoDataObject::operator=( other );
+    m_primitives = other.m_primitives;
+    m_primitivePositions->invalidate();
+    return *this;
+}
+
 bool GeoDataPlaylist::operator==(const GeoDataPlaylist& other) const
 {
     if( this->m_primitives.size() != other.m_primitives.size() ){
@@ -100,10 +128,16 @@ const GeoDataTourPrimitive* GeoDataPlaylist::primitive(int id) const
     return m_primitives.at(id);
 }
 
+int GeoDataPlaylist::primitivePosition( const GeoDataTourPrimitive *primitive ) const
+{
+    return m_primitivePositions->position( m_primitives, primitive );
+}
+
 void GeoDataPlaylist::addPrimitive( GeoDataTourPrimitive *primitive )
 {
     primitive->setParent( this );
     m_primitives.push_back( primitive );
+    m_primitivePositions->inserted( m_primitives, m_primitives.size() - 1 );
 }
 
 void GeoDataPlaylist::insertPrimitive( int position, GeoDataTourPrimitive *primitive )
@@ -111,17 +145,21 @@ void GeoDataPlaylist::insertPrimitive( int position, GeoDataTourPrimitive *primi
     primitive->setParent( this );
     int const index = qBound( 0, position, m_primitives.size() );
     m_primitives.insert( index, primitive );
+    m_primitivePositions->inserted( m_primitives, index );
 }
 
 void GeoDataPlaylist::removePrimitiveAt(int position)
 {
+    const GeoDataTourPrimitive *primitive = m_primitives.at( position );
     m_primitives.removeAt( position );
+    m_primitivePositions->removed( m_primitives, position, primitive );
 }
 
 void GeoDataPlaylist::swapPrimitives( int positionA, int positionB )
 {
     if ( qMin( positionA, positionB ) >= 0 && qMax( positionA, positionB ) < m_primitives.size() ) {
         m_primitives.swap( positionA, positionB );
+        m_primitivePositions->swapped( m_primitives, positionA, positionB );
     }
 }
 
@@ -19,9 +19,16 @@
 namespace Marble
 {
 
+template<class T> class GeoDataChildPositionIndex;
+
 class GEODATA_EXPORT GeoDataPlaylist : public GeoDataObject
 {
 public:
+    GeoDataPlaylist();
+    GeoDataPlaylist( const GeoDataPlaylist &other );
+    ~GeoDataPlaylist();
+
+    GeoDataPlaylist &operator=( const GeoDataPlaylist &other );
 
     bool operator==( const GeoDataPlaylist &other ) const;
     bool operator!=( const GeoDataPlaylist &other ) const;
@@ -29,6 +36,11 @@ public:
 
     GeoDataTourPrimitive* primitive( int index );
     const GeoDataTourPrimitive* primitive( int index ) const;
+
+    /**
+     * Returns the index of @p primitive in the playlist, or -1 if it is not contained
+     */
+    int primitivePosition( const GeoDataTourPrimitive *primitive ) const;
     void addPrimitive( GeoDataTourPrimitive* primitive );
     void insertPrimitive( int index, GeoDataTourPrimitive* primitive );
     void removePrimitiveAt( int index );
@@ -38,6 +50,7 @@ public:
 
 private:
     QList<GeoDataTourPrimitive*> m_primitives;
+    GeoDataChildPositionIndex<GeoDataTourPrimitive> *m_primitivePositions;
 };
 
 } // namespace Marble
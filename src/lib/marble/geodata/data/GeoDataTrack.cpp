@@ -18,17 +18,31 @@
 
 #include "GeoDataLineString.h"
 
-#include <QMap>
-#include <QLinkedList>
+#include <QVector>
 #include "GeoDataExtendedData.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace Marble {
 
+namespace {
+    // timestamp of points without time information
+    const qint64 invalidWhen = std::numeric_limits<qint64>::min();
+
+    qint64 toMSecs( const QDateTime &when )
+    {
+        return when.isValid() ? when.toMSecsSinceEpoch() : invalidWhen;
+    }
+}
+
 class GeoDataTrackPrivate : public GeoDataGeometryPrivate
 {
 public:
     GeoDataTrackPrivate()
         : m_lineStringNeedsUpdate( false ),
+          m_sorted( true ),
+          m_orderNeedsUpdate( true ),
           m_interpolate( false )
     {
     }
@@ -43,14 +57,115 @@ public:
     {
         while ( m_when.size() < m_coordinates.size() ) {
             //fill coordinates without time information with null QDateTime
-            m_when.append( QDateTime() );
+            m_when.append( invalidWhen );
+            m_sorted = false;
         }
     }
 
+    void appendWhen( qint64 when )
+    {
+        m_sorted = m_sorted && when != invalidWhen && ( m_when.isEmpty() || m_when.last() <= when );
+        m_when.append( when );
+        m_orderNeedsUpdate = true;
+    }
+
+    void updateSorted()
+    {
+        m_sorted = true;
+        for ( int i = 0; i < m_when.size() && m_sorted; ++i ) {
+            m_sorted = m_when.at( i ) != invalidWhen && ( i == 0 || m_when.at( i - 1 ) <= m_when.at( i ) );
+        }
+        m_orderNeedsUpdate = true;
+    }
+
+    /**
+     * Number of points with both time and coordinates, in the order of their time.
+     */
+    int timedPointCount() const
+    {
+        if ( m_sorted ) {
+            return qMin( m_when.size(), m_coordinates.size() );
+        }
+        updateOrder();
+        return m_order.size();
+    }
+
+    /**
+     * Index of the @p i-th point in the order of time.
+     */
+    int timedPointIndex( int i ) const
+    {
+        return m_sorted ? i : m_order.at( i );
+    }
+
+    /**
+     * Returns the position in the order of time of the first point later than @p when.
+     */
+    int upperBound( qint64 when ) const
+    {
+        int first = 0;
+        int count = timedPointCount();
+        while ( count > 0 ) {
+            int const step = count / 2;
+            if ( m_when.at( timedPointIndex( first + step ) ) <= when ) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        return first;
+    }
+
+    void updateOrder() const
+    {
+        if ( !m_orderNeedsUpdate ) {
+            return;
+        }
+
+        // Points with the same time keep their order, so exact matches find
+        // the first of them and interpolation uses the last one.
+        m_order.clear();
+        int const size = qMin( m_when.size(), m_coordinates.size() );
+        for ( int i = 0; i < size; ++i ) {
+            if ( m_when.at( i ) != invalidWhen ) {
+                m_order.append( i );
+            }
+        }
+        std::stable_sort( m_order.begin(), m_order.end(), TimeLessThan( m_when ) );
+        m_orderNeedsUpdate = false;
+    }
+
+    struct TimeLessThan
+    {
+        explicit TimeLessThan( const QVector<qint64> &when ) : m_when( when ) {}
+        bool operator()( int a, int b ) const { return m_when.at( a ) < m_when.at( b ); }
+        const QVector<qint64> &m_when;
+    };
+
+    void removeAt( int index, int count )
+    {
+        m_when.remove( index, count );
+        if ( index < m_coordinates.size() ) {
+            m_coordinates.erase( m_coordinates.begin() + index,
+                                 m_coordinates.begin() + qMin( index + count, m_coordinates.size() ) );
+        }
+        m_lineStringNeedsUpdate = true;
+        m_orderNeedsUpdate = true;
+    }
+
     GeoDataLineString m_lineString;
     bool m_lineStringNeedsUpdate;
 
-    QList<QDateTime> m_when;
+    // Times in ms since the epoch. As long as they are all valid and
+    // in ascending order, points are looked up by binary search on
+    // m_when directly. Otherwise m_order holds the indices of the
+    // points with a valid time, sorted by time.
+    QVector<qint64> m_when;
+    bool m_sorted;
+    mutable QVector<int> m_order;
+    mutable bool m_orderNeedsUpdate;
+
     QList<GeoDataCoordinates> m_coordinates;
 
     GeoDataExtendedData m_extendedData;
@@ -111,20 +226,20 @@ void GeoDataTrack::setInterpolate(bool on)
 
 QDateTime GeoDataTrack::firstWhen() const
 {
-    if ( p()->m_when.isEmpty() ) {
+    if ( p()->m_when.isEmpty() || p()->m_when.first() == invalidWhen ) {
         return QDateTime();
     }
 
-    return p()->m_when.first();
+    return QDateTime::fromMSecsSinceEpoch( p()->m_when.first(), Qt::UTC );
 }
 
 QDateTime GeoDataTrack::lastWhen() const
 {
-    if ( p()->m_when.isEmpty() ) {
+    if ( p()->m_when.isEmpty() || p()->m_when.last() == invalidWhen ) {
         return QDateTime();
     }
 
-    return p()->m_when.last();
+    return QDateTime::fromMSecsSinceEpoch( p()->m_when.last(), Qt::UTC );
 }
 
 QList<GeoDataCoordinates> GeoDataTrack::coordinatesList() const
@@ -134,57 +249,61 @@ QList<GeoDataCoordinates> GeoDataTrack::coordinatesList() const
 
 QList<QDateTime> GeoDataTrack::whenList() const
 {
-    return p()->m_when;
+    QList<QDateTime> result;
+    result.reserve( p()->m_when.size() );
+    for ( int i = 0; i < p()->m_when.size(); ++i ) {
+        result.append( whenAt( i ) );
+    }
+    return result;
+}
+
+QDateTime GeoDataTrack::whenAt( int index ) const
+{
+    qint64 const when = p()->m_when.at( index );
+    return when == invalidWhen ? QDateTime() : QDateTime::fromMSecsSinceEpoch( when, Qt::UTC );
 }
 
 GeoDataCoordinates GeoDataTrack::coordinatesAt( const QDateTime &when ) const
 {
-    if ( p()->m_when.isEmpty() ) {
+    if ( p()->m_when.isEmpty() || !when.isValid() ) {
         return GeoDataCoordinates();
     }
 
-    if ( p()->m_when.contains( when ) ) {
-        //exact match found
-        int index = p()->m_when.indexOf( when );
-        if ( index < p()->m_coordinates.size() ) {
-            return p()->m_coordinates.at( index );
+    qint64 const msecs = when.toMSecsSinceEpoch();
+    int const next = p()->upperBound( msecs );
+    int const count = p()->timedPointCount();
+
+    // exact match found, use the first point with that time
+    if ( next > 0 && p()->m_when.at( p()->timedPointIndex( next - 1 ) ) == msecs ) {
+        int first = next - 1;
+        while ( first > 0 && p()->m_when.at( p()->timedPointIndex( first - 1 ) ) == msecs ) {
+            --first;
         }
+        return p()->m_coordinates.at( p()->timedPointIndex( first ) );
     }
 
     if ( !interpolate() ) {
         return GeoDataCoordinates();
     }
 
-    typedef QMap<QDateTime, GeoDataCoordinates> PointMap;
-    PointMap pointMap;
-    for ( int i = 0; i < qMin( p()->m_when.size(), p()->m_coordinates.size() ); ++i) {
-        if ( p()->m_when.at( i ).isValid() ) {
-            pointMap[ p()->m_when.at( i ) ] = p()->m_coordinates.at( i );
-        }
-    }
-
-    QMap<QDateTime, GeoDataCoordinates>::const_iterator nextEntry = const_cast<const PointMap&>(pointMap).upperBound( when );
-
     // No tracked point happened before "when"
-    if ( nextEntry == pointMap.constBegin() ) {
+    if ( next == 0 ) {
         mDebug() << "No tracked point before " << when;
         return GeoDataCoordinates();
     }
 
-    if ( nextEntry == pointMap.constEnd() ) {
+    if ( next == count ) {
         mDebug() << "No track point after" << when;
         return GeoDataCoordinates();
     }
 
-    QMap<QDateTime, GeoDataCoordinates>::const_iterator previousEntry = nextEntry - 1;
-    GeoDataCoordinates previousCoord = previousEntry.value();
+    int const previousIndex = p()->timedPointIndex( next - 1 );
+    int const nextIndex = p()->timedPointIndex( next );
+    GeoDataCoordinates previousCoord = p()->m_coordinates.at( previousIndex );
+    GeoDataCoordinates nextCoord = p()->m_coordinates.at( nextIndex );
 
-    QDateTime previousWhen = previousEntry.key();
-    QDateTime nextWhen = nextEntry.key();
-    GeoDataCoordinates nextCoord = nextEntry.value();
-
-    int interval = previousWhen.msecsTo( nextWhen );
-    int position = previousWhen.msecsTo( when );
+    qint64 interval = p()->m_when.at( nextIndex ) - p()->m_when.at( previousIndex );
+    qint64 position = msecs - p()->m_when.at( previousIndex );
     qreal t = (qreal)position / (qreal)interval;
 
     const Quaternion interpolated = Quaternion::slerp( previousCoord.quaternion(), nextCoord.quaternion(), t );
@@ -206,16 +325,35 @@ void GeoDataTrack::addPoint( const QDateTime &when, const GeoDataCoordinates &co
     detach();
 
     p()->equalizeWhenSize();
-    p()->m_lineStringNeedsUpdate = true;
-    int i=0;
-    while ( i < p()->m_when.size() ) {
-        if ( p()->m_when.at( i ) > when ) {
-            break;
+
+    qint64 const msecs = toMSecs( when );
+    int i = p()->m_when.size();
+    if ( p()->m_sorted ) {
+        if ( !p()->m_when.isEmpty() && msecs < p()->m_when.last() ) {
+            i = std::upper_bound( p()->m_when.constBegin(), p()->m_when.constEnd(), msecs ) - p()->m_when.constBegin();
+        }
+    } else {
+        i = 0;
+        while ( i < p()->m_when.size() ) {
+            if ( p()->m_when.at( i ) > msecs ) {
+                break;
+            }
+            ++i;
         }
-        ++i;
     }
-    p()->m_when.insert(i, when );
-    p()->m_coordinates.insert(i, coord );
+
+    if ( i == p()->m_when.size() ) {
+        // the common case of points arriving in order
+        p()->appendWhen( msecs );
+        p()->m_coordinates.append( coord );
+        return;
+    }
+
+    p()->m_when.insert( i, msecs );
+    p()->m_coordinates.insert( i, coord );
+    p()->m_sorted = p()->m_sorted && msecs != invalidWhen;
+    p()->m_orderNeedsUpdate = true;
+    p()->m_lineStringNeedsUpdate = true;
 }
 
 void GeoDataTrack::appendCoordinates( const GeoDataCoordinates &coord )
@@ -223,27 +361,27 @@ void GeoDataTrack::appendCoordinates( const GeoDataCoordinates &coord )
     detach();
 
     p()->equalizeWhenSize();
-    p()->m_lineStringNeedsUpdate = true;
     p()->m_coordinates.append( coord );
+    p()->m_orderNeedsUpdate = true;
 }
 
 void GeoDataTrack::appendAltitude( qreal altitude )
 {
     detach();
 
-    p()->m_lineStringNeedsUpdate = true;
     Q_ASSERT( !p()->m_coordinates.isEmpty() );
     if ( p()->m_coordinates.isEmpty() ) return;
-    GeoDataCoordinates coordinates = p()->m_coordinates.takeLast();
-    coordinates.setAltitude( altitude );
-    p()->m_coordinates.append( coordinates );
+    p()->m_coordinates.last().setAltitude( altitude );
+    if ( p()->m_lineString.size() == p()->m_coordinates.size() ) {
+        p()->m_lineStringNeedsUpdate = true;
+    }
 }
 
 void GeoDataTrack::appendWhen( const QDateTime &when )
 {
     detach();
 
-    p()->m_when.append( when );
+    p()->appendWhen( toMSecs( when ) );
 }
 
 void GeoDataTrack::clear()
@@ -252,6 +390,8 @@ void GeoDataTrack::clear()
 
     p()->m_when.clear();
     p()->m_coordinates.clear();
+    p()->m_sorted = true;
+    p()->m_orderNeedsUpdate = true;
     p()->m_lineStringNeedsUpdate = true;
 }
 
@@ -265,9 +405,21 @@ void GeoDataTrack::removeBefore( const QDateTime &when )
     }
     p()->equalizeWhenSize();
 
-    while ( !p()->m_when.isEmpty() && p()->m_when.first() < when ) {
-        p()->m_when.takeFirst();
-        p()->m_coordinates.takeFirst();
+    qint64 const msecs = toMSecs( when );
+    int count = 0;
+    if ( p()->m_sorted ) {
+        count = std::lower_bound( p()->m_when.constBegin(), p()->m_when.constEnd(), msecs ) - p()->m_when.constBegin();
+    } else {
+        while ( count < p()->m_when.size() && p()->m_when.at( count ) < msecs ) {
+            ++count;
+        }
+    }
+
+    if ( count > 0 ) {
+        p()->removeAt( 0, count );
+        if ( !p()->m_sorted ) {
+            p()->updateSorted();
+        }
     }
 }
 
@@ -280,10 +432,22 @@ void GeoDataTrack::removeAfter( const QDateTime &when )
         return;
     }
     p()->equalizeWhenSize();
-    while ( !p()->m_when.isEmpty() && p()->m_when.last() > when ) {
-        p()->m_when.takeLast();
-        p()->m_coordinates.takeLast();
 
+    qint64 const msecs = toMSecs( when );
+    int keep = p()->m_when.size();
+    if ( p()->m_sorted ) {
+        keep = std::upper_bound( p()->m_when.constBegin(), p()->m_when.constEnd(), msecs ) - p()->m_when.constBegin();
+    } else {
+        while ( keep > 0 && p()->m_when.at( keep - 1 ) > msecs ) {
+            --keep;
+        }
+    }
+
+    if ( keep < p()->m_when.size() ) {
+        p()->removeAt( keep, p()->m_when.size() - keep );
+        if ( !p()->m_sorted ) {
+            p()->updateSorted();
+        }
     }
 }
 
@@ -291,11 +455,14 @@ const GeoDataLineString *GeoDataTrack::lineString() const
 {
     if ( p()->m_lineStringNeedsUpdate ) {
         p()->m_lineString = GeoDataLineString();
-        foreach ( const GeoDataCoordinates &coordinates, coordinatesList() ) {
-            p()->m_lineString.append( coordinates );
-        }
         p()->m_lineStringNeedsUpdate = false;
     }
+
+    // Points appended since the last call are added to the cached line string.
+    for ( int i = p()->m_lineString.size(); i < p()->m_coordinates.size(); ++i ) {
+        p()->m_lineString.append( p()->m_coordinates.at( i ) );
+    }
+
     return &p()->m_lineString;
 }
 
@@ -106,10 +106,17 @@ public:
 
     /**
      * Returns the time value of all the points in the map, in chronological
-     * order.
+     * order. This converts every time value, use whenAt() to look at some
+     * of them only.
      */
     QList<QDateTime> whenList() const;
 
+    /**
+     * Return the time value at specified index, or an invalid QDateTime if the
+     * point has no time information.
+     */
+    QDateTime whenAt( int index ) const;
+
     /**
      * If interpolate() is true, return the coordinates interpolated from the
      * time values before and after @p when, otherwise return the coordinates
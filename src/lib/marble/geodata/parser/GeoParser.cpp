@@ -170,7 +170,8 @@ void GeoParser::parseDocument()
         while ( !atEnd() ) {
             readNext();
             if ( isEndElement() ) {
-                m_nodeStack.pop();
+                // the associated node may have been replaced while parsing the children
+                stackItem = m_nodeStack.pop();
 #if DUMP_PARENT_STACK > 0
                 dumpParentStack( name().toString(), m_nodeStack.size(), true );
 #endif
@@ -192,6 +193,24 @@ void GeoParser::parseDocument()
         dumpParentStack( name().toString() + "-discarded", m_nodeStack.size(), true );
     }
 #endif
+
+    elementParsed( stackItem );
+}
+
+void GeoParser::elementParsed( const GeoStackItem &item )
+{
+    Q_UNUSED( item );
+}
+
+void GeoParser::replaceNode( GeoNode *node, GeoNode *replacement )
+{
+    QStack<GeoStackItem>::iterator it = m_nodeStack.begin();
+    QStack<GeoStackItem>::iterator const end = m_nodeStack.end();
+    for (; it != end; ++it ) {
+        if ( it->associatedNode() == node ) {
+            it->assignNode( replacement );
+        }
+    }
 }
 
 void GeoParser::raiseWarning( const QString& warning )
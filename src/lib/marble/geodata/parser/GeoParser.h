@@ -85,6 +85,22 @@ protected:
 
     virtual GeoDocument* createDocument() const = 0;
 
+    /**
+     * This method is called whenever an element and all of its children
+     * have been parsed, with the element's parent still being on top of
+     * the parent chain. The default implementation does nothing.
+     * Reimplement it to process parsed nodes before the whole document has
+     * been read, e.g. to hand them off incrementally.
+     */
+    virtual void elementParsed( const GeoStackItem &item );
+
+    /**
+     * Replaces @p node by @p replacement in the parent chain, so that all
+     * children parsed from now on are associated with @p replacement.
+     * This allows to hand off a node before all of its children were parsed.
+     */
+    void replaceNode( GeoNode *node, GeoNode *replacement );
+
 protected:
     GeoDocument* m_document;
     GeoDataGenericSourceType m_source;
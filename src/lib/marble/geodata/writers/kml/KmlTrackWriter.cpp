@@ -30,11 +30,12 @@ bool KmlTrackWriter::write( const GeoNode *node, GeoWriter &writer ) const
     KmlObjectTagWriter::writeIdentifiers( writer, track );
 
     int points = track->size();
+    const QList<GeoDataCoordinates> coordinatesList = track->coordinatesList();
     for ( int i = 0; i < points; i++ ) {
-        writer.writeElement( "when", track->whenList().at( i ).toString( Qt::ISODate ) );
+        writer.writeElement( "when", track->whenAt( i ).toString( Qt::ISODate ) );
 
         qreal lon, lat, alt;
-        track->coordinatesList().at( i ).geoCoordinates( lon, lat, alt, GeoDataCoordinates::Degree );
+        coordinatesList.at( i ).geoCoordinates( lon, lat, alt, GeoDataCoordinates::Degree );
         QString coord = QString::number( lon, 'f', 10 ) + ' '
                         + QString::number( lat, 'f', 10 ) + ' ' + QString::number( alt, 'f', 10 );
 
@@ -663,8 +663,8 @@ void GeometryLayer::handleHighlight( qreal lon, qreal lat, GeoDataCoordinates::U
                  * highlight them.
                  */
                 if ( isHighlight ) {
-                    QVector<GeoDataFeature*>::Iterator iter = doc->begin();
-                    QVector<GeoDataFeature*>::Iterator const end = doc->end();
+                    QVector<GeoDataFeature*>::ConstIterator iter = doc->constBegin();
+                    QVector<GeoDataFeature*>::ConstIterator const end = doc->constEnd();
 
                     for ( ; iter != end; ++iter ) {
                         if ( (*iter)->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
@@ -688,8 +688,8 @@ void GeometryLayer::handleHighlight( qreal lon, qreal lat, GeoDataCoordinates::U
                             }
 
                             if ( multiGeometry ) {
-                                QVector<GeoDataGeometry*>::Iterator multiIter = multiGeometry->begin();
-                                QVector<GeoDataGeometry*>::Iterator const multiEnd = multiGeometry->end();
+                                QVector<GeoDataGeometry*>::ConstIterator multiIter = multiGeometry->constBegin();
+                                QVector<GeoDataGeometry*>::ConstIterator const multiEnd = multiGeometry->constEnd();
 
                                 for ( ; multiIter != multiEnd; ++multiIter ) {
                                     GeoDataPolygon *poly = dynamic_cast<GeoDataPolygon*>( *multiIter );
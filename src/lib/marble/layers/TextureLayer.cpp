@@ -54,6 +54,7 @@ public:
     void requestDelayedRepaint();
     void updateTextureLayers();
     void updateTile( const TileId &tileId, const QImage &tileImage );
+    void removeTile( const TileId &tileId );
 
     void addGroundOverlays( QModelIndex parent, int first, int last );
     void removeGroundOverlays( QModelIndex parent, int first, int last );
@@ -170,6 +171,13 @@ void TextureLayer::Private::updateTile( const TileId &tileId, const QImage &tile
     requestDelayedRepaint();
 }
 
+void TextureLayer::Private::removeTile( const TileId &tileId )
+{
+    // the scaled replacement of a tile whose download was canceled must
+    // not come back from the cache, loading it again restarts the download
+    m_tileLoader.removeTile( tileId );
+}
+
 bool TextureLayer::Private::drawOrderLessThan( const GeoDataGroundOverlay* o1, const GeoDataGroundOverlay* o2 )
 {
     return o1->drawOrder() < o2->drawOrder();
@@ -247,6 +255,8 @@ TextureLayer::TextureLayer( HttpDownloadManager *downloadManager,
 {
     connect( &d->m_loader, SIGNAL(tileCompleted(TileId,QImage)),
              this, SLOT(updateTile(TileId,QImage)) );
+    connect( &d->m_loader, SIGNAL(tileDownloadCanceled(TileId)),
+             this, SLOT(removeTile(TileId)) );
 
     // Repaint timer
     d->m_repaintTimer.setSingleShot( true );
@@ -348,6 +358,7 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
 
     const QRect dirtyRect = QRect( QPoint( 0, 0), viewport->size() );
     d->m_texmapper->mapTexture( painter, viewport, d->m_tileZoomLevel, dirtyRect, d->m_texcolorizer );
+    d->m_layerDecorator.setVisibleStackedTiles( d->m_tileLoader.visibleTiles().toVector(), d->m_centerCoordinates );
     d->m_renderState.addChild( d->m_tileLoader.renderState() );
     d->m_runtimeTrace = QString("Texture Cache: %1 ").arg(d->m_tileLoader.tileCount());
     return true;
@@ -381,124 +381,127 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
     const bool isLong = lineString.size() > 10;
     const int maximumDetail = levelForResolution(viewport->angularResolution());
     // The first node of optimized linestrings has a non-zero detail value.
-    const bool hasDetail = itBegin->detail() != 0;
+    const bool hasDetail = itBegin != itEnd && itBegin->detail() != 0;
+
+    // Optimization for line strings with a big amount of nodes: only visit
+    // the nodes that the current resolution can show.
+    const QVector<int> nodes = ( hasDetail || isLong ) ? lineString.significantNodes( maximumDetail )
+                                                       : QVector<int>();
+    int node = 0;
 
     while ( itCoords != itEnd )
     {
-        // Optimization for line strings with a big amount of nodes
-        bool skipNode = (hasDetail ? itCoords->detail() > maximumDetail
-                : itCoords != itBegin && isLong && !processingLastNode &&
-                !viewport->resolves( *itPreviousCoords, *itCoords ) );
-
-        if ( !skipNode ) {
-
-            q->screenCoordinates( *itCoords, viewport, x, y, globeHidesPoint );
+        q->screenCoordinates( *itCoords, viewport, x, y, globeHidesPoint );
 
-            // Initializing variables that store the values of the previous iteration
-            if ( !processingLastNode && itCoords == itBegin ) {
-                previousGlobeHidesPoint = globeHidesPoint;
-                itPreviousCoords = itCoords;
-                previousX = x;
-                previousY = y;
-            }
+        // Initializing variables that store the values of the previous iteration
+        if ( !processingLastNode && itCoords == itBegin ) {
+            previousGlobeHidesPoint = globeHidesPoint;
+            itPreviousCoords = itCoords;
+            previousX = x;
+            previousY = y;
+        }
 
-            // Check for the "horizon case" (which is present e.g. for the spherical projection
-            const bool isAtHorizon = ( globeHidesPoint || previousGlobeHidesPoint ) &&
-                                     ( globeHidesPoint !=  previousGlobeHidesPoint );
+        // Check for the "horizon case" (which is present e.g. for the spherical projection
+        const bool isAtHorizon = ( globeHidesPoint || previousGlobeHidesPoint ) &&
+                                 ( globeHidesPoint !=  previousGlobeHidesPoint );
 
-            if ( isAtHorizon ) {
-                // Handle the "horizon case"
-                horizonCoords = findHorizon( *itPreviousCoords, *itCoords, viewport, f );
+        if ( isAtHorizon ) {
+            // Handle the "horizon case"
+            horizonCoords = findHorizon( *itPreviousCoords, *itCoords, viewport, f );
 
-                if ( lineString.isClosed() ) {
-                    if ( horizonPair ) {
-                        horizonToPolygon( viewport, horizonDisappearCoords, horizonCoords, polygons.last() );
-                        horizonPair = false;
+            if ( lineString.isClosed() ) {
+                if ( horizonPair ) {
+                    horizonToPolygon( viewport, horizonDisappearCoords, horizonCoords, polygons.last() );
+                    horizonPair = false;
+                }
+                else {
+                    if ( globeHidesPoint ) {
+                        horizonDisappearCoords = horizonCoords;
+                        horizonPair = true;
                     }
                     else {
-                        if ( globeHidesPoint ) {
-                            horizonDisappearCoords = horizonCoords;
-                            horizonPair = true;
-                        }
-                        else {
-                            horizonOrphanCoords = horizonCoords;
-                            horizonOrphan = true;
-                        }
+                        horizonOrphanCoords = horizonCoords;
+                        horizonOrphan = true;
                     }
                 }
+            }
 
-                q->screenCoordinates( horizonCoords, viewport, horizonX, horizonY );
+            q->screenCoordinates( horizonCoords, viewport, horizonX, horizonY );
 
-                // If the line appears on the visible half we need
-                // to add an interpolated point at the horizon as the previous point.
-                if ( previousGlobeHidesPoint ) {
-                    *polygons.last() << QPointF( horizonX, horizonY );
-                }
+            // If the line appears on the visible half we need
+            // to add an interpolated point at the horizon as the previous point.
+            if ( previousGlobeHidesPoint ) {
+                *polygons.last() << QPointF( horizonX, horizonY );
             }
+        }
 
-            // This if-clause contains the section that tessellates the line
-            // segments of a linestring. If you are about to learn how the code of
-            // this class works you can safely ignore this section for a start.
+        // This if-clause contains the section that tessellates the line
+        // segments of a linestring. If you are about to learn how the code of
+        // this class works you can safely ignore this section for a start.
 
-            if ( lineString.tessellate() /* && ( isVisible || previousIsVisible ) */ ) {
+        if ( lineString.tessellate() /* && ( isVisible || previousIsVisible ) */ ) {
 
-                if ( !isAtHorizon ) {
+            if ( !isAtHorizon ) {
 
-                    tessellateLineSegment( *itPreviousCoords, previousX, previousY,
+                tessellateLineSegment( *itPreviousCoords, previousX, previousY,
+                                       *itCoords, x, y,
+                                       polygons, viewport,
+                                       f, !lineString.isClosed() );
+
+            }
+            else {
+                // Connect the interpolated  point at the horizon with the
+                // current or previous point in the line.
+                if ( previousGlobeHidesPoint ) {
+                    tessellateLineSegment( horizonCoords, horizonX, horizonY,
                                            *itCoords, x, y,
                                            polygons, viewport,
                                            f, !lineString.isClosed() );
-
                 }
                 else {
-                    // Connect the interpolated  point at the horizon with the
-                    // current or previous point in the line.
-                    if ( previousGlobeHidesPoint ) {
-                        tessellateLineSegment( horizonCoords, horizonX, horizonY,
-                                               *itCoords, x, y,
-                                               polygons, viewport,
-                                               f, !lineString.isClosed() );
-                    }
-                    else {
-                        tessellateLineSegment( *itPreviousCoords, previousX, previousY,
-                                               horizonCoords, horizonX, horizonY,
-                                               polygons, viewport,
-                                               f, !lineString.isClosed() );
-                    }
+                    tessellateLineSegment( *itPreviousCoords, previousX, previousY,
+                                           horizonCoords, horizonX, horizonY,
+                                           polygons, viewport,
+                                           f, !lineString.isClosed() );
                 }
             }
+        }
+        else {
+            if ( !globeHidesPoint ) {
+                *polygons.last() << QPointF( x, y );
+            }
             else {
-                if ( !globeHidesPoint ) {
-                    *polygons.last() << QPointF( x, y );
-                }
-                else {
-                    if ( !previousGlobeHidesPoint && isAtHorizon ) {
-                        *polygons.last() << QPointF( horizonX, horizonY );
-                    }
+                if ( !previousGlobeHidesPoint && isAtHorizon ) {
+                    *polygons.last() << QPointF( horizonX, horizonY );
                 }
             }
+        }
 
-            if ( globeHidesPoint ) {
-                if (   !previousGlobeHidesPoint
-                    && !lineString.isClosed()
-                    ) {
-                    polygons.append( new QPolygonF );
-                }
+        if ( globeHidesPoint ) {
+            if (   !previousGlobeHidesPoint
+                && !lineString.isClosed()
+                ) {
+                polygons.append( new QPolygonF );
             }
-
-            previousGlobeHidesPoint = globeHidesPoint;
-            itPreviousCoords = itCoords;
-            previousX = x;
-            previousY = y;
         }
 
+        previousGlobeHidesPoint = globeHidesPoint;
+        itPreviousCoords = itCoords;
+        previousX = x;
+        previousY = y;
+
         // Here we modify the condition to be able to process the
         // first node after the last node in a LinearRing.
 
         if ( processingLastNode ) {
             break;
         }
-        ++itCoords;
+        if ( nodes.isEmpty() ) {
+            ++itCoords;
+        } else {
+            ++node;
+            itCoords = node < nodes.size() ? itBegin + nodes.at( node ) : itEnd;
+        }
 
         if ( itCoords == itEnd  && lineString.isClosed() ) {
             itCoords = itBegin;
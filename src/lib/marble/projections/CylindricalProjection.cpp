@@ -293,60 +293,62 @@ bool CylindricalProjectionPrivate::lineStringToPolygon( const GeoDataLineString
     const bool isLong = lineString.size() > 10;
     const int maximumDetail = levelForResolution(viewport->angularResolution());
     // The first node of optimized linestrings has a non-zero detail value.
-    const bool hasDetail = itBegin->detail() != 0;
+    const bool hasDetail = itBegin != itEnd && itBegin->detail() != 0;
+
+    // Optimization for line strings with a big amount of nodes: only visit
+    // the nodes that the current resolution can show.
+    const QVector<int> nodes = ( hasDetail || isLong ) ? lineString.significantNodes( maximumDetail )
+                                                       : QVector<int>();
+    int node = 0;
 
     while ( itCoords != itEnd )
     {
-        // Optimization for line strings with a big amount of nodes
-        bool skipNode = (hasDetail ? itCoords->detail() > maximumDetail
-                : itCoords != itBegin && isLong && !processingLastNode &&
-                !viewport->resolves( *itPreviousCoords, *itCoords ) );
-
-        if ( !skipNode ) {
-
-
-            Q_Q( const CylindricalProjection );
-
-            q->screenCoordinates( *itCoords, viewport, x, y );
+        Q_Q( const CylindricalProjection );
 
-            // Initializing variables that store the values of the previous iteration
-            if ( !processingLastNode && itCoords == itBegin ) {
-                itPreviousCoords = itCoords;
-                previousX = x;
-                previousY = y;
-            }
+        q->screenCoordinates( *itCoords, viewport, x, y );
 
-            // This if-clause contains the section that tessellates the line
-            // segments of a linestring. If you are about to learn how the code of
-            // this class works you can safely ignore this section for a start.
+        // Initializing variables that store the values of the previous iteration
+        if ( !processingLastNode && itCoords == itBegin ) {
+            itPreviousCoords = itCoords;
+            previousX = x;
+            previousY = y;
+        }
 
-            if ( lineString.tessellate() ) {
+        // This if-clause contains the section that tessellates the line
+        // segments of a linestring. If you are about to learn how the code of
+        // this class works you can safely ignore this section for a start.
 
-                mirrorCount = tessellateLineSegment( *itPreviousCoords, previousX, previousY,
-                                           *itCoords, x, y,
-                                           polygons, viewport,
-                                           f, mirrorCount, distance );
-            }
+        if ( lineString.tessellate() ) {
 
-            else {
-                // special case for polys which cross dateline but have no Tesselation Flag
-                // the expected rendering is a screen coordinates straight line between
-                // points, but in projections with repeatX things are not smooth
-                mirrorCount = crossDateLine( *itPreviousCoords, *itCoords, x, y, polygons, mirrorCount, distance );
-            }
+            mirrorCount = tessellateLineSegment( *itPreviousCoords, previousX, previousY,
+                                       *itCoords, x, y,
+                                       polygons, viewport,
+                                       f, mirrorCount, distance );
+        }
 
-            itPreviousCoords = itCoords;
-            previousX = x;
-            previousY = y;
+        else {
+            // special case for polys which cross dateline but have no Tesselation Flag
+            // the expected rendering is a screen coordinates straight line between
+            // points, but in projections with repeatX things are not smooth
+            mirrorCount = crossDateLine( *itPreviousCoords, *itCoords, x, y, polygons, mirrorCount, distance );
         }
 
+        itPreviousCoords = itCoords;
+        previousX = x;
+        previousY = y;
+
         // Here we modify the condition to be able to process the
         // first node after the last node in a LinearRing.
 
         if ( processingLastNode ) {
             break;
         }
-        ++itCoords;
+        if ( nodes.isEmpty() ) {
+            ++itCoords;
+        } else {
+            ++node;
+            itCoords = node < nodes.size() ? itBegin + nodes.at( node ) : itEnd;
+        }
 
         if ( itCoords == itEnd  && lineString.isClosed() ) {
             itCoords = itBegin;
@@ -16,14 +16,65 @@
 #include "GeoDataPlacemark.h"
 #include "MarbleMath.h"
 
+#include <QFutureWatcher>
+#include <QPointF>
 #include <QTimer>
-#include <QPainter>
+#include <QtConcurrentRun>
+
+#include <algorithm>
 
 namespace Marble {
 
+/**
+  * The cells of a grid covered by a route, plus the values needed for scoring. The grid
+  * is chosen such that the route spans at most 64 cells in each direction, which bounds
+  * the cost of comparing two routes.
+  */
+struct RouteSignature
+{
+    RouteSignature();
+
+    /** Cells have an edge length of M_PI / 2^level radian */
+    int level;
+
+    /** Sorted keys of the covered cells, row in the upper and column in the lower 32 bit */
+    QVector<quint64> cells;
+
+    qreal length;
+
+    qreal instructionScore;
+};
+
+RouteSignature::RouteSignature() :
+    level( 0 ),
+    length( 0.0 ),
+    instructionScore( 0.0 )
+{
+    // nothing to do
+}
+
 class Q_DECL_HIDDEN AlternativeRoutesModel::Private
 {
 public:
+    /** A route waiting for its signature to be calculated in the thread pool */
+    struct PendingRoute
+    {
+        GeoDataDocument* document;
+        QFutureWatcher<RouteSignature>* watcher;
+        qreal instructionScore;
+    };
+
+    /** Orders routes by the score of their signatures, see higherScore() */
+    class HigherScore
+    {
+    public:
+        explicit HigherScore( const QHash<const GeoDataDocument*, RouteSignature> &signatures );
+        bool operator()( const GeoDataDocument* one, const GeoDataDocument* two ) const;
+
+    private:
+        const QHash<const GeoDataDocument*, RouteSignature> &m_signatures;
+    };
+
     Private();
 
     /**
@@ -36,9 +87,10 @@ public:
       * be treated as totally different (e.g. different route requests), two routes with a similarity
       * of 1 are considered equal. Otherwise the routes overlap to an extent indicated by the
       * similarity value -- the higher, the more they do overlap.
-      * @note: The direction of routes is important; reversed routes are not considered equal
+      * It is the share of grid cells covered by the longer route among all cells covered by
+      * any of them, compared in the coarser grid of both.
       */
-    static qreal similarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB );
+    static qreal similarity( const RouteSignature &routeA, const RouteSignature &routeB );
 
     /**
       * Returns the distance between the given polygon and the given point
@@ -63,15 +115,24 @@ public:
     static GeoDataCoordinates coordinates( const GeoDataCoordinates &start, qreal distance, qreal bearing );
 
     /**
-      * Returns the similarity between routeA and routeB. This method is not symmetric, i.e. in
-      * general unidirectionalSimilarity(a,b) != unidirectionalSimilarity(b,a)
+      * Calculates the grid cells and the length of a route given by its points in radian.
+      * Runs in the thread pool.
       */
-    static qreal unidirectionalSimilarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB );
+    static RouteSignature analyze( const QVector<QPointF> &points );
+
+    /** Returns the cells of the signature in the grid of the given, coarser level */
+    static QVector<quint64> cells( const RouteSignature &signature, int level );
+
+    /** Returns the signature of a route, calculating it if needed */
+    const RouteSignature &signature( const GeoDataDocument* document );
+
+    /** Starts calculating the signature of a route in the thread pool */
+    void startAnalysis( GeoDataDocument* document, AlternativeRoutesModel* model );
 
     /**
       * (Primitive) scoring for routes
       */
-    static bool higherScore( const GeoDataDocument* one, const GeoDataDocument* two );
+    static bool higherScore( const RouteSignature &one, const RouteSignature &two );
 
     /**
       * Returns true if the given route contains instructions (placemarks with turn instructions)
@@ -80,9 +141,7 @@ public:
 
     static const GeoDataLineString* waypoints( const GeoDataDocument* document );
 
-    static int nonZero( const QImage &image );
-
-    static QPolygonF polygon( const GeoDataLineString &lineString, qreal x, qreal y, qreal sx, qreal sy );
+    static QVector<QPointF> points( const GeoDataDocument* document );
 
     /** The currently shown alternative routes (model data) */
     QVector<GeoDataDocument*> m_routes;
@@ -90,6 +149,11 @@ public:
     /** Pending route data (waiting for other results to come in) */
     QVector<GeoDataDocument*> m_restrainedRoutes;
 
+    /** Routes whose signature is being calculated, in the order they arrived */
+    QList<PendingRoute> m_pendingRoutes;
+
+    QHash<const GeoDataDocument*, RouteSignature> m_signatures;
+
     /** Counts the time between route request and first result */
     QTime m_responseTime;
 
@@ -103,45 +167,127 @@ AlternativeRoutesModel::Private::Private() :
     // nothing to do
 }
 
-int AlternativeRoutesModel::Private::nonZero( const QImage &image )
+bool AlternativeRoutesModel::Private::filter( const GeoDataDocument* document ) const
 {
-  QRgb const black = qRgb( 0, 0, 0 );
-  int count = 0;
-  for ( int y = 0; y < image.height(); ++y ) {
-      QRgb* destLine = (QRgb*) image.scanLine( y );
-      for ( int x = 0; x < image.width(); ++x ) {
-          count += destLine[x] == black ? 0 : 1;
-      }
-  }
-  return count;
+    for ( int i=0; i<m_routes.size(); ++i ) {
+        qreal similarity = Private::similarity( m_signatures.value( document ), m_signatures.value( m_routes.at( i ) ) );
+        if ( similarity > 0.8 ) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
-QPolygonF AlternativeRoutesModel::Private::polygon( const GeoDataLineString &lineString, qreal x, qreal y, qreal sx, qreal sy )
+qreal AlternativeRoutesModel::Private::similarity( const RouteSignature &routeA, const RouteSignature &routeB )
 {
-    QPolygonF poly;
-    for ( int i = 0; i < lineString.size(); ++i ) {
-        poly << QPointF( qAbs( ( lineString)[i].longitude() - x ) * sx,
-                         qAbs( ( lineString)[i].latitude()  - y ) * sy );
+    int const level = qMin( routeA.level, routeB.level );
+    QVector<quint64> const cellsA = cells( routeA, level );
+    QVector<quint64> const cellsB = cells( routeB, level );
+
+    int common = 0;
+    for ( int a = 0, b = 0; a < cellsA.size() && b < cellsB.size(); ) {
+        if ( cellsA[a] < cellsB[b] ) {
+            ++a;
+        } else if ( cellsB[b] < cellsA[a] ) {
+            ++b;
+        } else {
+            ++common;
+            ++a;
+            ++b;
+        }
     }
-    return poly;
+
+    int const united = cellsA.size() + cellsB.size() - common;
+    return united ? qreal( qMax( cellsA.size(), cellsB.size() ) ) / united : 0.0;
 }
 
-bool AlternativeRoutesModel::Private::filter( const GeoDataDocument* document ) const
+QVector<quint64> AlternativeRoutesModel::Private::cells( const RouteSignature &signature, int level )
 {
-    for ( int i=0; i<m_routes.size(); ++i ) {
-        qreal similarity = Private::similarity( document, m_routes.at( i ) );
-        if ( similarity > 0.8 ) {
-            return true;
+    Q_ASSERT( level <= signature.level );
+    if ( level == signature.level ) {
+        return signature.cells;
+    }
+
+    int const shift = signature.level - level;
+    QVector<quint64> result;
+    result.reserve( signature.cells.size() );
+    foreach ( quint64 cell, signature.cells ) {
+        quint64 const row = ( cell >> 32 ) >> shift;
+        quint64 const column = ( cell & 0xffffffff ) >> shift;
+        result.append( ( row << 32 ) | column );
+    }
+
+    std::sort( result.begin(), result.end() );
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+    return result;
+}
+
+RouteSignature AlternativeRoutesModel::Private::analyze( const QVector<QPointF> &points )
+{
+    RouteSignature result;
+    if ( points.isEmpty() ) {
+        return result;
+    }
+
+    qreal west = points.first().x();
+    qreal east = west;
+    qreal south = points.first().y();
+    qreal north = south;
+    for ( int i = 1; i < points.size(); ++i ) {
+        west = qMin( west, points[i].x() );
+        east = qMax( east, points[i].x() );
+        south = qMin( south, points[i].y() );
+        north = qMax( north, points[i].y() );
+        result.length += distanceSphere( points[i-1].x(), points[i-1].y(), points[i].x(), points[i].y() ) * EARTH_RADIUS;
+    }
+
+    // the largest level whose cells still cover the route with 64 cells per direction
+    qreal const extent = qMax( east - west, north - south );
+    result.level = extent > 0 ? qBound( 0, int( floor( log( 64 * M_PI / extent ) / M_LN2 ) ), 24 ) : 24;
+    qreal const cellSize = M_PI / ( 1 << result.level );
+
+    // segments are sampled at half the cell size so that no covered cell is skipped
+    for ( int i = 0; i < points.size(); ++i ) {
+        QPointF const &point = points[i];
+        QPointF const delta = i > 0 ? point - points[i-1] : QPointF();
+        int const steps = qAbs( delta.x() ) > M_PI ? 1 : qMax( 1, int( ceil( qMax( qAbs( delta.x() ), qAbs( delta.y() ) ) * 2 / cellSize ) ) );
+        for ( int step = i > 0 ? 1 : steps; step <= steps; ++step ) {
+            QPointF const sample = point - delta * ( 1.0 - qreal( step ) / steps );
+            quint64 const column = quint64( ( sample.x() + M_PI ) / cellSize );
+            quint64 const row = quint64( ( sample.y() + M_PI / 2 ) / cellSize );
+            result.cells.append( ( row << 32 ) | column );
         }
     }
 
-    return false;
+    std::sort( result.cells.begin(), result.cells.end() );
+    result.cells.erase( std::unique( result.cells.begin(), result.cells.end() ), result.cells.end() );
+    return result;
 }
 
-qreal AlternativeRoutesModel::Private::similarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB )
+const RouteSignature &AlternativeRoutesModel::Private::signature( const GeoDataDocument* document )
 {
-    return qMax<qreal>( unidirectionalSimilarity( routeA, routeB ),
-                        unidirectionalSimilarity( routeB, routeA ) );
+    QHash<const GeoDataDocument*, RouteSignature>::iterator iter = m_signatures.find( document );
+    if ( iter == m_signatures.end() ) {
+        RouteSignature signature = analyze( points( document ) );
+        signature.instructionScore = instructionScore( document );
+        iter = m_signatures.insert( document, signature );
+    }
+
+    return iter.value();
+}
+
+void AlternativeRoutesModel::Private::startAnalysis( GeoDataDocument* document, AlternativeRoutesModel* model )
+{
+    PendingRoute pending;
+    pending.document = document;
+    pending.instructionScore = instructionScore( document );
+    pending.watcher = new QFutureWatcher<RouteSignature>( model );
+    QObject::connect( pending.watcher, SIGNAL(finished()), model, SLOT(addAnalyzedRoutes()) );
+    m_pendingRoutes << pending;
+
+    // only plain coordinates are passed to the thread pool, the document stays in this thread
+    pending.watcher->setFuture( QtConcurrent::run( &Private::analyze, points( document ) ) );
 }
 
 qreal AlternativeRoutesModel::Private::distance( const GeoDataLineString &wayPoints, const GeoDataCoordinates &position )
@@ -195,50 +341,24 @@ qreal AlternativeRoutesModel::Private::distance( const GeoDataCoordinates &satel
     }
 }
 
-qreal AlternativeRoutesModel::Private::unidirectionalSimilarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB )
+bool AlternativeRoutesModel::Private::higherScore( const RouteSignature &one, const RouteSignature &two )
 {
-    const GeoDataLineString* waypointsA = waypoints( routeA );
-    const GeoDataLineString* waypointsB = waypoints( routeB );
-    if ( !waypointsA || !waypointsB )
-    {
-        return 0.0;
-    }
-
-    QImage image( 64, 64, QImage::Format_ARGB32_Premultiplied );
-    image.fill( qRgb( 0, 0, 0 ) );
-    GeoDataLatLonBox box = GeoDataLatLonBox::fromLineString( *waypointsA );
-    box = box.united( GeoDataLatLonBox::fromLineString( *waypointsB ) );
-    if ( !box.width() || !box.height() ) {
-      return 0.0;
+    if ( one.instructionScore != two.instructionScore ) {
+        return one.instructionScore > two.instructionScore;
     }
 
-    qreal const sw = image.width() / box.width();
-    qreal const sh = image.height() / box.height();
-
-    QPainter painter( &image );
-    painter.setPen( QColor( Qt::white ) );
-
-    painter.drawPoints( Private::polygon( *waypointsA, box.west(), box.north(), sw, sh ) );
-    int const countA = Private::nonZero( image );
-
-    painter.drawPoints( Private::polygon( *waypointsB, box.west(), box.north(), sw, sh ) );
-    int const countB = Private::nonZero( image );
-    Q_ASSERT( countA <= countB );
-    return countB ? 1.0 - qreal( countB - countA ) / countB : 0;
+    return one.length < two.length;
 }
 
-bool AlternativeRoutesModel::Private::higherScore( const GeoDataDocument* one, const GeoDataDocument* two )
+AlternativeRoutesModel::Private::HigherScore::HigherScore( const QHash<const GeoDataDocument*, RouteSignature> &signatures ) :
+    m_signatures( signatures )
 {
-    qreal instructionScoreA = instructionScore( one );
-    qreal instructionScoreB = instructionScore( two );
-    if ( instructionScoreA != instructionScoreB ) {
-        return instructionScoreA > instructionScoreB;
-    }
-
-    qreal lengthA = waypoints( one )->length( EARTH_RADIUS );
-    qreal lengthB = waypoints( two )->length( EARTH_RADIUS );
+    // nothing to do
+}
 
-    return lengthA < lengthB;
+bool AlternativeRoutesModel::Private::HigherScore::operator()( const GeoDataDocument* one, const GeoDataDocument* two ) const
+{
+    return higherScore( m_signatures.value( one ), m_signatures.value( two ) );
 }
 
 qreal AlternativeRoutesModel::Private::instructionScore( const GeoDataDocument* document )
@@ -293,6 +413,19 @@ const GeoDataLineString* AlternativeRoutesModel::Private::waypoints( const GeoDa
     return 0;
 }
 
+QVector<QPointF> AlternativeRoutesModel::Private::points( const GeoDataDocument* document )
+{
+    QVector<QPointF> result;
+    const GeoDataLineString* lineString = waypoints( document );
+    if ( lineString ) {
+        result.reserve( lineString->size() );
+        for ( int i = 0; i < lineString->size(); ++i ) {
+            result << QPointF( lineString->at( i ).longitude(), lineString->at( i ).latitude() );
+        }
+    }
+    return result;
+}
+
 AlternativeRoutesModel::AlternativeRoutesModel( QObject *parent ) :
         QAbstractListModel( parent ),
         d( new Private() )
@@ -302,6 +435,9 @@ AlternativeRoutesModel::AlternativeRoutesModel( QObject *parent ) :
 
 AlternativeRoutesModel::~AlternativeRoutesModel()
 {
+    foreach ( const Private::PendingRoute &pending, d->m_pendingRoutes ) {
+        delete pending.document;
+    }
     delete d;
 }
 
@@ -345,7 +481,7 @@ void AlternativeRoutesModel::newRequest( RouteRequest * )
 void AlternativeRoutesModel::addRestrainedRoutes()
 {
     Q_ASSERT( d->m_routes.isEmpty() );
-    qSort( d->m_restrainedRoutes.begin(), d->m_restrainedRoutes.end(), Private::higherScore );
+    std::sort( d->m_restrainedRoutes.begin(), d->m_restrainedRoutes.end(), Private::HigherScore( d->m_signatures ) );
 
     foreach( GeoDataDocument* route, d->m_restrainedRoutes ) {
         if ( !d->filter( route ) ) {
@@ -354,6 +490,10 @@ void AlternativeRoutesModel::addRestrainedRoutes()
 //            GeoDataDocument* base = d->m_routes.isEmpty() ? 0 : d->m_routes.first();
             d->m_routes.push_back( route );
             endInsertRows();
+        } else {
+            // a dropped route must not leave its signature behind, another
+            // document may get the same address later
+            d->m_signatures.remove( route );
         }
     }
 
@@ -372,6 +512,25 @@ void AlternativeRoutesModel::addRoute( GeoDataDocument* document, WritePolicy po
         return;
     }
 
+    // Comparing long routes is expensive, it is prepared in the thread pool
+    d->startAnalysis( document, this );
+}
+
+void AlternativeRoutesModel::addAnalyzedRoutes()
+{
+    // keep the order in which the routes arrived
+    while ( !d->m_pendingRoutes.isEmpty() && d->m_pendingRoutes.first().watcher->isFinished() ) {
+        Private::PendingRoute const pending = d->m_pendingRoutes.takeFirst();
+        RouteSignature signature = pending.watcher->result();
+        signature.instructionScore = pending.instructionScore;
+        d->m_signatures.insert( pending.document, signature );
+        pending.watcher->deleteLater();
+        addAnalyzedRoute( pending.document );
+    }
+}
+
+void AlternativeRoutesModel::addAnalyzedRoute( GeoDataDocument* document )
+{
     if ( d->m_routes.isEmpty() && d->m_restrainedRoutes.isEmpty() ) {
         // First
         int responseTime = d->m_responseTime.elapsed();
@@ -382,13 +541,19 @@ void AlternativeRoutesModel::addRoute( GeoDataDocument* document, WritePolicy po
     } else if ( d->m_routes.isEmpty() && !d->m_restrainedRoutes.isEmpty() ) {
         d->m_restrainedRoutes.push_back( document );
     } else {
+        // copies, looking up a signature may rehash
+        RouteSignature const signature = d->signature( document );
         for ( int i=0; i<d->m_routes.size(); ++i ) {
-            qreal similarity = Private::similarity( document, d->m_routes.at( i ) );
+            RouteSignature const other = d->signature( d->m_routes.at( i ) );
+            qreal similarity = Private::similarity( signature, other );
             if ( similarity > 0.8 ) {
-                if ( Private::higherScore( document, d->m_routes.at( i ) ) ) {
+                if ( Private::higherScore( signature, other ) ) {
+                    d->m_signatures.remove( d->m_routes.at( i ) );
                     d->m_routes[i] = document;
                     QModelIndex changed = index( i );
                     emit dataChanged( changed, changed );
+                } else {
+                    d->m_signatures.remove( document );
                 }
 
                 return;
@@ -433,6 +598,15 @@ void AlternativeRoutesModel::clear()
     QVector<GeoDataDocument*> routes = d->m_routes;
     d->m_currentIndex = -1;
     d->m_routes.clear();
+    foreach ( const Private::PendingRoute &pending, d->m_pendingRoutes ) {
+        // the result of a running analysis is simply not used anymore
+        delete pending.watcher;
+        routes << pending.document;
+    }
+    d->m_pendingRoutes.clear();
+    foreach ( const GeoDataDocument* route, routes ) {
+        d->m_signatures.remove( route );
+    }
     qDeleteAll(routes);
     endResetModel();
 }
@@ -89,7 +89,11 @@ Q_SIGNALS:
 private Q_SLOTS:
     void addRestrainedRoutes();
 
+    void addAnalyzedRoutes();
+
 private:
+    void addAnalyzedRoute( GeoDataDocument* document );
+
     class Private;
     Private *const d;
 };
@@ -10,9 +10,40 @@
 
 #include "Route.h"
 
+#include "MarbleGlobal.h"
+#include "MarbleMath.h"
+
+#include <cmath>
+#include <algorithm>
+
 namespace Marble
 {
 
+namespace
+{
+    // edge length of the cells of the segment index in radians, about 1.3 km on Earth
+    qreal const indexCellSize = 0.0002;
+
+    // number of segments following the last matched one which are always checked
+    int const forwardWindow = 3;
+
+    inline int indexCell( qreal angle )
+    {
+        return int( floor( angle / indexCellSize ) );
+    }
+
+    inline qint64 indexKey( int x, int y )
+    {
+        return ( qint64( y ) << 32 ) | quint32( x );
+    }
+
+    /** Maps cells west of -180 or east of +180 degrees to the cells they wrap around to */
+    inline int wrappedIndexCell( int x )
+    {
+        return indexCell( GeoDataCoordinates::normalizeLon( ( x + 0.5 ) * indexCellSize ) );
+    }
+}
+
 Route::Route() :
     m_distance( 0.0 ),
     m_travelTime( 0 ),
@@ -27,6 +58,7 @@ void Route::addRouteSegment( const RouteSegment &segment )
     if ( segment.isValid() ) {
         m_bounds = m_bounds.united( segment.bounds() );
         m_distance += segment.distance();
+        m_pathOffsets << m_path.size();
         m_path << segment.path();
         if ( segment.maneuver().position().isValid() ) {
             m_turnPoints << segment.maneuver().position();
@@ -36,6 +68,7 @@ void Route::addRouteSegment( const RouteSegment &segment )
         }
         m_segments.push_back( segment );
         m_positionDirty = true;
+        addToIndex( m_segments.size() - 1 );
 
         for ( int i=1; i<m_segments.size(); ++i ) {
             m_segments[i-1].setNextRouteSegment(&m_segments[i]);
@@ -94,6 +127,106 @@ GeoDataCoordinates Route::position() const
     return m_position;
 }
 
+void Route::addToIndex( int segmentIndex )
+{
+    // Long edges are sampled at least twice per cell. Cells they touch
+    // in between are found by extending queries by one cell.
+    const GeoDataLineString &path = m_segments[segmentIndex].path();
+    for ( int i = 0; i < path.size(); ++i ) {
+        addToIndex( segmentIndex, path[i] );
+        if ( i + 1 < path.size() ) {
+            qreal deltaLon = path[i+1].longitude() - path[i].longitude();
+            qreal const deltaLat = path[i+1].latitude() - path[i].latitude();
+            if ( deltaLon > M_PI ) {
+                // crosses the date line westwards
+                deltaLon -= 2 * M_PI;
+            } else if ( deltaLon < -M_PI ) {
+                deltaLon += 2 * M_PI;
+            }
+
+            int const steps = int( 2.0 * qMax( qAbs( deltaLon ), qAbs( deltaLat ) ) / indexCellSize );
+            for ( int j = 1; j < steps; ++j ) {
+                qreal const t = qreal( j ) / steps;
+                qreal const lon = GeoDataCoordinates::normalizeLon( path[i].longitude() + t * deltaLon );
+                addToIndex( segmentIndex, GeoDataCoordinates( lon, path[i].latitude() + t * deltaLat ) );
+            }
+        }
+    }
+}
+
+void Route::addToIndex( int segmentIndex, const GeoDataCoordinates &position )
+{
+    QVector<int> &cell = m_segmentIndex[indexKey( indexCell( position.longitude() ), indexCell( position.latitude() ) )];
+    if ( cell.isEmpty() || cell.last() != segmentIndex ) {
+        cell.append( segmentIndex );
+    }
+}
+
+QVector<int> Route::segmentsNear( const GeoDataCoordinates &position, qreal distance ) const
+{
+    qreal const radius = distance / EARTH_RADIUS;
+    qreal const cosLat = cos( position.latitude() );
+    qreal const lonRadius = cosLat > 0.0 ? radius / cosLat : 2 * M_PI;
+
+    int const west = indexCell( position.longitude() - lonRadius ) - 1;
+    int const east = indexCell( position.longitude() + lonRadius ) + 1;
+    int const south = indexCell( position.latitude() - radius ) - 1;
+    int const north = indexCell( position.latitude() + radius ) + 1;
+
+    QVector<int> result;
+    if ( lonRadius >= M_PI || qreal( east - west + 1 ) * ( north - south + 1 ) > m_segmentIndex.size() ) {
+        // far off the route, or close to a pole
+        result.reserve( m_segments.size() );
+        for ( int i = 0; i < m_segments.size(); ++i ) {
+            result << i;
+        }
+        return result;
+    }
+
+    // the cells next to the date line are looked up on both sides of it
+    for ( int y = south; y <= north; ++y ) {
+        for ( int x = west; x <= east; ++x ) {
+            QHash<qint64, QVector<int> >::const_iterator const cell = m_segmentIndex.constFind( indexKey( wrappedIndexCell( x ), y ) );
+            if ( cell != m_segmentIndex.constEnd() ) {
+                result << cell.value();
+            }
+        }
+    }
+
+    std::sort( result.begin(), result.end() );
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+    return result;
+}
+
+int Route::closestPathIndex( const GeoDataCoordinates &position ) const
+{
+    // Path points are indexed in the cell they lie in, so the closest point
+    // of the segments near the position is the closest one of the whole path
+    // if it is within the searched distance. Otherwise the search widens,
+    // until it covers all segments.
+    qreal distance = indexCellSize * EARTH_RADIUS;
+    forever {
+        QVector<int> const candidates = segmentsNear( position, distance );
+        qreal minDistance = -1.0;
+        int result = -1;
+        foreach( int i, candidates ) {
+            const GeoDataLineString &path = m_segments[i].path();
+            for ( int j = 0; j < path.size(); ++j ) {
+                qreal const pointDistance = distanceSphere( path[j], position );
+                if ( minDistance < 0.0 || pointDistance < minDistance ) {
+                    minDistance = pointDistance;
+                    result = m_pathOffsets[i] + j;
+                }
+            }
+        }
+
+        if ( candidates.size() == m_segments.size() || ( result >= 0 && minDistance * EARTH_RADIUS <= distance ) ) {
+            return result;
+        }
+        distance *= 4.0;
+    }
+}
+
 void Route::updatePosition() const
 {
     if ( !m_segments.isEmpty() ) {
@@ -102,24 +235,38 @@ void Route::updatePosition() const
         }
 
         qreal distance = m_segments[m_closestSegmentIndex].distanceTo( m_position, m_currentWaypoint, m_positionOnRoute );
-        QList<int> candidates;
-
-        for ( int i=0; i<m_segments.size(); ++i ) {
-            if ( i != m_closestSegmentIndex && m_segments[i].minimalDistanceTo( m_position ) <= distance ) {
-                candidates << i;
-            }
-        }
-
         GeoDataCoordinates closest, interpolated;
-        foreach( int i, candidates ) {
+
+        // Most of the time the position is still on the last matched
+        // segment or has moved on to one of the next ones
+        int const windowStart = m_closestSegmentIndex;
+        int const windowEnd = qMin( windowStart + 1 + forwardWindow, m_segments.size() );
+        for ( int i = windowStart + 1; i < windowEnd; ++i ) {
             qreal const dist = m_segments[i].distanceTo( m_position, closest, interpolated );
-            if ( distance < 0.0 || dist < distance ) {
+            if ( dist < distance ) {
                 distance = dist;
                 m_closestSegmentIndex = i;
                 m_positionOnRoute = interpolated;
                 m_currentWaypoint = closest;
             }
         }
+
+        // Any other segment which is closer must pass near the position
+        foreach( int i, segmentsNear( m_position, distance ) ) {
+            if ( i >= windowStart && i < windowEnd ) {
+                continue;
+            }
+
+            if ( m_segments[i].minimalDistanceTo( m_position ) <= distance ) {
+                qreal const dist = m_segments[i].distanceTo( m_position, closest, interpolated );
+                if ( dist < distance ) {
+                    distance = dist;
+                    m_closestSegmentIndex = i;
+                    m_positionOnRoute = interpolated;
+                    m_currentWaypoint = closest;
+                }
+            }
+        }
     }
 
     m_positionDirty = false;
@@ -14,6 +14,8 @@
 #include "RouteSegment.h"
 #include "GeoDataLatLonBox.h"
 
+#include <QHash>
+
 namespace Marble
 {
 
@@ -50,17 +52,35 @@ public:
 
     GeoDataCoordinates positionOnRoute() const;
 
+    /**
+     * Returns the index of the point of path() closest to @p position,
+     * or -1 if the route is empty.
+     */
+    int closestPathIndex( const GeoDataCoordinates &position ) const;
+
 private:
     void updatePosition() const;
 
+    void addToIndex( int segmentIndex );
+
+    void addToIndex( int segmentIndex, const GeoDataCoordinates &position );
+
+    QVector<int> segmentsNear( const GeoDataCoordinates &position, qreal distance ) const;
+
     GeoDataLatLonBox m_bounds;
 
     qreal m_distance;
 
     QVector<RouteSegment> m_segments;
 
+    /** Indices of the segments passing through each cell of a lon/lat grid */
+    QHash<qint64, QVector<int> > m_segmentIndex;
+
     GeoDataLineString m_path;
 
+    /** Index of the first point of each segment in m_path */
+    QVector<int> m_pathOffsets;
+
     GeoDataLineString m_turnPoints;
 
     GeoDataLineString m_waypoints;
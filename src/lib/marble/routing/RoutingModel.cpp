@@ -43,7 +43,13 @@ public:
     RouteRequest* const m_request;
     QHash<int, QByteArray> m_roleNames;
 
+    // maps the via points of m_request to the closest points of the route path, see rightNeighbor()
+    QVector<GeoDataCoordinates> m_mappedViaPoints;
+    QMap<int,int> m_viaPointMapping;
+
     void updateViaPoints( const GeoDataCoordinates &position );
+
+    void updateViaPointMapping( const RouteRequest *route );
 };
 
 RoutingModelPrivate::RoutingModelPrivate( RouteRequest* request )
@@ -67,6 +73,45 @@ void RoutingModelPrivate::updateViaPoints( const GeoDataCoordinates &position )
     }
 }
 
+void RoutingModelPrivate::updateViaPointMapping( const RouteRequest *route )
+{
+    QVector<GeoDataCoordinates> viaPoints;
+    viaPoints.reserve( route->size() );
+    for ( int i=0; i<route->size(); ++i ) {
+        viaPoints << route->at( i );
+    }
+
+    if ( viaPoints == m_mappedViaPoints ) {
+        return;
+    }
+
+    // Generate an ordered list of all waypoints
+    GeoDataLineString const &points = m_route.path();
+    QMap<int,int> mapping;
+
+    // Force first mapping point to match the route start
+    mapping[0] = 0;
+
+    // Calculate the mapping between waypoints and via points
+    // Need two for loops to avoid getting stuck in local minima
+    for ( int j=1; j<route->size()-1; ++j ) {
+        qreal minDistance = -1.0;
+        for ( int i=mapping[j-1]; i<points.size(); ++i ) {
+            qreal distance = distanceSphere( points[i], route->at(j) );
+            if (minDistance < 0.0 || distance < minDistance ) {
+                mapping[j] = i;
+                minDistance = distance;
+            }
+        }
+    }
+
+    // Force last mapping point to match the route destination
+    mapping[route->size()-1] = points.size()-1;
+
+    m_viaPointMapping = mapping;
+    m_mappedViaPoints = viaPoints;
+}
+
 RoutingModel::RoutingModel( RouteRequest* request, MarbleModel *model, QObject *parent ) :
         QAbstractListModel( parent ), d( new RoutingModelPrivate( request ) )
 {
@@ -163,6 +208,7 @@ void RoutingModel::setRoute( const Route &route )
 {
     d->m_route = route;
     d->m_deviation = RoutingModelPrivate::Unknown;
+    d->m_mappedViaPoints.clear();
 
     beginResetModel();
     endResetModel();
@@ -223,6 +269,7 @@ void RoutingModel::exportGpx( QIODevice *device ) const
 void RoutingModel::clear()
 {
     d->m_route = Route();
+    d->m_mappedViaPoints.clear();
     beginResetModel();
     endResetModel();
     emit currentRouteChanged();
@@ -237,39 +284,12 @@ int RoutingModel::rightNeighbor( const GeoDataCoordinates &position, RouteReques
         return route->size() - 1;
     }
 
-    // Generate an ordered list of all waypoints
-    GeoDataLineString points = d->m_route.path();
-    QMap<int,int> mapping;
-
-    // Force first mapping point to match the route start
-    mapping[0] = 0;
-
-    // Calculate the mapping between waypoints and via points
-    // Need two for loops to avoid getting stuck in local minima
-    for ( int j=1; j<route->size()-1; ++j ) {
-        qreal minDistance = -1.0;
-        for ( int i=mapping[j-1]; i<points.size(); ++i ) {
-            qreal distance = distanceSphere( points[i], route->at(j) );
-            if (minDistance < 0.0 || distance < minDistance ) {
-                mapping[j] = i;
-                minDistance = distance;
-            }
-        }
-    }
+    // The mapping only changes with the route or the via points
+    d->updateViaPointMapping( route );
+    QMap<int,int> const &mapping = d->m_viaPointMapping;
 
     // Determine waypoint with minimum distance to the provided position
-    qreal minWaypointDistance = -1.0;
-    int waypoint=0;
-    for ( int i=0; i<points.size(); ++i ) {
-        qreal waypointDistance = distanceSphere( points[i], position );
-        if ( minWaypointDistance < 0.0 || waypointDistance < minWaypointDistance ) {
-            minWaypointDistance = waypointDistance;
-            waypoint = i;
-        }
-    }
-
-    // Force last mapping point to match the route destination
-    mapping[route->size()-1] = points.size()-1;
+    int const waypoint = qMax( 0, d->m_route.closestPathIndex( position ) );
 
     // Determine neighbor based on the mapping
     QMap<int, int>::const_iterator iter = mapping.constBegin();
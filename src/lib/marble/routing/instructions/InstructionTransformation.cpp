@@ -10,6 +10,11 @@
 
 #include "InstructionTransformation.h"
 
+#include "GeoDataData.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+
 #include <cmath>
 
 namespace Marble
@@ -42,4 +47,35 @@ RoutingInstructions InstructionTransformation::process( const RoutingWaypoints &
     return result;
 }
 
+QVector<GeoDataPlacemark*> InstructionTransformation::placemarks( const RoutingInstructions &directions )
+{
+    QVector<GeoDataPlacemark*> result;
+    result.reserve( directions.size() );
+    for ( int i = 0; i < directions.size(); ++i ) {
+        GeoDataPlacemark* placemark = new GeoDataPlacemark( directions[i].instructionText() );
+        GeoDataExtendedData extendedData;
+        GeoDataData turnType;
+        turnType.setName( "turnType" );
+        turnType.setValue( qVariantFromValue<int>( int( directions[i].turnType() ) ) );
+        extendedData.addValue( turnType );
+        GeoDataData roadName;
+        roadName.setName( "roadName" );
+        roadName.setValue( directions[i].roadName() );
+        extendedData.addValue( roadName );
+        placemark->setExtendedData( extendedData );
+        Q_ASSERT( !directions[i].points().isEmpty() );
+        GeoDataLineString* geometry = new GeoDataLineString;
+        QVector<RoutingWaypoint> items = directions[i].points();
+        for ( int j = 0; j < items.size(); ++j ) {
+            RoutingPoint point = items[j].point();
+            GeoDataCoordinates coordinates( point.lon(), point.lat(), 0.0, GeoDataCoordinates::Degree );
+            geometry->append( coordinates );
+        }
+        placemark->setGeometry( geometry );
+        result.push_back( placemark );
+    }
+
+    return result;
+}
+
 } // namespace Marble
@@ -15,9 +15,13 @@
 #include "RoutingWaypoint.h"
 #include "marble_export.h"
 
+#include <QVector>
+
 namespace Marble
 {
 
+class GeoDataPlacemark;
+
 /**
   * Transforms waypoints and metadata into driving directions
   */
@@ -27,6 +31,14 @@ public:
     /** Transforms waypoints and metadata into driving directions */
     static RoutingInstructions process( const RoutingWaypoints &waypoints );
 
+    /**
+      * Creates a placemark for each direction, as routing runners add them to their
+      * route documents: the instruction text as name, the instruction points as
+      * geometry and the turn type and road name as extended data.
+      * The caller takes ownership of the placemarks.
+      */
+    static QVector<GeoDataPlacemark*> placemarks( const RoutingInstructions &directions );
+
 private:
     // Pure static usage
     InstructionTransformation();
@@ -26,37 +26,180 @@
 #include "routing/RoutingModel.h"
 
 #include <QFileInfo>
+#include <QMutexLocker>
+#include <QtConcurrentRun>
 
 namespace Marble
 {
 
 ElevationProfileDataSource::ElevationProfileDataSource( QObject *parent ) :
-    QObject( parent )
+    QObject( parent ),
+    m_elevationModel( 0 ),
+    m_recalculationPending( false ),
+    m_generation( 0 )
 {
-    // nothing to do
+    m_cache.setMaxCost( 10 );
 }
 
-QList<QPointF> ElevationProfileDataSource::calculateElevationData( const GeoDataLineString &lineString ) const
+ElevationProfileDataSource::~ElevationProfileDataSource()
 {
-    // TODO: Don't re-calculate the whole route if only a small part of it was changed
+    // cancel running calculations, they access the members
+    m_generation.fetchAndAddOrdered( 1 );
+    foreach ( const PendingProfile &pending, m_pendingProfiles ) {
+        pending.watcher->waitForFinished();
+    }
+}
+
+void ElevationProfileDataSource::updateElevationData( const GeoDataLineString &lineString, const ElevationModel *elevationModel )
+{
+    m_generation.fetchAndAddOrdered( 1 );
+    m_lineString = lineString;
+    m_elevationModel = elevationModel;
+
+    // the float item is only a few hundred pixels wide
+    const int coarsePointCount = 500;
+    if ( lineString.size() > 2 * coarsePointCount ) {
+        const int step = lineString.size() / coarsePointCount;
+        GeoDataLineString coarsePoints;
+        for ( int i = 0; i < lineString.size(); i += step ) {
+            coarsePoints << lineString[i];
+        }
+        if ( ( lineString.size() - 1 ) % step ) {
+            coarsePoints << lineString.last();
+        }
+        startCalculation( coarsePoints, true );
+    }
+
+    startCalculation( lineString, false );
+}
+
+void ElevationProfileDataSource::recalculateElevationData()
+{
+    if ( !m_pendingProfiles.isEmpty() ) {
+        // restarting would starve the calculation while tiles keep arriving
+        m_recalculationPending = true;
+        return;
+    }
+
+    m_recalculationPending = false;
+    {
+        QMutexLocker locker( &m_cacheMutex );
+        m_cache.clear();
+    }
+
+    if ( !m_lineString.isEmpty() ) {
+        startCalculation( m_lineString, false );
+    }
+}
+
+void ElevationProfileDataSource::handleElevationData()
+{
+    // in order of request, so that a coarse profile never replaces a complete one
+    while ( !m_pendingProfiles.isEmpty() && m_pendingProfiles.first().watcher->isFinished() ) {
+        const PendingProfile pending = m_pendingProfiles.takeFirst();
+        pending.watcher->deleteLater();
+        if ( pending.generation != m_generation.load() ) {
+            continue; // canceled
+        }
+
+        if ( pending.coarse && !m_pendingProfiles.isEmpty() && m_pendingProfiles.first().watcher->isFinished() ) {
+            continue; // the complete profile is ready as well
+        }
+
+        emit dataUpdated( pending.points, pending.watcher->result() );
+    }
+
+    if ( m_pendingProfiles.isEmpty() && m_recalculationPending ) {
+        recalculateElevationData();
+    }
+}
+
+void ElevationProfileDataSource::startCalculation( const GeoDataLineString &points, bool coarse )
+{
+    PendingProfile pending;
+    pending.points = points;
+    pending.coarse = coarse;
+    pending.generation = m_generation.load();
+    pending.watcher = new QFutureWatcher<QList<QPointF> >( this );
+    connect( pending.watcher, SIGNAL(finished()), this, SLOT(handleElevationData()) );
+    pending.watcher->setFuture( QtConcurrent::run( this, &ElevationProfileDataSource::calculateElevationData, points,
+                                                   m_elevationModel, coarse, pending.generation ) );
+    m_pendingProfiles << pending;
+}
+
+QList<QPointF> ElevationProfileDataSource::calculateElevationData( const GeoDataLineString &lineString, const ElevationModel *elevationModel,
+                                                                   bool coarse, int generation )
+{
+    // coarse profiles are shown only briefly, they are not worth caching
+    const uint key = coarse ? 0 : geometryHash( lineString );
+    if ( !coarse ) {
+        QMutexLocker locker( &m_cacheMutex );
+        if ( const QList<QPointF> *elevationData = m_cache.object( key ) ) {
+            return *elevationData;
+        }
+    }
+
+    if ( m_generation.load() != generation ) {
+        return QList<QPointF>(); // canceled
+    }
+
+    const QVector<qreal> ele = elevations( lineString, elevationModel );
     QList<QPointF> result;
     qreal distance = 0;
 
-    //GeoDataLineString path;
     for ( int i = 0; i < lineString.size(); i++ ) {
-        const qreal ele = getElevation( lineString[i] );
+        if ( i % 1000 == 0 && m_generation.load() != generation ) {
+            return QList<QPointF>(); // canceled
+        }
 
         if ( i ) {
             distance += EARTH_RADIUS * distanceSphere( lineString[i-1], lineString[i] );
         }
 
-        if ( ele != invalidElevationData ) { // skip no data
-            result.append( QPointF( distance, ele ) );
+        if ( ele[i] != invalidElevationData ) { // skip no data
+            result.append( QPointF( distance, ele[i] ) );
         }
     }
 
+    if ( !coarse ) {
+        QMutexLocker locker( &m_cacheMutex );
+        m_cache.insert( key, new QList<QPointF>( result ) );
+    }
+
     return result;
 }
+
+QVector<qreal> ElevationProfileDataSource::elevations( const GeoDataLineString &lineString, const ElevationModel *elevationModel )
+{
+    QVector<qreal> result;
+    if ( !elevationModel ) {
+        result.reserve( lineString.size() );
+        for ( int i = 0; i < lineString.size(); i++ ) {
+            result << lineString[i].altitude();
+        }
+        return result;
+    }
+
+    result = elevationModel->heights( lineString.constBegin(), lineString.constEnd() );
+    for ( int i = 0; i < result.size(); i++ ) {
+        if ( result[i] == invalidElevationData ) { // no data
+            result[i] = 0;
+        }
+    }
+    return result;
+}
+
+uint ElevationProfileDataSource::geometryHash( const GeoDataLineString &lineString )
+{
+    QByteArray data;
+    data.reserve( lineString.size() * 3 * sizeof( qreal ) );
+    for ( int i = 0; i < lineString.size(); i++ ) {
+        const qreal values[3] = { lineString[i].longitude(), lineString[i].latitude(), lineString[i].altitude() };
+        data.append( reinterpret_cast<const char*>( values ), sizeof( values ) );
+    }
+
+    return qHash( data );
+}
 // end of impl of ElevationProfileDataSource
 
 ElevationProfileTrackDataSource::ElevationProfileTrackDataSource( const GeoDataTreeModel *treeModel, QObject *parent ) :
@@ -99,7 +242,7 @@ void ElevationProfileTrackDataSource::requestUpdate()
 
     const GeoDataLineString *routePoints = m_trackList[m_currentSourceIndex]->lineString();
 
-    emit dataUpdated(*routePoints, calculateElevationData(*routePoints));
+    updateElevationData(*routePoints);
 }
 
 bool ElevationProfileTrackDataSource::isDataAvailable() const
@@ -107,11 +250,6 @@ bool ElevationProfileTrackDataSource::isDataAvailable() const
     return !m_trackHash.isEmpty();
 }
 
-qreal ElevationProfileTrackDataSource::getElevation(const GeoDataCoordinates &coordinates) const
-{
-    return coordinates.altitude();
-}
-
 void ElevationProfileTrackDataSource::handleObjectAdded(GeoDataObject *object)
 {
     const GeoDataDocument *document = dynamic_cast<const GeoDataDocument *>(object);
@@ -226,25 +364,13 @@ void ElevationProfileRouteDataSource::requestUpdate()
     }
 
     const GeoDataLineString routePoints = m_routingModel->route().path();
-    const QList<QPointF> elevationData = calculateElevationData( routePoints );
-    emit dataUpdated( routePoints, elevationData );
+    updateElevationData( routePoints, m_elevationModel );
 }
 
 bool ElevationProfileRouteDataSource::isDataAvailable() const
 {
     return m_routingModel && m_routingModel->rowCount() > 0;
 }
-
-qreal ElevationProfileRouteDataSource::getElevation(const GeoDataCoordinates &coordinates) const
-{
-    const qreal lat = coordinates.latitude ( GeoDataCoordinates::Degree );
-    const qreal lon = coordinates.longitude( GeoDataCoordinates::Degree );
-    qreal ele = m_elevationModel->height( lon, lat );
-    if ( ele == invalidElevationData ) { // no data
-        ele = 0;
-    }
-    return ele;
-}
 // end of impl of ElevationProfileRouteDataSource
 
 }
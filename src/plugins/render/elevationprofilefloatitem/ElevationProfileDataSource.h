@@ -13,19 +13,25 @@
 #ifndef ELEVATIONPROFILEDATASOURCE_H
 #define ELEVATIONPROFILEDATASOURCE_H
 
+#include "GeoDataLineString.h"
+
 #include <QObject>
 
+#include <QAtomicInt>
+#include <QCache>
+#include <QFutureWatcher>
 #include <QHash>
+#include <QMutex>
 #include <QList>
 #include <QPointF>
 #include <QStringList>
+#include <QVector>
 
 namespace Marble
 {
 
 class ElevationModel;
 class GeoDataCoordinates;
-class GeoDataLineString;
 class GeoDataObject;
 class GeoDataTrack;
 class GeoDataTreeModel;
@@ -39,6 +45,8 @@ class ElevationProfileDataSource : public QObject
 public:
     explicit ElevationProfileDataSource( QObject *parent = 0 );
 
+    ~ElevationProfileDataSource();
+
     /**
      * @brief isDataAvailable
      * @return true if data is available to display
@@ -48,13 +56,51 @@ public:
 public Q_SLOTS:
     virtual void requestUpdate() = 0;
 
+    /**
+     * Discards the cached profiles and calculates the last requested one again,
+     * in full resolution only. For when the elevation model has more data.
+     */
+    void recalculateElevationData();
+
 Q_SIGNALS:
     void sourceCountChanged();
     void dataUpdated( const GeoDataLineString &points, const QList<QPointF> &elevationData );
 
 protected:
-    QList<QPointF> calculateElevationData(const GeoDataLineString &lineString) const;
-    virtual qreal getElevation(const GeoDataCoordinates &coordinates) const = 0;
+    /**
+     * Calculates the elevation profile of @p lineString in the background and
+     * emits dataUpdated() with it. Elevations are looked up in @p elevationModel,
+     * or taken from the altitudes of @p lineString if it is 0. Long line strings
+     * are passed in a coarse resolution first. Calculations of earlier requests
+     * are canceled.
+     */
+    void updateElevationData(const GeoDataLineString &lineString, const ElevationModel *elevationModel = 0);
+
+private Q_SLOTS:
+    void handleElevationData();
+
+private:
+    struct PendingProfile
+    {
+        GeoDataLineString points;
+        bool coarse;
+        int generation;
+        QFutureWatcher<QList<QPointF> >* watcher;
+    };
+
+    void startCalculation(const GeoDataLineString &points, bool coarse);
+    QList<QPointF> calculateElevationData(const GeoDataLineString &lineString, const ElevationModel *elevationModel,
+                                          bool coarse, int generation);
+    static QVector<qreal> elevations(const GeoDataLineString &lineString, const ElevationModel *elevationModel);
+    static uint geometryHash(const GeoDataLineString &lineString);
+
+    GeoDataLineString m_lineString;
+    const ElevationModel *m_elevationModel;
+    bool m_recalculationPending;
+    QAtomicInt m_generation;
+    QList<PendingProfile> m_pendingProfiles;
+    QMutex m_cacheMutex; // the cache is used by the calculations
+    QCache<uint, QList<QPointF> > m_cache;
 };
 
 /**
@@ -78,9 +124,6 @@ public:
 public Q_SLOTS:
     virtual void requestUpdate();
 
-protected:
-    virtual qreal getElevation(const GeoDataCoordinates &coordinates) const;
-
 private Q_SLOTS:
     void handleObjectAdded( GeoDataObject *object );
     void handleObjectRemoved( GeoDataObject *object );
@@ -107,9 +150,6 @@ public:
 public Q_SLOTS:
     virtual void requestUpdate();
 
-protected:
-    virtual qreal getElevation(const GeoDataCoordinates &coordinates) const;
-
 private:
     const RoutingModel *const m_routingModel;
     const ElevationModel *const m_elevationModel;
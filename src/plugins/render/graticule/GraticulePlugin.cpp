@@ -30,6 +30,7 @@
 #include <QPixmap>
 #include <QSvgRenderer>
 #include <QBrush>
+#include <QFontMetrics>
 #include <QColorDialog>
 #include <QDebug>
 
@@ -40,6 +41,7 @@ namespace Marble
 
 GraticulePlugin::GraticulePlugin()
     : RenderPlugin( 0 ),
+      m_linePen( GridPen ),
       m_showPrimaryLabels( true ),
       m_showSecondaryLabels( true ),
       m_isInitialized( false ),
@@ -50,6 +52,7 @@ GraticulePlugin::GraticulePlugin()
 
 GraticulePlugin::GraticulePlugin( const MarbleModel *marbleModel )
     : RenderPlugin( marbleModel ),
+      m_linePen( GridPen ),
       m_equatorCirclePen( Qt::yellow ),
       m_tropicsCirclePen( Qt::yellow ),
       m_gridCirclePen( Qt::white ),
@@ -298,118 +301,274 @@ qreal GraticulePlugin::zValue() const
     return 1.0;
 }
 
+GraticulePlugin::GridParameters::GridParameters()
+    : notation( GeoDataCoordinates::DMS ),
+      normalStep( 0.0 ),
+      boldStep( 0.0 ),
+      showPrimaryLabels( false ),
+      showSecondaryLabels( false )
+{
+}
+
+bool GraticulePlugin::GridParameters::operator!=( const GridParameters &other ) const
+{
+    return !( viewLatLonAltBox == other.viewLatLonAltBox )
+        || notation != other.notation
+        || planetId != other.planetId
+        || normalStep != other.normalStep
+        || boldStep != other.boldStep
+        || showPrimaryLabels != other.showPrimaryLabels
+        || showSecondaryLabels != other.showSecondaryLabels;
+}
+
+GraticulePlugin::ScreenParameters::ScreenParameters()
+    : projection( Spherical ),
+      radius( 0 )
+{
+}
+
+bool GraticulePlugin::ScreenParameters::operator!=( const ScreenParameters &other ) const
+{
+    return projection != other.projection
+        || !( planetAxis == other.planetAxis )
+        || radius != other.radius
+        || size != other.size;
+}
+
 void GraticulePlugin::renderGrid( GeoPainter *painter, ViewportParams *viewport,
                                   const QPen& equatorCirclePen,
                                   const QPen& tropicsCirclePen,
                                   const QPen& gridCirclePen )
 {
-    GeoDataLatLonAltBox viewLatLonAltBox = viewport->viewLatLonAltBox();
+    // The grid lines only need to be created again if the view box or the spacing changed
+    GridParameters gridParameters;
+    gridParameters.viewLatLonAltBox = viewport->viewLatLonAltBox();
+    gridParameters.notation = m_currentNotation;
+    gridParameters.planetId = marbleModel()->planet()->id();
+    gridParameters.normalStep = 360.0 / m_normalLineMap.lowerBound(viewport->radius()).value();
+    gridParameters.boldStep = 0.0;
+    if (    painter->mapQuality() == HighQuality
+         || painter->mapQuality() == PrintQuality ) {
+        gridParameters.boldStep = 360.0 / m_boldLineMap.lowerBound(viewport->radius()).value();
+    }
+    gridParameters.showPrimaryLabels = m_showPrimaryLabels;
+    gridParameters.showSecondaryLabels = m_showSecondaryLabels;
+
+    if ( gridParameters != m_gridParameters ) {
+        m_gridParameters = gridParameters;
+        m_gridLines.clear();
+        createGrid();
+    }
+
+    // ... and they only need to be projected again if the viewport changed
+    ScreenParameters screenParameters;
+    screenParameters.projection = viewport->projection();
+    screenParameters.planetAxis = viewport->planetAxis();
+    screenParameters.radius = viewport->radius();
+    screenParameters.size = viewport->size();
+
+    const bool reproject = screenParameters != m_screenParameters
+                        || m_screenLines.size() != m_gridLines.size();
+    if ( reproject ) {
+        m_screenParameters = screenParameters;
+        m_screenLines.clear();
+        m_screenLines.resize( m_gridLines.size() );
+    }
+
+    QPen boldPen = gridCirclePen;
+    boldPen.setWidthF( 1.5 );
+
+    QPen tropicsPen = tropicsCirclePen;
+    if (   painter->mapQuality() != OutlineQuality
+        && painter->mapQuality() != LowQuality ) {
+        tropicsPen.setStyle( Qt::DotLine );
+    }
 
-    painter->setPen( equatorCirclePen );
+    for ( int i = 0; i < m_gridLines.size(); ++i ) {
+        const GridLine &gridLine = m_gridLines.at( i );
+
+        if ( i == 0 || gridLine.pen != m_gridLines.at( i - 1 ).pen ) {
+            switch ( gridLine.pen ) {
+            case EquatorPen:
+                painter->setPen( equatorCirclePen );
+                break;
+            case TropicsPen:
+                painter->setPen( tropicsPen );
+                break;
+            case GridPen:
+                painter->setPen( gridCirclePen );
+                break;
+            case BoldGridPen:
+                painter->setPen( boldPen );
+                break;
+            }
+        }
+
+        if ( reproject ) {
+            renderGridLine( painter, viewport, gridLine, m_screenLines[i] );
+        } else {
+            drawGridLine( painter, gridLine, m_screenLines.at( i ) );
+        }
+    }
+}
+
+void GraticulePlugin::createGrid()
+{
+    const GeoDataLatLonAltBox &viewLatLonAltBox = m_gridParameters.viewLatLonAltBox;
+
+    m_linePen = EquatorPen;
 
     LabelPositionFlags mainPosition(NoLabel);
     if ( m_showPrimaryLabels ) {
         mainPosition = LineCenter;
     }
-    // Render the equator
-    renderLatitudeLine( painter, 0.0, viewLatLonAltBox, tr( "Equator" ), mainPosition );
+    // Add the equator
+    addLatitudeLine( 0.0, viewLatLonAltBox, tr( "Equator" ), mainPosition );
 
-    // Render the Prime Meridian and Antimeridian
+    // Add the Prime Meridian and Antimeridian
     GeoDataCoordinates::Notation notation = GeoDataCoordinates::defaultNotation();
     if (marbleModel()->planet()->id() != "sky" && notation != GeoDataCoordinates::Astro) {
-        renderLongitudeLine( painter, 0.0, viewLatLonAltBox, 0.0, 0.0, tr( "Prime Meridian" ), mainPosition );
-        renderLongitudeLine( painter, 180.0, viewLatLonAltBox, 0.0, 0.0, tr( "Antimeridian" ), mainPosition );
+        addLongitudeLine( 0.0, viewLatLonAltBox, 0.0, 0.0, tr( "Prime Meridian" ), mainPosition );
+        addLongitudeLine( 180.0, viewLatLonAltBox, 0.0, 0.0, tr( "Antimeridian" ), mainPosition );
     }
 
-    painter->setPen( gridCirclePen );
-    // painter->setPen( QPen( QBrush( Qt::white ), 0.75 ) );
+    m_linePen = GridPen;
 
-    // Render UTM grid zones
+    // Add UTM grid zones
     if ( m_currentNotation == GeoDataCoordinates::UTM ) {
-        renderLatitudeLine( painter, 84.0, viewLatLonAltBox );
+        addLatitudeLine( 84.0, viewLatLonAltBox );
 
-        renderLongitudeLines( painter, viewLatLonAltBox,
+        addLongitudeLines( viewLatLonAltBox,
                     6.0, 18.0, 154.0, LineEnd | IgnoreXMargin );
-        renderLongitudeLines( painter, viewLatLonAltBox,
+        addLongitudeLines( viewLatLonAltBox,
                     6.0, 34.0, 10.0, LineStart | IgnoreXMargin );
 
-        // Paint longitudes with exceptions
-        renderLongitudeLines( painter, viewLatLonAltBox,
+        // Add longitudes with exceptions
+        addLongitudeLines( viewLatLonAltBox,
                     6.0, 6.0, 162.0, LineEnd | IgnoreXMargin );
-        renderLongitudeLines( painter, viewLatLonAltBox,
+        addLongitudeLines( viewLatLonAltBox,
                     6.0, 26.0, 146.0, LineEnd | IgnoreXMargin  );
 
-        renderLatitudeLines( painter, viewLatLonAltBox, 8.0 /*,
-                             LineStart | IgnoreYMargin */ );
+        addLatitudeLines( viewLatLonAltBox, 8.0 /*,
+                          LineStart | IgnoreYMargin */ );
 
         return;
     }
 
-    // Render the normal grid
+    // Add the normal grid
 
-    // calculate the angular distance between coordinate lines of the normal grid
-    qreal normalDegreeStep = 360.0 / m_normalLineMap.lowerBound(viewport->radius()).value();
+    const qreal normalDegreeStep = m_gridParameters.normalStep;
 
     LabelPositionFlags labelXPosition(NoLabel), labelYPosition(NoLabel);
     if ( m_showSecondaryLabels ) {
         labelXPosition = LineStart | IgnoreXMargin;
         labelYPosition = LineStart | IgnoreYMargin;
     }
-    renderLongitudeLines( painter, viewLatLonAltBox,
-                          normalDegreeStep, normalDegreeStep, normalDegreeStep,
-                          labelXPosition );
-    renderLatitudeLines(  painter, viewLatLonAltBox, normalDegreeStep,
-                          labelYPosition );
+    addLongitudeLines( viewLatLonAltBox,
+                       normalDegreeStep, normalDegreeStep, normalDegreeStep,
+                       labelXPosition );
+    addLatitudeLines(  viewLatLonAltBox, normalDegreeStep,
+                       labelYPosition );
 
-    // Render some non-cut off longitude lines ..
-    renderLongitudeLine( painter, +90.0, viewLatLonAltBox );
-    renderLongitudeLine( painter, -90.0, viewLatLonAltBox );
+    // Add some non-cut off longitude lines ..
+    addLongitudeLine( +90.0, viewLatLonAltBox );
+    addLongitudeLine( -90.0, viewLatLonAltBox );
 
-    // Render the bold grid
+    // Add the bold grid, which is only shown in high quality
 
-    if (    painter->mapQuality() == HighQuality
-         || painter->mapQuality() == PrintQuality ) {
+    if ( m_gridParameters.boldStep > 0.0 ) {
+        m_linePen = BoldGridPen;
 
-        QPen boldPen = gridCirclePen;
-        boldPen.setWidthF( 1.5 );
-        painter->setPen( boldPen );
-    
-        // calculate the angular distance between coordinate lines of the bold grid
-        qreal boldDegreeStep = 360.0 / m_boldLineMap.lowerBound(viewport->radius()).value();
+        const qreal boldDegreeStep = m_gridParameters.boldStep;
 
-        renderLongitudeLines( painter, viewLatLonAltBox,
-                            boldDegreeStep, normalDegreeStep, normalDegreeStep,
-                            NoLabel
-                            );
-        renderLatitudeLines(  painter, viewLatLonAltBox, boldDegreeStep,
-                            NoLabel );
+        addLongitudeLines( viewLatLonAltBox,
+                           boldDegreeStep, normalDegreeStep, normalDegreeStep,
+                           NoLabel
+                         );
+        addLatitudeLines(  viewLatLonAltBox, boldDegreeStep,
+                           NoLabel );
     }
 
-    QPen tropicsPen = tropicsCirclePen;
-    if (   painter->mapQuality() != OutlineQuality
-        && painter->mapQuality() != LowQuality ) {
-        tropicsPen.setStyle( Qt::DotLine );
-    }
-    painter->setPen( tropicsPen );
+    m_linePen = TropicsPen;
 
     // Determine the planet's axial tilt
     qreal axialTilt = RAD2DEG * marbleModel()->planet()->epsilon();
 
     if ( axialTilt > 0 ) {
-        // Render the tropics
-        renderLatitudeLine( painter, +axialTilt, viewLatLonAltBox, tr( "Tropic of Cancer" ), mainPosition  );
-        renderLatitudeLine( painter, -axialTilt, viewLatLonAltBox, tr( "Tropic of Capricorn" ), mainPosition );
+        // Add the tropics
+        addLatitudeLine( +axialTilt, viewLatLonAltBox, tr( "Tropic of Cancer" ), mainPosition  );
+        addLatitudeLine( -axialTilt, viewLatLonAltBox, tr( "Tropic of Capricorn" ), mainPosition );
 
-        // Render the arctics
-        renderLatitudeLine( painter, +90.0 - axialTilt, viewLatLonAltBox, tr( "Arctic Circle" ), mainPosition );
-        renderLatitudeLine( painter, -90.0 + axialTilt, viewLatLonAltBox, tr( "Antarctic Circle" ), mainPosition );
+        // Add the arctics
+        addLatitudeLine( +90.0 - axialTilt, viewLatLonAltBox, tr( "Arctic Circle" ), mainPosition );
+        addLatitudeLine( -90.0 + axialTilt, viewLatLonAltBox, tr( "Antarctic Circle" ), mainPosition );
     }    
 }
 
-void GraticulePlugin::renderLatitudeLine( GeoPainter *painter, qreal latitude,
-                                          const GeoDataLatLonAltBox& viewLatLonAltBox,
-                                          const QString& lineLabel,
-                                          LabelPositionFlags labelPositionFlags )
+void GraticulePlugin::renderGridLine( GeoPainter *painter, const ViewportParams *viewport,
+                                      const GridLine &gridLine, ScreenLine &screenLine )
+{
+    // Same as GeoPainter::drawPolyline(), but keeping the projected polygons
+    // and the label positions for the next repaint of the same viewport
+    const GeoDataLatLonAltBox &latLonAltBox = gridLine.lineString.latLonAltBox();
+    if ( !viewport->viewLatLonAltBox().intersects( latLonAltBox ) ||
+         !viewport->resolves( latLonAltBox ) ) {
+        return;
+    }
+
+    QVector<QPolygonF*> polygons;
+    viewport->screenCoordinates( gridLine.lineString, polygons );
+
+    const bool hasLabel = !gridLine.label.isEmpty() && !gridLine.labelPositionFlags.testFlag( NoLabel );
+    const QFontMetrics metrics = painter->fontMetrics();
+    const int labelWidth = metrics.width( gridLine.label );
+    const int labelAscent = metrics.ascent();
+    const QSizeF labelSize = metrics.size( 0, gridLine.label );
+
+    QVector<QPointF> labelNodes;
+    foreach ( const QPolygonF *polygon, polygons ) {
+        screenLine.polygons << *polygon;
+
+        if ( !hasLabel ) {
+            painter->drawPolyline( *polygon );
+            continue;
+        }
+
+        labelNodes.clear();
+        painter->drawPolyline( *polygon, labelNodes, gridLine.labelPositionFlags );
+        foreach ( const QPointF &labelNode, labelNodes ) {
+            QPointF labelPosition = labelNode + QPointF( 3.0, -2.0 );
+
+            qreal xmax = painter->viewport().width() - 10.0 - labelWidth;
+            if ( labelPosition.x() > xmax ) labelPosition.setX( xmax );
+            qreal ymin = 10.0 + labelAscent;
+            if ( labelPosition.y() < ymin ) labelPosition.setY( ymin );
+            qreal ymax = painter->viewport().height() - 10.0 - labelAscent;
+            if ( labelPosition.y() > ymax ) labelPosition.setY( ymax );
+
+            const QRectF labelRect( labelPosition, labelSize );
+            painter->drawText( labelRect, gridLine.label );
+            screenLine.labelRects << labelRect;
+        }
+    }
+    qDeleteAll( polygons );
+}
+
+void GraticulePlugin::drawGridLine( GeoPainter *painter, const GridLine &gridLine, const ScreenLine &screenLine )
+{
+    foreach ( const QPolygonF &polygon, screenLine.polygons ) {
+        painter->drawPolyline( polygon );
+    }
+
+    foreach ( const QRectF &labelRect, screenLine.labelRects ) {
+        painter->drawText( labelRect, gridLine.label );
+    }
+}
+
+void GraticulePlugin::addLatitudeLine( qreal latitude,
+                                       const GeoDataLatLonAltBox& viewLatLonAltBox,
+                                       const QString& lineLabel,
+                                       LabelPositionFlags labelPositionFlags )
 {
     qreal fromSouthLat = viewLatLonAltBox.south( GeoDataCoordinates::Degree );
     qreal toNorthLat   = viewLatLonAltBox.north( GeoDataCoordinates::Degree );
@@ -446,14 +605,19 @@ void GraticulePlugin::renderLatitudeLine( GeoPainter *painter, qreal latitude,
         }
     }
 
-    painter->drawPolyline( line, lineLabel, labelPositionFlags, painter->pen().color() );
+    GridLine gridLine;
+    gridLine.lineString = line;
+    gridLine.label = lineLabel;
+    gridLine.labelPositionFlags = labelPositionFlags;
+    gridLine.pen = m_linePen;
+    m_gridLines << gridLine;
 }
 
-void GraticulePlugin::renderLongitudeLine( GeoPainter *painter, qreal longitude,
-                                           const GeoDataLatLonAltBox& viewLatLonAltBox, 
-                                           qreal northPolarGap, qreal southPolarGap,
-                                           const QString& lineLabel,
-                                           LabelPositionFlags labelPositionFlags )
+void GraticulePlugin::addLongitudeLine( qreal longitude,
+                                        const GeoDataLatLonAltBox& viewLatLonAltBox, 
+                                        qreal northPolarGap, qreal southPolarGap,
+                                        const QString& lineLabel,
+                                        LabelPositionFlags labelPositionFlags )
 {
     const qreal fromWestLon = viewLatLonAltBox.west();
     const qreal toEastLon   = viewLatLonAltBox.east();
@@ -489,14 +653,18 @@ void GraticulePlugin::renderLongitudeLine( GeoPainter *painter, qreal longitude,
         line << n1 << n3;
     }
 
-    painter->drawPolyline( line, lineLabel, labelPositionFlags, painter->pen().color() );
+    GridLine gridLine;
+    gridLine.lineString = line;
+    gridLine.label = lineLabel;
+    gridLine.labelPositionFlags = labelPositionFlags;
+    gridLine.pen = m_linePen;
+    m_gridLines << gridLine;
 }
 
-void GraticulePlugin::renderLatitudeLines( GeoPainter *painter,
-                                           const GeoDataLatLonAltBox& viewLatLonAltBox,
-                                           qreal step,
-                                           LabelPositionFlags labelPositionFlags
-                                         )
+void GraticulePlugin::addLatitudeLines( const GeoDataLatLonAltBox& viewLatLonAltBox,
+                                        qreal step,
+                                        LabelPositionFlags labelPositionFlags
+                                      )
 {
     if ( step <= 0 ) {
         return;
@@ -533,7 +701,7 @@ void GraticulePlugin::renderLatitudeLines( GeoPainter *painter,
 
         // Paint all latitude coordinate lines except for the equator
         if ( itStep != 0.0 ) {
-            renderLatitudeLine( painter, itStep, viewLatLonAltBox, label, labelPositionFlags );
+            addLatitudeLine( itStep, viewLatLonAltBox, label, labelPositionFlags );
         }
 
         itStep += step;
@@ -541,50 +709,48 @@ void GraticulePlugin::renderLatitudeLines( GeoPainter *painter,
 }
 
 
-void GraticulePlugin::renderUtmExceptions( GeoPainter *painter,
-                                            const GeoDataLatLonAltBox& viewLatLonAltBox,
-                                            qreal itStep, qreal northPolarGap, qreal southPolarGap,
-                                            const QString & label,
-                                            LabelPositionFlags labelPositionFlags )
+void GraticulePlugin::addUtmExceptions( const GeoDataLatLonAltBox& viewLatLonAltBox,
+                                         qreal itStep, qreal northPolarGap, qreal southPolarGap,
+                                         const QString & label,
+                                         LabelPositionFlags labelPositionFlags )
 {
     // This code renders the so called "exceptions" in the UTM coordinate grid
     // See: http://en.wikipedia.org/wiki/Universal_Transverse_Mercator_coordinate_system#Exceptions
     if ( northPolarGap == 6.0 && southPolarGap == 162.0) {
         if ( label == "33" ) {
-            renderLongitudeLine( painter, itStep-3.0, viewLatLonAltBox, northPolarGap,
+            addLongitudeLine( itStep-3.0, viewLatLonAltBox, northPolarGap,
             southPolarGap, label, labelPositionFlags );
         } else if ( label == "35" ) {
-            renderLongitudeLine( painter, itStep-3.0, viewLatLonAltBox, northPolarGap,
+            addLongitudeLine( itStep-3.0, viewLatLonAltBox, northPolarGap,
             southPolarGap, label, labelPositionFlags );
         } else if ( label == "37" ) {
-            renderLongitudeLine( painter, itStep-3.0, viewLatLonAltBox, northPolarGap,
+            addLongitudeLine( itStep-3.0, viewLatLonAltBox, northPolarGap,
             southPolarGap, label, labelPositionFlags );
         } else if ( label == "32" || label == "34" || label == "36" ) {
             // paint nothing
         } else {
-            renderLongitudeLine( painter, itStep, viewLatLonAltBox, northPolarGap,
+            addLongitudeLine( itStep, viewLatLonAltBox, northPolarGap,
             southPolarGap, label, labelPositionFlags );
         }
     }
     else if ( northPolarGap == 26.0 && southPolarGap == 146.0 ) {
         if ( label == "32" ) {
-            renderLongitudeLine( painter, itStep-3.0, viewLatLonAltBox, northPolarGap,
+            addLongitudeLine( itStep-3.0, viewLatLonAltBox, northPolarGap,
             southPolarGap, label, labelPositionFlags );
         } else {
-            renderLongitudeLine( painter, itStep, viewLatLonAltBox, northPolarGap,
+            addLongitudeLine( itStep, viewLatLonAltBox, northPolarGap,
             southPolarGap, label, labelPositionFlags );
         }
     }
     else {
-        renderLongitudeLine( painter, itStep, viewLatLonAltBox, northPolarGap,
+        addLongitudeLine( itStep, viewLatLonAltBox, northPolarGap,
         southPolarGap, label, labelPositionFlags );
     }
 }
 
-void GraticulePlugin::renderLongitudeLines( GeoPainter *painter, 
-                                            const GeoDataLatLonAltBox& viewLatLonAltBox, 
-                                            qreal step, qreal northPolarGap, qreal southPolarGap,
-                                            LabelPositionFlags labelPositionFlags )
+void GraticulePlugin::addLongitudeLines( const GeoDataLatLonAltBox& viewLatLonAltBox,
+                                         qreal step, qreal northPolarGap, qreal southPolarGap,
+                                         LabelPositionFlags labelPositionFlags )
 {
     if ( step <= 0 ) {
         return;
@@ -622,10 +788,10 @@ void GraticulePlugin::renderLongitudeLines( GeoPainter *painter,
 
             // Paint all longitude coordinate lines (except for the meridians in non-UTM mode)
             if (notation == GeoDataCoordinates::UTM ) {
-                renderUtmExceptions( painter, viewLatLonAltBox, itStep, northPolarGap,
+                addUtmExceptions( viewLatLonAltBox, itStep, northPolarGap,
                 southPolarGap, label, labelPositionFlags );
             } else if ( itStep != 0.0 && itStep != 180.0 && itStep != -180.0 ) {
-                renderLongitudeLine( painter, itStep, viewLatLonAltBox, northPolarGap,
+                addLongitudeLine( itStep, viewLatLonAltBox, northPolarGap,
                 southPolarGap, label, labelPositionFlags );
             }
             itStep += step;
@@ -649,10 +815,10 @@ void GraticulePlugin::renderLongitudeLines( GeoPainter *painter,
 
             // Paint all longitude coordinate lines (except for the meridians in non-UTM mode)
             if (notation == GeoDataCoordinates::UTM ) {
-                renderUtmExceptions( painter, viewLatLonAltBox, itStep, northPolarGap,
+                addUtmExceptions( viewLatLonAltBox, itStep, northPolarGap,
                 southPolarGap, label, labelPositionFlags );
             } else if ( itStep != 0.0 && itStep != 180.0 && itStep != -180.0 ) {
-                renderLongitudeLine( painter, itStep, viewLatLonAltBox, northPolarGap,
+                addLongitudeLine( itStep, viewLatLonAltBox, northPolarGap,
                 southPolarGap, label, labelPositionFlags );
             }
             itStep += step;
@@ -674,10 +840,10 @@ void GraticulePlugin::renderLongitudeLines( GeoPainter *painter,
 
             // Paint all longitude coordinate lines (except for the meridians in non-UTM mode)
             if (notation == GeoDataCoordinates::UTM ) {
-                renderUtmExceptions( painter, viewLatLonAltBox, itStep, northPolarGap,
+                addUtmExceptions( viewLatLonAltBox, itStep, northPolarGap,
                 southPolarGap, label, labelPositionFlags );
             } else if ( itStep != 0.0 && itStep != 180.0 && itStep != -180.0 ) {
-                renderLongitudeLine( painter, itStep, viewLatLonAltBox, northPolarGap,
+                addLongitudeLine( itStep, viewLatLonAltBox, northPolarGap,
                 southPolarGap, label, labelPositionFlags );
             }
             itStep += step;
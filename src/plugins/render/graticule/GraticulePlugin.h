@@ -23,6 +23,9 @@
 #include <QIcon>
 #include <QColorDialog>
 #include <QAbstractButton>
+#include <QPolygonF>
+#include <QRectF>
+#include <QSize>
 
 
 #include "DialogConfigurationInterface.h"
@@ -32,6 +35,9 @@
 
 #include "GeoDataCoordinates.h"
 #include "GeoDataLatLonAltBox.h"
+#include "GeoDataLineString.h"
+#include "MarbleGlobal.h"
+#include "Quaternion.h"
 
 
 namespace Ui 
@@ -112,8 +118,67 @@ class GraticulePlugin : public RenderPlugin, public DialogConfigurationInterface
 
 
  private:
+    enum PenRole {
+        EquatorPen,
+        TropicsPen,
+        GridPen,
+        BoldGridPen
+    };
+
+    /**
+     * @brief A coordinate line created for the current view bounding box.
+     */
+    struct GridLine
+    {
+        GeoDataLineString lineString;
+        QString label;
+        LabelPositionFlags labelPositionFlags;
+        PenRole pen;
+    };
+
+    /**
+     * @brief The projected polygons and the label positions of a GridLine.
+     */
+    struct ScreenLine
+    {
+        QVector<QPolygonF> polygons;
+        QVector<QRectF> labelRects;
+    };
+
+    /**
+     * @brief Everything the grid lines depend on. They are created again if any of it changes.
+     */
+    struct GridParameters
+    {
+        GridParameters();
+        bool operator!=( const GridParameters &other ) const;
+
+        GeoDataLatLonAltBox viewLatLonAltBox;
+        GeoDataCoordinates::Notation notation;
+        QString planetId;
+        qreal normalStep;
+        qreal boldStep;
+        bool showPrimaryLabels;
+        bool showSecondaryLabels;
+    };
+
+    /**
+     * @brief Everything the projection of the grid lines depends on.
+     */
+    struct ScreenParameters
+    {
+        ScreenParameters();
+        bool operator!=( const ScreenParameters &other ) const;
+
+        Projection projection;
+        Quaternion planetAxis;
+        int radius;
+        QSize size;
+    };
+
      /**
      * @brief Renders the coordinate grid within the defined view bounding box.
+     * The grid lines and their projection are reused as long as the viewport does not change.
      * @param painter the painter used to draw the grid
      * @param viewport the viewport
      */
@@ -122,20 +187,34 @@ class GraticulePlugin : public RenderPlugin, public DialogConfigurationInterface
                      const QPen& tropicsCirclePen,
                      const QPen& gridCirclePen );
 
+    /**
+     * @brief Creates the grid lines for the view bounding box and the steps of m_gridParameters.
+     */
+    void createGrid();
+
+    /**
+     * @brief Projects and draws a grid line, keeping the result in @p screenLine.
+     */
+    static void renderGridLine( GeoPainter *painter, const ViewportParams *viewport,
+                                const GridLine &gridLine, ScreenLine &screenLine );
+
+    /**
+     * @brief Draws a grid line that has been projected before.
+     */
+    static void drawGridLine( GeoPainter *painter, const GridLine &gridLine, const ScreenLine &screenLine );
+
      /**
-     * @brief Renders a latitude line within the defined view bounding box.
-     * @param painter the painter used to draw the latitude line
+     * @brief Adds a latitude line within the defined view bounding box.
      * @param latitude the latitude of the coordinate line measured in degree .
      * @param viewLatLonAltBox the latitude longitude bounding box that is covered by the view.
      */
-    static void renderLatitudeLine( GeoPainter *painter, qreal latitude,
-                                    const GeoDataLatLonAltBox& viewLatLonAltBox = GeoDataLatLonAltBox(),
-                                    const QString& lineLabel = QString(),
-                                    LabelPositionFlags labelPositionFlags = LineCenter );
+    void addLatitudeLine( qreal latitude,
+                          const GeoDataLatLonAltBox& viewLatLonAltBox = GeoDataLatLonAltBox(),
+                          const QString& lineLabel = QString(),
+                          LabelPositionFlags labelPositionFlags = LineCenter );
 
     /**
-     * @brief Renders a longitude line within the defined view bounding box.
-     * @param painter the painter used to draw the latitude line
+     * @brief Adds a longitude line within the defined view bounding box.
      * @param longitude the longitude of the coordinate line measured in degree .
      * @param viewLatLonAltBox the latitude longitude bounding box that is covered by the view.
      * @param polarGap the area around the poles in which most longitude lines are not drawn
@@ -144,27 +223,24 @@ class GraticulePlugin : public RenderPlugin, public DialogConfigurationInterface
      *        The radius of the polarGap area is measured in degrees. 
      * @param lineLabel draws a label using the font and color properties set for the painter.
      */
-    static void renderLongitudeLine( GeoPainter *painter, qreal longitude,
-                                     const GeoDataLatLonAltBox& viewLatLonAltBox = GeoDataLatLonAltBox(),
-                                     qreal northPolarGap = 0.0, qreal southPolarGap = 0.0,
-                                     const QString& lineLabel = QString(),
-                                     LabelPositionFlags labelPositionFlags = LineCenter );
+    void addLongitudeLine( qreal longitude,
+                           const GeoDataLatLonAltBox& viewLatLonAltBox = GeoDataLatLonAltBox(),
+                           qreal northPolarGap = 0.0, qreal southPolarGap = 0.0,
+                           const QString& lineLabel = QString(),
+                           LabelPositionFlags labelPositionFlags = LineCenter );
 
     /**
-     * @brief Renders the latitude lines that are visible within the defined view bounding box.
-     * @param painter the painter used to draw the latitude lines
+     * @brief Adds the latitude lines that are visible within the defined view bounding box.
      * @param viewLatLonAltBox the latitude longitude bounding box that is covered by the view.
      * @param step the angular distance between the lines measured in degrees .
      */
-    void renderLatitudeLines( GeoPainter *painter, 
-                              const GeoDataLatLonAltBox& viewLatLonAltBox,
-                              qreal step,
-                              LabelPositionFlags labelPositionFlags = LineCenter
-                            );
+    void addLatitudeLines( const GeoDataLatLonAltBox& viewLatLonAltBox,
+                           qreal step,
+                           LabelPositionFlags labelPositionFlags = LineCenter
+                         );
 
     /**
-     * @brief Renders the longitude lines that are visible within the defined view bounding box.
-     * @param painter the painter used to draw the latitude lines
+     * @brief Adds the longitude lines that are visible within the defined view bounding box.
      * @param viewLatLonAltBox the latitude longitude bounding box that is covered by the view.
      * @param step the angular distance between the lines measured in degrees .
      * @param northPolarGap the area around the north pole in which most longitude lines are not drawn
@@ -176,16 +252,14 @@ class GraticulePlugin : public RenderPlugin, public DialogConfigurationInterface
      *        concurring lines around the poles which obstruct the view onto the surface.
      *        The radius of the polarGap area is measured in degrees. 
      */
-    void renderLongitudeLines( GeoPainter *painter, 
-                              const GeoDataLatLonAltBox& viewLatLonAltBox, 
-                              qreal step, 
-                              qreal northPolarGap = 0.0, qreal southPolarGap = 0.0,
-                              LabelPositionFlags labelPositionFlags = LineCenter
-                             );
+    void addLongitudeLines( const GeoDataLatLonAltBox& viewLatLonAltBox, 
+                            qreal step, 
+                            qreal northPolarGap = 0.0, qreal southPolarGap = 0.0,
+                            LabelPositionFlags labelPositionFlags = LineCenter
+                          );
 
     /**
-     * @brief Renders UTM exceptions that are visible within the defined view bounding box.
-     * @param painter the painter used to draw the latitude lines
+     * @brief Adds UTM exceptions that are visible within the defined view bounding box.
      * @param viewLatLonAltBox the latitude longitude bounding box that is covered by the view.
      * @param step the angular distance between the lines measured in degrees .
      * @param northPolarGap the area around the north pole in which most longitude lines are not drawn
@@ -197,12 +271,11 @@ class GraticulePlugin : public RenderPlugin, public DialogConfigurationInterface
      *        concurring lines around the poles which obstruct the view onto the surface.
      *        The radius of the polarGap area is measured in degrees.
      */
-    static void renderUtmExceptions( GeoPainter *painter,
-                                     const GeoDataLatLonAltBox& viewLatLonAltBox,
-                                     qreal step,
-                                     qreal northPolarGap, qreal southPolarGap,
-                                     const QString & label,
-                                     LabelPositionFlags labelPositionFlags );
+    void addUtmExceptions( const GeoDataLatLonAltBox& viewLatLonAltBox,
+                           qreal step,
+                           qreal northPolarGap, qreal southPolarGap,
+                           const QString & label,
+                           LabelPositionFlags labelPositionFlags );
 
     /**
      * @brief Maps the number of coordinate lines per 360 deg against the globe radius on the screen.
@@ -216,6 +289,13 @@ class GraticulePlugin : public RenderPlugin, public DialogConfigurationInterface
     QMap<qreal,qreal> m_boldLineMap;
     QMap<qreal,qreal> m_normalLineMap;
 
+    // The grid lines of the current view and their projection
+    GridParameters m_gridParameters;
+    QVector<GridLine> m_gridLines;
+    PenRole m_linePen;
+    ScreenParameters m_screenParameters;
+    QVector<ScreenLine> m_screenLines;
+
     QPen m_equatorCirclePen;
     QPen m_tropicsCirclePen;
     QPen m_gridCirclePen;
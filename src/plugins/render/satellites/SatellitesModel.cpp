@@ -13,6 +13,7 @@
 #include "MarbleDebug.h"
 #include "SatellitesMSCItem.h"
 #include "SatellitesTLEItem.h"
+#include "SatellitesTLEPropagator.h"
 
 #include "MarbleClock.h"
 #include "GeoDataPlacemark.h"
@@ -95,10 +96,6 @@ void SatellitesModel::updateVisibility()
             bool enabled = ( ( oItem->relatedBody().toLower() == m_lcPlanet ) &&
                              ( m_enabledIds.contains( oItem->id() ) ) );
             oItem->setEnabled( enabled );
-
-            if( enabled ) {
-                oItem->update();
-            }
         }
 
         SatellitesTLEItem *eItem = dynamic_cast<SatellitesTLEItem*>(obj);
@@ -106,16 +103,39 @@ void SatellitesModel::updateVisibility()
             // TLE satellites are always earth satellites
             bool enabled = ( m_lcPlanet == "earth" );
             eItem->setEnabled( enabled );
-
-            if( enabled ) {
-                eItem->update();
-            }
         }
     }
 
+    update();
+
     endUpdateItems();
 }
 
+void SatellitesModel::update()
+{
+    if( !isEnabled() ) {
+        return;
+    }
+
+    // TLE satellites are propagated in one batch
+    SatellitesTLEPropagator propagator;
+    QVector<SatellitesTLEItem*> tleItems;
+    foreach( TrackerPluginItem *obj, items() ) {
+        SatellitesTLEItem *tleItem = dynamic_cast<SatellitesTLEItem*>(obj);
+        if( tleItem == NULL ) {
+            obj->update();
+        } else if( tleItem->addSamples( &propagator ) ) {
+            tleItems << tleItem;
+        }
+    }
+
+    propagator.propagate();
+
+    foreach( SatellitesTLEItem *tleItem, tleItems ) {
+        tleItem->addPoints( propagator );
+    }
+}
+
 void SatellitesModel::parseFile( const QString &id,
                                  const QByteArray &data )
 {
@@ -49,6 +49,12 @@ protected:
      */
     void parseTLE( const QString &id, const QByteArray &data );
 
+protected Q_SLOTS:
+    /**
+     * Updates all items, propagating the TLE satellites in a batch.
+     */
+    virtual void update();
+
 private:
     void setupColors();
     QColor nextColor();
@@ -9,6 +9,7 @@
 //
 
 #include "SatellitesTLEItem.h"
+#include "SatellitesTLEPropagator.h"
 
 #include "MarbleClock.h"
 #include "MarbleDebug.h"
@@ -29,6 +30,7 @@
 #include <QColor>
 
 #include <cmath>
+#include <qmath.h>
 #include <QDialog>
 #include <QCheckBox>
 
@@ -41,8 +43,10 @@ SatellitesTLEItem::SatellitesTLEItem( const QString &name,
                                       const MarbleClock *clock )
     : TrackerPluginItem( name ),
       m_satrec( satrec ),
+      m_epoch( timeAtEpoch() ),
       m_track( new GeoDataTrack() ),
-      m_clock( clock )
+      m_clock( clock ),
+      m_batchIndex( -1 )
 {
     double tumin, mu, xke, j2, j3, j4, j3oj2;
     double radiusearthkm;
@@ -80,8 +84,17 @@ void SatellitesTLEItem::setDescription()
 
 void SatellitesTLEItem::update()
 {
-    if( !isEnabled() ) {
-        return;
+    SatellitesTLEPropagator propagator;
+    if ( addSamples( &propagator ) ) {
+        propagator.propagate();
+        addPoints( propagator );
+    }
+}
+
+bool SatellitesTLEItem::addSamples( SatellitesTLEPropagator *propagator )
+{
+    if( !isEnabled() || !isVisible() ) {
+        return false;
     }
 
     QDateTime startTime = m_clock->dateTime();
@@ -94,37 +107,49 @@ void SatellitesTLEItem::update()
     m_track->removeBefore( startTime );
     m_track->removeAfter( endTime );
 
-    addPointAt( m_clock->dateTime() );
+    m_pendingTimes.clear();
+    m_pendingTimes << m_clock->dateTime();
 
-    // time interval between each point in the track, in seconds
-    double step = period() / 100.0;
+    // The track points lie on a grid of 100 points per period starting at
+    // the epoch, so that points of earlier updates can be kept and only
+    // the part of the window not covered by the track needs propagation.
+    qint64 const epoch = m_epoch.toMSecsSinceEpoch();
+    qint64 const step = qMax<qint64>( 1, qRound64( period() * 1000 / 100.0 ) );
+    qint64 const end = endTime.toMSecsSinceEpoch();
+    qint64 const first = m_track->size() > 0 ? m_track->firstWhen().toMSecsSinceEpoch() : end;
+    qint64 const last = m_track->size() > 0 ? m_track->lastWhen().toMSecsSinceEpoch() : end;
 
-    for ( double i = startTime.toTime_t(); i < endTime.toTime_t(); i += step ) {
+    qint64 time = epoch + step * qCeil( ( startTime.toMSecsSinceEpoch() - epoch ) / double( step ) );
+    for ( ; time < end; time += step ) {
         // No need to add points in this interval
-        if ( i >= m_track->firstWhen().toTime_t() ) {
-            i = m_track->lastWhen().toTime_t() + step;
+        if ( first <= time && time <= last ) {
+            time += ( last - time ) / step * step;
+            continue;
         }
 
-        addPointAt( QDateTime::fromTime_t( i ) );
+        m_pendingTimes << QDateTime::fromMSecsSinceEpoch( time ).toUTC();
     }
-}
 
-void SatellitesTLEItem::addPointAt( const QDateTime &dateTime )
-{
-    // in minutes
-    double timeSinceEpoch = (double)( dateTime.toTime_t() -
-        timeAtEpoch().toTime_t() ) / 60.0;
+    QVector<double> minutes; // since the epoch
+    minutes.reserve( m_pendingTimes.size() );
+    foreach ( const QDateTime &dateTime, m_pendingTimes ) {
+        minutes << ( dateTime.toMSecsSinceEpoch() - epoch ) / 60000.0;
+    }
 
-    double r[3], v[3];
-    sgp4( wgs84, m_satrec, timeSinceEpoch, r, v );
+    m_batchIndex = propagator->addSatellite( m_satrec, minutes );
+    return true;
+}
 
-    GeoDataCoordinates coordinates = fromTEME(
-        r[0], r[1], r[2], gmst( timeSinceEpoch ) );
-    if ( m_satrec.error != 0 ) {
-        return;
+void SatellitesTLEItem::addPoints( const SatellitesTLEPropagator &propagator )
+{
+    for ( int i = 0; i < m_pendingTimes.size(); ++i ) {
+        if ( propagator.isValid( m_batchIndex, i ) ) {
+            m_track->addPoint( m_pendingTimes[i], propagator.coordinates( m_batchIndex, i ) );
+        }
     }
 
-    m_track->addPoint( dateTime, coordinates);
+    m_pendingTimes.clear();
+    m_batchIndex = -1;
 }
 
 QDateTime SatellitesTLEItem::timeAtEpoch() const
@@ -169,47 +194,4 @@ double SatellitesTLEItem::inclination() const
     return m_satrec.inclo / M_PI * 180;
 }
 
-GeoDataCoordinates SatellitesTLEItem::fromTEME( double x,
-                                                double y,
-                                                double z,
-                                                double gmst ) const
-{
-    double lon = atan2( y, x );
-    // Rotate the angle by gmst (the origin goes from the vernal equinox
-    // point to the Greenwich Meridian)
-    lon = GeoDataCoordinates::normalizeLon( fmod(lon - gmst, 2 * M_PI) );
-
-    double lat = atan2( z, sqrt( x*x + y*y ) );
-
-    //TODO: determine if this is worth the extra precision
-    // Algorithm from http://celestrak.com/columns/v02n03/
-    //TODO: demonstrate it.
-    double a = m_earthSemiMajorAxis;
-    double planetRadius = sqrt( x*x + y*y );
-    double latp = lat;
-    double C;
-    for ( int i = 0; i < 3; i++ ) {
-        C = 1 / sqrt( 1 - square( m_satrec.ecco * sin( latp ) ) );
-        lat = atan2( z + a * C * square( m_satrec.ecco ) * sin( latp ), planetRadius );
-    }
-
-    double alt = planetRadius / cos( lat ) - a * C;
-
-    lat = GeoDataCoordinates::normalizeLat( lat );
-
-    return GeoDataCoordinates( lon, lat, alt * 1000 );
-}
-
-double SatellitesTLEItem::gmst( double minutesP ) const
-{
-    // Earth rotation rate in rad/min, from sgp4io.cpp
-    double rptim = 4.37526908801129966e-3;
-    return fmod( m_satrec.gsto + rptim * minutesP, 2 * M_PI );
-}
-
-double SatellitesTLEItem::square( double x )
-{
-    return x * x;
-}
-
 } // namespace Marble
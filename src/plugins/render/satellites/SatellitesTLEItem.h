@@ -16,6 +16,9 @@
 #include "GeoDataCoordinates.h"
 #include "GeoDataTrack.h"
 
+#include <QDateTime>
+#include <QVector>
+
 #include <sgp4unit.h>
 
 class QColor;
@@ -24,6 +27,7 @@ namespace Marble {
 
 class GeoDataTrack;
 class MarbleClock;
+class SatellitesTLEPropagator;
 
 /**
  * An instance SatellitesTLEItem represents an item of a two-line-elements
@@ -38,29 +42,33 @@ public:
 
     void update();
 
+    /**
+     * Removes the points outside of the time window at the current clock
+     * time from the track and adds the satellite to @p propagator, to be
+     * propagated to the missing points of the window.
+     * @return false if the item is disabled or invisible and needs no update
+     */
+    bool addSamples( SatellitesTLEPropagator *propagator );
+
+    /**
+     * Adds the points propagated by @p propagator, which was passed to
+     * addSamples() before, to the track.
+     */
+    void addPoints( const SatellitesTLEPropagator &propagator );
+
 private:
     double m_earthSemiMajorAxis; // in km
     elsetrec m_satrec;
+    QDateTime m_epoch;
 
     GeoDataTrack *m_track;
 
     const MarbleClock *m_clock;
 
-    void setDescription();
-
-    /**
-     * Add a point in the GeoDataTrack geometry of the placemark with time
-     * dateTime and coordinates of the satellite determined from m_satrec.
-     */
-    void addPointAt( const QDateTime &dateTime );
+    int m_batchIndex;
+    QVector<QDateTime> m_pendingTimes;
 
-    /**
-     * Create a GeoDataCoordinates object from the cartesian coordinates
-     * @p x, @p y and @p z in km in the Earth-centered inertial frame known
-     * as TEME (True equator, Mean equinox) with Greenwich Mean Sidereal Time
-     * @p gmst in radians at time of observation.
-     */
-    GeoDataCoordinates fromTEME( double x, double y, double z, double gmst ) const;
+    void setDescription();
 
     /**
      * @return The time at the satellite epoch determined from m_satrec
@@ -89,17 +97,6 @@ private:
      * @return The inclination in degrees
      */
     double inclination() const;
-
-    /**
-     * Returns the Greenwich Mean Sideral Time in radians, @p minutes
-     * after the epoch.
-     */
-    double gmst( double minutes ) const;
-
-    /**
-     * @return The square of @p x
-     */
-    static double square( double x );
 };
 
 } // namespace Marble
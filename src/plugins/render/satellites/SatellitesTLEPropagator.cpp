@@ -0,0 +1,126 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "SatellitesTLEPropagator.h"
+
+#include "MarbleGlobal.h"
+
+#include <QtConcurrentMap>
+
+#include <cmath>
+
+namespace Marble {
+
+SatellitesTLEPropagator::SatellitePropagation::SatellitePropagation( SatellitesTLEPropagator *propagator ) :
+    m_propagator( propagator )
+{
+    // nothing to do
+}
+
+void SatellitesTLEPropagator::SatellitePropagation::operator()( int satellite ) const
+{
+    m_propagator->propagate( satellite );
+}
+
+SatellitesTLEPropagator::SatellitesTLEPropagator()
+{
+    double tumin, mu, xke, j2, j3, j4, j3oj2;
+    double radiusearthkm;
+    getgravconst( wgs84, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2 );
+    m_earthSemiMajorAxis = radiusearthkm;
+
+    m_firstSample << 0;
+}
+
+int SatellitesTLEPropagator::addSatellite( const elsetrec &satrec, const QVector<double> &minutes )
+{
+    m_satrecs << satrec;
+    m_minutes << minutes;
+    m_firstSample << m_minutes.size();
+    return m_satrecs.size() - 1;
+}
+
+void SatellitesTLEPropagator::propagate()
+{
+    m_longitudes.resize( m_minutes.size() );
+    m_latitudes.resize( m_minutes.size() );
+    m_altitudes.resize( m_minutes.size() );
+    m_valid.fill( false, m_minutes.size() );
+
+    QVector<int> satellites( m_satrecs.size() );
+    for ( int i = 0; i < satellites.size(); ++i ) {
+        satellites[i] = i;
+    }
+
+    QtConcurrent::blockingMap( satellites, SatellitePropagation( this ) );
+}
+
+bool SatellitesTLEPropagator::isValid( int satellite, int sample ) const
+{
+    return m_valid[m_firstSample[satellite] + sample];
+}
+
+GeoDataCoordinates SatellitesTLEPropagator::coordinates( int satellite, int sample ) const
+{
+    int const index = m_firstSample[satellite] + sample;
+    return GeoDataCoordinates( m_longitudes[index], m_latitudes[index], m_altitudes[index] );
+}
+
+void SatellitesTLEPropagator::propagate( int satellite )
+{
+    // sgp4 keeps intermediate results of the deep space integration in
+    // the satrec, so each satellite is propagated by a single thread
+    elsetrec &satrec = m_satrecs[satellite];
+
+    // Earth rotation rate in rad/min, from sgp4io.cpp
+    double const rptim = 4.37526908801129966e-3;
+
+    for ( int i = m_firstSample[satellite]; i < m_firstSample[satellite + 1]; ++i ) {
+        double r[3], v[3];
+        sgp4( wgs84, satrec, m_minutes[i], r, v );
+        if ( satrec.error != 0 ) {
+            continue;
+        }
+
+        double const gmst = fmod( satrec.gsto + rptim * m_minutes[i], 2 * M_PI );
+        fromTEME( i, satrec.ecco, r[0], r[1], r[2], gmst );
+        m_valid[i] = true;
+    }
+}
+
+void SatellitesTLEPropagator::fromTEME( int sample, double eccentricity, double x, double y, double z, double gmst )
+{
+    double lon = atan2( y, x );
+    // Rotate the angle by gmst (the origin goes from the vernal equinox
+    // point to the Greenwich Meridian)
+    lon = GeoDataCoordinates::normalizeLon( fmod(lon - gmst, 2 * M_PI) );
+
+    double lat = atan2( z, sqrt( x*x + y*y ) );
+
+    //TODO: determine if this is worth the extra precision
+    // Algorithm from http://celestrak.com/columns/v02n03/
+    //TODO: demonstrate it.
+    double a = m_earthSemiMajorAxis;
+    double planetRadius = sqrt( x*x + y*y );
+    double latp = lat;
+    double C;
+    for ( int i = 0; i < 3; i++ ) {
+        C = 1 / sqrt( 1 - eccentricity * eccentricity * sin( latp ) * sin( latp ) );
+        lat = atan2( z + a * C * eccentricity * eccentricity * sin( latp ), planetRadius );
+    }
+
+    double alt = planetRadius / cos( lat ) - a * C;
+
+    m_longitudes[sample] = lon;
+    m_latitudes[sample] = GeoDataCoordinates::normalizeLat( lat );
+    m_altitudes[sample] = alt * 1000;
+}
+
+} // namespace Marble
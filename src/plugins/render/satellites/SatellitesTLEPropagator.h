@@ -0,0 +1,90 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_SATELLITESTLEPROPAGATOR_H
+#define MARBLE_SATELLITESTLEPROPAGATOR_H
+
+#include "GeoDataCoordinates.h"
+
+#include <QVector>
+
+#include <sgp4unit.h>
+
+namespace Marble {
+
+/**
+ * Propagates a batch of two-line-elements satellites to several points in
+ * time each. Satellites are propagated in parallel in the global thread pool,
+ * the samples of all satellites are stored in flat arrays.
+ */
+class SatellitesTLEPropagator
+{
+public:
+    SatellitesTLEPropagator();
+
+    /**
+     * Adds the satellite @p satrec to the batch, to be propagated to each of
+     * @p minutes after its epoch.
+     * @return The index of the satellite in the batch
+     */
+    int addSatellite( const elsetrec &satrec, const QVector<double> &minutes );
+
+    /**
+     * Propagates all satellites of the batch and returns once done.
+     */
+    void propagate();
+
+    /**
+     * @return Whether sample @p sample of satellite @p satellite could be propagated
+     */
+    bool isValid( int satellite, int sample ) const;
+
+    /**
+     * @return The position of the satellite @p satellite at its sample @p sample
+     */
+    GeoDataCoordinates coordinates( int satellite, int sample ) const;
+
+private:
+    /** Propagates single satellites of the batch, see QtConcurrent::blockingMap() */
+    class SatellitePropagation
+    {
+    public:
+        typedef void result_type;
+
+        explicit SatellitePropagation( SatellitesTLEPropagator *propagator );
+        void operator()( int satellite ) const;
+
+    private:
+        SatellitesTLEPropagator *m_propagator;
+    };
+
+    void propagate( int satellite );
+
+    /**
+     * Converts the cartesian coordinates @p x, @p y and @p z in km in the
+     * Earth-centered inertial frame known as TEME (True equator, Mean equinox)
+     * with Greenwich Mean Sidereal Time @p gmst in radians at time of
+     * observation to geodetic coordinates of sample @p sample.
+     */
+    void fromTEME( int sample, double eccentricity, double x, double y, double z, double gmst );
+
+    double m_earthSemiMajorAxis; // in km
+    QVector<elsetrec> m_satrecs;
+    QVector<int> m_firstSample; // satellite i owns the samples from m_firstSample[i] to m_firstSample[i+1]
+    QVector<double> m_minutes;
+    QVector<double> m_longitudes; // in radians
+    QVector<double> m_latitudes; // in radians
+    QVector<double> m_altitudes; // in meters
+    QVector<bool> m_valid;
+};
+
+} // namespace Marble
+
+#endif // MARBLE_SATELLITESTLEPROPAGATOR_H
@@ -52,13 +52,6 @@ public:
         m_parent->parseFile( id, m_storagePolicy.data( id ) );
     }
 
-    void update()
-    {
-        foreach( TrackerPluginItem *item, m_itemVector ) {
-            item->update();
-        }
-    }
-
     void updateDocument()
     {
         // we cannot use ->clear() since its implementation
@@ -116,6 +109,16 @@ void TrackerPluginModel::enable( bool enabled )
         d->m_treeModel->removeDocument( d->m_document );
     }
     d->m_enabled = enabled;
+
+    if( enabled ) {
+        // items are not updated while disabled
+        update();
+    }
+}
+
+bool TrackerPluginModel::isEnabled() const
+{
+    return d->m_enabled;
 }
 
 void TrackerPluginModel::addItem( TrackerPluginItem *mark )
@@ -158,6 +161,17 @@ void TrackerPluginModel::endUpdateItems()
     emit itemUpdateEnded();
 }
 
+void TrackerPluginModel::update()
+{
+    if( !d->m_enabled ) {
+        return;
+    }
+
+    foreach( TrackerPluginItem *item, d->m_itemVector ) {
+        item->update();
+    }
+}
+
 void TrackerPluginModel::downloadFile(const QUrl &url, const QString &id)
 {
     d->m_downloadManager->addJob( url, id, id, DownloadBrowse );
@@ -43,6 +43,11 @@ public:
 
     void enable( bool enabled );
 
+    /**
+     * Returns whether the items of the model are shown.
+     */
+    bool isEnabled() const;
+
     /**
      * Add the item @p mark to the model.
      *
@@ -94,6 +99,13 @@ public:
      */
     virtual void parseFile( const QString &id, const QByteArray &file );
 
+protected Q_SLOTS:
+    /**
+     * Updates all items, e.g. when the time changed. Does nothing while the
+     * model is disabled. Reimplement it to update the items in a batch.
+     */
+    virtual void update();
+
 Q_SIGNALS:
     void itemUpdateStarted();
     void itemUpdateEnded();
@@ -102,7 +114,6 @@ Q_SIGNALS:
 private:
     TrackerPluginModelPrivate *d;
     Q_PRIVATE_SLOT( d, void downloaded( const QString &, const QString & ) );
-    Q_PRIVATE_SLOT( d, void update() );
 };
 
 } // namespace Marble
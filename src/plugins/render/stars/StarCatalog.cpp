@@ -0,0 +1,248 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "StarCatalog.h"
+
+#include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <qmath.h>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+namespace
+{
+    /** Orders stars by their bin first and by their magnitude second */
+    class BinAndMagnitudeLessThan
+    {
+    public:
+        BinAndMagnitudeLessThan( const QVector<int> &bins, const QVector<qreal> &magnitudes ) :
+            m_bins( bins ),
+            m_magnitudes( magnitudes )
+        {
+        }
+
+        bool operator()( int a, int b ) const
+        {
+            return m_bins[a] < m_bins[b] || ( m_bins[a] == m_bins[b] && m_magnitudes[a] < m_magnitudes[b] );
+        }
+
+    private:
+        const QVector<int> &m_bins;
+        const QVector<qreal> &m_magnitudes;
+    };
+}
+
+StarCatalog::StarCatalog()
+{
+    // nothing to do
+}
+
+StarCatalog StarCatalog::load( const QString &fileName )
+{
+    StarCatalog catalog;
+
+    QFile starFile( fileName );
+    starFile.open( QIODevice::ReadOnly );
+    QDataStream in( &starFile );
+
+    // Read and check the header
+    quint32 magic;
+    in >> magic;
+    if ( magic != 0x73746172 ) {
+        return catalog;
+    }
+
+    // Read the version
+    qint32 version;
+    in >> version;
+    if ( version > 004 ) {
+        mDebug() << "stars.dat: file too new.";
+        return catalog;
+    }
+
+    if ( version == 003 ) {
+        mDebug() << "stars.dat: file version no longer supported.";
+        return catalog;
+    }
+
+    mDebug() << "Star Catalog Version " << version;
+
+    QVector<int> ids;
+    QVector<qreal> rects;
+    QVector<qreal> decls;
+    QVector<qreal> magnitudes;
+    QVector<int> colorIds;
+
+    int id = 0;
+    double ra;
+    double de;
+    double mag;
+    int colorId = 2;
+
+    while ( !in.atEnd() ) {
+        if ( version >= 2 ) {
+            in >> id;
+        }
+        in >> ra;
+        in >> de;
+        in >> mag;
+
+        if ( version >= 4 ) {
+            in >> colorId;
+        }
+
+        ids << id;
+        rects << ra;
+        decls << de;
+        magnitudes << mag;
+        colorIds << colorId;
+    }
+
+    // Bins of 10 degrees in declination, and of about 10 degrees in
+    // right ascension at the declination closest to the equator
+    QVector<int> bandBegin;
+    bandBegin << 0;
+    qreal const bandHeight = M_PI / bandCount;
+    for ( int band = 0; band < bandCount; ++band ) {
+        qreal const bottom = -M_PI / 2 + band * bandHeight;
+        qreal const minDecl = qMin( qAbs( bottom ), qAbs( bottom + bandHeight ) );
+        int const sectors = qMax( 1, qCeil( 2 * bandCount * cos( minDecl ) ) );
+        qreal const sectorWidth = 2 * M_PI / sectors;
+        for ( int sector = 0; sector < sectors; ++sector ) {
+            catalog.m_binCenters << Quaternion::fromSpherical( ( sector + 0.5 ) * sectorWidth, bottom + bandHeight / 2 );
+            // farthest distance of a point in the bin from its center
+            catalog.m_binRadii << bandHeight / 2 + sectorWidth / 2 * cos( minDecl );
+        }
+        bandBegin << bandBegin.last() + sectors;
+    }
+
+    QVector<int> bins( ids.size() );
+    QVector<int> order( ids.size() );
+    for ( int i = 0; i < ids.size(); ++i ) {
+        bins[i] = bin( rects[i], decls[i], bandBegin );
+        order[i] = i;
+    }
+
+    std::stable_sort( order.begin(), order.end(), BinAndMagnitudeLessThan( bins, magnitudes ) );
+
+    catalog.m_x.reserve( ids.size() );
+    catalog.m_y.reserve( ids.size() );
+    catalog.m_z.reserve( ids.size() );
+    catalog.m_magnitudes.reserve( ids.size() );
+    catalog.m_colorIds.reserve( ids.size() );
+    catalog.m_binBegin.fill( 0, bandBegin.last() + 1 );
+    for ( int i = 0; i < order.size(); ++i ) {
+        int const star = order[i];
+        Quaternion const position = Quaternion::fromSpherical( rects[star], decls[star] );
+        catalog.m_x << position.v[Q_X];
+        catalog.m_y << position.v[Q_Y];
+        catalog.m_z << position.v[Q_Z];
+        catalog.m_magnitudes << magnitudes[star];
+        catalog.m_colorIds << colorIds[star];
+        catalog.m_indices[ids[star]] = i;
+        ++catalog.m_binBegin[bins[star] + 1];
+    }
+
+    for ( int i = 1; i < catalog.m_binBegin.size(); ++i ) {
+        catalog.m_binBegin[i] += catalog.m_binBegin[i - 1];
+    }
+
+    return catalog;
+}
+
+bool StarCatalog::isEmpty() const
+{
+    return m_magnitudes.isEmpty();
+}
+
+int StarCatalog::index( int id ) const
+{
+    return m_indices.value( id, -1 );
+}
+
+Quaternion StarCatalog::quaternion( int index ) const
+{
+    return Quaternion( 0.0, m_x[index], m_y[index], m_z[index] );
+}
+
+qreal StarCatalog::magnitude( int index ) const
+{
+    return m_magnitudes[index];
+}
+
+int StarCatalog::colorId( int index ) const
+{
+    return m_colorIds[index];
+}
+
+QVector<int> StarCatalog::bins( const Quaternion &axis, qreal radius ) const
+{
+    QVector<int> result;
+    for ( int i = 0; i < m_binCenters.size(); ++i ) {
+        Quaternion const &center = m_binCenters[i];
+        qreal const distance = center.v[Q_X] * axis.v[Q_X] + center.v[Q_Y] * axis.v[Q_Y] + center.v[Q_Z] * axis.v[Q_Z];
+        if ( distance >= cos( qMin<qreal>( M_PI, radius + m_binRadii[i] ) ) ) {
+            result << i;
+        }
+    }
+
+    return result;
+}
+
+int StarCatalog::binBegin( int bin ) const
+{
+    return m_binBegin[bin];
+}
+
+int StarCatalog::binEnd( int bin, qreal magnitudeLimit ) const
+{
+    QVector<qreal>::const_iterator const begin = m_magnitudes.constBegin() + m_binBegin[bin];
+    QVector<qreal>::const_iterator const end = m_magnitudes.constBegin() + m_binBegin[bin + 1];
+    return std::lower_bound( begin, end, magnitudeLimit ) - m_magnitudes.constBegin();
+}
+
+void StarCatalog::rotate( const matrix &m, int begin, int end, qreal *x, qreal *y, qreal *z ) const
+{
+    qreal const m00 = m[0][0], m01 = m[0][1], m02 = m[0][2];
+    qreal const m10 = m[1][0], m11 = m[1][1], m12 = m[1][2];
+    qreal const m20 = m[2][0], m21 = m[2][1], m22 = m[2][2];
+
+    // a plain loop over the coordinate arrays, which compilers vectorize
+    const qreal *sx = m_x.constData() + begin;
+    const qreal *sy = m_y.constData() + begin;
+    const qreal *sz = m_z.constData() + begin;
+    int const count = end - begin;
+    for ( int i = 0; i < count; ++i ) {
+        x[i] = m00 * sx[i] + m10 * sy[i] + m20 * sz[i];
+        y[i] = m01 * sx[i] + m11 * sy[i] + m21 * sz[i];
+        z[i] = m02 * sx[i] + m12 * sy[i] + m22 * sz[i];
+    }
+}
+
+int StarCatalog::bin( qreal rect, qreal decl, const QVector<int> &bandBegin )
+{
+    int const band = qBound( 0, int( ( decl + M_PI / 2 ) / ( M_PI / bandCount ) ), bandCount - 1 );
+    int const sectors = bandBegin[band + 1] - bandBegin[band];
+
+    qreal ra = fmod( rect, 2 * M_PI );
+    if ( ra < 0 ) {
+        ra += 2 * M_PI;
+    }
+
+    return bandBegin[band] + qMin( sectors - 1, int( ra / ( 2 * M_PI / sectors ) ) );
+}
+
+}
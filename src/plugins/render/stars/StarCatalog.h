@@ -0,0 +1,98 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_STARCATALOG_H
+#define MARBLE_STARCATALOG_H
+
+#include "Quaternion.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace Marble
+{
+
+/**
+ * The stars of the star catalog, prepared for rendering.
+ *
+ * The sky is divided into bins of about 10 x 10 degrees. The stars are
+ * sorted by bin and, within each bin, by magnitude, such that rendering
+ * only visits the bins within the visible part of the sky and stops at
+ * the magnitude limit. Star positions are kept as unit vectors in separate
+ * arrays per coordinate.
+ */
+class StarCatalog
+{
+public:
+    StarCatalog();
+
+    /**
+     * Reads the catalog from @p fileName (usually stars/stars.dat).
+     * Returns an empty catalog on errors.
+     */
+    static StarCatalog load( const QString &fileName );
+
+    bool isEmpty() const;
+
+    /**
+     * Returns the index of the star with the catalog id @p id, or -1.
+     */
+    int index( int id ) const;
+
+    Quaternion quaternion( int index ) const;
+
+    qreal magnitude( int index ) const;
+
+    int colorId( int index ) const;
+
+    /**
+     * Returns the bins that may contain stars within the angle @p radius (in
+     * radians) around the direction @p axis.
+     */
+    QVector<int> bins( const Quaternion &axis, qreal radius ) const;
+
+    /**
+     * Returns the index of the first star in @p bin.
+     */
+    int binBegin( int bin ) const;
+
+    /**
+     * Returns the index after the last star in @p bin that is brighter than
+     * @p magnitudeLimit.
+     */
+    int binEnd( int bin, qreal magnitudeLimit ) const;
+
+    /**
+     * Rotates the positions of the stars from @p begin to @p end (exclusive)
+     * by @p m and stores the coordinates of the results in @p x, @p y and @p z.
+     */
+    void rotate( const matrix &m, int begin, int end, qreal *x, qreal *y, qreal *z ) const;
+
+private:
+    static const int bandCount = 18;
+
+    static int bin( qreal rect, qreal decl, const QVector<int> &bandBegin );
+
+    QVector<qreal> m_x;
+    QVector<qreal> m_y;
+    QVector<qreal> m_z;
+    QVector<qreal> m_magnitudes;
+    QVector<int> m_colorIds;
+    QHash<int, int> m_indices;
+
+    QVector<int> m_binBegin; // first star of each bin, followed by the number of stars
+    QVector<Quaternion> m_binCenters;
+    QVector<qreal> m_binRadii;
+};
+
+}
+
+#endif
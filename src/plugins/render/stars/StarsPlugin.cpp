@@ -19,6 +19,7 @@
 #include <QContextMenuEvent>
 #include <QMenu>
 #include <QColorDialog>
+#include <QtConcurrentRun>
 #include <qmath.h>
 
 #include "MarbleClock.h"
@@ -75,10 +76,14 @@ StarsPlugin::StarsPlugin( const MarbleModel *marbleModel )
       m_doRender( false )
 {
     prepareNames();
+
+    connect( &m_starsWatcher, SIGNAL(finished()), this, SLOT(starsLoaded()) );
 }
 
 StarsPlugin::~StarsPlugin()
 {
+    m_starsWatcher.waitForFinished();
+
     delete m_contextMenu;
     delete m_constellationsAction;
     delete m_sunMoonAction;
@@ -532,67 +537,8 @@ void StarsPlugin::celestialPoleGetColor()
 void StarsPlugin::loadStars()
 {
     //mDebug() << Q_FUNC_INFO;
-    // Load star data
-    m_stars.clear();
-
-    QFile starFile( MarbleDirs::path( "stars/stars.dat" ) );
-    starFile.open( QIODevice::ReadOnly );
-    QDataStream in( &starFile );
-
-    // Read and check the header
-    quint32 magic;
-    in >> magic;
-    if ( magic != 0x73746172 ) {
-        return;
-    }
-
-    // Read the version
-    qint32 version;
-    in >> version;
-    if ( version > 004 ) {
-        mDebug() << "stars.dat: file too new.";
-        return;
-    }
-
-    if ( version == 003 ) {
-        mDebug() << "stars.dat: file version no longer supported.";
-        return;
-    }
-
-    int maxid = 0;
-    int id = 0;
-    int starIndex = 0;
-    double ra;
-    double de;
-    double mag;
-    int colorId = 2;
-
-    mDebug() << "Star Catalog Version " << version;
-
-    while ( !in.atEnd() ) {
-        if ( version >= 2 ) {
-            in >> id;
-        }
-        if ( id > maxid ) {
-            maxid = id;
-        }
-        in >> ra;
-        in >> de;
-        in >> mag;
-
-        if ( version >= 4 ) {
-            in >> colorId;
-        }
-
-        StarPoint star( id, ( qreal )( ra ), ( qreal )( de ), ( qreal )( mag ), colorId );
-        // Create entry in stars database
-        m_stars << star;
-        // Create key,value pair in idHash table to map from star id to
-        // index in star database vector
-        m_idHash[id] = starIndex;
-        // Increment Index for use in hash
-        ++starIndex;
-    }
+    // Load star data in the background, stars are rendered once it is done
+    m_starsWatcher.setFuture( QtConcurrent::run( &StarCatalog::load, MarbleDirs::path( "stars/stars.dat" ) ) );
 
     // load the Sun pixmap
     // TODO: adjust pixmap size according to distance
@@ -602,6 +548,12 @@ void StarsPlugin::loadStars()
     m_starsLoaded = true;
 }
 
+void StarsPlugin::starsLoaded()
+{
+    m_stars = m_starsWatcher.result();
+    requestRepaint();
+}
+
 void StarsPlugin::createStarPixmaps()
 {
     // Load star pixmaps
@@ -976,7 +928,7 @@ bool StarsPlugin::render( GeoPainter *painter, ViewportParams *viewport,
             }
         }
 
-        if ( m_renderConstellationLines ||  m_renderConstellationLabels )
+        if ( ( m_renderConstellationLines ||  m_renderConstellationLabels ) && !m_stars.isEmpty() )
         {
             // Render Constellations
             for ( int c = 0; c < m_constellations.size(); ++c ) {
@@ -998,8 +950,8 @@ bool StarsPlugin::render( GeoPainter *painter, ViewportParams *viewport,
                         painter->setPen( constellationPenSolid );
                     }
 
-                    int idx1 = m_idHash.value( starId1,-1 );
-                    int idx2 = m_idHash.value( starId2,-1 );
+                    int idx1 = m_stars.index( starId1 );
+                    int idx2 = m_stars.index( starId2 );
 
                    
                     if ( idx1 < 0 ) {
@@ -1016,9 +968,9 @@ bool StarsPlugin::render( GeoPainter *painter, ViewportParams *viewport,
                         continue;
                     }
                     // Fetch quaternion from star s in constellation c
-                    Quaternion q1 = m_stars.at( idx1 ).quaternion();
+                    Quaternion q1 = m_stars.quaternion( idx1 );
                     // Fetch quaternion from star s+1 in constellation c
-                    Quaternion q2 = m_stars.at( idx2 ).quaternion();
+                    Quaternion q2 = m_stars.quaternion( idx2 );
 
                     q1.rotateAroundAxis( skyAxisMatrix );
                     q2.rotateAroundAxis( skyAxisMatrix );
@@ -1065,41 +1017,56 @@ bool StarsPlugin::render( GeoPainter *painter, ViewportParams *viewport,
 
         // Render Stars
 
-        for ( int s = 0; s < m_stars.size(); ++s  ) {
-            Quaternion  qpos = m_stars.at(s).quaternion();
-
-            qpos.rotateAroundAxis( skyAxisMatrix );
-
-            if ( qpos.v[Q_Z] > 0 ) {
+        // Only bins of the catalog in the part of the sky covered by the
+        // viewport are visited, and only up to the magnitude limit.
+        const Quaternion viewAxis( 0.0, -skyAxisMatrix[0][2], -skyAxisMatrix[1][2], -skyAxisMatrix[2][2] );
+        const qreal screenRadius = 0.5 * sqrt( ( qreal )viewport->width() * viewport->width() + viewport->height() * viewport->height() ) / skyRadius;
+        const qreal visibleRadius = screenRadius < 1.0 ? asin( screenRadius ) : M_PI / 2;
+
+        QVector<qreal> starX;
+        QVector<qreal> starY;
+        QVector<qreal> starZ;
+        foreach ( int bin, m_stars.bins( viewAxis, visibleRadius ) ) {
+            const int begin = m_stars.binBegin( bin );
+            const int end = m_stars.binEnd( bin, m_magnitudeLimit );
+            if ( begin == end ) {
                 continue;
             }
 
-            qreal  earthCenteredX = qpos.v[Q_X] * skyRadius;
-            qreal  earthCenteredY = qpos.v[Q_Y] * skyRadius;
+            starX.resize( end - begin );
+            starY.resize( end - begin );
+            starZ.resize( end - begin );
+            m_stars.rotate( skyAxisMatrix, begin, end, starX.data(), starY.data(), starZ.data() );
 
-            // Don't draw high placemarks (e.g. satellites) that aren't visible.
-            if ( qpos.v[Q_Z] < 0
-                    && ( ( earthCenteredX * earthCenteredX
-                           + earthCenteredY * earthCenteredY )
-                         < earthRadius * earthRadius ) ) {
-                continue;
-            }
+            for ( int i = 0; i < end - begin; ++i ) {
+                if ( starZ[i] > 0 ) {
+                    continue;
+                }
 
-            // Let (x, y) be the position on the screen of the placemark..
-            const int x = ( int )( viewport->width()  / 2 + skyRadius * qpos.v[Q_X] );
-            const int y = ( int )( viewport->height() / 2 - skyRadius * qpos.v[Q_Y] );
+                qreal  earthCenteredX = starX[i] * skyRadius;
+                qreal  earthCenteredY = starY[i] * skyRadius;
 
-            // Skip placemarks that are outside the screen area
-            if ( x < 0 || x >= viewport->width()
-                    || y < 0 || y >= viewport->height() )
-                continue;
+                // Don't draw high placemarks (e.g. satellites) that aren't visible.
+                if ( starZ[i] < 0
+                        && ( ( earthCenteredX * earthCenteredX
+                               + earthCenteredY * earthCenteredY )
+                             < earthRadius * earthRadius ) ) {
+                    continue;
+                }
+
+                // Let (x, y) be the position on the screen of the placemark..
+                const int x = ( int )( viewport->width()  / 2 + skyRadius * starX[i] );
+                const int y = ( int )( viewport->height() / 2 - skyRadius * starY[i] );
 
-            // Show star if it is brighter than magnitude threshold
-            if ( m_stars.at(s).magnitude() < m_magnitudeLimit ) {
+                // Skip placemarks that are outside the screen area
+                if ( x < 0 || x >= viewport->width()
+                        || y < 0 || y >= viewport->height() )
+                    continue;
 
                 // colorId is used to select which pixmap in vector to display
-                int colorId = m_stars.at(s).colorId();
-                QPixmap s_pixmap = starPixmap(m_stars.at(s).magnitude(), colorId);
+                const int s = begin + i;
+                int colorId = m_stars.colorId( s );
+                QPixmap s_pixmap = starPixmap( m_stars.magnitude( s ), colorId );
                 int sizeX = s_pixmap.width();
                 int sizeY = s_pixmap.height();
                 painter->drawPixmap( x-sizeX/2, y-sizeY/2 ,s_pixmap );
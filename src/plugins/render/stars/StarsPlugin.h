@@ -15,6 +15,7 @@
 #ifndef MARBLESTARSPLUGIN_H
 #define MARBLESTARSPLUGIN_H
 
+#include <QFutureWatcher>
 #include <QObject>
 #include <QVector>
 #include <QVariant>
@@ -24,6 +25,7 @@
 #include "RenderPlugin.h"
 #include "Quaternion.h"
 #include "DialogConfigurationInterface.h"
+#include "StarCatalog.h"
 
 class QDateTime;
 class QMenu;
@@ -37,54 +39,6 @@ namespace Ui
 namespace Marble
 {
 
-class StarPoint
-{
-public:
-    StarPoint() {}
-    /**
-     * @brief create a starpoint from rectaszension and declination
-     * @param  rect rectaszension
-     * @param  lat declination
-     * @param  mag magnitude
-     * (default for Radian: north pole at pi/2, southpole at -pi/2)
-     */
-    StarPoint(int id, qreal rect, qreal decl, qreal mag, int colorId) :
-        m_id( id ),
-        m_magnitude( mag ),
-        m_colorId( colorId )
-    {
-        m_q = Quaternion::fromSpherical( rect, decl );
-    }
-
-    ~StarPoint() {}
-
-    qreal magnitude() const
-    {
-        return m_magnitude;
-    }
-
-    const Quaternion &quaternion() const
-    {
-        return m_q;
-    }
-
-    int id() const
-    {
-        return m_id;
-    }
-    
-    int colorId() const
-    {
-        return m_colorId;
-    } 
-
-private:
-    int         m_id;
-    qreal       m_magnitude;
-    Quaternion  m_q;
-    int         m_colorId;
-};
-
 class DsoPoint
 {
 public:
@@ -177,6 +131,7 @@ protected:
 
 private Q_SLOTS:
     void requestRepaint();
+    void starsLoaded();
     void toggleSunMoon();
     void togglePlanets();
     void toggleDsos();
@@ -239,12 +194,12 @@ private:
     bool m_dsosLoaded;
     bool m_zoomSunMoon;
     bool m_viewSolarSystemLabel;
-    QVector<StarPoint> m_stars;
+    StarCatalog m_stars;
+    QFutureWatcher<StarCatalog> m_starsWatcher;
     QPixmap m_pixmapSun;
     QPixmap m_pixmapMoon;
     QVector<Constellation> m_constellations;
     QVector<DsoPoint> m_dsos;
-    QHash<int,int> m_idHash;
     QImage m_dsoImage;
     int m_magnitudeLimit;
     int m_zoomCoefficient;
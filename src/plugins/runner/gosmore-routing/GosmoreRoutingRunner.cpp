@@ -126,37 +126,12 @@ QVector<GeoDataPlacemark*> GosmoreRunnerPrivate::parseGosmoreInstructions( const
         }
     }
 
-    QVector<GeoDataPlacemark*> result;
     QTextStream stream( content );
     stream.setCodec("UTF8");
     stream.setAutoDetectUnicode( true );
 
     RoutingInstructions directions = InstructionTransformation::process( m_parser.parse( stream ) );
-    for( int i=0; i<directions.size(); ++i ) {
-        GeoDataPlacemark* placemark = new GeoDataPlacemark( directions[i].instructionText() );
-        GeoDataExtendedData extendedData;
-        GeoDataData turnType;
-        turnType.setName( "turnType" );
-        turnType.setValue( qVariantFromValue<int>( int( directions[i].turnType() ) ) );
-        extendedData.addValue( turnType );
-        GeoDataData roadName;
-        roadName.setName( "roadName" );
-        roadName.setValue( directions[i].roadName() );
-        extendedData.addValue( roadName );
-        placemark->setExtendedData( extendedData );
-        Q_ASSERT( !directions[i].points().isEmpty() );
-        GeoDataLineString* geometry = new GeoDataLineString;
-        QVector<RoutingWaypoint> items = directions[i].points();
-        for (int j=0; j<items.size(); ++j ) {
-            RoutingPoint point = items[j].point();
-            GeoDataCoordinates coordinates( point.lon(), point.lat(), 0.0, GeoDataCoordinates::Degree );
-            geometry->append( coordinates );
-        }
-        placemark->setGeometry( geometry );
-        result.push_back( placemark );
-    }
-
-    return result;
+    return InstructionTransformation::placemarks( directions );
 }
 
 GeoDataDocument* GosmoreRunnerPrivate::createDocument( GeoDataLineString* routeWaypoints, const QVector<GeoDataPlacemark*> instructions )
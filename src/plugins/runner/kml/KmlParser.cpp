@@ -10,16 +10,47 @@
 #include "KmlParser.h"
 #include "KmlElementDictionary.h"
 #include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataTypes.h"
+#include "ParsingRunner.h"
+
+#include <QObject>
 
 namespace Marble {
 
+// Number of features handed off at once while streaming
+static const int s_streamingBatchSize = 1000;
+// Maximum time in ms completed features are held back before being handed off
+static const int s_streamingBatchInterval = 250;
+
 KmlParser::KmlParser()
-    : GeoParser( 0 )
+    : GeoParser( 0 ),
+      m_presetDocument( 0 ),
+      m_runner( 0 ),
+      m_batchSize( 0 )
 {
 }
 
 KmlParser::~KmlParser()
 {
+    delete m_presetDocument;
+
+    // features which were not handed off due to an error or cancelation
+    for ( int i = 0; i < m_batches.size(); ++i ) {
+        qDeleteAll( m_batches[i].second );
+    }
+}
+
+void KmlParser::setDocument( KmlDocument *document )
+{
+    delete m_presetDocument;
+    m_presetDocument = document;
+}
+
+void KmlParser::setStreaming( ParsingRunner *runner )
+{
+    m_runner = runner;
+    m_flushTimer.start();
 }
 
 bool KmlParser::isValidRootElement()
@@ -42,7 +73,165 @@ bool KmlParser::isValidElement(const QString& tagName) const
 
 GeoDocument* KmlParser::createDocument() const
 {
+    if ( m_presetDocument ) {
+        KmlDocument *const document = m_presetDocument;
+        m_presetDocument = 0;
+        return document;
+    }
+
     return new KmlDocument;
 }
 
+void KmlParser::elementParsed( const GeoStackItem &item )
+{
+    if ( !m_runner ) {
+        return;
+    }
+
+    if ( m_runner->isCanceled() ) {
+        if ( !hasError() ) {
+            raiseError( QObject::tr( "Parsing was canceled" ) );
+        }
+        return;
+    }
+
+    GeoDataFeature *const feature = dynamic_cast<GeoDataFeature*>( item.associatedNode() );
+    GeoDataDocument *const document = static_cast<GeoDataDocument*>( m_document );
+    if ( !feature || feature == document ) {
+        return;
+    }
+
+    bool const isContainer = feature->nodeType() == GeoDataTypes::GeoDataFolderType
+                             || feature->nodeType() == GeoDataTypes::GeoDataDocumentType;
+    if ( isContainer && m_handedOff.contains( static_cast<GeoDataContainer*>( feature ) ) ) {
+        finishReplacement( static_cast<GeoDataContainer*>( feature ) );
+    } else {
+        // Only features of folders and documents up to the root are streamed,
+        // not e.g. the ones of <Update> elements
+        GeoDataObject *ancestor = feature->parent();
+        while ( ancestor && ancestor != document
+                && ( ancestor->nodeType() == GeoDataTypes::GeoDataFolderType
+                     || ancestor->nodeType() == GeoDataTypes::GeoDataDocumentType ) ) {
+            ancestor = ancestor->parent();
+        }
+        if ( ancestor != document ) {
+            return;
+        }
+
+        // Tag handlers append features to their container, so a completed
+        // feature is the last child of its container
+        GeoDataContainer *const container = static_cast<GeoDataContainer*>( feature->parent() );
+        if ( container->size() == 0 || container->child( container->size() - 1 ) != feature ) {
+            return;
+        }
+
+        handOff( container, feature );
+    }
+
+    if ( m_batchSize >= s_streamingBatchSize || m_flushTimer.elapsed() >= s_streamingBatchInterval ) {
+        flush();
+    }
+}
+
+void KmlParser::handOff( GeoDataContainer *container, GeoDataFeature *feature )
+{
+    GeoDataDocument *const document = static_cast<GeoDataDocument*>( m_document );
+
+    // All containers from the root down to the completed feature are open
+    // and each one is the last child of its parent
+    QVector<GeoDataContainer*> containers;
+    for ( GeoDataContainer *open = container; open; open = static_cast<GeoDataContainer*>( open->parent() ) ) {
+        containers.prepend( open );
+    }
+
+    bool const containerHandedOff = m_handedOff.contains( container );
+    GeoDataContainer *target = 0;
+    for ( int i = 0; i < containers.size(); ++i ) {
+        GeoDataContainer *const open = containers[i];
+        if ( m_handedOff.contains( open ) ) {
+            target = m_handedOff.value( open );
+            continue;
+        }
+
+        GeoDataContainer *replacement = 0;
+        if ( open->nodeType() == GeoDataTypes::GeoDataFolderType ) {
+            replacement = new GeoDataFolder;
+        } else if ( open == document ) {
+            replacement = static_cast<GeoDataDocument*>( createDocument() );
+        } else {
+            replacement = new GeoDataDocument;
+        }
+
+        // The open child stays with the parser, the completed feature is
+        // handed off along with its container
+        if ( i + 1 < containers.size() ) {
+            GeoDataFeature *const child = open->child( open->size() - 1 );
+            open->remove( open->size() - 1 );
+            replacement->append( child );
+        }
+
+        replaceNode( open, replacement );
+        if ( open == document ) {
+            m_document = static_cast<GeoDataDocument*>( replacement );
+            emit m_runner->featuresParsed( 0, QVector<GeoDataFeature*>() << open );
+        } else {
+            GeoDataContainer *const parent = static_cast<GeoDataContainer*>( open->parent() );
+            parent->remove( parent->size() - 1 );
+            parent->append( replacement );
+            addToBatch( target, open );
+        }
+
+        m_handedOff.insert( replacement, open );
+        target = open;
+    }
+
+    if ( containerHandedOff ) {
+        container->remove( container->size() - 1 );
+        addToBatch( target, feature );
+    }
+}
+
+void KmlParser::finishReplacement( GeoDataContainer *replacement )
+{
+    // Completed children were handed off already, hand off any others anyway
+    GeoDataContainer *const target = m_handedOff.take( replacement );
+    while ( replacement->size() > 0 ) {
+        addToBatch( target, replacement->child( 0 ) );
+        replacement->remove( 0 );
+    }
+
+    GeoDataContainer *const parent = static_cast<GeoDataContainer*>( replacement->parent() );
+    if ( parent && parent->size() > 0 && parent->child( parent->size() - 1 ) == replacement ) {
+        parent->remove( parent->size() - 1 );
+    }
+    delete replacement;
+}
+
+void KmlParser::addToBatch( GeoDataContainer *target, GeoDataFeature *feature )
+{
+    if ( m_batches.isEmpty() || m_batches.last().first != target ) {
+        m_batches.append( qMakePair( target, QVector<GeoDataFeature*>() ) );
+    }
+    m_batches.last().second.append( feature );
+    ++m_batchSize;
+}
+
+void KmlParser::flush()
+{
+    if ( !m_runner ) {
+        return;
+    }
+
+    for ( int i = 0; i < m_batches.size(); ++i ) {
+        emit m_runner->featuresParsed( m_batches[i].first, m_batches[i].second );
+    }
+    m_batches.clear();
+    m_batchSize = 0;
+
+    if ( device() ) {
+        emit m_runner->parsingProgress( device()->pos(), device()->size() );
+    }
+    m_flushTimer.restart();
+}
+
 }
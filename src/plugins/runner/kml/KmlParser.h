@@ -13,20 +13,63 @@
 #include "GeoParser.h"
 #include "KmlDocument.h"
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
 namespace Marble {
 
+class GeoDataContainer;
+class GeoDataFeature;
+class ParsingRunner;
+
 class KmlParser : public GeoParser
 {
 public:
     KmlParser();
     virtual ~KmlParser();
 
+    /**
+     * Parses into @p document instead of a new document, e.g. to set it up
+     * before it is handed off while streaming. Takes ownership.
+     */
+    void setDocument( KmlDocument *document );
+
+    /**
+     * Hands off completed features in batches through
+     * ParsingRunner::featuresParsed() of @p runner while reading, and stops
+     * reading once @p runner is canceled.
+     *
+     * Folders and documents are handed off along with their first completed
+     * child and are replaced by empty containers of the same type for the
+     * rest of the parsing. The document returned by releaseDocument() is
+     * such a replacement once the parsed document was handed off.
+     */
+    void setStreaming( ParsingRunner *runner );
+
+    /** Delivers all completed features which were not handed off yet */
+    void flush();
+
 private:
     virtual bool isValidElement(const QString& tagName) const;
     virtual bool isValidRootElement();
 
     virtual GeoDocument* createDocument() const;
+    virtual void elementParsed( const GeoStackItem &item );
+
+    void handOff( GeoDataContainer *container, GeoDataFeature *feature );
+    void finishReplacement( GeoDataContainer *replacement );
+    void addToBatch( GeoDataContainer *target, GeoDataFeature *feature );
 
+    mutable KmlDocument *m_presetDocument;
+    ParsingRunner *m_runner;
+    // replacement on the parsing side -> handed off container
+    QHash<GeoDataContainer*, GeoDataContainer*> m_handedOff;
+    // handed off containers and features to append to them, in order
+    QVector<QPair<GeoDataContainer*, QVector<GeoDataFeature*> > > m_batches;
+    int m_batchSize;
+    QElapsedTimer m_flushTimer;
 };
 
 }
@@ -59,20 +59,34 @@ GeoDataDocument *KmlRunner::parseFile(const QString &fileName, DocumentRole role
     // Open file in right mode
     file.open( QIODevice::ReadOnly );
 
+    // The document is set up before parsing as it is handed off early when streaming
+    KmlDocument *document = new KmlDocument;
+    document->setDocumentRole( role );
+    document->setFileName( fileName );
+    document->setBaseUri( kmlFileName );
+    document->setFiles( kmzPath, kmzFiles );
+
     KmlParser parser;
+    parser.setDocument( document );
+    if ( isStreaming() ) {
+        parser.setStreaming( this );
+    }
 
     if ( !parser.read( &file ) ) {
         error = parser.errorString();
         mDebug() << error;
         return nullptr;
     }
-    GeoDocument* document = parser.releaseDocument();
-    Q_ASSERT( document );
-    KmlDocument* doc = static_cast<KmlDocument*>( document );
-    doc->setDocumentRole( role );
-    doc->setFileName( fileName );
-    doc->setBaseUri( kmlFileName );
-    doc->setFiles( kmzPath, kmzFiles );
+    parser.flush();
+
+    GeoDataDocument *doc = static_cast<GeoDataDocument*>( parser.releaseDocument() );
+    Q_ASSERT( doc );
+    if ( doc != document ) {
+        // the remaining data of a streamed document
+        doc->setDocumentRole( role );
+        doc->setFileName( fileName );
+        doc->setBaseUri( kmlFileName );
+    }
 
     file.close();
     return doc;
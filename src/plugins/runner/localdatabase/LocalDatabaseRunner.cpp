@@ -12,21 +12,21 @@
 #include "LocalDatabaseRunner.h"
 
 #include "MarbleModel.h"
-#include "MarblePlacemarkModel.h"
-#include "GeoDataFeature.h"
+#include "PlacemarkIndexModel.h"
+#include "GeoDataLatLonBox.h"
 #include "GeoDataPlacemark.h"
-#include "GeoDataCoordinates.h"
 
-#include "MarbleDebug.h"
 #include <QString>
-#include <QStringList>
 #include <QVector>
 
-#include <QtDebug>
-
 namespace Marble
 {
 
+namespace {
+    // more results than anyone would scroll through
+    int const maximumResults = 100;
+}
+
 LocalDatabaseRunner::LocalDatabaseRunner(QObject *parent) :
     SearchRunner(parent)
 {
@@ -42,27 +42,10 @@ void LocalDatabaseRunner::search( const QString &searchTerm, const GeoDataLatLon
     QVector<GeoDataPlacemark*> vector;
 
     if (model()) {
-        const QAbstractItemModel * placemarkModel = model()->placemarkModel();
+        const PlacemarkIndexModel *placemarkModel = qobject_cast<const PlacemarkIndexModel*>( model()->placemarkModel() );
 
         if (placemarkModel) {
-            QModelIndexList resultList;
-            QModelIndex firstIndex = placemarkModel->index( 0, 0 );
-            resultList = placemarkModel->match( firstIndex,
-                                    Qt::DisplayRole, searchTerm, -1,
-                                    Qt::MatchStartsWith );
-
-            bool const searchEverywhere = preferred.isEmpty();
-            foreach ( const QModelIndex& index, resultList ) {
-                if( !index.isValid() ) {
-                    mDebug() << "invalid index!!!";
-                    continue;
-                }
-                GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>( index.data( MarblePlacemarkModel::ObjectPointerRole )));
-                if ( placemark &&
-                     ( searchEverywhere || preferred.contains( placemark->coordinate() ) ) ) {
-                    vector.append( new GeoDataPlacemark( *placemark ));
-                }
-            }
+            vector = placemarkModel->findPlacemarks( searchTerm, preferred, maximumResults );
         }
     }
 
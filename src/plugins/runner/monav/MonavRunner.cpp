@@ -170,29 +170,7 @@ int MonavRunnerPrivate::retrieveRoute( const Marble::RouteRequest* route, QVecto
         }
 
         RoutingInstructions directions = InstructionTransformation::process( waypoints );
-        for ( int i = 0; i < directions.size(); ++i ) {
-            GeoDataPlacemark* placemark = new GeoDataPlacemark( directions[i].instructionText() );
-            GeoDataExtendedData extendedData;
-            GeoDataData turnType;
-            turnType.setName( "turnType" );
-            turnType.setValue( qVariantFromValue<int>( int( directions[i].turnType() ) ) );
-            extendedData.addValue( turnType );
-            GeoDataData roadName;
-            roadName.setName( "roadName" );
-            roadName.setValue( directions[i].roadName() );
-            extendedData.addValue( roadName );
-            placemark->setExtendedData( extendedData );
-            Q_ASSERT( !directions[i].points().isEmpty() );
-            GeoDataLineString* geometry = new GeoDataLineString;
-            QVector<RoutingWaypoint> items = directions[i].points();
-            for ( int j = 0; j < items.size(); ++j ) {
-                RoutingPoint point = items[j].point();
-                GeoDataCoordinates coordinates( point.lon(), point.lat(), 0.0, GeoDataCoordinates::Degree );
-                geometry->append( coordinates );
-            }
-            placemark->setGeometry( geometry );
-            instructions->push_back( placemark );
-        }
+        *instructions += InstructionTransformation::placemarks( directions );
         int duration = (int) reply.seconds;
         return duration;
     }
@@ -0,0 +1,220 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "OfflineRoutingPlugin.h"
+#include "OfflineRoutingRunner.h"
+#include "RoutingGraph.h"
+
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+
+#include "ui_OfflineRoutingConfigWidget.h"
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace Marble
+{
+
+class OfflineRoutingPluginPrivate
+{
+public:
+    ~OfflineRoutingPluginPrivate();
+
+    static QString mapDirectory();
+
+    QMutex m_mutex;
+    QHash<QString, RoutingGraph*> m_graphs;
+};
+
+OfflineRoutingPluginPrivate::~OfflineRoutingPluginPrivate()
+{
+    qDeleteAll( m_graphs );
+}
+
+QString OfflineRoutingPluginPrivate::mapDirectory()
+{
+    return MarbleDirs::localPath() + "/maps/earth/offline-routing/";
+}
+
+OfflineRoutingPlugin::OfflineRoutingPlugin( QObject *parent ) :
+    RoutingRunnerPlugin( parent ),
+    d( new OfflineRoutingPluginPrivate )
+{
+    setSupportedCelestialBodies( QStringList() << "earth" );
+    setCanWorkOffline( true );
+}
+
+OfflineRoutingPlugin::~OfflineRoutingPlugin()
+{
+    delete d;
+}
+
+QString OfflineRoutingPlugin::name() const
+{
+    return tr( "Offline Routing" );
+}
+
+QString OfflineRoutingPlugin::guiString() const
+{
+    return tr( "Offline" );
+}
+
+QString OfflineRoutingPlugin::nameId() const
+{
+    return "offline-routing";
+}
+
+QString OfflineRoutingPlugin::version() const
+{
+    return "1.0";
+}
+
+QString OfflineRoutingPlugin::description() const
+{
+    return tr( "Calculates routes from OpenStreetMap data without an external routing engine" );
+}
+
+QString OfflineRoutingPlugin::copyrightYears() const
+{
+    return "2016";
+}
+
+QList<PluginAuthor> OfflineRoutingPlugin::pluginAuthors() const
+{
+    return QList<PluginAuthor>()
+            << PluginAuthor( "The Marble Team", "marble-devel@kde.org" );
+}
+
+RoutingRunner *OfflineRoutingPlugin::newRunner() const
+{
+    return new OfflineRoutingRunner( this );
+}
+
+class OfflineRoutingConfigWidget : public RoutingRunnerPlugin::ConfigWidget
+{
+public:
+    OfflineRoutingConfigWidget()
+        : RoutingRunnerPlugin::ConfigWidget()
+    {
+        ui_configWidget = new Ui::OfflineRoutingConfigWidget;
+        ui_configWidget->setupUi( this );
+        ui_configWidget->transport->addItem( tr( "Car" ), "motorcar" );
+        ui_configWidget->transport->addItem( tr( "Bicycle" ), "bicycle" );
+        ui_configWidget->transport->addItem( tr( "Pedestrian" ), "foot" );
+    }
+
+    virtual ~OfflineRoutingConfigWidget()
+    {
+        delete ui_configWidget;
+    }
+
+    virtual void loadSettings( const QHash<QString, QVariant> &settings )
+    {
+        int const index = ui_configWidget->transport->findData( settings.value( "transport", "motorcar" ).toString() );
+        ui_configWidget->transport->setCurrentIndex( qMax( 0, index ) );
+        if ( settings.value( "method" ).toString() == "shortest" ) {
+            ui_configWidget->shortest->setChecked( true );
+        } else {
+            ui_configWidget->fastest->setChecked( true );
+        }
+    }
+
+    virtual QHash<QString, QVariant> settings() const
+    {
+        QHash<QString,QVariant> settings;
+        settings.insert( "transport", ui_configWidget->transport->itemData( ui_configWidget->transport->currentIndex() ) );
+        settings.insert( "method", ui_configWidget->shortest->isChecked() ? "shortest" : "fastest" );
+        return settings;
+    }
+
+private:
+    Ui::OfflineRoutingConfigWidget *ui_configWidget;
+};
+
+RoutingRunnerPlugin::ConfigWidget *OfflineRoutingPlugin::configWidget()
+{
+    return new OfflineRoutingConfigWidget();
+}
+
+bool OfflineRoutingPlugin::supportsTemplate( RoutingProfilesModel::ProfileTemplate profileTemplate ) const
+{
+    return profileTemplate != RoutingProfilesModel::CarEcologicalTemplate
+        && profileTemplate != RoutingProfilesModel::LastTemplate;
+}
+
+QHash< QString, QVariant > OfflineRoutingPlugin::templateSettings( RoutingProfilesModel::ProfileTemplate profileTemplate ) const
+{
+    QHash<QString, QVariant> result;
+    switch ( profileTemplate ) {
+        case RoutingProfilesModel::CarFastestTemplate:
+            result["transport"] = "motorcar";
+            result["method"] = "fastest";
+            break;
+        case RoutingProfilesModel::CarShortestTemplate:
+            result["transport"] = "motorcar";
+            result["method"] = "shortest";
+            break;
+        case RoutingProfilesModel::CarEcologicalTemplate:
+            break;
+        case RoutingProfilesModel::BicycleTemplate:
+            result["transport"] = "bicycle";
+            result["method"] = "fastest";
+            break;
+        case RoutingProfilesModel::PedestrianTemplate:
+            result["transport"] = "foot";
+            result["method"] = "fastest";
+            break;
+        case RoutingProfilesModel::LastTemplate:
+            Q_ASSERT( false );
+            break;
+    }
+    return result;
+}
+
+bool OfflineRoutingPlugin::canWork() const
+{
+    return QDir( OfflineRoutingPluginPrivate::mapDirectory() ).exists();
+}
+
+const RoutingGraph *OfflineRoutingPlugin::graph( const QString &transport, const QString &method ) const
+{
+    QString const key = RoutingGraph::fileName( transport, method );
+
+    // loading only maps the file, building is left to routing-graph-builder
+    QMutexLocker locker( &d->m_mutex );
+    if ( d->m_graphs.contains( key ) ) {
+        return d->m_graphs.value( key );
+    }
+
+    QString const fileName = OfflineRoutingPluginPrivate::mapDirectory() + key;
+    if ( !QFile::exists( fileName ) ) {
+        mDebug() << "No routing graph" << fileName << "yet, create it with routing-graph-builder";
+        return 0;
+    }
+
+    RoutingGraph *graph = new RoutingGraph;
+    if ( !graph->load( fileName ) ) {
+        delete graph;
+        return 0;
+    }
+
+    d->m_graphs.insert( key, graph );
+    return graph;
+}
+
+}
+
+Q_EXPORT_PLUGIN2( OfflineRoutingPlugin, Marble::OfflineRoutingPlugin )
+
+#include "moc_OfflineRoutingPlugin.cpp"
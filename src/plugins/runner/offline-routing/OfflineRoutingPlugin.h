@@ -0,0 +1,75 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_OFFLINEROUTINGPLUGIN_H
+#define MARBLE_OFFLINEROUTINGPLUGIN_H
+
+#include "RoutingRunnerPlugin.h"
+
+namespace Marble
+{
+
+class OfflineRoutingPluginPrivate;
+class RoutingGraph;
+
+/**
+ * Calculates routes in-process from the graph files in the
+ * maps/earth/offline-routing/ directory, one per transport and method.
+ * The graphs are preprocessed from an OpenStreetMap extract with the
+ * routing-graph-builder tool, no route is found until they exist.
+ */
+class OfflineRoutingPlugin : public RoutingRunnerPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA( IID "org.kde.edu.marble.OfflineRoutingPlugin" )
+    Q_INTERFACES( Marble::RoutingRunnerPlugin )
+
+public:
+    explicit OfflineRoutingPlugin( QObject *parent = 0 );
+
+    ~OfflineRoutingPlugin();
+
+    QString name() const;
+
+    QString guiString() const;
+
+    QString nameId() const;
+
+    QString version() const;
+
+    QString description() const;
+
+    QString copyrightYears() const;
+
+    QList<PluginAuthor> pluginAuthors() const;
+
+    virtual RoutingRunner *newRunner() const;
+
+    ConfigWidget* configWidget();
+
+    bool supportsTemplate( RoutingProfilesModel::ProfileTemplate profileTemplate ) const;
+
+    QHash< QString, QVariant > templateSettings( RoutingProfilesModel::ProfileTemplate profileTemplate ) const;
+
+    virtual bool canWork() const;
+
+    /**
+     * Returns the routing graph of the given transport and method. Thread-safe,
+     * returns 0 if its graph file has not been built.
+     */
+    const RoutingGraph *graph( const QString &transport, const QString &method ) const;
+
+private:
+    OfflineRoutingPluginPrivate* const d;
+};
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "OfflineRoutingRunner.h"
+#include "OfflineRoutingPlugin.h"
+#include "RoutingGraph.h"
+
+#include "MarbleDebug.h"
+#include "MarbleMath.h"
+#include "routing/RouteRequest.h"
+#include "routing/instructions/InstructionTransformation.h"
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+
+#include <QElapsedTimer>
+#include <QTime>
+
+namespace Marble
+{
+
+class OfflineRoutingRunnerPrivate
+{
+public:
+    explicit OfflineRoutingRunnerPrivate( const OfflineRoutingPlugin *plugin );
+
+    static QVector<GeoDataPlacemark*> instructions( const RoutingGraph *graph, const QVector<RoutingGraph::RouteEdge> &route );
+
+    static GeoDataDocument* createDocument( GeoDataLineString *geometry, const QVector<GeoDataPlacemark*> &instructions, const QString &name, const GeoDataExtendedData &data );
+
+    const OfflineRoutingPlugin *const m_plugin;
+};
+
+OfflineRoutingRunnerPrivate::OfflineRoutingRunnerPrivate( const OfflineRoutingPlugin *plugin ) :
+    m_plugin( plugin )
+{
+    // nothing to do
+}
+
+QVector<GeoDataPlacemark*> OfflineRoutingRunnerPrivate::instructions( const RoutingGraph *graph, const QVector<RoutingGraph::RouteEdge> &route )
+{
+    RoutingWaypoints waypoints;
+    for ( int i = 0; i <= route.size(); ++i ) {
+        // the last node is described by the edge leading to it
+        RoutingGraph::RouteEdge const &step = route[qMin( i, route.size() - 1 )];
+        quint32 const node = i < route.size() ? step.from : step.to;
+        GeoDataCoordinates const coordinates = graph->coordinates( node );
+        RoutingPoint const point( coordinates.longitude( GeoDataCoordinates::Degree ), coordinates.latitude( GeoDataCoordinates::Degree ) );
+
+        RoutingWaypoint::JunctionType junction = RoutingWaypoint::None;
+        if ( graph->isJunction( node ) ) {
+            junction = step.edge->flags & RoutingGraph::Roundabout ? RoutingWaypoint::Roundabout : RoutingWaypoint::Other;
+        }
+
+        QString const type = graph->string( step.edge->type );
+        QString const road = graph->string( step.edge->name );
+        waypoints.push_back( RoutingWaypoint( point, junction, "", type, -1, road ) );
+    }
+
+    return InstructionTransformation::placemarks( InstructionTransformation::process( waypoints ) );
+}
+
+GeoDataDocument* OfflineRoutingRunnerPrivate::createDocument( GeoDataLineString *geometry, const QVector<GeoDataPlacemark*> &instructions, const QString &name, const GeoDataExtendedData &data )
+{
+    if ( !geometry || geometry->isEmpty() ) {
+        delete geometry;
+        qDeleteAll( instructions );
+        return 0;
+    }
+
+    GeoDataDocument* result = new GeoDataDocument;
+    GeoDataPlacemark* routePlacemark = new GeoDataPlacemark;
+    routePlacemark->setName( "Route" );
+    routePlacemark->setGeometry( geometry );
+    routePlacemark->setExtendedData( data );
+    result->append( routePlacemark );
+
+    foreach( GeoDataPlacemark* placemark, instructions ) {
+        result->append( placemark );
+    }
+
+    result->setName( name );
+    return result;
+}
+
+OfflineRoutingRunner::OfflineRoutingRunner( const OfflineRoutingPlugin *plugin, QObject *parent ) :
+    RoutingRunner( parent ),
+    d( new OfflineRoutingRunnerPrivate( plugin ) )
+{
+    // nothing to do
+}
+
+OfflineRoutingRunner::~OfflineRoutingRunner()
+{
+    delete d;
+}
+
+void OfflineRoutingRunner::retrieveRoute( const RouteRequest *request )
+{
+    QHash<QString, QVariant> const settings = request->routingProfile().pluginSettings()["offline-routing"];
+    const RoutingGraph *graph = d->m_plugin->graph( settings.value( "transport", "motorcar" ).toString(),
+                                                    settings.value( "method", "fastest" ).toString() );
+    if ( !graph || request->size() < 2 ) {
+        emit routeCalculated( 0 );
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<RoutingGraph::RouteEdge> route;
+    quint32 source = graph->nearestNode( request->at( 0 ) );
+    for ( int i = 1; i < request->size(); ++i ) {
+        quint32 const target = graph->nearestNode( request->at( i ) );
+        if ( !graph->route( source, target, &route ) ) {
+            mDebug() << "No route between via points" << i - 1 << "and" << i;
+            emit routeCalculated( 0 );
+            return;
+        }
+        source = target;
+    }
+
+    if ( route.isEmpty() ) {
+        emit routeCalculated( 0 );
+        return;
+    }
+
+    GeoDataLineString* geometry = new GeoDataLineString;
+    qreal seconds = 0.0;
+    geometry->append( graph->coordinates( route.first().from ) );
+    foreach ( const RoutingGraph::RouteEdge &step, route ) {
+        GeoDataCoordinates const coordinates = graph->coordinates( step.to );
+        qreal const length = distanceSphere( geometry->last(), coordinates ) * EARTH_RADIUS;
+        seconds += length * 3.6 / qMax<int>( 1, step.edge->speed );
+        geometry->append( coordinates );
+    }
+
+    QVector<GeoDataPlacemark*> const instructions = d->instructions( graph, route );
+    mDebug() << "Route with" << route.size() << "edges found in" << timer.elapsed() << "ms";
+
+    QTime const time = QTime( 0, 0 ).addSecs( qRound( seconds ) );
+    qreal const length = geometry->length( EARTH_RADIUS );
+    QString const name = nameString( "Offline", length, time );
+    GeoDataExtendedData const data = routeData( length, time );
+    emit routeCalculated( d->createDocument( geometry, instructions, name, data ) );
+}
+
+}
+
+#include "moc_OfflineRoutingRunner.cpp"
@@ -0,0 +1,39 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_OFFLINEROUTINGRUNNER_H
+#define MARBLE_OFFLINEROUTINGRUNNER_H
+
+#include "RoutingRunner.h"
+
+namespace Marble
+{
+
+class OfflineRoutingPlugin;
+class OfflineRoutingRunnerPrivate;
+
+class OfflineRoutingRunner : public RoutingRunner
+{
+    Q_OBJECT
+public:
+    explicit OfflineRoutingRunner( const OfflineRoutingPlugin *plugin, QObject *parent = 0 );
+
+    ~OfflineRoutingRunner();
+
+    // Overriding MarbleAbstractRunner
+    virtual void retrieveRoute( const RouteRequest *request );
+
+private:
+    OfflineRoutingRunnerPrivate* const d;
+};
+
+}
+
+#endif
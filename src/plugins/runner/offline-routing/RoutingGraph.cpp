@@ -0,0 +1,424 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "RoutingGraph.h"
+
+#include "MarbleDebug.h"
+
+#include <QHash>
+#include <QPair>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include <cmath>
+#include <cstring>
+
+namespace Marble
+{
+
+namespace
+{
+    // edge length of a grid cell, 0.01 degree in 1e-7 degree
+    qint32 const cellSize = 100000;
+
+    // how many rings of cells around a position are searched for the nearest node
+    int const maxRing = 5;
+
+    quint8 const junctionFlag = 0x1;
+
+    bool cellLessThan( const RoutingGraph::Cell &cell, const QPair<qint32, qint32> &key )
+    {
+        return cell.y < key.first || ( cell.y == key.first && cell.x < key.second );
+    }
+
+    quint32 aligned( quint32 size )
+    {
+        return ( size + 3 ) & ~3u;
+    }
+}
+
+const quint32 RoutingGraph::invalidNode;
+const quint32 RoutingGraph::fileMagic;
+const quint32 RoutingGraph::fileVersion;
+
+RoutingGraph::RoutingGraph() :
+    m_data( 0 ),
+    m_nodes( 0 ),
+    m_firstEdge( 0 ),
+    m_edges( 0 ),
+    m_nodeFlags( 0 ),
+    m_cells( 0 ),
+    m_stringOffsets( 0 ),
+    m_strings( 0 )
+{
+    memset( &m_header, 0, sizeof( m_header ) );
+}
+
+RoutingGraph::~RoutingGraph()
+{
+    if ( m_data ) {
+        m_file.unmap( const_cast<uchar*>( m_data ) );
+    }
+}
+
+bool RoutingGraph::load( const QString &fileName )
+{
+    m_file.setFileName( fileName );
+    if ( !m_file.open( QIODevice::ReadOnly ) ) {
+        mDebug() << "Cannot open routing graph" << fileName;
+        return false;
+    }
+
+    qint64 const size = m_file.size();
+    if ( size < qint64( sizeof( Header ) ) ) {
+        mDebug() << "Truncated routing graph" << fileName;
+        return false;
+    }
+
+    m_data = m_file.map( 0, size );
+    if ( !m_data ) {
+        mDebug() << "Cannot map routing graph" << fileName;
+        return false;
+    }
+
+    memcpy( &m_header, m_data, sizeof( Header ) );
+    if ( m_header.magic != fileMagic || m_header.version != fileVersion ) {
+        mDebug() << "Not a routing graph of a supported version" << fileName;
+        m_file.unmap( const_cast<uchar*>( m_data ) );
+        m_data = 0;
+        return false;
+    }
+
+    quint64 offset = sizeof( Header );
+    quint64 const nodesOffset = offset;
+    offset += quint64( m_header.nodeCount ) * sizeof( Node );
+    quint64 const firstEdgeOffset = offset;
+    offset += ( quint64( m_header.nodeCount ) + 1 ) * sizeof( quint32 );
+    quint64 const edgesOffset = offset;
+    offset += quint64( m_header.edgeCount ) * sizeof( Edge );
+    quint64 const nodeFlagsOffset = offset;
+    offset += aligned( m_header.nodeCount );
+    quint64 const cellsOffset = offset;
+    offset += ( quint64( m_header.cellCount ) + 1 ) * sizeof( Cell );
+    quint64 const stringOffsetsOffset = offset;
+    offset += ( quint64( m_header.stringCount ) + 1 ) * sizeof( quint32 );
+    quint64 const stringsOffset = offset;
+    offset += m_header.stringBytes;
+
+    if ( offset != quint64( size ) ) {
+        mDebug() << "Corrupt routing graph" << fileName;
+        m_file.unmap( const_cast<uchar*>( m_data ) );
+        m_data = 0;
+        return false;
+    }
+
+    m_nodes = reinterpret_cast<const Node*>( m_data + nodesOffset );
+    m_firstEdge = reinterpret_cast<const quint32*>( m_data + firstEdgeOffset );
+    m_edges = reinterpret_cast<const Edge*>( m_data + edgesOffset );
+    m_nodeFlags = m_data + nodeFlagsOffset;
+    m_cells = reinterpret_cast<const Cell*>( m_data + cellsOffset );
+    m_stringOffsets = reinterpret_cast<const quint32*>( m_data + stringOffsetsOffset );
+    m_strings = reinterpret_cast<const char*>( m_data + stringsOffset );
+
+    if ( !isValid() ) {
+        mDebug() << "Corrupt routing graph" << fileName;
+        m_file.unmap( const_cast<uchar*>( m_data ) );
+        m_data = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool RoutingGraph::isValid() const
+{
+    // Queries index the mapped arrays without further checks, so every
+    // index stored in the file is checked once here.
+    quint32 const nodeCount = m_header.nodeCount;
+    if ( m_firstEdge[0] != 0 || m_firstEdge[nodeCount] != m_header.edgeCount ) {
+        return false;
+    }
+    for ( quint32 node = 0; node < nodeCount; ++node ) {
+        if ( m_firstEdge[node] > m_firstEdge[node+1] ) {
+            return false;
+        }
+    }
+
+    for ( quint32 i = 0; i < m_header.edgeCount; ++i ) {
+        const Edge &edge = m_edges[i];
+        if ( edge.target >= nodeCount || ( edge.middle != invalidNode && edge.middle >= nodeCount ) ) {
+            return false;
+        }
+    }
+
+    if ( m_cells[0].firstNode != 0 || m_cells[m_header.cellCount].firstNode != nodeCount ) {
+        return false;
+    }
+    for ( quint32 i = 0; i < m_header.cellCount; ++i ) {
+        if ( m_cells[i].firstNode > m_cells[i+1].firstNode ) {
+            return false;
+        }
+    }
+
+    if ( m_stringOffsets[0] != 0 || m_stringOffsets[m_header.stringCount] != m_header.stringBytes ) {
+        return false;
+    }
+    for ( quint32 i = 0; i < m_header.stringCount; ++i ) {
+        if ( m_stringOffsets[i] > m_stringOffsets[i+1] ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+quint32 RoutingGraph::nodeCount() const
+{
+    return m_data ? m_header.nodeCount : 0;
+}
+
+GeoDataCoordinates RoutingGraph::coordinates( quint32 node ) const
+{
+    Q_ASSERT( node < m_header.nodeCount );
+    return GeoDataCoordinates( m_nodes[node].lon * 1.0e-7, m_nodes[node].lat * 1.0e-7, 0.0, GeoDataCoordinates::Degree );
+}
+
+bool RoutingGraph::isJunction( quint32 node ) const
+{
+    Q_ASSERT( node < m_header.nodeCount );
+    return m_nodeFlags[node] & junctionFlag;
+}
+
+QString RoutingGraph::string( quint32 index ) const
+{
+    if ( index >= m_header.stringCount ) {
+        return QString();
+    }
+
+    quint32 const begin = m_stringOffsets[index];
+    return QString::fromUtf8( m_strings + begin, m_stringOffsets[index+1] - begin );
+}
+
+QString RoutingGraph::fileName( const QString &transport, const QString &method )
+{
+    return QString( "%1-%2.graph" ).arg( transport ).arg( method == "shortest" ? "shortest" : "fastest" );
+}
+
+qint32 RoutingGraph::cell( qint32 fixed )
+{
+    return fixed >= 0 ? fixed / cellSize : -( ( -fixed + cellSize - 1 ) / cellSize );
+}
+
+quint32 RoutingGraph::nearestNode( const GeoDataCoordinates &position ) const
+{
+    if ( !m_data ) {
+        return invalidNode;
+    }
+
+    qint32 const lon = qRound( position.longitude( GeoDataCoordinates::Degree ) * 1.0e7 );
+    qint32 const lat = qRound( position.latitude( GeoDataCoordinates::Degree ) * 1.0e7 );
+    qint32 const x = cell( lon );
+    qint32 const y = cell( lat );
+
+    // distances are compared in 1e-7 degree of latitude
+    qreal const scale = cos( position.latitude() );
+    qreal bestDistance = std::numeric_limits<qreal>::max();
+    quint32 best = invalidNode;
+    Cell const *const cellsEnd = m_cells + m_header.cellCount;
+
+    for ( int ring = 0; ring <= maxRing; ++ring ) {
+        for ( int dy = -ring; dy <= ring; ++dy ) {
+            for ( int dx = -ring; dx <= ring; ++dx ) {
+                if ( qAbs( dx ) != ring && qAbs( dy ) != ring ) {
+                    continue;
+                }
+
+                QPair<qint32, qint32> const key( y + dy, x + dx );
+                Cell const *found = std::lower_bound( m_cells, cellsEnd, key, cellLessThan );
+                if ( found == cellsEnd || found->y != key.first || found->x != key.second ) {
+                    continue;
+                }
+
+                for ( quint32 node = found->firstNode; node < ( found + 1 )->firstNode; ++node ) {
+                    qreal const deltaLon = ( m_nodes[node].lon - lon ) * scale;
+                    qreal const deltaLat = m_nodes[node].lat - lat;
+                    qreal const distance = deltaLon * deltaLon + deltaLat * deltaLat;
+                    if ( distance < bestDistance ) {
+                        bestDistance = distance;
+                        best = node;
+                    }
+                }
+            }
+        }
+
+        // cells of the next ring are at least this far away
+        qreal const bound = ring * cellSize * scale;
+        if ( best != invalidNode && bestDistance <= bound * bound ) {
+            break;
+        }
+    }
+
+    return best;
+}
+
+bool RoutingGraph::route( quint32 source, quint32 target, QVector<RouteEdge> *route ) const
+{
+    if ( source >= nodeCount() || target >= nodeCount() ) {
+        return false;
+    }
+
+    if ( source == target ) {
+        return true;
+    }
+
+    struct Label
+    {
+        quint32 distance;
+        quint32 parent;
+        const Edge *edge;
+    };
+
+    typedef QPair<quint32, quint32> Entry;
+    typedef std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > Queue;
+
+    QHash<quint32, Label> labels[2];
+    Queue queues[2];
+    quint8 const flags[2] = { Forward, Backward };
+
+    Label const start = { 0, invalidNode, 0 };
+    labels[0].insert( source, start );
+    labels[1].insert( target, start );
+    queues[0].push( Entry( 0, source ) );
+    queues[1].push( Entry( 0, target ) );
+
+    quint32 const infinity = std::numeric_limits<quint32>::max();
+    quint32 best = infinity;
+    quint32 meeting = invalidNode;
+
+    // Both searches only relax edges to nodes higher in the hierarchy. They
+    // are done once neither can improve on the best meeting node anymore.
+    forever {
+        quint32 const forwardMin = queues[0].empty() ? infinity : queues[0].top().first;
+        quint32 const backwardMin = queues[1].empty() ? infinity : queues[1].top().first;
+        if ( qMin( forwardMin, backwardMin ) >= best ) {
+            break;
+        }
+
+        int const direction = forwardMin <= backwardMin ? 0 : 1;
+        Entry const entry = queues[direction].top();
+        queues[direction].pop();
+        quint32 const node = entry.second;
+        if ( labels[direction].value( node ).distance < entry.first ) {
+            continue;
+        }
+
+        QHash<quint32, Label>::const_iterator const other = labels[1-direction].constFind( node );
+        if ( other != labels[1-direction].constEnd() && entry.first + other->distance < best ) {
+            best = entry.first + other->distance;
+            meeting = node;
+        }
+
+        for ( quint32 i = m_firstEdge[node]; i < m_firstEdge[node+1]; ++i ) {
+            Edge const &edge = m_edges[i];
+            if ( !( edge.flags & flags[direction] ) ) {
+                continue;
+            }
+
+            quint32 const distance = entry.first + edge.weight;
+            QHash<quint32, Label>::iterator label = labels[direction].find( edge.target );
+            if ( label == labels[direction].end() ) {
+                Label const reached = { distance, node, &edge };
+                labels[direction].insert( edge.target, reached );
+                queues[direction].push( Entry( distance, edge.target ) );
+            } else if ( distance < label->distance ) {
+                label->distance = distance;
+                label->parent = node;
+                label->edge = &edge;
+                queues[direction].push( Entry( distance, edge.target ) );
+            }
+        }
+    }
+
+    if ( meeting == invalidNode ) {
+        return false;
+    }
+
+    // upward edges from the source to the meeting node
+    QVector<RouteEdge> upward;
+    for ( quint32 node = meeting; node != source; ) {
+        Label const &label = labels[0][node];
+        RouteEdge const step = { label.parent, node, label.edge };
+        upward.append( step );
+        node = label.parent;
+    }
+    std::reverse( upward.begin(), upward.end() );
+
+    foreach ( const RouteEdge &step, upward ) {
+        unpack( step.from, step.to, step.edge, route );
+    }
+
+    // downward edges from the meeting node to the target
+    for ( quint32 node = meeting; node != target; ) {
+        Label const &label = labels[1][node];
+        unpack( node, label.parent, label.edge, route );
+        node = label.parent;
+    }
+
+    return true;
+}
+
+const RoutingGraph::Edge *RoutingGraph::findEdge( quint32 node, quint32 target, quint8 flag ) const
+{
+    for ( quint32 i = m_firstEdge[node]; i < m_firstEdge[node+1]; ++i ) {
+        if ( m_edges[i].target == target && ( m_edges[i].flags & flag ) ) {
+            return &m_edges[i];
+        }
+    }
+
+    return 0;
+}
+
+void RoutingGraph::unpack( quint32 from, quint32 to, const Edge *edge, QVector<RouteEdge> *route ) const
+{
+    QVector<RouteEdge> stack;
+    RouteEdge const first = { from, to, edge };
+    stack.push_back( first );
+
+    while ( !stack.isEmpty() ) {
+        RouteEdge const current = stack.last();
+        stack.pop_back();
+
+        quint32 const middle = current.edge->middle;
+        if ( middle == invalidNode ) {
+            route->append( current );
+            continue;
+        }
+
+        // The shortcut was added when its middle node was contracted, that
+        // node still stores both halves.
+        const Edge *const head = findEdge( middle, current.from, Backward );
+        const Edge *const tail = findEdge( middle, current.to, Forward );
+        if ( !head || !tail ) {
+            mDebug() << "Cannot unpack shortcut via" << middle;
+            continue;
+        }
+
+        RouteEdge const second = { middle, current.to, tail };
+        RouteEdge const first = { current.from, middle, head };
+        stack.push_back( second );
+        stack.push_back( first );
+    }
+}
+
+}
@@ -0,0 +1,149 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_ROUTINGGRAPH_H
+#define MARBLE_ROUTINGGRAPH_H
+
+#include "GeoDataCoordinates.h"
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+namespace Marble
+{
+
+/**
+ * A road network preprocessed with contraction hierarchies, see RoutingGraphBuilder.
+ *
+ * The graph file is mapped into memory as is. Each node only stores the edges
+ * to nodes that were contracted after it, so both searches of a bidirectional
+ * Dijkstra query only move upwards in the hierarchy and settle few nodes.
+ * Shortcut edges remember the node they bypass and are unpacked into the
+ * original road edges for the route geometry and the turn instructions.
+ */
+class RoutingGraph
+{
+public:
+    enum EdgeFlag {
+        Forward = 0x1,       ///< the edge can be used from its node to its target
+        Backward = 0x2,      ///< the edge can be used from its target to its node
+        Roundabout = 0x4
+    };
+
+    /** Edge record of the graph file */
+    struct Edge
+    {
+        quint32 target;
+        quint32 weight;     ///< travel time in 1/10 s or length in 1/10 m
+        quint32 middle;     ///< node bypassed by a shortcut, invalidNode for road edges
+        quint32 name;       ///< string index of the road name
+        quint16 type;       ///< string index of the highway type
+        quint8 flags;
+        quint8 speed;       ///< km/h
+    };
+
+    /** A road edge of a route, in driving direction */
+    struct RouteEdge
+    {
+        quint32 from;
+        quint32 to;
+        const Edge *edge;
+    };
+
+    static const quint32 invalidNode = 0xffffffff;
+
+    RoutingGraph();
+
+    ~RoutingGraph();
+
+    bool load( const QString &fileName );
+
+    quint32 nodeCount() const;
+
+    GeoDataCoordinates coordinates( quint32 node ) const;
+
+    /** True if more than two road edges meet at the node */
+    bool isJunction( quint32 node ) const;
+
+    QString string( quint32 index ) const;
+
+    /**
+     * Returns the node closest to the given position within a few kilometers,
+     * invalidNode if there is none.
+     */
+    quint32 nearestNode( const GeoDataCoordinates &position ) const;
+
+    /**
+     * Calculates the best route from source to target and appends its road
+     * edges to route. Returns false if target is not reachable.
+     */
+    bool route( quint32 source, quint32 target, QVector<RouteEdge> *route ) const;
+
+    /** Name of the graph file of the given transport and method */
+    static QString fileName( const QString &transport, const QString &method );
+
+    /** Grid cell of a position given in 1e-7 degree, used to order the nodes */
+    static qint32 cell( qint32 fixed );
+
+    static const quint32 fileMagic = 0x4d524348; // "MRCH"
+    static const quint32 fileVersion = 1;
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint32 nodeCount;
+        quint32 edgeCount;
+        quint32 cellCount;
+        quint32 stringCount;
+        quint32 stringBytes;
+        quint32 reserved;
+    };
+
+    struct Node
+    {
+        qint32 lon;         ///< 1e-7 degree
+        qint32 lat;
+    };
+
+    /** Nodes are sorted by cells, the nodes of a cell are stored consecutively */
+    struct Cell
+    {
+        qint32 y;
+        qint32 x;
+        quint32 firstNode;
+    };
+
+private:
+    Q_DISABLE_COPY( RoutingGraph )
+
+    /** Checks that the indices of the mapped file stay within its arrays */
+    bool isValid() const;
+
+    const Edge *findEdge( quint32 node, quint32 target, quint8 flag ) const;
+
+    void unpack( quint32 from, quint32 to, const Edge *edge, QVector<RouteEdge> *route ) const;
+
+    QFile m_file;
+    const uchar *m_data;
+    Header m_header;
+    const Node *m_nodes;
+    const quint32 *m_firstEdge;
+    const Edge *m_edges;
+    const quint8 *m_nodeFlags;
+    const Cell *m_cells;
+    const quint32 *m_stringOffsets;
+    const char *m_strings;
+};
+
+}
+
+#endif
@@ -0,0 +1,656 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "RoutingGraphBuilder.h"
+#include "RoutingGraph.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTypes.h"
+#include "MarbleDebug.h"
+#include "MarbleMath.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QHash>
+#include <QPair>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace Marble
+{
+
+namespace
+{
+    // witness searches give up after settling this many nodes
+    int const witnessSettleLimit = 500;
+
+    quint32 const infinity = std::numeric_limits<quint32>::max();
+}
+
+class RoutingGraphBuilderPrivate
+{
+public:
+    typedef RoutingGraph::Edge Edge;
+
+    struct Shortcut
+    {
+        quint32 from;
+        quint32 to;
+        quint32 weight;
+    };
+
+    RoutingGraphBuilderPrivate( const QString &transport, const QString &method );
+
+    int speed( const OsmPlacemarkData &osmData ) const;
+    bool isAccessible( const OsmPlacemarkData &osmData ) const;
+    void oneway( const OsmPlacemarkData &osmData, bool *forward, bool *backward ) const;
+
+    quint32 node( const GeoDataCoordinates &coordinates );
+    static quint32 string( const QString &string, QHash<QString, quint32> &ids, QStringList &strings );
+    void addEdge( quint32 from, quint32 to, const Edge &edge );
+    static void removeEdge( QVector<Edge> &edges, quint32 target );
+
+    void witnessSearch( quint32 source, quint32 excluded, quint32 maxWeight );
+    int shortcuts( quint32 node, QVector<Shortcut> *result );
+    int priority( quint32 node );
+    void contract( quint32 node );
+
+    QString const m_transport;
+    bool const m_fastest;
+
+    QHash<quint64, quint32> m_nodeIds;
+    QVector<RoutingGraph::Node> m_nodes;
+    QVector<int> m_degree;
+    QHash<QString, quint32> m_nameIds;
+    QStringList m_names;
+    QHash<QString, quint32> m_typeIds;
+    QStringList m_types;
+
+    // the remaining graph during contraction, incoming edges store their source as target
+    QVector<QVector<Edge> > m_out;
+    QVector<QVector<Edge> > m_in;
+
+    // edges of contracted nodes to nodes contracted later
+    QVector<QVector<Edge> > m_upward;
+    QVector<bool> m_contracted;
+    QVector<int> m_contractedNeighbors;
+    bool m_isContracted;
+
+    QVector<quint32> m_distance;
+    QVector<quint32> m_touched;
+};
+
+RoutingGraphBuilderPrivate::RoutingGraphBuilderPrivate( const QString &transport, const QString &method ) :
+    m_transport( transport ),
+    m_fastest( method != "shortest" ),
+    m_isContracted( false )
+{
+    // nothing to do
+}
+
+int RoutingGraphBuilderPrivate::speed( const OsmPlacemarkData &osmData ) const
+{
+    QString const highway = osmData.tagValue( "highway" );
+
+    if ( m_transport == "foot" ) {
+        static QStringList const forbidden = QStringList() << "motorway" << "motorway_link" << "construction" << "proposed";
+        return forbidden.contains( highway ) ? 0 : 5;
+    }
+
+    if ( m_transport == "bicycle" ) {
+        static QStringList const forbidden = QStringList() << "motorway" << "motorway_link" << "construction" << "proposed";
+        static QStringList const pushing = QStringList() << "footway" << "pedestrian" << "steps";
+        if ( forbidden.contains( highway ) ) {
+            return 0;
+        }
+        if ( pushing.contains( highway ) ) {
+            return osmData.containsTag( "bicycle", "yes" ) || osmData.containsTag( "bicycle", "designated" ) ? 16 : 0;
+        }
+        return 16;
+    }
+
+    static QHash<QString, int> speeds;
+    if ( speeds.isEmpty() ) {
+        speeds["motorway"] = 120;
+        speeds["motorway_link"] = 60;
+        speeds["trunk"] = 100;
+        speeds["trunk_link"] = 50;
+        speeds["primary"] = 80;
+        speeds["primary_link"] = 40;
+        speeds["secondary"] = 70;
+        speeds["secondary_link"] = 35;
+        speeds["tertiary"] = 60;
+        speeds["tertiary_link"] = 30;
+        speeds["unclassified"] = 50;
+        speeds["road"] = 30;
+        speeds["residential"] = 30;
+        speeds["service"] = 20;
+        speeds["living_street"] = 10;
+    }
+
+    int result = speeds.value( highway );
+    if ( result > 0 && osmData.containsTagKey( "maxspeed" ) ) {
+        QString const maxSpeed = osmData.tagValue( "maxspeed" );
+        bool ok = false;
+        int const limit = maxSpeed.section( ' ', 0, 0 ).toInt( &ok );
+        if ( ok && limit > 0 ) {
+            result = qMin( result, maxSpeed.contains( "mph" ) ? qRound( limit * 1.609 ) : limit );
+        }
+    }
+    return result;
+}
+
+bool RoutingGraphBuilderPrivate::isAccessible( const OsmPlacemarkData &osmData ) const
+{
+    // the most specific access tag wins
+    QStringList keys;
+    if ( m_transport == "foot" ) {
+        keys << "foot";
+    } else if ( m_transport == "bicycle" ) {
+        keys << "bicycle" << "vehicle";
+    } else {
+        keys << "motorcar" << "motor_vehicle" << "vehicle";
+    }
+    keys << "access";
+
+    foreach ( const QString &key, keys ) {
+        if ( osmData.containsTagKey( key ) ) {
+            QString const value = osmData.tagValue( key );
+            return value != "no" && value != "private";
+        }
+    }
+
+    return !osmData.containsTag( "area", "yes" );
+}
+
+void RoutingGraphBuilderPrivate::oneway( const OsmPlacemarkData &osmData, bool *forward, bool *backward ) const
+{
+    *forward = true;
+    *backward = true;
+    if ( m_transport == "foot" ) {
+        return;
+    }
+    if ( m_transport == "bicycle" && osmData.containsTag( "oneway:bicycle", "no" ) ) {
+        return;
+    }
+
+    QString const oneway = osmData.tagValue( "oneway" );
+    if ( oneway == "yes" || oneway == "true" || oneway == "1" ) {
+        *backward = false;
+    } else if ( oneway == "-1" || oneway == "reverse" ) {
+        *forward = false;
+    } else if ( oneway != "no" ) {
+        bool const implied = osmData.containsTag( "junction", "roundabout" )
+                || osmData.containsTag( "highway", "motorway" )
+                || osmData.containsTag( "highway", "motorway_link" );
+        *backward = !implied;
+    }
+}
+
+quint32 RoutingGraphBuilderPrivate::node( const GeoDataCoordinates &coordinates )
+{
+    RoutingGraph::Node node;
+    node.lon = qRound( coordinates.longitude( GeoDataCoordinates::Degree ) * 1.0e7 );
+    node.lat = qRound( coordinates.latitude( GeoDataCoordinates::Degree ) * 1.0e7 );
+
+    // ways are connected by sharing nodes, which are identified by their position
+    quint64 const key = ( quint64( quint32( node.lat ) ) << 32 ) | quint32( node.lon );
+    QHash<quint64, quint32>::const_iterator const iter = m_nodeIds.constFind( key );
+    if ( iter != m_nodeIds.constEnd() ) {
+        return iter.value();
+    }
+
+    quint32 const id = m_nodes.size();
+    m_nodeIds.insert( key, id );
+    m_nodes.append( node );
+    m_degree.append( 0 );
+    m_out.append( QVector<Edge>() );
+    m_in.append( QVector<Edge>() );
+    return id;
+}
+
+quint32 RoutingGraphBuilderPrivate::string( const QString &string, QHash<QString, quint32> &ids, QStringList &strings )
+{
+    QHash<QString, quint32>::const_iterator const iter = ids.constFind( string );
+    if ( iter != ids.constEnd() ) {
+        return iter.value();
+    }
+
+    quint32 const id = strings.size();
+    ids.insert( string, id );
+    strings.append( string );
+    return id;
+}
+
+void RoutingGraphBuilderPrivate::addEdge( quint32 from, quint32 to, const Edge &edge )
+{
+    for ( int i = 0; i < m_out[from].size(); ++i ) {
+        if ( m_out[from][i].target == to ) {
+            if ( m_out[from][i].weight <= edge.weight ) {
+                return;
+            }
+            removeEdge( m_out[from], to );
+            removeEdge( m_in[to], from );
+            break;
+        }
+    }
+
+    Edge outgoing = edge;
+    outgoing.target = to;
+    m_out[from].append( outgoing );
+
+    Edge incoming = edge;
+    incoming.target = from;
+    m_in[to].append( incoming );
+}
+
+void RoutingGraphBuilderPrivate::removeEdge( QVector<Edge> &edges, quint32 target )
+{
+    for ( int i = 0; i < edges.size(); ++i ) {
+        if ( edges[i].target == target ) {
+            edges[i] = edges.last();
+            edges.removeLast();
+            return;
+        }
+    }
+}
+
+void RoutingGraphBuilderPrivate::witnessSearch( quint32 source, quint32 excluded, quint32 maxWeight )
+{
+    foreach ( quint32 node, m_touched ) {
+        m_distance[node] = infinity;
+    }
+    m_touched.clear();
+
+    typedef QPair<quint32, quint32> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+    m_distance[source] = 0;
+    m_touched.append( source );
+    queue.push( Entry( 0, source ) );
+
+    int settled = 0;
+    while ( !queue.empty() && settled < witnessSettleLimit ) {
+        Entry const entry = queue.top();
+        queue.pop();
+        if ( entry.first > m_distance[entry.second] ) {
+            continue;
+        }
+        if ( entry.first > maxWeight ) {
+            break;
+        }
+        ++settled;
+
+        foreach ( const Edge &edge, m_out[entry.second] ) {
+            if ( edge.target == excluded ) {
+                continue;
+            }
+
+            quint32 const distance = entry.first + edge.weight;
+            if ( distance < m_distance[edge.target] ) {
+                if ( m_distance[edge.target] == infinity ) {
+                    m_touched.append( edge.target );
+                }
+                m_distance[edge.target] = distance;
+                queue.push( Entry( distance, edge.target ) );
+            }
+        }
+    }
+}
+
+int RoutingGraphBuilderPrivate::shortcuts( quint32 node, QVector<Shortcut> *result )
+{
+    int count = 0;
+    foreach ( const Edge &incoming, m_in[node] ) {
+        quint32 maxWeight = 0;
+        foreach ( const Edge &outgoing, m_out[node] ) {
+            if ( outgoing.target != incoming.target ) {
+                maxWeight = qMax( maxWeight, incoming.weight + outgoing.weight );
+            }
+        }
+        if ( maxWeight == 0 ) {
+            continue;
+        }
+
+        witnessSearch( incoming.target, node, maxWeight );
+        foreach ( const Edge &outgoing, m_out[node] ) {
+            quint32 const weight = incoming.weight + outgoing.weight;
+            if ( outgoing.target == incoming.target || m_distance[outgoing.target] <= weight ) {
+                continue;
+            }
+
+            ++count;
+            if ( result ) {
+                Shortcut const shortcut = { incoming.target, outgoing.target, weight };
+                result->append( shortcut );
+            }
+        }
+    }
+
+    return count;
+}
+
+int RoutingGraphBuilderPrivate::priority( quint32 node )
+{
+    int const removed = m_in[node].size() + m_out[node].size();
+    return shortcuts( node, 0 ) - removed + m_contractedNeighbors[node];
+}
+
+void RoutingGraphBuilderPrivate::contract( quint32 node )
+{
+    QVector<Shortcut> added;
+    shortcuts( node, &added );
+
+    // keep the remaining edges of the node for the queries, merging both directions of roads
+    QVector<Edge> &upward = m_upward[node];
+    foreach ( const Edge &outgoing, m_out[node] ) {
+        Edge edge = outgoing;
+        edge.flags |= RoutingGraph::Forward;
+        upward.append( edge );
+    }
+    foreach ( const Edge &incoming, m_in[node] ) {
+        bool merged = false;
+        for ( int i = 0; i < upward.size() && !merged; ++i ) {
+            Edge &edge = upward[i];
+            if ( edge.target == incoming.target && edge.weight == incoming.weight && edge.middle == incoming.middle
+                 && edge.name == incoming.name && edge.type == incoming.type && edge.speed == incoming.speed
+                 && ( edge.flags & RoutingGraph::Roundabout ) == ( incoming.flags & RoutingGraph::Roundabout ) ) {
+                edge.flags |= RoutingGraph::Backward;
+                merged = true;
+            }
+        }
+        if ( !merged ) {
+            Edge edge = incoming;
+            edge.flags |= RoutingGraph::Backward;
+            upward.append( edge );
+        }
+    }
+
+    QVector<quint32> neighbors;
+    foreach ( const Edge &outgoing, m_out[node] ) {
+        removeEdge( m_in[outgoing.target], node );
+        neighbors.append( outgoing.target );
+    }
+    foreach ( const Edge &incoming, m_in[node] ) {
+        removeEdge( m_out[incoming.target], node );
+        neighbors.append( incoming.target );
+    }
+    m_out[node].clear();
+    m_in[node].clear();
+    m_contracted[node] = true;
+
+    foreach ( const Shortcut &shortcut, added ) {
+        Edge edge;
+        edge.target = shortcut.to;
+        edge.weight = shortcut.weight;
+        edge.middle = node;
+        edge.name = 0;
+        edge.type = 0;
+        edge.flags = 0;
+        edge.speed = 0;
+        addEdge( shortcut.from, shortcut.to, edge );
+    }
+
+    std::sort( neighbors.begin(), neighbors.end() );
+    neighbors.erase( std::unique( neighbors.begin(), neighbors.end() ), neighbors.end() );
+    foreach ( quint32 neighbor, neighbors ) {
+        ++m_contractedNeighbors[neighbor];
+    }
+}
+
+RoutingGraphBuilder::RoutingGraphBuilder( const QString &transport, const QString &method ) :
+    d( new RoutingGraphBuilderPrivate( transport, method ) )
+{
+    // nothing to do
+}
+
+RoutingGraphBuilder::~RoutingGraphBuilder()
+{
+    delete d;
+}
+
+void RoutingGraphBuilder::addDocument( const GeoDataDocument *document )
+{
+    Q_ASSERT( !d->m_isContracted );
+
+    foreach ( const GeoDataPlacemark *placemark, document->placemarkList() ) {
+        if ( !placemark->geometry() || placemark->geometry()->nodeType() != GeoDataTypes::GeoDataLineStringType ) {
+            continue;
+        }
+
+        const GeoDataLineString *lineString = static_cast<const GeoDataLineString*>( placemark->geometry() );
+        OsmPlacemarkData const &osmData = placemark->osmData();
+        if ( lineString->size() < 2 || !osmData.containsTagKey( "highway" ) ) {
+            continue;
+        }
+
+        int const speed = d->speed( osmData );
+        if ( speed <= 0 || !d->isAccessible( osmData ) ) {
+            continue;
+        }
+
+        bool forward, backward;
+        d->oneway( osmData, &forward, &backward );
+
+        QString name = osmData.tagValue( "name" );
+        if ( name.isEmpty() ) {
+            name = osmData.tagValue( "ref" );
+        }
+
+        RoutingGraph::Edge edge;
+        edge.middle = RoutingGraph::invalidNode;
+        edge.name = d->string( name, d->m_nameIds, d->m_names );
+        edge.type = d->string( osmData.tagValue( "highway" ), d->m_typeIds, d->m_types );
+        edge.flags = osmData.containsTag( "junction", "roundabout" ) ? RoutingGraph::Roundabout : 0;
+        edge.speed = qMin( speed, 255 );
+
+        quint32 previous = d->node( lineString->first() );
+        for ( int i = 1; i < lineString->size(); ++i ) {
+            quint32 const current = d->node( lineString->at( i ) );
+            if ( current == previous ) {
+                continue;
+            }
+
+            qreal const length = distanceSphere( lineString->at( i - 1 ), lineString->at( i ) ) * EARTH_RADIUS;
+            qreal const weight = d->m_fastest ? length * 36.0 / speed : length * 10.0;
+            edge.weight = qMax( 1, qRound( weight ) );
+
+            ++d->m_degree[previous];
+            ++d->m_degree[current];
+            if ( forward ) {
+                d->addEdge( previous, current, edge );
+            }
+            if ( backward ) {
+                d->addEdge( current, previous, edge );
+            }
+            previous = current;
+        }
+    }
+}
+
+void RoutingGraphBuilder::contract()
+{
+    Q_ASSERT( !d->m_isContracted );
+
+    int const count = d->m_nodes.size();
+    d->m_upward.resize( count );
+    d->m_contracted.fill( false, count );
+    d->m_contractedNeighbors.fill( 0, count );
+    d->m_distance.fill( infinity, count );
+
+    typedef QPair<int, quint32> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+    QVector<int> priorities( count );
+    for ( int i = 0; i < count; ++i ) {
+        priorities[i] = d->priority( i );
+        queue.push( Entry( priorities[i], i ) );
+    }
+
+    int contracted = 0;
+    while ( !queue.empty() ) {
+        Entry const entry = queue.top();
+        queue.pop();
+        quint32 const node = entry.second;
+        if ( d->m_contracted[node] || entry.first != priorities[node] ) {
+            continue;
+        }
+
+        // priorities change as the graph shrinks, only contract the node if it is still the best
+        int const current = d->priority( node );
+        if ( current > entry.first && !queue.empty() && current > queue.top().first ) {
+            priorities[node] = current;
+            queue.push( Entry( current, node ) );
+            continue;
+        }
+
+        QVector<quint32> neighbors;
+        foreach ( const RoutingGraph::Edge &edge, d->m_out[node] ) {
+            neighbors.append( edge.target );
+        }
+        foreach ( const RoutingGraph::Edge &edge, d->m_in[node] ) {
+            neighbors.append( edge.target );
+        }
+
+        d->contract( node );
+
+        foreach ( quint32 neighbor, neighbors ) {
+            if ( !d->m_contracted[neighbor] ) {
+                priorities[neighbor] = d->priority( neighbor );
+                queue.push( Entry( priorities[neighbor], neighbor ) );
+            }
+        }
+
+        ++contracted;
+        if ( contracted % 100000 == 0 ) {
+            mDebug() << "Contracted" << contracted << "of" << count << "nodes";
+        }
+    }
+
+    d->m_out.clear();
+    d->m_in.clear();
+    d->m_distance.clear();
+    d->m_touched.clear();
+    d->m_isContracted = true;
+}
+
+bool RoutingGraphBuilder::save( const QString &fileName ) const
+{
+    Q_ASSERT( d->m_isContracted );
+
+    // store the nodes ordered by cells for the nearest node lookup and memory locality
+    quint32 const count = d->m_nodes.size();
+    QVector<QPair<QPair<qint32, qint32>, quint32> > order;
+    order.reserve( count );
+    for ( quint32 i = 0; i < count; ++i ) {
+        RoutingGraph::Node const &node = d->m_nodes[i];
+        order.append( qMakePair( qMakePair( RoutingGraph::cell( node.lat ), RoutingGraph::cell( node.lon ) ), i ) );
+    }
+    std::sort( order.begin(), order.end() );
+
+    QVector<quint32> ids( count );
+    for ( quint32 i = 0; i < count; ++i ) {
+        ids[order[i].second] = i;
+    }
+
+    QVector<RoutingGraph::Node> nodes;
+    QVector<quint32> firstEdge;
+    QVector<RoutingGraph::Edge> edges;
+    QByteArray nodeFlags;
+    QVector<RoutingGraph::Cell> cells;
+    nodes.reserve( count );
+    firstEdge.reserve( count + 1 );
+    nodeFlags.reserve( count + 3 );
+
+    for ( quint32 i = 0; i < count; ++i ) {
+        quint32 const old = order[i].second;
+        nodes.append( d->m_nodes[old] );
+        firstEdge.append( edges.size() );
+        foreach ( const RoutingGraph::Edge &upward, d->m_upward[old] ) {
+            RoutingGraph::Edge edge = upward;
+            edge.target = ids[edge.target];
+            if ( edge.middle != RoutingGraph::invalidNode ) {
+                edge.middle = ids[edge.middle];
+            } else {
+                // the string table starts with the few highway types
+                edge.name += d->m_types.size();
+            }
+            edges.append( edge );
+        }
+        nodeFlags.append( char( d->m_degree[old] > 2 ? 1 : 0 ) );
+
+        if ( cells.isEmpty() || cells.last().y != order[i].first.first || cells.last().x != order[i].first.second ) {
+            RoutingGraph::Cell const cell = { order[i].first.first, order[i].first.second, i };
+            cells.append( cell );
+        }
+    }
+    firstEdge.append( edges.size() );
+    while ( nodeFlags.size() % 4 != 0 ) {
+        nodeFlags.append( char( 0 ) );
+    }
+    RoutingGraph::Cell const sentinel = { 0, 0, count };
+    cells.append( sentinel );
+
+    QVector<quint32> stringOffsets;
+    QByteArray strings;
+    foreach ( const QString &string, d->m_types + d->m_names ) {
+        stringOffsets.append( strings.size() );
+        strings.append( string.toUtf8() );
+    }
+    stringOffsets.append( strings.size() );
+
+    RoutingGraph::Header header;
+    header.magic = RoutingGraph::fileMagic;
+    header.version = RoutingGraph::fileVersion;
+    header.nodeCount = count;
+    header.edgeCount = edges.size();
+    header.cellCount = cells.size() - 1;
+    header.stringCount = d->m_types.size() + d->m_names.size();
+    header.stringBytes = strings.size();
+    header.reserved = 0;
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Cannot write routing graph" << fileName;
+        return false;
+    }
+
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    file.write( reinterpret_cast<const char*>( nodes.constData() ), nodes.size() * sizeof( RoutingGraph::Node ) );
+    file.write( reinterpret_cast<const char*>( firstEdge.constData() ), firstEdge.size() * sizeof( quint32 ) );
+    file.write( reinterpret_cast<const char*>( edges.constData() ), edges.size() * sizeof( RoutingGraph::Edge ) );
+    file.write( nodeFlags );
+    file.write( reinterpret_cast<const char*>( cells.constData() ), cells.size() * sizeof( RoutingGraph::Cell ) );
+    file.write( reinterpret_cast<const char*>( stringOffsets.constData() ), stringOffsets.size() * sizeof( quint32 ) );
+    file.write( strings );
+    return file.commit();
+}
+
+int RoutingGraphBuilder::nodeCount() const
+{
+    return d->m_nodes.size();
+}
+
+int RoutingGraphBuilder::edgeCount() const
+{
+    int result = 0;
+    foreach ( const QVector<RoutingGraph::Edge> &edges, d->m_isContracted ? d->m_upward : d->m_out ) {
+        result += edges.size();
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,58 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_ROUTINGGRAPHBUILDER_H
+#define MARBLE_ROUTINGGRAPHBUILDER_H
+
+#include <QString>
+
+namespace Marble
+{
+
+class GeoDataDocument;
+class RoutingGraphBuilderPrivate;
+
+/**
+ * Creates the graph file read by RoutingGraph from OpenStreetMap data.
+ *
+ * Only the roads usable with the given transport ("motorcar", "bicycle" or
+ * "foot") are kept. Edge weights are travel times for the fastest and
+ * lengths for the shortest method. The nodes are contracted in the order of
+ * their edge difference, a node with a short witness search bypassing it
+ * does not need a shortcut.
+ */
+class RoutingGraphBuilder
+{
+public:
+    RoutingGraphBuilder( const QString &transport, const QString &method );
+
+    ~RoutingGraphBuilder();
+
+    /** Adds the highways of a document created by the OSM parser */
+    void addDocument( const GeoDataDocument *document );
+
+    /** Builds the contraction hierarchy, call once after adding all documents */
+    void contract();
+
+    bool save( const QString &fileName ) const;
+
+    int nodeCount() const;
+
+    int edgeCount() const;
+
+private:
+    Q_DISABLE_COPY( RoutingGraphBuilder )
+
+    RoutingGraphBuilderPrivate* const d;
+};
+
+}
+
+#endif
@@ -8,8 +8,10 @@
 // Copyright 2011 Thibaut Gridel <tgridel@free.fr>
 
 #include "ShpRunner.h"
+#include "ShpSpatialIndex.h"
 
 #include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
 #include "GeoDataPlacemark.h"
 #include "GeoDataPolygon.h"
 #include "GeoDataSchema.h"
@@ -25,46 +27,178 @@
 namespace Marble
 {
 
-ShpRunner::ShpRunner(QObject *parent) :
-    ParsingRunner(parent)
+namespace
+{
+
+struct ShpFields
+{
+    ShpFields( DBFHandle dbfhandle ) :
+        name( dbfhandle ? DBFGetFieldIndex( dbfhandle, "Name" ) : -1 ),
+        note( dbfhandle ? DBFGetFieldIndex( dbfhandle, "Note" ) : -1 ),
+        mapColor( dbfhandle ? DBFGetFieldIndex( dbfhandle, "mapcolor13" ) : -1 )
+    {
+    }
+
+    int name;
+    int note;
+    int mapColor;
+};
+
+// three corners and the closing vertex
+int const minimumRingVertices = 4;
+
+/**
+ * Appends the vertices [first, end) of @p shape to @p line, skipping
+ * vertices closer than @p resolution degree to the last appended one.
+ * The first and last vertex are always kept. If fewer than
+ * @p minimumVertices would remain, all vertices are appended instead.
+ */
+void appendVertices( GeoDataLineString &line, const SHPObject *shape, int first, int end, qreal resolution,
+                     int minimumVertices = 2 )
 {
+    double lastX = 0;
+    double lastY = 0;
+    for ( int k = first; k < end; ++k ) {
+        double const x = shape->padfX[k];
+        double const y = shape->padfY[k];
+        if ( resolution > 0 && k != first && k != end - 1
+             && qAbs( x - lastX ) < resolution && qAbs( y - lastY ) < resolution ) {
+            continue;
+        }
+        line.append( GeoDataCoordinates( x, y, 0, GeoDataCoordinates::Degree ) );
+        lastX = x;
+        lastY = y;
+    }
+
+    if ( line.size() < minimumVertices && line.size() < end - first ) {
+        // small features keep their shape rather than collapse
+        line.clear();
+        appendVertices( line, shape, first, end, 0 );
+    }
 }
 
-ShpRunner::~ShpRunner()
+int partEnd( const SHPObject *shape, int part )
 {
+    return ( part + 1 < shape->nParts ) ? shape->panPartStart[part+1] : shape->nVertices;
 }
 
-GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role, QString &error)
+GeoDataGeometry *createGeometry( const SHPObject *shape, int shapeType, qreal resolution )
 {
-    QFileInfo fileinfo( fileName );
-    if( fileinfo.suffix().compare( "shp", Qt::CaseInsensitive ) != 0 ) {
-        error = QString("File %1 does not have a shp suffix").arg(fileName);
-        mDebug() << error;
-        return nullptr;
+    switch ( shapeType ) {
+        case SHPT_POINT: {
+            return new GeoDataPoint( *shape->padfX, *shape->padfY, 0, GeoDataCoordinates::Degree );
+        }
+
+        case SHPT_MULTIPOINT: {
+            GeoDataMultiGeometry *geom = new GeoDataMultiGeometry;
+            for( int j=0; j<shape->nVertices; ++j ) {
+                geom->append( new GeoDataPoint( GeoDataCoordinates(
+                              shape->padfX[j], shape->padfY[j],
+                              0, GeoDataCoordinates::Degree ) ) );
+            }
+            return geom;
+        }
+
+        case SHPT_ARC: {
+            if ( shape->nParts != 1 ) {
+                GeoDataMultiGeometry *geom = new GeoDataMultiGeometry;
+                for( int j=0; j<shape->nParts; ++j ) {
+                    GeoDataLineString *line = new GeoDataLineString;
+                    appendVertices( *line, shape, shape->panPartStart[j], partEnd( shape, j ), resolution );
+                    geom->append( line );
+                }
+                return geom;
+            }
+
+            GeoDataLineString *line = new GeoDataLineString;
+            appendVertices( *line, shape, 0, shape->nVertices, resolution );
+            return line;
+        }
+
+        case SHPT_POLYGON: {
+            if ( shape->nParts != 1 ) {
+                bool isRingClockwise = false;
+                GeoDataMultiGeometry *multigeom = new GeoDataMultiGeometry;
+                GeoDataPolygon *poly = 0;
+                int polygonCount = 0;
+                for( int j=0; j<shape->nParts; ++j ) {
+                    GeoDataLinearRing ring;
+                    appendVertices( ring, shape, shape->panPartStart[j], partEnd( shape, j ), resolution, minimumRingVertices );
+                    isRingClockwise = ring.isClockwise();
+                    if ( j == 0 || isRingClockwise ) {
+                        poly = new GeoDataPolygon;
+                        ++polygonCount;
+                        poly->setOuterBoundary( ring );
+                        if ( polygonCount > 1 ) {
+                            multigeom->append( poly );
+                        }
+                    }
+                    else {
+                        poly->appendInnerBoundary( ring );
+                    }
+                }
+                if ( polygonCount > 1 ) {
+                    return multigeom;
+                }
+                delete multigeom;
+                return poly;
+            }
+
+            GeoDataPolygon *poly = new GeoDataPolygon;
+            GeoDataLinearRing ring;
+            appendVertices( ring, shape, 0, shape->nVertices, resolution, minimumRingVertices );
+            poly->setOuterBoundary( ring );
+            return poly;
+        }
     }
 
-    SHPHandle handle = SHPOpen( fileName.toStdString().c_str(), "rb" );
-    if ( !handle ) {
-        error = QString("Failed to read %1").arg(fileName);
-        mDebug() << error;
-        return nullptr;
+    return 0;
+}
+
+GeoDataPlacemark *createPlacemark( SHPHandle handle, DBFHandle dbfhandle, const ShpFields &fields,
+                                   int shapeType, int index, qreal resolution )
+{
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+
+    if ( fields.name >= 0 ) {
+        placemark->setName( DBFReadStringAttribute( dbfhandle, index, fields.name ) );
+    }
+    if ( fields.note >= 0 ) {
+        placemark->setDescription( DBFReadStringAttribute( dbfhandle, index, fields.note ) );
+    }
+
+    double mapColor = fields.mapColor >= 0 ? DBFReadDoubleAttribute( dbfhandle, index, fields.mapColor ) : 0;
+    if ( mapColor ) {
+        GeoDataStyle::Ptr style(new GeoDataStyle);
+        if ( mapColor >= 0 && mapColor <=255 ) {
+            quint8 colorIndex = quint8( mapColor );
+            style->polyStyle().setColorIndex( colorIndex );
+        }
+        else {
+            quint8 colorIndex = 0;     // mapColor is undefined in this case
+            style->polyStyle().setColorIndex( colorIndex );
+        }
+        placemark->setStyle( style );
     }
-    int entities;
-    int shapeType;
-    SHPGetInfo( handle, &entities, &shapeType, NULL, NULL );
-    mDebug() << " SHP info " << entities << " Entities "
-             << shapeType << " Shape Type ";
 
-    DBFHandle dbfhandle;
-    dbfhandle = DBFOpen( fileName.toStdString().c_str(), "rb");
-    int nameField = DBFGetFieldIndex( dbfhandle, "Name" );
-    int noteField = DBFGetFieldIndex( dbfhandle, "Note" );
-    int mapColorField = DBFGetFieldIndex( dbfhandle, "mapcolor13" );
+    SHPObject *shape = SHPReadObject( handle, index );
+    if ( shape ) {
+        GeoDataGeometry *geometry = createGeometry( shape, shapeType, resolution );
+        if ( geometry ) {
+            placemark->setGeometry( geometry );
+        }
+        SHPDestroyObject( shape );
+    }
+
+    return placemark;
+}
 
+GeoDataDocument *createDocument( DocumentRole role, const ShpFields &fields )
+{
     GeoDataDocument *document = new GeoDataDocument;
     document->setDocumentRole( role );
 
-    if ( mapColorField != -1 ) {
+    if ( fields.mapColor != -1 ) {
         GeoDataSchema schema;
         schema.setId("default");
         GeoDataSimpleField simpleField;
@@ -74,144 +208,66 @@ GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role
         document->addSchema( schema );
     }
 
-    for ( int i=0; i< entities; ++i ) {
-        GeoDataPlacemark  *placemark = 0;
-        placemark = new GeoDataPlacemark;
-        document->append( placemark );
-
-        SHPObject *shape = SHPReadObject( handle, i );
-        if( nameField ) {
-            const char* info = DBFReadStringAttribute( dbfhandle, i, nameField );
-            placemark->setName( info );
-            mDebug() << "name " << placemark->name();
-        }
-        if( noteField ) {
-            const char* note = DBFReadStringAttribute( dbfhandle, i, noteField );
-            placemark->setDescription( note );
-            mDebug() << "desc " << placemark->description();
-        }
+    return document;
+}
 
-        double mapColor = DBFReadDoubleAttribute( dbfhandle, i, mapColorField );
-        if ( mapColor ) {
-            GeoDataStyle::Ptr style(new GeoDataStyle);
-            if ( mapColor >= 0 && mapColor <=255 ) {
-                quint8 colorIndex = quint8( mapColor );
-                style->polyStyle().setColorIndex( colorIndex );
-            }
-            else {
-                quint8 colorIndex = 0;     // mapColor is undefined in this case
-                style->polyStyle().setColorIndex( colorIndex );
-            }
-            placemark->setStyle( style );
-        }
+SHPHandle openShapefile( const QString &fileName, QString &error )
+{
+    QFileInfo fileinfo( fileName );
+    if( fileinfo.suffix().compare( "shp", Qt::CaseInsensitive ) != 0 ) {
+        error = QString("File %1 does not have a shp suffix").arg(fileName);
+        mDebug() << error;
+        return 0;
+    }
 
-        switch ( shapeType ) {
-            case SHPT_POINT: {
-                GeoDataPoint *point = new GeoDataPoint( *shape->padfX, *shape->padfY, 0, GeoDataCoordinates::Degree );
-                placemark->setGeometry( point );
-                mDebug() << "point " << placemark->name();
-                break;
-            }
+    SHPHandle handle = SHPOpen( fileName.toStdString().c_str(), "rb" );
+    if ( !handle ) {
+        error = QString("Failed to read %1").arg(fileName);
+        mDebug() << error;
+        return 0;
+    }
 
-            case SHPT_MULTIPOINT: {
-                GeoDataMultiGeometry *geom = new GeoDataMultiGeometry;
-                for( int j=0; j<shape->nVertices; ++j ) {
-                    geom->append( new GeoDataPoint( GeoDataCoordinates(
-                                  shape->padfX[j], shape->padfY[j],
-                                  0, GeoDataCoordinates::Degree ) ) );
-                }
-                placemark->setGeometry( geom );
-                mDebug() << "multipoint " << placemark->name();
-                break;
-            }
+    return handle;
+}
 
-            case SHPT_ARC: {
-                if ( shape->nParts != 1 ) {
-                    GeoDataMultiGeometry *geom = new GeoDataMultiGeometry;
-                    for( int j=0; j<shape->nParts; ++j ) {
-                        GeoDataLineString *line = new GeoDataLineString;
-                        int itEnd = (j + 1 < shape->nParts) ? shape->panPartStart[j+1] : shape->nVertices;
-                        for( int k=shape->panPartStart[j]; k<itEnd; ++k ) {
-                            line->append( GeoDataCoordinates(
-                                          shape->padfX[k], shape->padfY[k],
-                                          0, GeoDataCoordinates::Degree ) );
-                        }
-                        geom->append( line );
-                    }
-                    placemark->setGeometry( geom );
-                    mDebug() << "arc " << placemark->name() << " " << shape->nParts;
+}
 
-                } else {
-                    GeoDataLineString *line = new GeoDataLineString;
-                    for( int j=0; j<shape->nVertices; ++j ) {
-                        line->append( GeoDataCoordinates(
-                                      shape->padfX[j], shape->padfY[j],
-                                      0, GeoDataCoordinates::Degree ) );
-                    }
-                    placemark->setGeometry( line );
-                    mDebug() << "arc " << placemark->name() << " " << shape->nParts;
-                }
-                break;
-            }
+ShpRunner::ShpRunner(QObject *parent) :
+    ParsingRunner(parent)
+{
+}
 
-            case SHPT_POLYGON: {
-                if ( shape->nParts != 1 ) {
-                    bool isRingClockwise = false;
-                    GeoDataMultiGeometry *multigeom = new GeoDataMultiGeometry;
-                    GeoDataPolygon *poly = 0;
-                    int polygonCount = 0;
-                    for( int j=0; j<shape->nParts; ++j ) {
-                        GeoDataLinearRing ring;
-                        int itStart = shape->panPartStart[j];
-                        int itEnd = (j + 1 < shape->nParts) ? shape->panPartStart[j+1] : shape->nVertices;
-                        for( int k = itStart; k<itEnd; ++k ) {
-                            ring.append( GeoDataCoordinates(
-                                         shape->padfX[k], shape->padfY[k],
-                                         0, GeoDataCoordinates::Degree ) );
-                        }
-                        isRingClockwise = ring.isClockwise();
-                        if ( j == 0 || isRingClockwise ) {
-                            poly = new GeoDataPolygon;
-                            ++polygonCount;
-                            poly->setOuterBoundary( ring );
-                            if ( polygonCount > 1 ) {
-                                multigeom->append( poly );
-                            }
-                        }
-                        else {
-                            poly->appendInnerBoundary( ring );
-                        }
-                    }
-                    if ( polygonCount > 1 ) {
-                        placemark->setGeometry( multigeom );
-                    }
-                    else {
-                        placemark->setGeometry( poly );
-                        delete multigeom;
-                        multigeom = 0;
-                    }
-                    mDebug() << "donut " << placemark->name() << " " << shape->nParts;
+ShpRunner::~ShpRunner()
+{
+}
 
-                } else {
-                    GeoDataPolygon *poly = new GeoDataPolygon;
-                    GeoDataLinearRing ring;
-                    for( int j=0; j<shape->nVertices; ++j ) {
-                        ring.append( GeoDataCoordinates(
-                                         shape->padfX[j], shape->padfY[j],
-                                         0, GeoDataCoordinates::Degree ) );
-                    }
-                    poly->setOuterBoundary( ring );
-                    placemark->setGeometry( poly );
-                    mDebug() << "poly " << placemark->name() << " " << shape->nParts;
-                }
-                break;
-            }
-        }
+GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role, QString &error)
+{
+    SHPHandle handle = openShapefile( fileName, error );
+    if ( !handle ) {
+        return nullptr;
+    }
+
+    int entities;
+    int shapeType;
+    SHPGetInfo( handle, &entities, &shapeType, NULL, NULL );
+    mDebug() << " SHP info " << entities << " Entities "
+             << shapeType << " Shape Type ";
+
+    DBFHandle dbfhandle = DBFOpen( fileName.toStdString().c_str(), "rb");
+    ShpFields const fields( dbfhandle );
+
+    GeoDataDocument *document = createDocument( role, fields );
+
+    for ( int i=0; i< entities; ++i ) {
+        document->append( createPlacemark( handle, dbfhandle, fields, shapeType, i, 0 ) );
     }
 
     SHPClose( handle );
 
-    DBFClose( dbfhandle );
+    if ( dbfhandle ) {
+        DBFClose( dbfhandle );
+    }
 
     if ( document->size() ) {
         document->setFileName( fileName );
@@ -222,6 +278,37 @@ GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role
     }
 }
 
+GeoDataDocument *ShpRunner::parseRegion( const QString &fileName, const GeoDataLatLonBox &region, qreal resolution,
+                                         DocumentRole role, QString &error )
+{
+    SHPHandle handle = openShapefile( fileName, error );
+    if ( !handle ) {
+        return nullptr;
+    }
+
+    int shapeType;
+    SHPGetInfo( handle, NULL, &shapeType, NULL, NULL );
+
+    QVector<int> const shapes = ShpSpatialIndex::index( fileName, handle )->shapes( region );
+
+    DBFHandle dbfhandle = DBFOpen( fileName.toStdString().c_str(), "rb");
+    ShpFields const fields( dbfhandle );
+
+    // An empty document is a valid result for regions without shapes
+    GeoDataDocument *document = createDocument( role, fields );
+    foreach ( int shape, shapes ) {
+        document->append( createPlacemark( handle, dbfhandle, fields, shapeType, shape, resolution ) );
+    }
+
+    SHPClose( handle );
+
+    if ( dbfhandle ) {
+        DBFClose( dbfhandle );
+    }
+
+    return document;
+}
+
 }
 
 #include "moc_ShpRunner.cpp"
@@ -22,6 +22,8 @@ public:
     explicit ShpRunner(QObject *parent = 0);
     ~ShpRunner();
     GeoDataDocument* parseFile( const QString &fileName, DocumentRole role, QString& error );
+    GeoDataDocument* parseRegion( const QString &fileName, const GeoDataLatLonBox &region, qreal resolution,
+                                  DocumentRole role, QString& error );
 };
 
 }
@@ -0,0 +1,172 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+
+#include "ShpSpatialIndex.h"
+
+#include "GeoDataLatLonBox.h"
+#include "MarbleDebug.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace Marble
+{
+
+namespace
+{
+    struct CacheEntry
+    {
+        QDateTime lastModified;
+        QSharedPointer<const ShpSpatialIndex> index;
+    };
+
+    // The cost of an index is the number of its shapes, so that only a few
+    // indexes of large shapefiles are kept. Indexes still used by a runner
+    // stay alive through their shared pointer after being evicted.
+    QMutex s_cacheMutex;
+    QCache<QString, CacheEntry> s_cache( 4 * 1024 * 1024 );
+}
+
+ShpSpatialIndex::ShpSpatialIndex( const QString &fileName, SHPHandle handle ) :
+    m_tree( 0 )
+{
+    // Same depth heuristic as SHPCreateTree(), which cannot compute it
+    // without reading all shapes itself.
+    int maxDepth = 0;
+    int maxNodeCount = 1;
+    while ( maxNodeCount * 4 < handle->nRecords ) {
+        maxDepth += 1;
+        maxNodeCount *= 2;
+    }
+
+    m_tree = SHPCreateTree( 0, 2, maxDepth, handle->adBoundsMin, handle->adBoundsMax );
+    if ( !m_tree ) {
+        return;
+    }
+
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        mDebug() << "Cannot read" << fileName << "to build the spatial index";
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setByteOrder( QDataStream::LittleEndian );
+    stream.setFloatingPointPrecision( QDataStream::DoublePrecision );
+
+    SHPObject object;
+    memset( &object, 0, sizeof( object ) );
+
+    for ( int i = 0; i < handle->nRecords; ++i ) {
+        // skip the record header with record number and content length
+        if ( !file.seek( qint64( handle->panRecOffset[i] ) + 8 ) ) {
+            continue;
+        }
+
+        qint32 shapeType;
+        stream >> shapeType;
+        if ( shapeType == SHPT_NULL ) {
+            continue;
+        }
+
+        if ( shapeType == SHPT_POINT || shapeType == SHPT_POINTZ || shapeType == SHPT_POINTM ) {
+            stream >> object.dfXMin >> object.dfYMin;
+            object.dfXMax = object.dfXMin;
+            object.dfYMax = object.dfYMin;
+        } else {
+            stream >> object.dfXMin >> object.dfYMin >> object.dfXMax >> object.dfYMax;
+        }
+
+        if ( stream.status() != QDataStream::Ok ) {
+            mDebug() << "Truncated record" << i << "in" << fileName;
+            stream.resetStatus();
+            continue;
+        }
+
+        object.nShapeId = i;
+        SHPTreeAddShapeId( m_tree, &object );
+    }
+}
+
+ShpSpatialIndex::~ShpSpatialIndex()
+{
+    if ( m_tree ) {
+        SHPDestroyTree( m_tree );
+    }
+}
+
+QSharedPointer<const ShpSpatialIndex> ShpSpatialIndex::index( const QString &fileName, SHPHandle handle )
+{
+    QFileInfo const fileInfo( fileName );
+    QString const key = fileInfo.absoluteFilePath();
+
+    QMutexLocker locker( &s_cacheMutex );
+    CacheEntry const *cached = s_cache.object( key );
+    if ( cached && cached->lastModified == fileInfo.lastModified() ) {
+        return cached->index;
+    }
+
+    CacheEntry *entry = new CacheEntry;
+    entry->lastModified = fileInfo.lastModified();
+    entry->index = QSharedPointer<const ShpSpatialIndex>( new ShpSpatialIndex( key, handle ) );
+    QSharedPointer<const ShpSpatialIndex> const result = entry->index;
+    // takes ownership, an index exceeding the maximum cost is deleted right away
+    s_cache.insert( key, entry, qMax( 1, handle->nRecords ) );
+    return result;
+}
+
+QVector<int> ShpSpatialIndex::shapes( const GeoDataLatLonBox &box ) const
+{
+    QVector<int> result;
+    if ( !m_tree ) {
+        return result;
+    }
+
+    qreal const north = box.north( GeoDataCoordinates::Degree );
+    qreal const south = box.south( GeoDataCoordinates::Degree );
+    qreal const east = box.east( GeoDataCoordinates::Degree );
+    qreal const west = box.west( GeoDataCoordinates::Degree );
+
+    if ( box.crossesDateLine() ) {
+        find( west, south, 180.0, north, result );
+        find( -180.0, south, east, north, result );
+        std::sort( result.begin(), result.end() );
+        result.erase( std::unique( result.begin(), result.end() ), result.end() );
+    } else {
+        find( west, south, east, north, result );
+        std::sort( result.begin(), result.end() );
+    }
+
+    return result;
+}
+
+void ShpSpatialIndex::find( double west, double south, double east, double north, QVector<int> &result ) const
+{
+    double boundsMin[4] = { west, south, 0.0, 0.0 };
+    double boundsMax[4] = { east, north, 0.0, 0.0 };
+
+    int count = 0;
+    int *ids = SHPTreeFindLikelyShapes( m_tree, boundsMin, boundsMax, &count );
+    result.reserve( result.size() + count );
+    for ( int i = 0; i < count; ++i ) {
+        result.append( ids[i] );
+    }
+    free( ids );
+}
+
+}
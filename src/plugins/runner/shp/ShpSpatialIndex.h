@@ -0,0 +1,59 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+
+#ifndef MARBLESHPSPATIALINDEX_H
+#define MARBLESHPSPATIALINDEX_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <shapefil.h>
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+
+/**
+ * A quad tree of the bounding boxes of all shapes in a shapefile.
+ *
+ * The bounding boxes are read from the record headers located through the
+ * .shx offsets, so building the index does not need to read any vertices.
+ * Indexes are shared between all runners, rebuilt when the file changes and
+ * the least recently used ones are dropped when they hold too many shapes.
+ */
+class ShpSpatialIndex
+{
+public:
+    ~ShpSpatialIndex();
+
+    /**
+     * Returns the index of the shapefile @p fileName, opened as @p handle.
+     * Thread safe, the index is built on first use.
+     */
+    static QSharedPointer<const ShpSpatialIndex> index( const QString &fileName, SHPHandle handle );
+
+    /**
+     * Returns the ids of all shapes whose bounding box intersects @p box,
+     * in ascending order.
+     */
+    QVector<int> shapes( const GeoDataLatLonBox &box ) const;
+
+private:
+    ShpSpatialIndex( const QString &fileName, SHPHandle handle );
+    void find( double west, double south, double east, double north, QVector<int> &result ) const;
+
+    Q_DISABLE_COPY( ShpSpatialIndex )
+    SHPTree *m_tree;
+};
+
+}
+
+#endif // MARBLESHPSPATIALINDEX_H
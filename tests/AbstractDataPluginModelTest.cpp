@@ -32,6 +32,7 @@ public:
     {}
 
     void setInitialized( bool initialized ) { m_initialized = initialized; }
+    void update() { emit updated(); }
 
     bool initialized() const { return m_initialized; }
     bool operator<( const AbstractDataPluginItem *other ) const { return this < other; }
@@ -92,6 +93,12 @@ private Q_SLOTS:
 
     void itemsVersusSetSticky();
 
+    void itemsVersusCoordinate();
+
+    void removeItem();
+
+    void evictItems();
+
  private:
     const MarbleModel m_marbleModel;
     static const ViewportParams fullViewport;
@@ -341,6 +348,88 @@ void AbstractDataPluginModelTest::itemsVersusSetSticky()
     QVERIFY( !model.items( &fullViewport, 1 ).contains( item ) );
 }
 
+void AbstractDataPluginModelTest::itemsVersusCoordinate()
+{
+    const ViewportParams zoomedViewport( Equirectangular, 0, 0, 10000, QSize( 230, 230 ) );
+
+    TestDataPluginItem *item = new TestDataPluginItem;
+    item->setInitialized( true );
+    item->setCoordinate( GeoDataCoordinates( 50, 50, 0, GeoDataCoordinates::Degree ) );
+
+    TestDataPluginModel model( &m_marbleModel );
+    model.addItemToList( item );
+
+    QVERIFY( !model.items( &zoomedViewport, 1 ).contains( item ) );
+    QVERIFY( model.items( &fullViewport, 1 ).contains( item ) );
+
+    // the position of the item is only picked up after it is updated
+    item->setCoordinate( GeoDataCoordinates( 0, 0 ) );
+    item->update();
+
+    QVERIFY( model.items( &zoomedViewport, 1 ).contains( item ) );
+}
+
+void AbstractDataPluginModelTest::removeItem()
+{
+    TestDataPluginItem *item = new TestDataPluginItem;
+    item->setId( "foo" );
+    item->setInitialized( true );
+
+    TestDataPluginModel model( &m_marbleModel );
+    model.addItemToList( item );
+
+    QVERIFY( model.items( &fullViewport, 1 ).contains( item ) );
+
+    delete item;
+
+    QCOMPARE( model.findItem( "foo" ), static_cast<AbstractDataPluginItem *>( 0 ) );
+    QVERIFY( model.items( &fullViewport, 1 ).isEmpty() );
+}
+
+void AbstractDataPluginModelTest::evictItems()
+{
+    const ViewportParams zoomedViewport( Equirectangular, 0, 0, 10000, QSize( 230, 230 ) );
+    const int count = 2000;
+
+    TestDataPluginModel model( &m_marbleModel );
+
+    TestDataPluginItem *favorite = new TestDataPluginItem;
+    favorite->setId( "favorite" );
+    favorite->setInitialized( true );
+    favorite->setFavorite( true );
+    favorite->setCoordinate( GeoDataCoordinates( 90, 0, 0, GeoDataCoordinates::Degree ) );
+    model.addItemToList( favorite );
+
+    TestDataPluginItem *visible = new TestDataPluginItem;
+    visible->setId( "visible" );
+    visible->setInitialized( true );
+    model.addItemToList( visible );
+
+    QList<AbstractDataPluginItem *> items;
+    for ( int i = 0; i < count; ++i ) {
+        TestDataPluginItem *item = new TestDataPluginItem;
+        item->setId( QString::number( i ) );
+        item->setInitialized( true );
+        item->setCoordinate( GeoDataCoordinates( 90, 0, 0, GeoDataCoordinates::Degree ) );
+        items << item;
+    }
+    model.addItemsToList( items );
+
+    QVERIFY( model.items( &zoomedViewport, 1 ).contains( visible ) );
+
+    int remaining = 0;
+    for ( int i = 0; i < count; ++i ) {
+        if ( model.itemExists( QString::number( i ) ) ) {
+            ++remaining;
+        }
+    }
+
+    // items out of view are removed, but not favorites and not items in view
+    QVERIFY( remaining < count );
+    QCOMPARE( model.findItem( "favorite" ), static_cast<AbstractDataPluginItem *>( favorite ) );
+    QCOMPARE( model.findItem( "visible" ), static_cast<AbstractDataPluginItem *>( visible ) );
+}
+
 QTEST_MAIN( AbstractDataPluginModelTest )
 
 #include "AbstractDataPluginModelTest.moc"
@@ -0,0 +1,97 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "routing/AlternativeRoutesModel.h"
+#include "GeoDataData.h"
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataPlacemark.h"
+#include "TestUtils.h"
+
+namespace Marble
+{
+
+class AlternativeRoutesModelTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void filterSimilarRoutes();
+    void preferInstructions();
+
+private:
+    static GeoDataDocument *createRoute( qreal offset, qreal detour, bool instructions );
+};
+
+GeoDataDocument *AlternativeRoutesModelTest::createRoute( qreal offset, qreal detour, bool instructions )
+{
+    // a route of about 7 km heading east, optionally bending north in the middle
+    GeoDataLineString *path = new GeoDataLineString;
+    for ( int i = 0; i <= 100; ++i ) {
+        qreal const bend = detour * ( 50 - qAbs( 50 - i ) ) / 50.0;
+        *path << GeoDataCoordinates( 8.0 + i * 0.001, 49.0 + offset + bend, 0.0, GeoDataCoordinates::Degree );
+    }
+
+    GeoDataDocument *document = new GeoDataDocument;
+    GeoDataPlacemark *route = new GeoDataPlacemark( "Route" );
+    route->setGeometry( path );
+    document->append( route );
+
+    if ( instructions ) {
+        GeoDataPlacemark *instruction = new GeoDataPlacemark( "Turn left" );
+        GeoDataExtendedData extendedData;
+        extendedData.addValue( GeoDataData( "turnType", 1 ) );
+        instruction->setExtendedData( extendedData );
+        document->append( instruction );
+    }
+
+    return document;
+}
+
+void AlternativeRoutesModelTest::filterSimilarRoutes()
+{
+    AlternativeRoutesModel model;
+    model.newRequest( 0 );
+
+    model.addRoute( createRoute( 0.0, 0.0, false ) );
+    model.addRoute( createRoute( 0.00001, 0.0, false ) );
+    model.addRoute( createRoute( 0.0, 0.02, false ) );
+    QTRY_COMPARE( model.rowCount(), 2 );
+
+    // arriving after the first results were shown
+    model.addRoute( createRoute( -0.00001, 0.0, false ) );
+    model.addRoute( createRoute( 0.0, -0.02, false ) );
+    QTRY_COMPARE( model.rowCount(), 3 );
+    QTest::qWait( 100 );
+    QCOMPARE( model.rowCount(), 3 );
+
+    model.newRequest( 0 );
+    QCOMPARE( model.rowCount(), 0 );
+}
+
+void AlternativeRoutesModelTest::preferInstructions()
+{
+    AlternativeRoutesModel model;
+    model.newRequest( 0 );
+
+    GeoDataDocument *withoutInstructions = createRoute( 0.0, 0.0, false );
+    GeoDataDocument *withInstructions = createRoute( 0.00001, 0.0, true );
+    model.addRoute( withoutInstructions );
+    model.addRoute( withInstructions );
+    QTRY_COMPARE( model.rowCount(), 1 );
+    QCOMPARE( model.route( 0 ), withInstructions );
+    QCOMPARE( model.currentRoute(), withInstructions );
+}
+
+}
+
+QTEST_MAIN( Marble::AlternativeRoutesModelTest )
+
+#include "AlternativeRoutesModelTest.moc"
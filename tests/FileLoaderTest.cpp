@@ -0,0 +1,321 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "FileManager.h"
+#include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "GeoDataTypes.h"
+#include "KmlRunner.h"
+#include "ParseRunnerPlugin.h"
+#include "PluginManager.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+/** Provides the KML runner without depending on the installed plugins */
+class TestKmlPlugin : public ParseRunnerPlugin
+{
+public:
+    QString name() const { return "KML"; }
+    QString nameId() const { return "KmlStreamingTest"; }
+    QString version() const { return "1.0"; }
+    QString description() const { return QString(); }
+    QString copyrightYears() const { return "2026"; }
+    QList<PluginAuthor> pluginAuthors() const { return QList<PluginAuthor>(); }
+    QString fileFormatDescription() const { return "KML"; }
+    QStringList fileExtensions() const { return QStringList() << "kml"; }
+    ParsingRunner *newRunner() const { return new KmlRunner; }
+};
+
+class FileLoaderTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    FileLoaderTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void runnerStreamsNestedFolders();
+    void runnerDiscardsBrokenFile();
+    void runnerStopsWhenCanceled();
+    void fileManagerStreamsIntoTreeModel();
+    void fileManagerCancelsRemovedFile();
+
+    // connected to ParsingRunner::featuresParsed()
+    void addFeatures( GeoDataContainer *container, const QVector<GeoDataFeature*> &features );
+    void addProgress( qint64 bytesRead, qint64 bytesTotal );
+
+private:
+    QString writeFile( const QString &name, const QByteArray &data );
+    static QByteArray kml( int folders, int placemarks );
+    static void verifyFolders( const GeoDataContainer *document, int folders, int placemarks );
+
+    QTemporaryDir m_dir;
+    ParsingRunner *m_runner;
+    bool m_cancelRunner;
+    GeoDataDocument *m_document;
+    QSet<GeoDataContainer*> m_containers;
+    int m_batches;
+    int m_placemarks;
+    QList<QPair<qint64, qint64> > m_progress;
+};
+
+FileLoaderTest::FileLoaderTest() :
+    m_runner( 0 ),
+    m_cancelRunner( false ),
+    m_document( 0 ),
+    m_batches( 0 ),
+    m_placemarks( 0 )
+{
+}
+
+void FileLoaderTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+}
+
+void FileLoaderTest::init()
+{
+    m_runner = new KmlRunner;
+    m_runner->setStreaming( true );
+    connect( m_runner, SIGNAL(featuresParsed(GeoDataContainer*,QVector<GeoDataFeature*>)),
+             this, SLOT(addFeatures(GeoDataContainer*,QVector<GeoDataFeature*>)) );
+    connect( m_runner, SIGNAL(parsingProgress(qint64,qint64)),
+             this, SLOT(addProgress(qint64,qint64)) );
+    m_cancelRunner = false;
+    m_document = 0;
+    m_containers.clear();
+    m_batches = 0;
+    m_placemarks = 0;
+    m_progress.clear();
+}
+
+void FileLoaderTest::cleanup()
+{
+    delete m_runner;
+    m_runner = 0;
+    delete m_document;
+    m_document = 0;
+}
+
+void FileLoaderTest::addFeatures( GeoDataContainer *container, const QVector<GeoDataFeature*> &features )
+{
+    if ( !container ) {
+        QCOMPARE( features.size(), 1 );
+        QVERIFY( !m_document );
+        m_document = dynamic_cast<GeoDataDocument*>( features.first() );
+        QVERIFY( m_document );
+        m_containers.insert( m_document );
+        return;
+    }
+
+    // Containers need to be handed off before their features
+    QVERIFY( m_containers.contains( container ) );
+    ++m_batches;
+    foreach ( GeoDataFeature *feature, features ) {
+        container->append( feature );
+        if ( feature->nodeType() == GeoDataTypes::GeoDataFolderType ) {
+            // folders are handed off along with their first placemark
+            m_containers.insert( static_cast<GeoDataContainer*>( feature ) );
+            m_placemarks += static_cast<GeoDataContainer*>( feature )->placemarkList().size();
+        } else {
+            ++m_placemarks;
+        }
+    }
+
+    if ( m_cancelRunner ) {
+        m_runner->cancel();
+    }
+}
+
+void FileLoaderTest::addProgress( qint64 bytesRead, qint64 bytesTotal )
+{
+    m_progress << qMakePair( bytesRead, bytesTotal );
+}
+
+QString FileLoaderTest::writeFile( const QString &name, const QByteArray &data )
+{
+    QString const fileName = m_dir.path() + '/' + name;
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( data ) != data.size() ) {
+        return QString();
+    }
+    return fileName;
+}
+
+QByteArray FileLoaderTest::kml( int folders, int placemarks )
+{
+    QByteArray data = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+                      "<Document>\n<name>Streamed</name>\n"
+                      "<Folder>\n<name>Wrapper</name>\n";
+    for ( int i = 0; i < folders; ++i ) {
+        data += "<Folder>\n<name>Folder " + QByteArray::number( i ) + "</name>\n";
+        for ( int j = 0; j < placemarks; ++j ) {
+            data += "<Placemark><name>" + QByteArray::number( j ) + "</name>"
+                    "<Point><coordinates>" + QByteArray::number( j % 360 - 180 ) + ",0</coordinates></Point>"
+                    "</Placemark>\n";
+        }
+        data += "</Folder>\n";
+    }
+    data += "</Folder>\n"
+            "<Style id=\"late\"><LineStyle><width>2</width></LineStyle></Style>\n"
+            "</Document>\n</kml>\n";
+    return data;
+}
+
+void FileLoaderTest::verifyFolders( const GeoDataContainer *document, int folders, int placemarks )
+{
+    QCOMPARE( document->size(), 1 );
+    const GeoDataContainer *wrapper = static_cast<const GeoDataContainer*>( document->child( 0 ) );
+    QCOMPARE( wrapper->nodeType(), GeoDataTypes::GeoDataFolderType );
+    QCOMPARE( wrapper->name(), QString( "Wrapper" ) );
+    QCOMPARE( wrapper->size(), folders );
+    for ( int i = 0; i < folders; ++i ) {
+        const GeoDataContainer *folder = static_cast<const GeoDataContainer*>( wrapper->child( i ) );
+        QCOMPARE( folder->name(), QString( "Folder %1" ).arg( i ) );
+        QCOMPARE( folder->size(), placemarks );
+        for ( int j = 0; j < placemarks; ++j ) {
+            QCOMPARE( folder->child( j )->name(), QString::number( j ) );
+        }
+    }
+}
+
+void FileLoaderTest::runnerStreamsNestedFolders()
+{
+    QString const fileName = writeFile( "nested.kml", kml( 3, 1500 ) );
+    QVERIFY( !fileName.isEmpty() );
+
+    QString error;
+    GeoDataDocument *remainder = m_runner->parseFile( fileName, UserDocument, error );
+    QVERIFY( error.isEmpty() );
+    QVERIFY( remainder );
+    QVERIFY( m_document );
+    QVERIFY( remainder != m_document );
+
+    // Placemarks arrive in several batches while parsing, not only at the end
+    QCOMPARE( m_placemarks, 3 * 1500 );
+    QVERIFY( m_batches >= 4 );
+    QCOMPARE( m_document->name(), QString( "Streamed" ) );
+    QCOMPARE( m_document->fileName(), fileName );
+    verifyFolders( m_document, 3, 1500 );
+
+    // Data following the features stays with the returned document
+    QCOMPARE( remainder->size(), 0 );
+    QVERIFY( static_cast<const GeoDataDocument*>( remainder )->style( "late" ) );
+    delete remainder;
+
+    QVERIFY( m_progress.size() >= 2 );
+    QVERIFY( m_progress.first().first < m_progress.last().first );
+    QCOMPARE( m_progress.last().first, QFileInfo( fileName ).size() );
+    QCOMPARE( m_progress.last().second, QFileInfo( fileName ).size() );
+}
+
+void FileLoaderTest::runnerDiscardsBrokenFile()
+{
+    QByteArray data = kml( 3, 1500 );
+    data.truncate( data.size() / 2 );
+    QString const fileName = writeFile( "broken.kml", data );
+    QVERIFY( !fileName.isEmpty() );
+
+    QString error;
+    GeoDataDocument *document = m_runner->parseFile( fileName, UserDocument, error );
+    QVERIFY( !document );
+    QVERIFY( !error.isEmpty() );
+}
+
+void FileLoaderTest::runnerStopsWhenCanceled()
+{
+    QString const fileName = writeFile( "canceled.kml", kml( 3, 1500 ) );
+    QVERIFY( !fileName.isEmpty() );
+
+    m_cancelRunner = true;
+    QString error;
+    GeoDataDocument *document = m_runner->parseFile( fileName, UserDocument, error );
+    QVERIFY( !document );
+    QVERIFY( !error.isEmpty() );
+    QVERIFY( m_runner->isCanceled() );
+    QVERIFY( m_placemarks > 0 );
+    QVERIFY( m_placemarks < 3 * 1500 );
+}
+
+void FileLoaderTest::fileManagerStreamsIntoTreeModel()
+{
+    QString const fileName = writeFile( "manager.kml", kml( 3, 1500 ) );
+    QVERIFY( !fileName.isEmpty() );
+
+    TestKmlPlugin plugin;
+    PluginManager pluginManager;
+    pluginManager.addParseRunnerPlugin( &plugin );
+    GeoDataTreeModel treeModel;
+    FileManager manager( &treeModel, &pluginManager );
+    QSignalSpy addedSpy( &manager, SIGNAL(fileAdded(QString)) );
+    QSignalSpy progressSpy( &manager, SIGNAL(fileLoadingProgress(QString,qint64,qint64)) );
+
+    manager.addFile( fileName, "manager", GeoDataStyle::Ptr(), UserDocument, 0, false );
+    QVERIFY( addedSpy.wait( 30000 ) );
+    QCOMPARE( manager.pendingFiles(), 0 );
+    QVERIFY( progressSpy.size() >= 1 );
+
+    GeoDataDocument *document = manager.at( fileName );
+    QVERIFY( document );
+    QCOMPARE( treeModel.rowCount(), 1 );
+    verifyFolders( document, 3, 1500 );
+    QVERIFY( static_cast<const GeoDataDocument*>( document )->style( "late" ) );
+
+    QModelIndex const wrapper = treeModel.index( 0, 0, treeModel.index( document ) );
+    QCOMPARE( treeModel.rowCount( wrapper ), 3 );
+    QCOMPARE( treeModel.rowCount( treeModel.index( 2, 0, wrapper ) ), 1500 );
+}
+
+void FileLoaderTest::fileManagerCancelsRemovedFile()
+{
+    QString const fileName = writeFile( "removed.kml", kml( 10, 2000 ) );
+    QVERIFY( !fileName.isEmpty() );
+
+    TestKmlPlugin plugin;
+    PluginManager pluginManager;
+    pluginManager.addParseRunnerPlugin( &plugin );
+    GeoDataTreeModel treeModel;
+    FileManager manager( &treeModel, &pluginManager );
+    QSignalSpy addedSpy( &manager, SIGNAL(fileAdded(QString)) );
+    QSignalSpy progressSpy( &manager, SIGNAL(fileLoadingProgress(QString,qint64,qint64)) );
+
+    manager.addFile( fileName, "removed", GeoDataStyle::Ptr(), UserDocument, 0, false );
+    QVERIFY( progressSpy.wait( 30000 ) );
+    manager.removeFile( fileName );
+    QCOMPARE( manager.pendingFiles(), 0 );
+    QCOMPARE( treeModel.rowCount(), 0 );
+
+    // batches which were already queued are dropped
+    QTest::qWait( 500 );
+    QCOMPARE( treeModel.rowCount(), 0 );
+    QCOMPARE( manager.size(), 0 );
+    QCOMPARE( addedSpy.size(), 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::FileLoaderTest )
+
+#include "FileLoaderTest.moc"
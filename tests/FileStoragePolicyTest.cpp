@@ -0,0 +1,220 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "FileStoragePolicy.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class FileStoragePolicyTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void filePath();
+    void queuedFileExists();
+    void flushWritesAllFiles();
+    void lastUpdateWins();
+    void absoluteFileName();
+    void failedWrite();
+    void backlogRejectsFiles();
+    void backlogAcceptsFirstFile();
+
+private:
+    static QByteArray readFile( const QString &fileName );
+
+    QTemporaryDir *m_dir;
+};
+
+QByteArray FileStoragePolicyTest::readFile( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void FileStoragePolicyTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY( m_dir->isValid() );
+}
+
+void FileStoragePolicyTest::cleanup()
+{
+    delete m_dir;
+    m_dir = 0;
+}
+
+void FileStoragePolicyTest::filePath()
+{
+    FileStoragePolicy policy( m_dir->path() );
+    QString const path = QDir::cleanPath( m_dir->path() );
+
+    QCOMPARE( policy.filePath( "maps/earth/osm/3/1/2.png" ), path + "/maps/earth/osm/3/1/2.png" );
+    QCOMPARE( policy.filePath( "maps//earth/./osm/3/1/2.png" ), path + "/maps/earth/osm/3/1/2.png" );
+    QCOMPARE( policy.filePath( "/tmp/tile.png" ), QString( "/tmp/tile.png" ) );
+}
+
+void FileStoragePolicyTest::queuedFileExists()
+{
+    FileStoragePolicy policy( m_dir->path() );
+    QVERIFY( !policy.fileExists( "maps/earth/osm/3/1/2.png" ) );
+
+    // Queued files exist right away, whether the writer got to them yet or not
+    QVERIFY( policy.updateFile( "maps/earth/osm/3/1/2.png", QByteArray( 4096, 'a' ) ) );
+    QVERIFY( policy.fileExists( "maps/earth/osm/3/1/2.png" ) );
+    QVERIFY( policy.fileExists( m_dir->path() + "/maps/earth/osm/3/1/2.png" ) );
+    QVERIFY( !policy.fileExists( "maps/earth/osm/3/1/3.png" ) );
+
+    policy.flush();
+    QCOMPARE( policy.backlog(), qint64( 0 ) );
+    QVERIFY( policy.fileExists( "maps/earth/osm/3/1/2.png" ) );
+
+    // Written files are not remembered
+    QVERIFY( QFile::remove( m_dir->path() + "/maps/earth/osm/3/1/2.png" ) );
+    QVERIFY( !policy.fileExists( "maps/earth/osm/3/1/2.png" ) );
+}
+
+void FileStoragePolicyTest::flushWritesAllFiles()
+{
+    FileStoragePolicy policy( m_dir->path() );
+    QSignalSpy updatedSpy( &policy, SIGNAL(fileUpdated(QString,qint64)) );
+    QSignalSpy failedSpy( &policy, SIGNAL(fileUpdateFailed(QString)) );
+
+    for ( int i = 0; i < 100; ++i ) {
+        QString const fileName = QString( "maps/earth/osm/7/%1/%2.png" ).arg( i % 10 ).arg( i );
+        QVERIFY( policy.updateFile( fileName, QByteArray::number( i ) ) );
+    }
+    policy.flush();
+
+    QCOMPARE( policy.backlog(), qint64( 0 ) );
+    QCOMPARE( failedSpy.size(), 0 );
+    QCOMPARE( updatedSpy.size(), 100 );
+    for ( int i = 0; i < 100; ++i ) {
+        // in the order they were queued, by their absolute path
+        QString const fileName = QDir::cleanPath( m_dir->path() ) + QString( "/maps/earth/osm/7/%1/%2.png" ).arg( i % 10 ).arg( i );
+        QCOMPARE( updatedSpy.at( i ).at( 0 ).toString(), fileName );
+        QCOMPARE( updatedSpy.at( i ).at( 1 ).toLongLong(), qint64( QByteArray::number( i ).size() ) );
+        QCOMPARE( readFile( fileName ), QByteArray::number( i ) );
+    }
+}
+
+void FileStoragePolicyTest::lastUpdateWins()
+{
+    FileStoragePolicy policy( m_dir->path() );
+    for ( int i = 0; i < 50; ++i ) {
+        QVERIFY( policy.updateFile( "maps/earth/osm/3/1/2.png", QByteArray::number( i ) ) );
+    }
+    QVERIFY( policy.fileExists( "maps/earth/osm/3/1/2.png" ) );
+    policy.flush();
+
+    QCOMPARE( readFile( m_dir->path() + "/maps/earth/osm/3/1/2.png" ), QByteArray::number( 49 ) );
+}
+
+void FileStoragePolicyTest::absoluteFileName()
+{
+    QTemporaryDir other;
+    QVERIFY( other.isValid() );
+    QString const fileName = other.path() + "/tile.png";
+
+    FileStoragePolicy policy( m_dir->path() );
+    QSignalSpy updatedSpy( &policy, SIGNAL(fileUpdated(QString,qint64)) );
+    QVERIFY( policy.updateFile( fileName, "data" ) );
+    QVERIFY( policy.fileExists( fileName ) );
+    policy.flush();
+
+    QCOMPARE( updatedSpy.size(), 1 );
+    QCOMPARE( updatedSpy.first().first().toString(), fileName );
+    QCOMPARE( readFile( fileName ), QByteArray( "data" ) );
+}
+
+void FileStoragePolicyTest::failedWrite()
+{
+    // A file where the directory would have to go
+    QFile blocker( m_dir->path() + "/maps" );
+    QVERIFY( blocker.open( QIODevice::WriteOnly ) );
+    blocker.close();
+
+    FileStoragePolicy policy( m_dir->path() );
+    QSignalSpy updatedSpy( &policy, SIGNAL(fileUpdated(QString,qint64)) );
+    QSignalSpy failedSpy( &policy, SIGNAL(fileUpdateFailed(QString)) );
+    QVERIFY( policy.updateFile( "maps/earth/osm/3/1/2.png", "data" ) );
+    policy.flush();
+
+    QCOMPARE( updatedSpy.size(), 0 );
+    QCOMPARE( failedSpy.size(), 1 );
+    QCOMPARE( failedSpy.first().first().toString(), QDir::cleanPath( m_dir->path() ) + "/maps/earth/osm/3/1/2.png" );
+    QVERIFY( !policy.lastErrorMessage().isEmpty() );
+    QVERIFY( !policy.fileExists( "maps/earth/osm/3/1/2.png" ) );
+    QCOMPARE( policy.backlog(), qint64( 0 ) );
+}
+
+void FileStoragePolicyTest::backlogRejectsFiles()
+{
+    FileStoragePolicy policy( m_dir->path() );
+    policy.setMaximumBacklog( 8 * 1024 * 1024 );
+    QSignalSpy updatedSpy( &policy, SIGNAL(fileUpdated(QString,qint64)) );
+
+    // Queuing is much faster than writing, so the backlog fills up. The
+    // caller is never blocked, files beyond the backlog are rejected.
+    QByteArray const data( 4 * 1024 * 1024, 'a' );
+    QList<int> accepted;
+    for ( int i = 0; i < 100; ++i ) {
+        if ( policy.updateFile( QString( "maps/earth/osm/7/0/%1.png" ).arg( i ), data ) ) {
+            accepted << i;
+        }
+        QVERIFY( policy.backlog() <= 8 * 1024 * 1024 );
+    }
+    QVERIFY( !accepted.isEmpty() );
+    QVERIFY( accepted.size() < 100 );
+    QVERIFY( !policy.lastErrorMessage().isEmpty() );
+
+    policy.flush();
+    QCOMPARE( policy.backlog(), qint64( 0 ) );
+    QCOMPARE( updatedSpy.size(), accepted.size() );
+    for ( int i = 0; i < 100; ++i ) {
+        QString const fileName = QString( "maps/earth/osm/7/0/%1.png" ).arg( i );
+        QCOMPARE( policy.fileExists( fileName ), accepted.contains( i ) );
+    }
+
+    // Once written, the backlog accepts files again
+    QVERIFY( policy.updateFile( "maps/earth/osm/7/1/0.png", data ) );
+    QVERIFY( policy.updateFile( "maps/earth/osm/7/1/1.png", data ) );
+}
+
+void FileStoragePolicyTest::backlogAcceptsFirstFile()
+{
+    // Files larger than the backlog are accepted if nothing else waits
+    FileStoragePolicy policy( m_dir->path() );
+    policy.setMaximumBacklog( 1024 );
+    QVERIFY( policy.updateFile( "maps/earth/osm/3/1/2.png", QByteArray( 64 * 1024, 'a' ) ) );
+    policy.flush();
+    QVERIFY( policy.updateFile( "maps/earth/osm/3/1/3.png", QByteArray( 64 * 1024, 'a' ) ) );
+    policy.flush();
+
+    QCOMPARE( readFile( m_dir->path() + "/maps/earth/osm/3/1/3.png" ).size(), 64 * 1024 );
+}
+
+}
+
+QTEST_MAIN( Marble::FileStoragePolicyTest )
+
+#include "FileStoragePolicyTest.moc"
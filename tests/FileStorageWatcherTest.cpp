@@ -0,0 +1,194 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "FileStorageWatcher.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class FileStorageWatcherTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void loadManifest();
+    void truncatedJournal();
+    void evictLeastRecentlyUsed();
+    void takeOverManifest();
+
+private:
+    QString writeTile( const QString &key, int size );
+
+    QTemporaryDir *m_dir;
+};
+
+void FileStorageWatcherTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY( m_dir->isValid() );
+}
+
+void FileStorageWatcherTest::cleanup()
+{
+    delete m_dir;
+    m_dir = 0;
+}
+
+QString FileStorageWatcherTest::writeTile( const QString &key, int size )
+{
+    QString const fileName = m_dir->path() + "/maps/" + key;
+    QDir().mkpath( QFileInfo( fileName ).path() );
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( QByteArray( size, 'a' ) ) != size ) {
+        return QString();
+    }
+    return fileName;
+}
+
+void FileStorageWatcherTest::loadManifest()
+{
+    QVERIFY( !writeTile( "earth/osm/10/1/1.png", 1000 ).isEmpty() );
+    QVERIFY( !writeTile( "earth/osm/10/1/2.png", 2000 ).isEmpty() );
+
+    {
+        // no manifest yet, the cache is crawled
+        FileStorageWatcherThread watcher( m_dir->path() );
+        watcher.getCurrentCacheSize();
+        QVERIFY( watcher.ownsManifest() );
+        QCOMPARE( watcher.currentCacheSize(), quint64( 3000 ) );
+
+        QString const fileName = writeTile( "earth/osm/10/1/3.png", 500 );
+        watcher.updateFile( fileName, 500 );
+        QCOMPARE( watcher.currentCacheSize(), quint64( 3500 ) );
+
+        // base tile levels are never evicted, so they are not recorded
+        watcher.updateFile( writeTile( "earth/osm/3/1/1.png", 100 ), 100 );
+        QCOMPARE( watcher.currentCacheSize(), quint64( 3500 ) );
+    }
+
+    // files written behind the back of the manifest are not counted...
+    QVERIFY( !writeTile( "earth/osm/10/1/4.png", 4000 ).isEmpty() );
+    FileStorageWatcherThread reloaded( m_dir->path() );
+    reloaded.getCurrentCacheSize();
+    QVERIFY( reloaded.ownsManifest() );
+    QCOMPARE( reloaded.currentCacheSize(), quint64( 3500 ) );
+
+    // ...until the manifest is rebuilt from the disc
+    reloaded.resetCurrentSize();
+    QCOMPARE( reloaded.currentCacheSize(), quint64( 7500 ) );
+}
+
+void FileStorageWatcherTest::truncatedJournal()
+{
+    QVERIFY( !writeTile( "earth/osm/10/1/1.png", 1000 ).isEmpty() );
+    QVERIFY( !writeTile( "earth/osm/10/1/2.png", 2000 ).isEmpty() );
+
+    {
+        FileStorageWatcherThread watcher( m_dir->path() );
+        watcher.getCurrentCacheSize();
+        watcher.updateFile( writeTile( "earth/osm/10/1/3.png", 500 ), 500 );
+        QCOMPARE( watcher.currentCacheSize(), quint64( 3500 ) );
+    }
+
+    // a crash while the last record was written
+    QString const manifestName = m_dir->path() + "/tilecache.manifest";
+    QFile manifest( manifestName );
+    QVERIFY( manifest.open( QIODevice::ReadWrite ) );
+    qint64 const truncatedSize = manifest.size() - 3;
+    QVERIFY( manifest.resize( truncatedSize ) );
+    manifest.close();
+
+    {
+        FileStorageWatcherThread watcher( m_dir->path() );
+        watcher.getCurrentCacheSize();
+        QCOMPARE( watcher.currentCacheSize(), quint64( 3000 ) );
+    }
+
+    // the manifest was rewritten without the broken record
+    QVERIFY( QFileInfo( manifestName ).size() < truncatedSize );
+    FileStorageWatcherThread watcher( m_dir->path() );
+    watcher.getCurrentCacheSize();
+    QCOMPARE( watcher.currentCacheSize(), quint64( 3000 ) );
+}
+
+void FileStorageWatcherTest::evictLeastRecentlyUsed()
+{
+    FileStorageWatcherThread watcher( m_dir->path() );
+    watcher.getCurrentCacheSize();
+    QVERIFY( watcher.ownsManifest() );
+
+    QStringList fileNames;
+    for ( int i = 0; i < 4; ++i ) {
+        fileNames << writeTile( QString( "earth/osm/10/1/%1.png" ).arg( i ), 1000 );
+        watcher.updateFile( fileNames.last(), 1000 );
+        QTest::qWait( 10 );
+    }
+    watcher.touchFile( fileNames.at( 0 ) );
+    QTest::qWait( 10 );
+    QCOMPARE( watcher.currentCacheSize(), quint64( 4000 ) );
+
+    // the cache is reduced below 95 % of the limit, the least recently used tiles first
+    watcher.setCacheLimit( 2500 );
+    QTRY_COMPARE( watcher.currentCacheSize(), quint64( 2000 ) );
+    QVERIFY( QFile::exists( fileNames.at( 0 ) ) );
+    QVERIFY( !QFile::exists( fileNames.at( 1 ) ) );
+    QVERIFY( !QFile::exists( fileNames.at( 2 ) ) );
+    QVERIFY( QFile::exists( fileNames.at( 3 ) ) );
+}
+
+void FileStorageWatcherTest::takeOverManifest()
+{
+    FileStorageWatcherThread *owner = new FileStorageWatcherThread( m_dir->path() );
+    owner->getCurrentCacheSize();
+    QVERIFY( owner->ownsManifest() );
+
+    FileStorageWatcherThread watcher( m_dir->path() );
+    watcher.getCurrentCacheSize();
+    QVERIFY( !watcher.ownsManifest() );
+    watcher.setCacheLimit( 2500 );
+
+    QStringList fileNames;
+    for ( int i = 0; i < 4; ++i ) {
+        fileNames << writeTile( QString( "earth/osm/10/1/%1.png" ).arg( i ), 1000 );
+        watcher.updateFile( fileNames.last(), 1000 );
+        QTest::qWait( 10 );
+    }
+
+    // only the owner of the manifest evicts tiles
+    QTest::qWait( 100 );
+    foreach ( const QString &fileName, fileNames ) {
+        QVERIFY( QFile::exists( fileName ) );
+    }
+
+    // once it is gone, the files written meanwhile are recorded and the limit is enforced
+    delete owner;
+    watcher.getCurrentCacheSize();
+    QVERIFY( watcher.ownsManifest() );
+    QTRY_COMPARE( watcher.currentCacheSize(), quint64( 2000 ) );
+    QVERIFY( !QFile::exists( fileNames.at( 0 ) ) );
+    QVERIFY( !QFile::exists( fileNames.at( 1 ) ) );
+    QVERIFY( QFile::exists( fileNames.at( 2 ) ) );
+    QVERIFY( QFile::exists( fileNames.at( 3 ) ) );
+}
+
+}
+
+QTEST_MAIN( Marble::FileStorageWatcherTest )
+
+#include "FileStorageWatcherTest.moc"
@@ -0,0 +1,106 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include <QTest>
+
+#include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "MarbleModel.h"
+
+namespace Marble
+{
+
+/**
+ * Measures loading and navigating a single large folder, which used to
+ * be quadratic in the number of placemarks due to linear row lookups.
+ */
+class GeoDataTreeModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void addLargeFolder_data();
+    void addLargeFolder();
+
+    void indexInLargeFolder();
+
+private:
+    static GeoDataDocument *createDocument( int placemarkCount );
+};
+
+GeoDataDocument *GeoDataTreeModelBenchmark::createDocument( int placemarkCount )
+{
+    GeoDataFolder *folder = new GeoDataFolder;
+    for ( int i = 0; i < placemarkCount; ++i ) {
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( QString::number( i ) );
+        placemark->setCoordinate( ( i % 360 ) - 180.0, ( i % 180 ) - 90.0, 0.0, GeoDataCoordinates::Degree );
+        folder->append( placemark );
+    }
+
+    GeoDataDocument *document = new GeoDataDocument;
+    document->append( folder );
+    return document;
+}
+
+void GeoDataTreeModelBenchmark::addLargeFolder_data()
+{
+    QTest::addColumn<int>( "placemarkCount" );
+
+    QTest::newRow( "1k" ) << 1000;
+    QTest::newRow( "10k" ) << 10000;
+    QTest::newRow( "100k" ) << 100000;
+}
+
+void GeoDataTreeModelBenchmark::addLargeFolder()
+{
+    QFETCH( int, placemarkCount );
+
+    MarbleModel model;
+    GeoDataDocument *document = createDocument( placemarkCount );
+
+    QBENCHMARK_ONCE {
+        model.treeModel()->addDocument( document );
+    }
+
+    QCOMPARE( model.placemarkModel()->rowCount(), placemarkCount );
+
+    model.treeModel()->removeDocument( document );
+    delete document;
+}
+
+void GeoDataTreeModelBenchmark::indexInLargeFolder()
+{
+    GeoDataTreeModel model;
+    GeoDataDocument *document = createDocument( 100000 );
+    model.addDocument( document );
+
+    GeoDataFolder *folder = static_cast<GeoDataFolder*>( document->child( 0 ) );
+    const QModelIndex folderIndex = model.index( folder );
+    QVERIFY( folderIndex.isValid() );
+
+    int mismatches = 0;
+    QBENCHMARK {
+        for ( int row = 0; row < folder->size(); ++row ) {
+            const QModelIndex child = model.index( folder->child( row ) );
+            if ( child.row() != row || model.parent( child ) != folderIndex ) {
+                ++mismatches;
+            }
+        }
+    }
+    QCOMPARE( mismatches, 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::GeoDataTreeModelBenchmark )
+
+#include "GeoDataTreeModelBenchmark.moc"
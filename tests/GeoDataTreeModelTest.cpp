@@ -8,6 +8,7 @@
 // Copyright 2014      Bernhard Beschow <bbeschow@cs.tu-berlin.de>
 //
 
+#include <QSignalSpy>
 #include <QTest>
 
 #include "GeoDataTreeModel.h"
@@ -26,6 +27,7 @@ private Q_SLOTS:
     void defaultConstructor();
     void setRootDocument();
     void addDocument();
+    void addFeatures();
 };
 
 void GeoDataTreeModelTest::defaultConstructor()
@@ -73,6 +75,38 @@ void GeoDataTreeModelTest::addDocument()
     }
 }
 
+void GeoDataTreeModelTest::addFeatures()
+{
+    qRegisterMetaType<GeoDataObject*>( "GeoDataObject*" );
+
+    GeoDataDocument *document = new GeoDataDocument;
+    GeoDataPlacemark *first = new GeoDataPlacemark;
+    document->append( first );
+
+    GeoDataTreeModel model;
+    model.addDocument( document );
+    const QModelIndex documentIndex = model.index( 0, 0 );
+
+    QSignalSpy rowsInsertedSpy( &model, SIGNAL(rowsInserted(QModelIndex,int,int)) );
+    QSignalSpy addedSpy( &model, SIGNAL(added(GeoDataObject*)) );
+
+    QVector<GeoDataFeature*> features;
+    features << new GeoDataPlacemark << new GeoDataPlacemark << new GeoDataPlacemark;
+
+    QCOMPARE( model.addFeatures( document, features ), 1 );
+    QCOMPARE( rowsInsertedSpy.count(), 1 );
+    QCOMPARE( rowsInsertedSpy.at( 0 ).at( 1 ).toInt(), 1 );
+    QCOMPARE( rowsInsertedSpy.at( 0 ).at( 2 ).toInt(), 3 );
+    QCOMPARE( addedSpy.count(), 3 );
+
+    QCOMPARE( model.rowCount( documentIndex ), 4 );
+    QCOMPARE( document->child( 3 ), features.last() );
+    QCOMPARE( features.last()->parent(), document );
+
+    QCOMPARE( model.addFeatures( document, QVector<GeoDataFeature*>() ), -1 );
+    QCOMPARE( rowsInsertedSpy.count(), 1 );
+}
+
 }
 
 QTEST_MAIN( Marble::GeoDataTreeModelTest )
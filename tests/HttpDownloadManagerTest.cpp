@@ -0,0 +1,192 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QUrl>
+
+#include "HttpDownloadManager.h"
+
+namespace Marble
+{
+
+class HttpDownloadManagerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void download();
+    void setJobPriorities();
+    void setJobPrioritiesOfOwners();
+
+private:
+    QUrl sourceUrl( int index ) const;
+
+    QTemporaryDir m_sourceDir;
+};
+
+void HttpDownloadManagerTest::initTestCase()
+{
+    QVERIFY( m_sourceDir.isValid() );
+
+    // more files than the default number of browse connections, so that
+    // some of the jobs have to wait in the queue
+    for ( int i = 0; i < 30; ++i ) {
+        QFile file( m_sourceDir.path() + QString( "/%1.txt" ).arg( i ) );
+        QVERIFY( file.open( QIODevice::WriteOnly ) );
+        file.write( QByteArray::number( i ) );
+    }
+}
+
+QUrl HttpDownloadManagerTest::sourceUrl( int index ) const
+{
+    return QUrl::fromLocalFile( m_sourceDir.path() + QString( "/%1.txt" ).arg( index ) );
+}
+
+void HttpDownloadManagerTest::download()
+{
+    HttpDownloadManager manager( 0 );
+    QSignalSpy spy( &manager, SIGNAL(downloadComplete(QByteArray,QString)) );
+
+    manager.addJob( sourceUrl( 0 ), "download/0.txt", "download:0", DownloadBrowse );
+    // already queued or being downloaded
+    manager.addJob( sourceUrl( 0 ), "download/0.txt", "download:0", DownloadBrowse );
+
+    QTRY_COMPARE( spy.count(), 1 );
+    QCOMPARE( spy.first().at( 0 ).toByteArray(), QByteArray( "0" ) );
+    QCOMPARE( spy.first().at( 1 ).toString(), QString( "download:0" ) );
+
+    QTest::qWait( 100 );
+    QCOMPARE( spy.count(), 1 );
+}
+
+void HttpDownloadManagerTest::setJobPriorities()
+{
+    HttpDownloadManager manager( 0 );
+    QSignalSpy spy( &manager, SIGNAL(downloadComplete(QByteArray,QString)) );
+    QSignalSpy canceledSpy( &manager, SIGNAL(downloadCanceled(QString)) );
+
+    manager.addJob( sourceUrl( 0 ), "other/0.txt", "other:0", DownloadBrowse );
+    for ( int i = 0; i < 30; ++i ) {
+        manager.addJob( sourceUrl( i ), QString( "tiles/%1.txt" ).arg( i ), QString( "tiles:%1" ).arg( i ), DownloadBrowse );
+    }
+
+    // only the tiles with an even number are still needed, the other
+    // ones are canceled whether they are queued or running already
+    QHash<QString, int> priorities;
+    QSet<QString> expected;
+    QSet<QString> expectedCanceled;
+    expected << "other:0";
+    for ( int i = 0; i < 30; i += 2 ) {
+        priorities.insert( QString( "tiles:%1" ).arg( i ), i );
+        expected << QString( "tiles:%1" ).arg( i );
+        expectedCanceled << QString( "tiles:%1" ).arg( i + 1 );
+    }
+    manager.setJobPriorities( this, "tiles:", priorities );
+
+    QSet<QString> canceled;
+    foreach ( const QList<QVariant> &arguments, canceledSpy ) {
+        canceled << arguments.at( 0 ).toString();
+    }
+    QCOMPARE( canceled, expectedCanceled );
+
+    QTRY_COMPARE( spy.count(), expected.size() );
+    QTest::qWait( 100 );
+    QCOMPARE( spy.count(), expected.size() );
+
+    QSet<QString> completed;
+    foreach ( const QList<QVariant> &arguments, spy ) {
+        const QString id = arguments.at( 1 ).toString();
+        QCOMPARE( arguments.at( 0 ).toByteArray(), id.section( ':', 1 ).toLatin1() );
+        completed << id;
+    }
+    QCOMPARE( completed, expected );
+}
+
+void HttpDownloadManagerTest::setJobPrioritiesOfOwners()
+{
+    HttpDownloadManager manager( 0 );
+    QSignalSpy spy( &manager, SIGNAL(downloadComplete(QByteArray,QString)) );
+    QSignalSpy canceledSpy( &manager, SIGNAL(downloadCanceled(QString)) );
+
+    // Two maps show different tiles of the same dataset
+    QObject *first = new QObject;
+    QObject *second = new QObject;
+    QHash<QString, int> firstPriorities;
+    QHash<QString, int> secondPriorities;
+    for ( int i = 0; i < 30; ++i ) {
+        if ( i % 2 == 0 ) {
+            firstPriorities.insert( QString( "tiles:%1" ).arg( i ), i );
+        }
+        if ( i % 3 == 0 ) {
+            secondPriorities.insert( QString( "tiles:%1" ).arg( i ), i );
+        }
+    }
+    manager.setJobPriorities( first, "tiles:", firstPriorities );
+    manager.setJobPriorities( second, "tiles:", secondPriorities );
+
+    for ( int i = 0; i < 30; ++i ) {
+        manager.addJob( sourceUrl( i ), QString( "tiles/%1.txt" ).arg( i ), QString( "tiles:%1" ).arg( i ), DownloadBrowse );
+    }
+
+    // only the tiles neither of them needs are canceled
+    manager.setJobPriorities( first, "tiles:", firstPriorities );
+    QSet<QString> expectedCanceled;
+    for ( int i = 0; i < 30; ++i ) {
+        if ( i % 2 != 0 && i % 3 != 0 ) {
+            expectedCanceled << QString( "tiles:%1" ).arg( i );
+        }
+    }
+    QSet<QString> canceled;
+    foreach ( const QList<QVariant> &arguments, canceledSpy ) {
+        canceled << arguments.at( 0 ).toString();
+    }
+    QCOMPARE( canceled, expectedCanceled );
+
+    // the tiles only the destroyed one needed follow
+    delete second;
+    QSet<QString> expected;
+    for ( int i = 0; i < 30; ++i ) {
+        if ( i % 2 == 0 ) {
+            expected << QString( "tiles:%1" ).arg( i );
+        } else {
+            expectedCanceled << QString( "tiles:%1" ).arg( i );
+        }
+    }
+    canceled.clear();
+    foreach ( const QList<QVariant> &arguments, canceledSpy ) {
+        canceled << arguments.at( 0 ).toString();
+    }
+    QCOMPARE( canceled, expectedCanceled );
+
+    QTRY_COMPARE( spy.count(), expected.size() );
+    QSet<QString> completed;
+    foreach ( const QList<QVariant> &arguments, spy ) {
+        completed << arguments.at( 1 ).toString();
+    }
+    QCOMPARE( completed, expected );
+
+    // nobody reports priorities anymore, jobs are left alone
+    delete first;
+    manager.addJob( sourceUrl( 1 ), "tiles/1.txt", "tiles:1", DownloadBrowse );
+    QTRY_COMPARE( spy.count(), expected.size() + 1 );
+    QCOMPARE( canceledSpy.count(), expectedCanceled.size() );
+}
+
+}
+
+QTEST_MAIN( Marble::HttpDownloadManagerTest )
+
+#include "HttpDownloadManagerTest.moc"
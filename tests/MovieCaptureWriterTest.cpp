@@ -0,0 +1,249 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "MovieCaptureWriter.h"
+
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class MovieCaptureWriterTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void output_data();
+    void output();
+
+    void y4mHeader();
+    void y4mColors_data();
+    void y4mColors();
+    void y4mOddSize();
+    void y4mScalesFrames();
+    void y4mBackpressure();
+
+    void imageSequence();
+    void cancelRemovesOutput();
+
+private:
+    static QByteArray write( const QString &fileName, const QList<QImage> &frames, int fps = 25 );
+    static QImage image( int width, int height, const QColor &color );
+
+    QTemporaryDir m_dir;
+};
+
+QByteArray MovieCaptureWriterTest::write( const QString &fileName, const QList<QImage> &frames, int fps )
+{
+    MovieCaptureWriter writer( fileName, QString(), fps );
+    writer.start();
+    foreach ( const QImage &frame, frames ) {
+        if ( !writer.enqueue( frame ) ) {
+            return QByteArray();
+        }
+    }
+    writer.finish();
+    writer.wait();
+    if ( writer.hasFailed() ) {
+        return QByteArray();
+    }
+
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return QByteArray();
+    }
+    QByteArray const data = file.readAll();
+    return writer.bytesWritten() == data.size() ? data : QByteArray();
+}
+
+QImage MovieCaptureWriterTest::image( int width, int height, const QColor &color )
+{
+    QImage result( width, height, QImage::Format_RGB32 );
+    result.fill( color );
+    return result;
+}
+
+void MovieCaptureWriterTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+}
+
+void MovieCaptureWriterTest::output_data()
+{
+    QTest::addColumn<QString>( "destination" );
+    QTest::addColumn<int>( "output" );
+
+    QTest::newRow( "y4m" ) << "tour.y4m" << int( MovieCaptureWriter::Y4M );
+    QTest::newRow( "Y4M" ) << "tour.Y4M" << int( MovieCaptureWriter::Y4M );
+    QTest::newRow( "png" ) << "tour.png" << int( MovieCaptureWriter::ImageSequence );
+    QTest::newRow( "mp4" ) << "tour.mp4" << int( MovieCaptureWriter::Encoder );
+    QTest::newRow( "none" ) << "tour" << int( MovieCaptureWriter::Encoder );
+}
+
+void MovieCaptureWriterTest::output()
+{
+    QFETCH( QString, destination );
+    QFETCH( int, output );
+
+    QCOMPARE( int( MovieCaptureWriter::output( destination ) ), output );
+}
+
+void MovieCaptureWriterTest::y4mHeader()
+{
+    QList<QImage> frames;
+    frames << image( 4, 2, Qt::black ) << image( 4, 2, Qt::black ) << image( 4, 2, Qt::black );
+    QByteArray const data = write( m_dir.path() + "/header.y4m", frames, 30 );
+
+    // the stream header is followed by a header and 4 x 2 luma and 2 x 1 x 2 chroma bytes per frame
+    QByteArray const header = "YUV4MPEG2 W4 H2 F30:1 Ip A1:1 C420jpeg\n";
+    QCOMPARE( data.size(), header.size() + 3 * ( 6 + 8 + 2 * 2 ) );
+    QCOMPARE( data.left( header.size() ), header );
+    for ( int i = 0; i < 3; ++i ) {
+        QCOMPARE( data.mid( header.size() + i * 18, 6 ), QByteArray( "FRAME\n" ) );
+    }
+}
+
+void MovieCaptureWriterTest::y4mColors_data()
+{
+    QTest::addColumn<QColor>( "color" );
+    QTest::addColumn<int>( "y" );
+    QTest::addColumn<int>( "cb" );
+    QTest::addColumn<int>( "cr" );
+
+    // ITU-R BT.601, studio swing
+    QTest::newRow( "black" ) << QColor( Qt::black ) << 16 << 128 << 128;
+    QTest::newRow( "white" ) << QColor( Qt::white ) << 235 << 128 << 128;
+    QTest::newRow( "red" ) << QColor( Qt::red ) << 82 << 90 << 240;
+    QTest::newRow( "green" ) << QColor( Qt::green ) << 144 << 54 << 34;
+    QTest::newRow( "blue" ) << QColor( Qt::blue ) << 41 << 240 << 110;
+}
+
+void MovieCaptureWriterTest::y4mColors()
+{
+    QFETCH( QColor, color );
+    QFETCH( int, y );
+    QFETCH( int, cb );
+    QFETCH( int, cr );
+
+    QByteArray const data = write( m_dir.path() + "/colors.y4m", QList<QImage>() << image( 2, 2, color ) );
+    QByteArray const frame = data.mid( data.indexOf( "FRAME\n" ) + 6 );
+    QCOMPARE( frame.size(), 4 + 1 + 1 );
+    for ( int i = 0; i < 4; ++i ) {
+        QCOMPARE( int( uchar( frame.at( i ) ) ), y );
+    }
+    QCOMPARE( int( uchar( frame.at( 4 ) ) ), cb );
+    QCOMPARE( int( uchar( frame.at( 5 ) ) ), cr );
+}
+
+void MovieCaptureWriterTest::y4mOddSize()
+{
+    // the last column and row of odd sized frames get chroma samples of their own
+    QImage frame = image( 3, 3, Qt::white );
+    frame.setPixel( 2, 0, qRgb( 255, 0, 0 ) );
+    frame.setPixel( 2, 1, qRgb( 255, 0, 0 ) );
+    frame.setPixel( 2, 2, qRgb( 255, 0, 0 ) );
+    frame.setPixel( 0, 2, qRgb( 255, 0, 0 ) );
+    frame.setPixel( 1, 2, qRgb( 255, 0, 0 ) );
+
+    QByteArray const data = write( m_dir.path() + "/odd.y4m", QList<QImage>() << frame );
+    QVERIFY( data.startsWith( "YUV4MPEG2 W3 H3 " ) );
+    QByteArray const planes = data.mid( data.indexOf( "FRAME\n" ) + 6 );
+    QCOMPARE( planes.size(), 9 + 2 * 2 * 2 );
+
+    // white top left, red elsewhere
+    QCOMPARE( int( uchar( planes.at( 9 ) ) ), 128 );
+    QCOMPARE( int( uchar( planes.at( 10 ) ) ), 90 );
+    QCOMPARE( int( uchar( planes.at( 11 ) ) ), 90 );
+    QCOMPARE( int( uchar( planes.at( 12 ) ) ), 90 );
+    QCOMPARE( int( uchar( planes.at( 13 ) ) ), 128 );
+    QCOMPARE( int( uchar( planes.at( 14 ) ) ), 240 );
+}
+
+void MovieCaptureWriterTest::y4mScalesFrames()
+{
+    // the first frame determines the size of the stream
+    QList<QImage> frames;
+    frames << image( 4, 4, Qt::white ) << image( 8, 6, Qt::white );
+    QByteArray const data = write( m_dir.path() + "/scaled.y4m", frames );
+    QVERIFY( data.startsWith( "YUV4MPEG2 W4 H4 " ) );
+    QCOMPARE( data.count( "FRAME\n" ), 2 );
+    QCOMPARE( data.size() - data.indexOf( "FRAME\n" ), 2 * ( 6 + 16 + 2 * 4 ) );
+}
+
+void MovieCaptureWriterTest::y4mBackpressure()
+{
+    // Far more frames than the queue holds, none of them may be dropped
+    QList<QImage> frames;
+    for ( int i = 0; i < 100; ++i ) {
+        frames << image( 64, 48, QColor::fromHsv( i * 3, 255, 255 ) );
+    }
+    QByteArray const data = write( m_dir.path() + "/many.y4m", frames );
+    QCOMPARE( data.count( "FRAME\n" ), 100 );
+
+    // and they are written in order
+    int const frameSize = 6 + 64 * 48 + 2 * 32 * 24;
+    int const start = data.indexOf( "FRAME\n" );
+    QCOMPARE( data.size(), start + 100 * frameSize );
+    for ( int i = 0; i < 100; i += 33 ) {
+        QByteArray const single = write( m_dir.path() + "/single.y4m", QList<QImage>() << frames.at( i ) );
+        QCOMPARE( data.mid( start + i * frameSize, frameSize ), single.mid( single.indexOf( "FRAME\n" ) ) );
+    }
+}
+
+void MovieCaptureWriterTest::imageSequence()
+{
+    QList<QImage> frames;
+    frames << image( 5, 3, Qt::red ) << image( 5, 3, Qt::green ) << image( 5, 3, Qt::blue );
+
+    MovieCaptureWriter writer( m_dir.path() + "/sequence.png", QString(), 25 );
+    writer.start();
+    foreach ( const QImage &frame, frames ) {
+        QVERIFY( writer.enqueue( frame ) );
+    }
+    writer.finish();
+    writer.wait();
+    QVERIFY( !writer.hasFailed() );
+    QVERIFY( !QFile::exists( m_dir.path() + "/sequence.png" ) );
+
+    for ( int i = 0; i < frames.size(); ++i ) {
+        QString const fileName = m_dir.path() + QString( "/sequence_00000%1.png" ).arg( i );
+        QImage const written( fileName );
+        QCOMPARE( written.size(), QSize( 5, 3 ) );
+        QCOMPARE( written.pixel( 2, 1 ), frames.at( i ).pixel( 2, 1 ) );
+    }
+    QVERIFY( !QFile::exists( m_dir.path() + "/sequence_000003.png" ) );
+}
+
+void MovieCaptureWriterTest::cancelRemovesOutput()
+{
+    QString const fileName = m_dir.path() + "/canceled.y4m";
+    MovieCaptureWriter writer( fileName, QString(), 25 );
+    writer.start();
+    for ( int i = 0; i < 20; ++i ) {
+        QVERIFY( writer.enqueue( image( 64, 48, Qt::white ) ) );
+    }
+    writer.cancel();
+    writer.wait();
+    QVERIFY( !QFile::exists( fileName ) );
+
+    // no frames are accepted after a cancel
+    QVERIFY( !writer.enqueue( image( 64, 48, Qt::white ) ) );
+}
+
+}
+
+QTEST_MAIN( Marble::MovieCaptureWriterTest )
+
+#include "MovieCaptureWriterTest.moc"
@@ -0,0 +1,134 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "MarbleMap.h"
+#include "MarbleModel.h"
+#include "NavigationReplayer.h"
+#include "NavigationTrace.h"
+#include "TestUtils.h"
+
+#include <QBuffer>
+
+namespace Marble
+{
+
+class NavigationTraceTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void saveAndLoad();
+    void loadInvalid();
+    void replay();
+
+private:
+    static NavigationTrace panAndZoom();
+};
+
+NavigationTrace NavigationTraceTest::panAndZoom()
+{
+    NavigationTrace trace;
+    NavigationTrace::Frame frame;
+    frame.size = QSize( 200, 100 );
+    frame.radius = 100;
+    for ( int i = 0; i < 50; ++i ) {
+        frame.msecs = i * 16;
+        frame.lon = i * 0.5;
+        frame.lat = -i * 0.25;
+        trace.append( frame );
+    }
+    frame.projection = Mercator;
+    for ( int i = 50; i < 100; ++i ) {
+        frame.msecs = i * 16;
+        frame.radius = 100 + i * 10;
+        trace.append( frame );
+    }
+    return trace;
+}
+
+void NavigationTraceTest::saveAndLoad()
+{
+    NavigationTrace const trace = panAndZoom();
+
+    QBuffer buffer;
+    buffer.open( QIODevice::WriteOnly );
+    QVERIFY( trace.save( &buffer ) );
+    buffer.close();
+
+    // properties that did not change are not stored again
+    QVERIFY( buffer.data().size() < trace.frames().size() * 24 );
+
+    buffer.open( QIODevice::ReadOnly );
+    NavigationTrace loaded;
+    QVERIFY( loaded.load( &buffer ) );
+    QCOMPARE( loaded.frames().size(), trace.frames().size() );
+    for ( int i = 0; i < trace.frames().size(); ++i ) {
+        QVERIFY( loaded.frames().at( i ) == trace.frames().at( i ) );
+        QCOMPARE( loaded.frames().at( i ).msecs, trace.frames().at( i ).msecs );
+    }
+    QCOMPARE( loaded.duration(), qint64( 99 * 16 ) );
+}
+
+void NavigationTraceTest::loadInvalid()
+{
+    QBuffer buffer;
+    buffer.setData( "not a trace" );
+    buffer.open( QIODevice::ReadOnly );
+
+    NavigationTrace trace;
+    QVERIFY( !trace.load( &buffer ) );
+    QVERIFY( trace.frames().isEmpty() );
+
+    // truncated
+    QBuffer truncated;
+    truncated.open( QIODevice::WriteOnly );
+    QVERIFY( panAndZoom().save( &truncated ) );
+    truncated.close();
+    truncated.setData( truncated.data().left( truncated.data().size() / 2 ) );
+    truncated.open( QIODevice::ReadOnly );
+    QVERIFY( !trace.load( &truncated ) );
+    QVERIFY( trace.frames().isEmpty() );
+
+    // a bogus frame count without the frames to go with it
+    QBuffer bogus;
+    bogus.open( QIODevice::WriteOnly );
+    QVERIFY( NavigationTrace().save( &bogus ) );
+    bogus.close();
+    QByteArray data = bogus.data();
+    data.replace( data.size() - 4, 4, QByteArray( 4, '\xff' ) );
+    bogus.setData( data );
+    bogus.open( QIODevice::ReadOnly );
+    QVERIFY( !trace.load( &bogus ) );
+    QVERIFY( trace.frames().isEmpty() );
+}
+
+void NavigationTraceTest::replay()
+{
+    MarbleModel model;
+    MarbleMap map( &model );
+    map.setMapThemeId( "earth/plain/plain.dgml" );
+
+    NavigationTrace const trace = panAndZoom();
+    NavigationReplayer replayer( &map );
+    replayer.replay( trace );
+
+    QCOMPARE( replayer.frameTimes().size(), trace.frames().size() );
+    QVERIFY( replayer.percentile( 50 ) <= replayer.percentile( 90 ) );
+    QVERIFY( replayer.percentile( 90 ) <= replayer.percentile( 100 ) );
+    QCOMPARE( map.projection(), Mercator );
+    QCOMPARE( map.radius(), 100 + 99 * 10 );
+    QCOMPARE( map.size(), QSize( 200, 100 ) );
+}
+
+}
+
+QTEST_MAIN( Marble::NavigationTraceTest )
+
+#include "NavigationTraceTest.moc"
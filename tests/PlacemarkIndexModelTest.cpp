@@ -0,0 +1,346 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include <QSignalSpy>
+#include <QTest>
+
+#include "PlacemarkIndexModel.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataGroundOverlay.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "GeoDataTypes.h"
+#include "MarblePlacemarkModel.h"
+
+namespace Marble
+{
+
+class PlacemarkIndexModelTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void defaultConstructor();
+    void addDocument();
+    void removeDocument();
+    void addFeature();
+    void removeFolder();
+    void setRootDocument();
+    void groundOverlays();
+    void findPlacemarks();
+    void findRenamedPlacemarks();
+
+private:
+    static GeoDataPlacemark *createPlacemark( const QString &name, qreal lon, qreal lat );
+};
+
+GeoDataPlacemark *PlacemarkIndexModelTest::createPlacemark( const QString &name, qreal lon, qreal lat )
+{
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( name );
+    placemark->setCoordinate( lon, lat, 0.0, GeoDataCoordinates::Degree );
+    return placemark;
+}
+
+void PlacemarkIndexModelTest::defaultConstructor()
+{
+    const PlacemarkIndexModel model;
+
+    QCOMPARE( model.rowCount(), 0 );
+    QCOMPARE( model.sourceModel(), static_cast<GeoDataTreeModel*>( 0 ) );
+    QVERIFY( model.featureType() == GeoDataTypes::GeoDataPlacemarkType );
+    QCOMPARE( model.feature( 0 ), static_cast<GeoDataFeature*>( 0 ) );
+    QCOMPARE( model.row( 0 ), -1 );
+}
+
+void PlacemarkIndexModelTest::addDocument()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setSourceModel( &treeModel );
+
+    QSignalSpy rowsInsertedSpy( &model, SIGNAL(rowsInserted(QModelIndex,int,int)) );
+
+    GeoDataDocument *first = new GeoDataDocument;
+    GeoDataPlacemark *a = createPlacemark( "a", 0, 0 );
+    GeoDataFolder *folder = new GeoDataFolder;
+    GeoDataPlacemark *b = createPlacemark( "b", 10, 10 );
+    first->append( a );
+    first->append( folder );
+    folder->append( b );
+    treeModel.addDocument( first );
+
+    QCOMPARE( rowsInsertedSpy.count(), 1 );
+    QCOMPARE( model.rowCount(), 2 );
+    QCOMPARE( model.feature( 0 ), a );
+    QCOMPARE( model.feature( 1 ), b );
+    QCOMPARE( model.row( b ), 1 );
+    QCOMPARE( model.row( folder ), -1 );
+
+    GeoDataDocument *empty = new GeoDataDocument;
+    treeModel.addDocument( empty );
+    QCOMPARE( rowsInsertedSpy.count(), 1 );
+
+    GeoDataDocument *second = new GeoDataDocument;
+    GeoDataPlacemark *c = createPlacemark( "c", 20, 20 );
+    second->append( c );
+    treeModel.addDocument( second );
+
+    QCOMPARE( rowsInsertedSpy.count(), 2 );
+    QCOMPARE( rowsInsertedSpy.at( 1 ).at( 1 ).toInt(), 2 );
+    QCOMPARE( rowsInsertedSpy.at( 1 ).at( 2 ).toInt(), 2 );
+    QCOMPARE( model.rowCount(), 3 );
+    QCOMPARE( model.feature( 2 ), c );
+    QCOMPARE( model.row( c ), 2 );
+
+    const QModelIndex index = model.index( 2, 0 );
+    QCOMPARE( index.data( Qt::DisplayRole ).toString(), QString( "c" ) );
+    QCOMPARE( qvariant_cast<GeoDataObject*>( index.data( MarblePlacemarkModel::ObjectPointerRole ) ), static_cast<GeoDataObject*>( c ) );
+}
+
+void PlacemarkIndexModelTest::removeDocument()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setSourceModel( &treeModel );
+
+    GeoDataDocument *first = new GeoDataDocument;
+    first->append( createPlacemark( "a", 0, 0 ) );
+    first->append( createPlacemark( "b", 0, 0 ) );
+    treeModel.addDocument( first );
+
+    GeoDataDocument *second = new GeoDataDocument;
+    GeoDataPlacemark *c = createPlacemark( "c", 0, 0 );
+    second->append( c );
+    treeModel.addDocument( second );
+
+    QSignalSpy rowsRemovedSpy( &model, SIGNAL(rowsRemoved(QModelIndex,int,int)) );
+
+    treeModel.removeDocument( first );
+    delete first;
+
+    QCOMPARE( rowsRemovedSpy.count(), 1 );
+    QCOMPARE( rowsRemovedSpy.at( 0 ).at( 1 ).toInt(), 0 );
+    QCOMPARE( rowsRemovedSpy.at( 0 ).at( 2 ).toInt(), 1 );
+    QCOMPARE( model.rowCount(), 1 );
+    QCOMPARE( model.feature( 0 ), c );
+    QCOMPARE( model.row( c ), 0 );
+}
+
+void PlacemarkIndexModelTest::addFeature()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setSourceModel( &treeModel );
+
+    GeoDataDocument *first = new GeoDataDocument;
+    GeoDataFolder *folder = new GeoDataFolder;
+    first->append( createPlacemark( "a", 0, 0 ) );
+    first->append( folder );
+    treeModel.addDocument( first );
+
+    GeoDataDocument *second = new GeoDataDocument;
+    GeoDataPlacemark *c = createPlacemark( "c", 0, 0 );
+    second->append( c );
+    treeModel.addDocument( second );
+
+    QSignalSpy rowsInsertedSpy( &model, SIGNAL(rowsInserted(QModelIndex,int,int)) );
+
+    GeoDataPlacemark *b = createPlacemark( "b", 0, 0 );
+    treeModel.addFeature( folder, b );
+
+    QCOMPARE( rowsInsertedSpy.count(), 1 );
+    QCOMPARE( rowsInsertedSpy.at( 0 ).at( 1 ).toInt(), 1 );
+    QCOMPARE( model.rowCount(), 3 );
+    QCOMPARE( model.feature( 1 ), b );
+    QCOMPARE( model.row( c ), 2 );
+
+    QSignalSpy rowsRemovedSpy( &model, SIGNAL(rowsRemoved(QModelIndex,int,int)) );
+
+    treeModel.removeFeature( b );
+    delete b;
+
+    QCOMPARE( rowsRemovedSpy.count(), 1 );
+    QCOMPARE( rowsRemovedSpy.at( 0 ).at( 1 ).toInt(), 1 );
+    QCOMPARE( model.rowCount(), 2 );
+    QCOMPARE( model.row( c ), 1 );
+}
+
+void PlacemarkIndexModelTest::removeFolder()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setSourceModel( &treeModel );
+
+    GeoDataDocument *document = new GeoDataDocument;
+    GeoDataFolder *folder = new GeoDataFolder;
+    GeoDataPlacemark *a = createPlacemark( "a", 0, 0 );
+    GeoDataPlacemark *d = createPlacemark( "d", 0, 0 );
+    document->append( a );
+    document->append( folder );
+    folder->append( createPlacemark( "b", 0, 0 ) );
+    folder->append( createPlacemark( "c", 0, 0 ) );
+    document->append( d );
+    treeModel.addDocument( document );
+
+    QCOMPARE( model.rowCount(), 4 );
+
+    QSignalSpy rowsRemovedSpy( &model, SIGNAL(rowsRemoved(QModelIndex,int,int)) );
+
+    treeModel.removeFeature( folder );
+    delete folder;
+
+    QCOMPARE( rowsRemovedSpy.count(), 1 );
+    QCOMPARE( rowsRemovedSpy.at( 0 ).at( 1 ).toInt(), 1 );
+    QCOMPARE( rowsRemovedSpy.at( 0 ).at( 2 ).toInt(), 2 );
+    QCOMPARE( model.rowCount(), 2 );
+    QCOMPARE( model.feature( 0 ), a );
+    QCOMPARE( model.feature( 1 ), d );
+    QCOMPARE( model.row( d ), 1 );
+}
+
+void PlacemarkIndexModelTest::setRootDocument()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setSourceModel( &treeModel );
+
+    GeoDataDocument root;
+    GeoDataDocument *document = new GeoDataDocument;
+    document->append( createPlacemark( "a", 0, 0 ) );
+    root.append( document );
+
+    QSignalSpy modelResetSpy( &model, SIGNAL(modelReset()) );
+
+    treeModel.setRootDocument( &root );
+
+    QCOMPARE( modelResetSpy.count(), 1 );
+    QCOMPARE( model.rowCount(), 1 );
+
+    treeModel.setRootDocument( 0 );
+    QCOMPARE( model.rowCount(), 0 );
+}
+
+void PlacemarkIndexModelTest::groundOverlays()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setFeatureType( GeoDataTypes::GeoDataGroundOverlayType );
+    model.setSourceModel( &treeModel );
+
+    GeoDataDocument *document = new GeoDataDocument;
+    GeoDataGroundOverlay *overlay = new GeoDataGroundOverlay;
+    document->append( createPlacemark( "a", 0, 0 ) );
+    document->append( overlay );
+    treeModel.addDocument( document );
+
+    QCOMPARE( model.rowCount(), 1 );
+    QCOMPARE( model.feature( 0 ), overlay );
+    QVERIFY( model.findPlacemarks( "a", GeoDataLatLonBox( 90, -90, 180, -180, GeoDataCoordinates::Degree ), 10 ).isEmpty() );
+}
+
+void PlacemarkIndexModelTest::findPlacemarks()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setSourceModel( &treeModel );
+
+    GeoDataDocument *document = new GeoDataDocument;
+    GeoDataPlacemark *saoPaulo = createPlacemark( QString::fromUtf8( "S\xc3\xa3o Paulo" ), -46.63, -23.55 );
+    saoPaulo->setPopularity( 12000000 );
+    GeoDataPlacemark *saoTome = createPlacemark( QString::fromUtf8( "S\xc3\xa3o Tom\xc3\xa9" ), 6.73, 0.34 );
+    saoTome->setPopularity( 70000 );
+    GeoDataPlacemark *salvador = createPlacemark( "Salvador", -38.5, -12.97 );
+    salvador->setPopularity( 2900000 );
+    GeoDataPlacemark *berlin = createPlacemark( "Berlin", 13.4, 52.5 );
+    berlin->setCountryCode( "DE" );
+    document->append( saoPaulo );
+    document->append( saoTome );
+    document->append( salvador );
+    document->append( berlin );
+    treeModel.addDocument( document );
+
+    QVector<GeoDataPlacemark*> result = model.findPlacemarks( "sao", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 2 );
+    QCOMPARE( result.at( 0 )->name(), saoPaulo->name() );
+    QCOMPARE( result.at( 1 )->name(), saoTome->name() );
+    QVERIFY( result.at( 0 ) != saoPaulo );
+    qDeleteAll( result );
+
+    result = model.findPlacemarks( "SA", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 3 );
+    QCOMPARE( result.at( 1 )->name(), salvador->name() );
+    qDeleteAll( result );
+
+    result = model.findPlacemarks( "sa", GeoDataLatLonBox(), 1 );
+    QCOMPARE( result.size(), 1 );
+    QCOMPARE( result.at( 0 )->name(), saoPaulo->name() );
+    qDeleteAll( result );
+
+    result = model.findPlacemarks( "sa", GeoDataLatLonBox( 10, -10, 10, 0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( result.size(), 1 );
+    QCOMPARE( result.at( 0 )->name(), saoTome->name() );
+    qDeleteAll( result );
+
+    result = model.findPlacemarks( "berlin (de", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 1 );
+    qDeleteAll( result );
+
+    QVERIFY( model.findPlacemarks( "x", GeoDataLatLonBox() ).isEmpty() );
+
+    treeModel.removeFeature( saoPaulo );
+    delete saoPaulo;
+
+    result = model.findPlacemarks( "sao", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 1 );
+    QCOMPARE( result.at( 0 )->name(), saoTome->name() );
+    qDeleteAll( result );
+}
+
+}
+
+void PlacemarkIndexModelTest::findRenamedPlacemarks()
+{
+    GeoDataTreeModel treeModel;
+    PlacemarkIndexModel model;
+    model.setSourceModel( &treeModel );
+
+    GeoDataDocument *document = new GeoDataDocument;
+    GeoDataPlacemark *berlin = createPlacemark( "Berlin", 13.4, 52.5 );
+    GeoDataPlacemark *bonn = createPlacemark( "Bonn", 7.1, 50.73 );
+    document->append( berlin );
+    document->append( bonn );
+    treeModel.addDocument( document );
+
+    // renamed through the tree model
+    QModelIndex const berlinIndex = treeModel.index( berlin );
+    QVERIFY( treeModel.setData( berlinIndex, "Potsdam", Qt::EditRole ) );
+    QVERIFY( model.findPlacemarks( "berlin", GeoDataLatLonBox() ).isEmpty() );
+    QVector<GeoDataPlacemark*> result = model.findPlacemarks( "pots", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 1 );
+    qDeleteAll( result );
+
+    // renamed in place and announced with dataChanged()
+    bonn->setName( "Cologne" );
+    QModelIndex const bonnIndex = treeModel.index( bonn );
+    emit treeModel.dataChanged( bonnIndex, bonnIndex );
+    QVERIFY( model.findPlacemarks( "bonn", GeoDataLatLonBox() ).isEmpty() );
+    result = model.findPlacemarks( "col", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 1 );
+    QCOMPARE( result.at( 0 )->name(), QString( "Cologne" ) );
+    qDeleteAll( result );
+    QCOMPARE( model.rowCount(), 2 );
+}
+
+QTEST_MAIN( Marble::PlacemarkIndexModelTest )
+
+#include "PlacemarkIndexModelTest.moc"
@@ -9,12 +9,17 @@
 //
 
 
+#include "GeoDataMultiTrack.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTrack.h"
 #include "GeoDataTreeModel.h"
+#include "MarblePlacemarkModel.h"
 #include "PositionProviderPlugin.h"
 #include "PositionTracking.h"
 #include "TestUtils.h"
 
 #include <QSignalSpy>
+#include <QTemporaryDir>
 
 class FakeProvider : public Marble::PositionProviderPlugin
 {
@@ -109,6 +114,13 @@ class PositionTrackingTest : public QObject
     void setPositionProviderPlugin();
 
     void clearTrack();
+
+    void maximumTrackPoints();
+    void trackJournal();
+
+ private:
+    static const GeoDataMultiTrack *currentTrack( const GeoDataTreeModel &treeModel );
+    static void followRoute( FakeProvider *provider, int count );
 };
 
 PositionTrackingTest::PositionTrackingTest()
@@ -231,6 +243,88 @@ void PositionTrackingTest::clearTrack()
     QVERIFY( tracking.isTrackEmpty() );
 }
 
+const GeoDataMultiTrack *PositionTrackingTest::currentTrack( const GeoDataTreeModel &treeModel )
+{
+    const QModelIndex indexCurrentTrack = treeModel.index( 1, 0, treeModel.index( 0, 0 ) );
+    GeoDataObject *object = qvariant_cast<GeoDataObject*>( indexCurrentTrack.data( MarblePlacemarkModel::ObjectPointerRole ) );
+    return static_cast<const GeoDataMultiTrack *>( static_cast<GeoDataPlacemark *>( object )->geometry() );
+}
+
+void PositionTrackingTest::followRoute( FakeProvider *provider, int count )
+{
+    const GeoDataAccuracy accuracy( GeoDataAccuracy::Detailed, 10.0, 22.0 );
+    const QDateTime start( QDate( 2016, 5, 1 ), QTime( 12, 0 ), Qt::UTC );
+
+    // heading east, then north after the 100th position
+    for ( int i = 0; i < count; ++i ) {
+        const GeoDataCoordinates position( qMin( i, 100 ) * 0.0001, qMax( 0, i - 100 ) * 0.0001,
+                                           0.0, GeoDataCoordinates::Degree );
+        provider->setPosition( position, accuracy, 10.0, 0.0, start.addMSecs( i * 100 ) );
+    }
+}
+
+void PositionTrackingTest::maximumTrackPoints()
+{
+    GeoDataTreeModel treeModel;
+    PositionTracking tracking( &treeModel );
+    tracking.setMaximumTrackPoints( 100 );
+    QCOMPARE( tracking.maximumTrackPoints(), 100 );
+
+    FakeProvider provider;
+    tracking.setPositionProviderPlugin( &provider );
+    provider.setStatus( PositionProviderStatusAvailable );
+
+    followRoute( &provider, 1000 );
+
+    const GeoDataTrack &track = currentTrack( treeModel )->last();
+    QVERIFY( track.size() <= 100 );
+    QVERIFY( track.lineString()->size() == track.size() );
+
+    // the start, the turn and the most recent positions are kept
+    const QList<GeoDataCoordinates> coordinates = track.coordinatesList();
+    QCOMPARE( coordinates.first(), GeoDataCoordinates( 0.0, 0.0, 0.0, GeoDataCoordinates::Degree ) );
+    QVERIFY( coordinates.contains( GeoDataCoordinates( 100 * 0.0001, 0.0, 0.0, GeoDataCoordinates::Degree ) ) );
+    for ( int i = 0; i < 50; ++i ) {
+        QCOMPARE( coordinates.at( coordinates.size() - 1 - i ),
+                  GeoDataCoordinates( 100 * 0.0001, ( 899 - i ) * 0.0001, 0.0, GeoDataCoordinates::Degree ) );
+    }
+
+    QVERIFY( tracking.length( 1.0 ) > 0.0 );
+}
+
+void PositionTrackingTest::trackJournal()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    const QString fileName = directory.path() + "/journal.bin";
+
+    {
+        GeoDataTreeModel treeModel;
+        PositionTracking tracking( &treeModel );
+        tracking.setMaximumTrackPoints( 100 );
+        tracking.setTrackJournal( fileName );
+        QCOMPARE( tracking.trackJournal(), fileName );
+
+        FakeProvider provider;
+        tracking.setPositionProviderPlugin( &provider );
+        provider.setStatus( PositionProviderStatusAvailable );
+        followRoute( &provider, 1000 );
+
+        tracking.clearTrack();
+        followRoute( &provider, 10 );
+    }
+
+    GeoDataMultiTrack tracks;
+    QVERIFY( PositionTracking::readTrackJournal( fileName, &tracks ) );
+    QCOMPARE( tracks.size(), 2 );
+    QCOMPARE( tracks.at( 0 ).size(), 1000 );
+    QCOMPARE( tracks.at( 1 ).size(), 10 );
+    QCOMPARE( tracks.at( 0 ).firstWhen(), QDateTime( QDate( 2016, 5, 1 ), QTime( 12, 0 ), Qt::UTC ) );
+    QCOMPARE( tracks.at( 0 ).coordinatesAt( 999 ), GeoDataCoordinates( 100 * 0.0001, 899 * 0.0001, 0.0, GeoDataCoordinates::Degree ) );
+
+    QVERIFY( !PositionTracking::readTrackJournal( directory.path() + "/missing.bin", &tracks ) );
+}
+
 }
 
 QTEST_MAIN( Marble::PositionTrackingTest )
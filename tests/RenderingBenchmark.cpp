@@ -0,0 +1,522 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include <QApplication>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QItemSelectionModel>
+#include <QPainter>
+#include <QPolygonF>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cmath>
+
+#include "GeoDataDocument.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTreeModel.h"
+#include "GeoPainter.h"
+#include "MarbleDirs.h"
+#include "MarbleGlobal.h"
+#include "MarbleMap.h"
+#include "MarbleModel.h"
+#include "PlacemarkLayout.h"
+#include "TextureColorizer.h"
+#include "TextureTile.h"
+#include "TileId.h"
+#include "ViewportParams.h"
+#include "VisiblePlacemark.h"
+#include "blendings/BlendingAlgorithms.h"
+#include "layers/GeometryLayer.h"
+
+Q_DECLARE_METATYPE( Marble::Projection )
+Q_DECLARE_METATYPE( Marble::MapQuality )
+
+namespace Marble
+{
+
+/**
+ * Measures the stages of rendering a map without a display.
+ *
+ * All data is generated in initTestCase(), so the benchmarks neither need
+ * installed map themes nor network access. Pass "-o results.xml,xml" to
+ * get machine readable results, the "benchmarks" target does so for all
+ * benchmarks.
+ */
+class RenderingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void textureMapping_data();
+    void textureMapping();
+
+    void colorize_data();
+    void colorize();
+
+    void geometryLayer_data();
+    void geometryLayer();
+
+    void placemarkLayout_data();
+    void placemarkLayout();
+
+    void projectLineString_data();
+    void projectLineString();
+
+    void decodeTile_data();
+    void decodeTile();
+
+    void blendTile_data();
+    void blendTile();
+
+private:
+    static QImage createTile( int x, int y, int level );
+    void writeTheme( const QString &name, bool mercator );
+
+    static void addZigZag( GeoDataLineString &lineString, int nodeCount, qreal west, qreal south );
+    static GeoDataDocument *createGeometryDocument( int count, bool polygons );
+    static GeoDataDocument *createPlacemarkDocument( int count );
+
+    typedef QPair<QString, Projection> ProjectionPair;
+    static QList<ProjectionPair> projections();
+
+    QTemporaryDir m_dataDir;
+};
+
+static const int tileSize = 256;
+static const int maximumTileLevel = 2;
+static const QSize viewportSize( 512, 512 );
+static const int viewportRadius = 300;
+
+QImage RenderingBenchmark::createTile( int x, int y, int level )
+{
+    // Some noise on top of a gradient, so that image codecs do not get
+    // away with trivially compressible data.
+    QImage tile( tileSize, tileSize, QImage::Format_RGB32 );
+    quint32 random = ( x + 1 ) * 7919 + ( y + 1 ) * 104729 + level;
+    for ( int row = 0; row < tileSize; ++row ) {
+        QRgb *line = reinterpret_cast<QRgb*>( tile.scanLine( row ) );
+        for ( int column = 0; column < tileSize; ++column ) {
+            random = random * 1103515245 + 12345;
+            int const noise = ( random >> 16 ) & 0x1f;
+            line[column] = qRgb( ( column + noise ) & 0xff, ( row + noise ) & 0xff, ( x * 64 + y * 32 + noise ) & 0xff );
+        }
+    }
+    return tile;
+}
+
+void RenderingBenchmark::writeTheme( const QString &name, bool mercator )
+{
+    QString const themeDir = m_dataDir.path() + "/maps/earth/" + name;
+    int const levelZeroColumns = mercator ? 1 : 2;
+    int const levelZeroRows = 1;
+
+    for ( int level = 0; level <= maximumTileLevel; ++level ) {
+        for ( int y = 0; y < levelZeroRows << level; ++y ) {
+            for ( int x = 0; x < levelZeroColumns << level; ++x ) {
+                QString const tilePath = mercator
+                    ? QString( "%1/%2/%3/%4.png" ).arg( themeDir ).arg( level ).arg( x ).arg( y )
+                    : QString( "%1/%2/%3/%3_%4.png" ).arg( themeDir ).arg( level )
+                      .arg( y, tileDigits, 10, QChar( '0' ) ).arg( x, tileDigits, 10, QChar( '0' ) );
+                QVERIFY( QDir().mkpath( QFileInfo( tilePath ).path() ) );
+                QVERIFY( createTile( x, y, level ).save( tilePath, "PNG" ) );
+            }
+        }
+    }
+
+    QFile dgml( themeDir + '/' + name + ".dgml" );
+    QVERIFY( dgml.open( QIODevice::WriteOnly ) );
+    dgml.write( QString(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<dgml xmlns=\"http://edu.kde.org/marble/dgml/2.0\">\n"
+        "  <document>\n"
+        "    <head>\n"
+        "      <name>%1</name>\n"
+        "      <target>earth</target>\n"
+        "      <theme>%1</theme>\n"
+        "      <visible>true</visible>\n"
+        "      <zoom><minimum>900</minimum><maximum>3500</maximum><discrete>false</discrete></zoom>\n"
+        "    </head>\n"
+        "    <map bgcolor=\"#000000\">\n"
+        "      <canvas/>\n"
+        "      <target/>\n"
+        "      <layer name=\"%1\" backend=\"texture\">\n"
+        "        <texture name=\"%1_data\">\n"
+        "          <sourcedir format=\"PNG\">earth/%1</sourcedir>\n"
+        "          <tileSize width=\"%2\" height=\"%2\"/>\n"
+        "          <storageLayout levelZeroColumns=\"%3\" levelZeroRows=\"%4\" maximumTileLevel=\"%5\" mode=\"%6\"/>\n"
+        "          <projection name=\"%7\"/>\n"
+        "        </texture>\n"
+        "      </layer>\n"
+        "    </map>\n"
+        "  </document>\n"
+        "</dgml>\n" )
+        .arg( name )
+        .arg( tileSize )
+        .arg( levelZeroColumns )
+        .arg( levelZeroRows )
+        .arg( maximumTileLevel )
+        .arg( mercator ? "OpenStreetMap" : "Marble" )
+        .arg( mercator ? "Mercator" : "Equirectangular" )
+        .toUtf8() );
+}
+
+void RenderingBenchmark::addZigZag( GeoDataLineString &lineString, int nodeCount, qreal west, qreal south )
+{
+    // A zig-zag line across a 20 by 20 degree box
+    for ( int i = 0; i < nodeCount; ++i ) {
+        qreal const lon = west + 20.0 * i / nodeCount;
+        qreal const lat = south + ( i % 2 ? 20.0 : 0.0 ) * ( i % 7 ) / 6.0;
+        lineString.append( GeoDataCoordinates( lon, lat, 0.0, GeoDataCoordinates::Degree ) );
+    }
+}
+
+GeoDataDocument *RenderingBenchmark::createGeometryDocument( int count, bool polygons )
+{
+    GeoDataDocument *document = new GeoDataDocument;
+    for ( int i = 0; i < count; ++i ) {
+        qreal const west = ( i * 37 ) % 340 - 180.0;
+        qreal const south = ( i * 17 ) % 140 - 70.0;
+        GeoDataPlacemark *placemark = new GeoDataPlacemark;
+        if ( polygons ) {
+            GeoDataPolygon *polygon = new GeoDataPolygon;
+            GeoDataLinearRing ring;
+            addZigZag( ring, 50, west, south );
+            polygon->setOuterBoundary( ring );
+            placemark->setGeometry( polygon );
+        } else {
+            GeoDataLineString *lineString = new GeoDataLineString;
+            addZigZag( *lineString, 50, west, south );
+            placemark->setGeometry( lineString );
+        }
+        document->append( placemark );
+    }
+    return document;
+}
+
+GeoDataDocument *RenderingBenchmark::createPlacemarkDocument( int count )
+{
+    GeoDataDocument *document = new GeoDataDocument;
+    for ( int i = 0; i < count; ++i ) {
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( QString( "Placemark %1" ).arg( i ) );
+        placemark->setCoordinate( ( i * 37 ) % 360 - 180.0, ( i * 17 ) % 170 - 85.0, 0.0, GeoDataCoordinates::Degree );
+        document->append( placemark );
+    }
+    return document;
+}
+
+QList<RenderingBenchmark::ProjectionPair> RenderingBenchmark::projections()
+{
+    QList<ProjectionPair> result;
+    result << qMakePair( QString( "Spherical" ), Spherical )
+           << qMakePair( QString( "Equirectangular" ), Equirectangular )
+           << qMakePair( QString( "Mercator" ), Mercator )
+           << qMakePair( QString( "Gnomonic" ), Gnomonic )
+           << qMakePair( QString( "Stereographic" ), Stereographic )
+           << qMakePair( QString( "LambertAzimuthal" ), LambertAzimuthal )
+           << qMakePair( QString( "AzimuthalEquidistant" ), AzimuthalEquidistant )
+           << qMakePair( QString( "VerticalPerspective" ), VerticalPerspective );
+    return result;
+}
+
+void RenderingBenchmark::initTestCase()
+{
+    QVERIFY( m_dataDir.isValid() );
+
+    writeTheme( "synthetic", false );
+    writeTheme( "synthetic-mercator", true );
+    QVERIFY( QDir().mkpath( m_dataDir.path() + "/plugins" ) );
+
+    // Keep installed themes, data and plugins out of the measurements
+    MarbleDirs::setMarbleDataPath( m_dataDir.path() );
+    MarbleDirs::setMarblePluginPath( m_dataDir.path() + "/plugins" );
+}
+
+void RenderingBenchmark::textureMapping_data()
+{
+    QTest::addColumn<QString>( "mapThemeId" );
+    QTest::addColumn<Projection>( "projection" );
+    QTest::addColumn<MapQuality>( "quality" );
+
+    const QString equirectTheme = "earth/synthetic/synthetic.dgml";
+    const QString mercatorTheme = "earth/synthetic-mercator/synthetic-mercator.dgml";
+
+    QList<QPair<QString, MapQuality> > qualities;
+    qualities << qMakePair( QString( "low" ), LowQuality )
+              << qMakePair( QString( "normal" ), NormalQuality )
+              << qMakePair( QString( "high" ), HighQuality );
+
+    typedef QPair<QString, MapQuality> QualityPair;
+    foreach ( const QualityPair &quality, qualities ) {
+        foreach ( const ProjectionPair &projection, projections() ) {
+            QString const name = projection.first + '/' + quality.first;
+            QTest::newRow( name.toLatin1().constData() ) << equirectTheme << projection.second << quality.second;
+        }
+
+        // Mercator tiles on a Mercator map are scaled instead of mapped
+        QString const name = "Mercator tiles/" + quality.first;
+        QTest::newRow( name.toLatin1().constData() ) << mercatorTheme << Mercator << quality.second;
+    }
+}
+
+void RenderingBenchmark::textureMapping()
+{
+    QFETCH( QString, mapThemeId );
+    QFETCH( Projection, projection );
+    QFETCH( MapQuality, quality );
+
+    MarbleMap map;
+    map.setMapThemeId( mapThemeId );
+    QCOMPARE( map.mapThemeId(), mapThemeId );
+    map.setSize( viewportSize );
+    map.setProjection( projection );
+    map.setRadius( viewportRadius );
+    map.setMapQualityForViewContext( quality, Still );
+    map.setShowBackground( false );
+
+    QImage image( map.size(), QImage::Format_ARGB32_Premultiplied );
+
+    // Moving the map between two positions makes every iteration map the
+    // whole texture again, with all tiles loaded during the first two.
+    int iteration = 0;
+    QBENCHMARK {
+        map.centerOn( iteration++ % 2 ? 1.0 : 0.0, 0.0 );
+        GeoPainter painter( &image, map.viewport(), map.mapQuality() );
+        map.paint( painter, QRect() );
+    }
+}
+
+void RenderingBenchmark::colorize_data()
+{
+    QTest::addColumn<Projection>( "projection" );
+    QTest::addColumn<MapQuality>( "quality" );
+
+    QTest::newRow( "Spherical/normal" ) << Spherical << NormalQuality;
+    QTest::newRow( "Spherical/high" ) << Spherical << HighQuality;
+    QTest::newRow( "Equirectangular/normal" ) << Equirectangular << NormalQuality;
+    QTest::newRow( "Equirectangular/high" ) << Equirectangular << HighQuality;
+    QTest::newRow( "Mercator/normal" ) << Mercator << NormalQuality;
+}
+
+void RenderingBenchmark::colorize()
+{
+    QFETCH( Projection, projection );
+    QFETCH( MapQuality, quality );
+
+    const ViewportParams viewport( projection, 0, 0, viewportRadius, viewportSize );
+
+    TextureColorizer colorizer( QString( MARBLE_SRC_DIR ) + "/data/seacolors.leg",
+                                QString( MARBLE_SRC_DIR ) + "/data/landcolors.leg" );
+    GeoDataDocument *land = createGeometryDocument( 100, true );
+    colorizer.addLandDocument( land );
+
+    // The red channel holds the elevation, as in the elevation model tiles
+    QImage elevation( viewportSize, QImage::Format_RGB32 );
+    QPainter painter( &elevation );
+    painter.drawImage( 0, 0, createTile( 0, 0, 0 ) );
+    painter.drawImage( tileSize, 0, createTile( 1, 0, 0 ) );
+    painter.drawImage( 0, tileSize, createTile( 0, 1, 0 ) );
+    painter.drawImage( tileSize, tileSize, createTile( 1, 1, 0 ) );
+    painter.end();
+
+    QBENCHMARK {
+        QImage image = elevation;
+        colorizer.colorize( &image, &viewport, quality );
+    }
+
+    delete land;
+}
+
+void RenderingBenchmark::geometryLayer_data()
+{
+    QTest::addColumn<int>( "count" );
+    QTest::addColumn<bool>( "polygons" );
+
+    QTest::newRow( "1k line strings" ) << 1000 << false;
+    QTest::newRow( "10k line strings" ) << 10000 << false;
+    QTest::newRow( "1k polygons" ) << 1000 << true;
+    QTest::newRow( "10k polygons" ) << 10000 << true;
+}
+
+void RenderingBenchmark::geometryLayer()
+{
+    QFETCH( int, count );
+    QFETCH( bool, polygons );
+
+    ViewportParams viewport( Spherical, 0, 0, viewportRadius, viewportSize );
+
+    GeoDataTreeModel model;
+    GeometryLayer layer( &model );
+    GeoDataDocument *document = createGeometryDocument( count, polygons );
+    model.addDocument( document );
+
+    QImage image( viewportSize, QImage::Format_ARGB32_Premultiplied );
+
+    QBENCHMARK {
+        GeoPainter painter( &image, &viewport, NormalQuality );
+        layer.render( &painter, &viewport );
+    }
+
+    model.removeDocument( document );
+    delete document;
+}
+
+void RenderingBenchmark::placemarkLayout_data()
+{
+    QTest::addColumn<int>( "count" );
+
+    QTest::newRow( "1k" ) << 1000;
+    QTest::newRow( "10k" ) << 10000;
+    QTest::newRow( "100k" ) << 100000;
+}
+
+void RenderingBenchmark::placemarkLayout()
+{
+    QFETCH( int, count );
+
+    const ViewportParams viewport( Spherical, 0, 0, viewportRadius, viewportSize );
+
+    MarbleModel model;
+    GeoDataDocument *document = createPlacemarkDocument( count );
+    model.treeModel()->addDocument( document );
+
+    QItemSelectionModel selectionModel( model.placemarkModel() );
+    PlacemarkLayout layout( model.placemarkModel(), &selectionModel, model.clock() );
+
+    QVector<VisiblePlacemark *> placemarks;
+    QBENCHMARK {
+        placemarks = layout.generateLayout( &viewport );
+    }
+    QVERIFY( !placemarks.isEmpty() );
+
+    model.treeModel()->removeDocument( document );
+    delete document;
+}
+
+void RenderingBenchmark::projectLineString_data()
+{
+    QTest::addColumn<Projection>( "projection" );
+    QTest::addColumn<int>( "nodeCount" );
+
+    foreach ( int nodeCount, QList<int>() << 10000 << 100000 ) {
+        foreach ( const ProjectionPair &projection, projections() ) {
+            QString const name = projection.first + '/' + QString::number( nodeCount / 1000 ) + 'k';
+            QTest::newRow( name.toLatin1().constData() ) << projection.second << nodeCount;
+        }
+    }
+}
+
+void RenderingBenchmark::projectLineString()
+{
+    QFETCH( Projection, projection );
+    QFETCH( int, nodeCount );
+
+    const ViewportParams viewport( projection, 0, 0, viewportRadius, viewportSize );
+
+    // A line around the whole globe, partially on the far side
+    GeoDataLineString lineString;
+    for ( int i = 0; i < nodeCount; ++i ) {
+        qreal const lon = -180.0 + 360.0 * i / nodeCount;
+        qreal const lat = 60.0 * sin( 12.0 * M_PI * i / nodeCount );
+        lineString.append( GeoDataCoordinates( lon, lat, 0.0, GeoDataCoordinates::Degree ) );
+    }
+
+    QVector<QPolygonF*> polygons;
+    QBENCHMARK {
+        qDeleteAll( polygons );
+        polygons.clear();
+        viewport.screenCoordinates( lineString, polygons );
+    }
+    QVERIFY( !polygons.isEmpty() );
+    qDeleteAll( polygons );
+}
+
+void RenderingBenchmark::decodeTile_data()
+{
+    QTest::addColumn<QByteArray>( "data" );
+
+    foreach ( const char *format, QList<const char *>() << "PNG" << "JPG" ) {
+        QByteArray data;
+        QBuffer buffer( &data );
+        buffer.open( QIODevice::WriteOnly );
+        if ( createTile( 0, 0, 0 ).save( &buffer, format ) ) {
+            QTest::newRow( format ) << data;
+        }
+    }
+}
+
+void RenderingBenchmark::decodeTile()
+{
+    QFETCH( QByteArray, data );
+
+    QImage image;
+    QBENCHMARK {
+        image = QImage::fromData( data );
+    }
+    QCOMPARE( image.size(), QSize( tileSize, tileSize ) );
+}
+
+void RenderingBenchmark::blendTile_data()
+{
+    QTest::addColumn<QString>( "blending" );
+
+    QTest::newRow( "Overpaint" ) << "OverpaintBlending";
+    QTest::newRow( "Multiply" ) << "MultiplyBlending";
+    QTest::newRow( "Allanon" ) << "AllanonBlending";
+    QTest::newRow( "Overlay" ) << "OverlayBlending";
+}
+
+void RenderingBenchmark::blendTile()
+{
+    QFETCH( QString, blending );
+
+    QScopedPointer<Blending> algorithm;
+    if ( blending == "OverpaintBlending" ) {
+        algorithm.reset( new OverpaintBlending );
+    } else if ( blending == "MultiplyBlending" ) {
+        algorithm.reset( new MultiplyBlending );
+    } else if ( blending == "AllanonBlending" ) {
+        algorithm.reset( new AllanonBlending );
+    } else {
+        algorithm.reset( new OverlayBlending );
+    }
+
+    const QImage bottom = createTile( 0, 0, 0 ).convertToFormat( QImage::Format_ARGB32_Premultiplied );
+    const TextureTile top( TileId(), createTile( 1, 0, 0 ), algorithm.data() );
+
+    QBENCHMARK {
+        QImage image = bottom;
+        algorithm->blend( &image, &top );
+    }
+}
+
+}
+
+int main( int argc, char *argv[] )
+{
+    // Everything is rendered into images, so do not require a display
+    if ( qEnvironmentVariableIsEmpty( "QT_QPA_PLATFORM" ) ) {
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+    }
+
+    QApplication app( argc, argv );
+    Marble::RenderingBenchmark benchmark;
+    return QTest::qExec( &benchmark, argc, argv );
+}
+
+#include "RenderingBenchmark.moc"
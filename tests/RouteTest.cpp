@@ -0,0 +1,174 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "routing/Route.h"
+#include "MarbleMath.h"
+#include "TestUtils.h"
+
+namespace Marble
+{
+
+class RouteTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void currentSegment_data();
+    void currentSegment();
+    void currentSegmentAtDateLine();
+    void closestPathIndex_data();
+    void closestPathIndex();
+
+private:
+    static Route serpentine();
+    static qreal closestDistance( const Route &route, const GeoDataCoordinates &position );
+};
+
+Route RouteTest::serpentine()
+{
+    // 20 rows of 10 segments each, about 200 m apart, driven back and forth
+    Route route;
+    for ( int row = 0; row < 20; ++row ) {
+        for ( int column = 0; column < 10; ++column ) {
+            GeoDataLineString path;
+            for ( int i = 0; i <= 4; ++i ) {
+                qreal const x = row % 2 == 0 ? column * 4 + i : 40 - column * 4 - i;
+                path << GeoDataCoordinates( 8.0 + x * 0.001, 49.0 + row * 0.002, 0.0, GeoDataCoordinates::Degree );
+            }
+            RouteSegment segment;
+            segment.setPath( path );
+            route.addRouteSegment( segment );
+        }
+    }
+    return route;
+}
+
+qreal RouteTest::closestDistance( const Route &route, const GeoDataCoordinates &position )
+{
+    qreal result = -1.0;
+    GeoDataCoordinates closest, interpolated;
+    for ( int i = 0; i < route.size(); ++i ) {
+        qreal const distance = route.at( i ).distanceTo( position, closest, interpolated );
+        if ( result < 0.0 || distance < result ) {
+            result = distance;
+        }
+    }
+    return result;
+}
+
+void RouteTest::currentSegment_data()
+{
+    QTest::addColumn<qreal>( "offset" );
+
+    addRow() << 0.0;
+    addRow() << 0.0008;  // between the rows
+    addRow() << 0.05;    // far off the route
+}
+
+void RouteTest::currentSegment()
+{
+    QFETCH( qreal, offset );
+
+    Route route = serpentine();
+    GeoDataCoordinates closest, interpolated;
+
+    // move along each row, then jump to the start of the next one
+    for ( int step = 0; step < 400; ++step ) {
+        qreal const lon = 8.0 + ( step % 41 ) * 0.001 + 0.0003;
+        qreal const lat = 49.0 + ( step / 41 ) * 0.002 + offset;
+        GeoDataCoordinates const position( lon, lat, 0.0, GeoDataCoordinates::Degree );
+        route.setPosition( position );
+
+        qreal const expected = closestDistance( route, position );
+        qreal const distance = route.currentSegment().distanceTo( position, closest, interpolated );
+        QCOMPARE( distance, expected );
+    }
+}
+
+void RouteTest::currentSegmentAtDateLine()
+{
+    // Short segments north of the route come first, so the segment across the
+    // date line is neither the first one nor in the window following it. It is
+    // followed by long segments on either side of the date line.
+    Route route;
+    QList<GeoDataLineString> paths;
+    for ( int i = 0; i < 5; ++i ) {
+        GeoDataLineString filler;
+        filler << GeoDataCoordinates( 179.9 + i * 0.01, 10.02, 0.0, GeoDataCoordinates::Degree )
+               << GeoDataCoordinates( 179.91 + i * 0.01, 10.02, 0.0, GeoDataCoordinates::Degree );
+        paths << filler;
+    }
+    GeoDataLineString west;
+    west << GeoDataCoordinates( 178.0, 10.0, 0.0, GeoDataCoordinates::Degree )
+         << GeoDataCoordinates( 179.99, 10.0, 0.0, GeoDataCoordinates::Degree );
+    GeoDataLineString across;
+    across << GeoDataCoordinates( 179.99, 10.0, 0.0, GeoDataCoordinates::Degree )
+           << GeoDataCoordinates( -179.99, 10.0, 0.0, GeoDataCoordinates::Degree );
+    GeoDataLineString east;
+    east << GeoDataCoordinates( -179.99, 10.0, 0.0, GeoDataCoordinates::Degree )
+         << GeoDataCoordinates( -178.0, 10.0, 0.0, GeoDataCoordinates::Degree );
+    paths << west << across << east;
+    foreach ( const GeoDataLineString &path, paths ) {
+        RouteSegment segment;
+        segment.setPath( path );
+        route.addRouteSegment( segment );
+    }
+
+    GeoDataCoordinates closest, interpolated;
+    for ( int step = 0; step < 40; ++step ) {
+        qreal const lon = GeoDataCoordinates::normalizeLon( 179.9 + step * 0.005, GeoDataCoordinates::Degree );
+        GeoDataCoordinates const position( lon, 10.001, 0.0, GeoDataCoordinates::Degree );
+        route.setPosition( position );
+
+        qreal const expected = closestDistance( route, position );
+        qreal const distance = route.currentSegment().distanceTo( position, closest, interpolated );
+        QCOMPARE( distance, expected );
+    }
+}
+
+void RouteTest::closestPathIndex_data()
+{
+    QTest::addColumn<qreal>( "offset" );
+
+    addRow() << 0.0;
+    addRow() << 0.0008;  // between the rows
+    addRow() << 0.05;    // far off the route
+}
+
+void RouteTest::closestPathIndex()
+{
+    QFETCH( qreal, offset );
+
+    Route const route = serpentine();
+    QCOMPARE( Route().closestPathIndex( GeoDataCoordinates( 0.0, 0.0 ) ), -1 );
+
+    for ( int step = 0; step < 400; step += 7 ) {
+        qreal const lon = 8.0 + ( step % 41 ) * 0.001 + 0.0003;
+        qreal const lat = 49.0 + ( step / 41 ) * 0.002 + offset;
+        GeoDataCoordinates const position( lon, lat, 0.0, GeoDataCoordinates::Degree );
+
+        int expected = -1;
+        qreal minDistance = -1.0;
+        for ( int i = 0; i < route.path().size(); ++i ) {
+            qreal const distance = distanceSphere( route.path()[i], position );
+            if ( minDistance < 0.0 || distance < minDistance ) {
+                minDistance = distance;
+                expected = i;
+            }
+        }
+        QCOMPARE( route.closestPathIndex( position ), expected );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::RouteTest )
+
+#include "RouteTest.moc"
@@ -0,0 +1,389 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "RoutingGraph.h"
+#include "RoutingGraphBuilder.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleGlobal.h"
+#include "MarbleMath.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include <cstring>
+
+namespace Marble
+{
+
+class RoutingGraphTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void nearestNode();
+    void shortcuts();
+    void routes();
+    void unreachable();
+    void saveLoad();
+
+private:
+    typedef QPair<quint32, quint32> Arc;
+
+    static const int rows = 6;
+    static const int columns = 8;
+
+    static GeoDataCoordinates position( int row, int column );
+    static quint32 weight( const GeoDataCoordinates &from, const GeoDataCoordinates &to );
+    static GeoDataPlacemark *createWay( const QVector<GeoDataCoordinates> &nodes, const QString &name,
+                                        const QString &highway, const QString &oneway = QString() );
+    void addWay( GeoDataDocument *document, const QVector<GeoDataCoordinates> &nodes, const QString &name,
+                 const QString &oneway = QString() );
+    quint32 dijkstra( quint32 source, quint32 target ) const;
+
+    QTemporaryDir m_directory;
+    QString m_fileName;
+    RoutingGraph m_graph;
+
+    QVector<GeoDataCoordinates> m_positions;
+    QVector<QPair<GeoDataCoordinates, GeoDataCoordinates> > m_arcPositions;
+
+    /// the road edges of the grid by node ids of m_graph, for the plain Dijkstra reference
+    QHash<Arc, quint32> m_weights;
+    QHash<quint32, QVector<quint32> > m_adjacency;
+};
+
+GeoDataCoordinates RoutingGraphTest::position( int row, int column )
+{
+    // about 200 m apart, the grid spans several cells of RoutingGraph
+    return GeoDataCoordinates( 8.4 + column * 0.003 + ( row % 2 ) * 0.0004,
+                               49.0 + row * 0.002 + ( column % 3 ) * 0.0003, 0.0, GeoDataCoordinates::Degree );
+}
+
+quint32 RoutingGraphTest::weight( const GeoDataCoordinates &from, const GeoDataCoordinates &to )
+{
+    // the weights of the shortest method, see RoutingGraphBuilder::addDocument()
+    return qMax( 1, qRound( distanceSphere( from, to ) * EARTH_RADIUS * 10.0 ) );
+}
+
+GeoDataPlacemark *RoutingGraphTest::createWay( const QVector<GeoDataCoordinates> &nodes, const QString &name,
+                                               const QString &highway, const QString &oneway )
+{
+    GeoDataLineString *lineString = new GeoDataLineString;
+    foreach ( const GeoDataCoordinates &node, nodes ) {
+        lineString->append( node );
+    }
+
+    OsmPlacemarkData osmData;
+    osmData.addTag( "highway", highway );
+    osmData.addTag( "name", name );
+    if ( !oneway.isEmpty() ) {
+        osmData.addTag( "oneway", oneway );
+    }
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( name );
+    placemark->setGeometry( lineString );
+    placemark->setOsmData( osmData );
+    return placemark;
+}
+
+void RoutingGraphTest::addWay( GeoDataDocument *document, const QVector<GeoDataCoordinates> &nodes,
+                               const QString &name, const QString &oneway )
+{
+    document->append( createWay( nodes, name, "residential", oneway ) );
+
+    for ( int i = 1; i < nodes.size(); ++i ) {
+        QPair<GeoDataCoordinates, GeoDataCoordinates> const forward( nodes[i-1], nodes[i] );
+        QPair<GeoDataCoordinates, GeoDataCoordinates> const backward( nodes[i], nodes[i-1] );
+        if ( oneway != "-1" ) {
+            m_arcPositions << forward;
+        }
+        if ( oneway != "yes" ) {
+            m_arcPositions << backward;
+        }
+    }
+}
+
+quint32 RoutingGraphTest::dijkstra( quint32 source, quint32 target ) const
+{
+    typedef QPair<quint32, quint32> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+    QHash<quint32, quint32> distances;
+    distances[source] = 0;
+    queue.push( Entry( 0, source ) );
+
+    while ( !queue.empty() ) {
+        Entry const entry = queue.top();
+        queue.pop();
+        if ( entry.second == target ) {
+            return entry.first;
+        }
+        if ( entry.first > distances.value( entry.second ) ) {
+            continue;
+        }
+
+        foreach ( quint32 next, m_adjacency.value( entry.second ) ) {
+            quint32 const distance = entry.first + m_weights.value( Arc( entry.second, next ) );
+            if ( !distances.contains( next ) || distance < distances[next] ) {
+                distances[next] = distance;
+                queue.push( Entry( distance, next ) );
+            }
+        }
+    }
+
+    return std::numeric_limits<quint32>::max();
+}
+
+void RoutingGraphTest::initTestCase()
+{
+    QVERIFY( m_directory.isValid() );
+    m_fileName = m_directory.path() + "/motorcar-shortest.mrch";
+
+    GeoDataDocument document;
+    for ( int row = 0; row < rows; ++row ) {
+        QVector<GeoDataCoordinates> nodes;
+        for ( int column = 0; column < columns; ++column ) {
+            nodes << position( row, column );
+        }
+        // two one-way streets in opposite directions
+        QString const oneway = row == 1 ? "yes" : row == 4 ? "-1" : QString();
+        addWay( &document, nodes, QString( "Row %1" ).arg( row ), oneway );
+    }
+    for ( int column = 0; column < columns; ++column ) {
+        QVector<GeoDataCoordinates> nodes;
+        for ( int row = 0; row < rows; ++row ) {
+            nodes << position( row, column );
+        }
+        addWay( &document, nodes, QString( "Column %1" ).arg( column ), column == 5 ? "yes" : QString() );
+    }
+
+    // not accessible by car, and a separate one-way island
+    document.append( createWay( QVector<GeoDataCoordinates>() << position( 0, 0 ) << position( 5, 7 ), "Footpath", "footway" ) );
+    QVector<GeoDataCoordinates> island;
+    island << GeoDataCoordinates( 8.45, 49.02, 0.0, GeoDataCoordinates::Degree )
+           << GeoDataCoordinates( 8.452, 49.02, 0.0, GeoDataCoordinates::Degree );
+    document.append( createWay( island, "Island", "service", "yes" ) );
+
+    RoutingGraphBuilder builder( "motorcar", "shortest" );
+    builder.addDocument( &document );
+    QCOMPARE( builder.nodeCount(), rows * columns + 2 );
+    builder.contract();
+    QVERIFY( builder.save( m_fileName ) );
+
+    QVERIFY( m_graph.load( m_fileName ) );
+    QCOMPARE( int( m_graph.nodeCount() ), rows * columns + 2 );
+
+    for ( int row = 0; row < rows; ++row ) {
+        for ( int column = 0; column < columns; ++column ) {
+            m_positions << position( row, column );
+        }
+    }
+
+    typedef QPair<GeoDataCoordinates, GeoDataCoordinates> Positions;
+    foreach ( const Positions &arc, m_arcPositions ) {
+        quint32 const from = m_graph.nearestNode( arc.first );
+        quint32 const to = m_graph.nearestNode( arc.second );
+        QVERIFY( from != RoutingGraph::invalidNode && to != RoutingGraph::invalidNode );
+        m_weights.insert( Arc( from, to ), weight( arc.first, arc.second ) );
+        m_adjacency[from].append( to );
+    }
+}
+
+void RoutingGraphTest::nearestNode()
+{
+    QSet<quint32> nodes;
+    foreach ( const GeoDataCoordinates &position, m_positions ) {
+        quint32 const node = m_graph.nearestNode( position );
+        QVERIFY( node < m_graph.nodeCount() );
+        QVERIFY( qAbs( m_graph.coordinates( node ).longitude() - position.longitude() ) < 1.0e-8 );
+        QVERIFY( qAbs( m_graph.coordinates( node ).latitude() - position.latitude() ) < 1.0e-8 );
+        nodes << node;
+    }
+    QCOMPARE( nodes.size(), m_positions.size() );
+
+    // slightly off a node, also across a cell border
+    GeoDataCoordinates const node = position( 2, 3 );
+    GeoDataCoordinates const offset( node.longitude( GeoDataCoordinates::Degree ) + 0.0004,
+                                     node.latitude( GeoDataCoordinates::Degree ) - 0.0003, 0.0, GeoDataCoordinates::Degree );
+    QCOMPARE( m_graph.nearestNode( offset ), m_graph.nearestNode( node ) );
+
+    // junctions
+    QVERIFY( m_graph.isJunction( m_graph.nearestNode( position( 2, 3 ) ) ) );
+    QVERIFY( !m_graph.isJunction( m_graph.nearestNode( position( 5, 0 ) ) ) );
+
+    // nothing within a few kilometers
+    QCOMPARE( m_graph.nearestNode( GeoDataCoordinates( 8.6, 49.0, 0.0, GeoDataCoordinates::Degree ) ), RoutingGraph::invalidNode );
+}
+
+void RoutingGraphTest::shortcuts()
+{
+    // contracting the inner nodes of a single road needs shortcuts between their neighbors
+    GeoDataDocument document;
+    QVector<GeoDataCoordinates> nodes;
+    for ( int i = 0; i < 10; ++i ) {
+        nodes << GeoDataCoordinates( 8.5 + i * 0.001, 49.1, 0.0, GeoDataCoordinates::Degree );
+    }
+    document.append( createWay( nodes, "Long Road", "primary" ) );
+
+    RoutingGraphBuilder builder( "motorcar", "fastest" );
+    builder.addDocument( &document );
+    builder.contract();
+    QVERIFY( builder.edgeCount() > nodes.size() - 1 );
+
+    QString const fileName = m_directory.path() + "/road.mrch";
+    QVERIFY( builder.save( fileName ) );
+    RoutingGraph graph;
+    QVERIFY( graph.load( fileName ) );
+
+    quint32 const source = graph.nearestNode( nodes.first() );
+    quint32 const target = graph.nearestNode( nodes.last() );
+    QVector<RoutingGraph::RouteEdge> route;
+    QVERIFY( graph.route( source, target, &route ) );
+
+    // the shortcuts are unpacked into the road edges, in driving order
+    QCOMPARE( route.size(), nodes.size() - 1 );
+    for ( int i = 0; i < route.size(); ++i ) {
+        QCOMPARE( route[i].edge->middle, RoutingGraph::invalidNode );
+        QCOMPARE( route[i].from, graph.nearestNode( nodes[i] ) );
+        QCOMPARE( route[i].to, graph.nearestNode( nodes[i+1] ) );
+        QCOMPARE( graph.string( route[i].edge->name ), QString( "Long Road" ) );
+        QCOMPARE( graph.string( route[i].edge->type ), QString( "primary" ) );
+        QCOMPARE( int( route[i].edge->speed ), 80 );
+    }
+}
+
+void RoutingGraphTest::routes()
+{
+    foreach ( const GeoDataCoordinates &from, m_positions ) {
+        foreach ( const GeoDataCoordinates &to, m_positions ) {
+            quint32 const source = m_graph.nearestNode( from );
+            quint32 const target = m_graph.nearestNode( to );
+            quint32 const expected = dijkstra( source, target );
+
+            QVector<RoutingGraph::RouteEdge> route;
+            QVERIFY( m_graph.route( source, target, &route ) );
+
+            quint32 length = 0;
+            quint32 node = source;
+            foreach ( const RoutingGraph::RouteEdge &step, route ) {
+                // a connected chain of road edges in their allowed direction
+                QCOMPARE( step.from, node );
+                QCOMPARE( step.edge->middle, RoutingGraph::invalidNode );
+                QVERIFY( m_weights.contains( Arc( step.from, step.to ) ) );
+                QCOMPARE( step.edge->weight, m_weights.value( Arc( step.from, step.to ) ) );
+                length += step.edge->weight;
+                node = step.to;
+            }
+            QCOMPARE( node, target );
+            QCOMPARE( length, expected );
+        }
+    }
+}
+
+void RoutingGraphTest::unreachable()
+{
+    quint32 const grid = m_graph.nearestNode( position( 0, 0 ) );
+    quint32 const start = m_graph.nearestNode( GeoDataCoordinates( 8.45, 49.02, 0.0, GeoDataCoordinates::Degree ) );
+    quint32 const end = m_graph.nearestNode( GeoDataCoordinates( 8.452, 49.02, 0.0, GeoDataCoordinates::Degree ) );
+    QVERIFY( start != grid && end != grid && start != end );
+
+    QVector<RoutingGraph::RouteEdge> route;
+    QVERIFY( m_graph.route( start, end, &route ) );
+    QCOMPARE( route.size(), 1 );
+
+    route.clear();
+    QVERIFY( !m_graph.route( end, start, &route ) );
+    QVERIFY( !m_graph.route( grid, start, &route ) );
+    QVERIFY( !m_graph.route( grid, m_graph.nodeCount(), &route ) );
+    QVERIFY( route.isEmpty() );
+}
+
+void RoutingGraphTest::saveLoad()
+{
+    RoutingGraph graph;
+    QVERIFY( graph.load( m_fileName ) );
+    QCOMPARE( graph.nodeCount(), m_graph.nodeCount() );
+    for ( quint32 i = 0; i < graph.nodeCount(); ++i ) {
+        QCOMPARE( graph.coordinates( i ), m_graph.coordinates( i ) );
+        QCOMPARE( graph.isJunction( i ), m_graph.isJunction( i ) );
+    }
+
+    QVector<RoutingGraph::RouteEdge> route;
+    QVERIFY( graph.route( graph.nearestNode( position( 0, 0 ) ), graph.nearestNode( position( 0, 2 ) ), &route ) );
+    QCOMPARE( route.size(), 2 );
+    QCOMPARE( graph.string( route.first().edge->name ), QString( "Row 0" ) );
+    QCOMPARE( graph.string( route.first().edge->type ), QString( "residential" ) );
+    QVERIFY( graph.string( 1000 ).isEmpty() );
+
+    // truncated files and files of other versions are rejected
+    QFile file( m_fileName );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QByteArray const data = file.readAll();
+    file.close();
+
+    QString const truncatedName = m_directory.path() + "/truncated.mrch";
+    QFile truncated( truncatedName );
+    QVERIFY( truncated.open( QIODevice::WriteOnly ) );
+    truncated.write( data.left( data.size() - 4 ) );
+    truncated.close();
+    RoutingGraph corrupt;
+    QVERIFY( !corrupt.load( truncatedName ) );
+    QCOMPARE( corrupt.nodeCount(), quint32( 0 ) );
+
+    QString const versionName = m_directory.path() + "/version.mrch";
+    QFile version( versionName );
+    QVERIFY( version.open( QIODevice::WriteOnly ) );
+    QByteArray changed = data;
+    changed[4] = char( RoutingGraph::fileVersion + 1 );
+    version.write( changed );
+    version.close();
+    RoutingGraph outdated;
+    QVERIFY( !outdated.load( versionName ) );
+
+    // as are files whose edges point past the nodes
+    RoutingGraph::Header header;
+    memcpy( &header, data.constData(), sizeof( header ) );
+    QVERIFY( header.edgeCount > 0 );
+    int const edgesOffset = sizeof( header ) + header.nodeCount * sizeof( RoutingGraph::Node )
+                            + ( header.nodeCount + 1 ) * sizeof( quint32 );
+    QString const targetName = m_directory.path() + "/target.mrch";
+    QFile target( targetName );
+    QVERIFY( target.open( QIODevice::WriteOnly ) );
+    changed = data;
+    quint32 const invalidTarget = header.nodeCount;
+    changed.replace( edgesOffset, sizeof( quint32 ), reinterpret_cast<const char*>( &invalidTarget ), sizeof( quint32 ) );
+    target.write( changed );
+    target.close();
+    RoutingGraph broken;
+    QVERIFY( !broken.load( targetName ) );
+    QCOMPARE( broken.nodeCount(), quint32( 0 ) );
+
+    RoutingGraph missing;
+    QVERIFY( !missing.load( m_directory.path() + "/missing.mrch" ) );
+}
+
+}
+
+QTEST_MAIN( Marble::RoutingGraphTest )
+
+#include "RoutingGraphTest.moc"
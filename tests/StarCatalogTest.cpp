@@ -0,0 +1,146 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "StarCatalog.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+#include <qmath.h>
+
+namespace Marble
+{
+
+class StarCatalogTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void load();
+    void binsContainVisibleStars_data();
+    void binsContainVisibleStars();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_fileName;
+    int m_starCount;
+};
+
+void StarCatalogTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+    m_fileName = m_dir.path() + "/stars.dat";
+
+    QFile file( m_fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QDataStream out( &file );
+    out << quint32( 0x73746172 ) << qint32( 4 );
+
+    // stars evenly distributed over the sky, poles and the origin of the
+    // right ascension included
+    qsrand( 42 );
+    m_starCount = 5000;
+    for ( int i = 0; i < m_starCount; ++i ) {
+        double ra = 2 * M_PI * qrand() / ( double( RAND_MAX ) + 1 );
+        double de = asin( 2.0 * qrand() / RAND_MAX - 1.0 );
+        if ( i < 4 ) {
+            ra = i * M_PI / 2;
+            de = i % 2 == 0 ? M_PI / 2 : -M_PI / 2;
+        }
+        double const mag = -1.5 + 8.0 * qrand() / RAND_MAX;
+        out << 1000 + i << ra << de << mag << i % 7;
+    }
+}
+
+void StarCatalogTest::load()
+{
+    StarCatalog const catalog = StarCatalog::load( m_fileName );
+    QVERIFY( !catalog.isEmpty() );
+    QCOMPARE( catalog.index( 999 ), -1 );
+
+    QSet<int> indices;
+    for ( int id = 1000; id < 1000 + m_starCount; ++id ) {
+        int const index = catalog.index( id );
+        QVERIFY( index >= 0 && index < m_starCount );
+        indices << index;
+    }
+    QCOMPARE( indices.size(), m_starCount );
+    QCOMPARE( catalog.colorId( catalog.index( 1012 ) ), 12 % 7 );
+}
+
+void StarCatalogTest::binsContainVisibleStars_data()
+{
+    QTest::addColumn<qreal>( "lon" );
+    QTest::addColumn<qreal>( "lat" );
+    QTest::addColumn<qreal>( "radius" );
+    QTest::addColumn<qreal>( "magnitudeLimit" );
+
+    QTest::newRow( "equator" ) << 1.0 << 0.0 << 0.3 << 6.5;
+    QTest::newRow( "origin" ) << 0.0 << 0.1 << 0.5 << 6.5;
+    QTest::newRow( "north pole" ) << 0.5 << M_PI / 2 << 0.4 << 6.5;
+    QTest::newRow( "south pole" ) << 2.0 << -1.5 << 0.2 << 4.0;
+    QTest::newRow( "bright" ) << 4.0 << 0.7 << 1.2 << 1.0;
+    QTest::newRow( "tiny" ) << 3.0 << -0.4 << 0.01 << 6.5;
+    QTest::newRow( "hemisphere" ) << 5.0 << 0.2 << M_PI / 2 << 6.5;
+    QTest::newRow( "sky" ) << 0.0 << 0.0 << M_PI << 10.0;
+}
+
+void StarCatalogTest::binsContainVisibleStars()
+{
+    QFETCH( qreal, lon );
+    QFETCH( qreal, lat );
+    QFETCH( qreal, radius );
+    QFETCH( qreal, magnitudeLimit );
+
+    StarCatalog const catalog = StarCatalog::load( m_fileName );
+    Quaternion const axis = Quaternion::fromSpherical( lon, lat );
+
+    // the stars in the bins, up to the magnitude limit
+    QSet<int> found;
+    foreach ( int bin, catalog.bins( axis, radius ) ) {
+        int const end = catalog.binEnd( bin, magnitudeLimit );
+        QVERIFY( catalog.binBegin( bin ) <= end );
+        for ( int i = catalog.binBegin( bin ); i < end; ++i ) {
+            QVERIFY( catalog.magnitude( i ) < magnitudeLimit );
+            QVERIFY( !found.contains( i ) );
+            found << i;
+        }
+        if ( end < catalog.binBegin( bin + 1 ) ) {
+            QVERIFY( catalog.magnitude( end ) >= magnitudeLimit );
+        }
+    }
+
+    // all stars within the radius and the magnitude limit
+    int visible = 0;
+    for ( int i = 0; i < m_starCount; ++i ) {
+        Quaternion const star = catalog.quaternion( i );
+        qreal const distance = star.v[Q_X] * axis.v[Q_X] + star.v[Q_Y] * axis.v[Q_Y] + star.v[Q_Z] * axis.v[Q_Z];
+        if ( distance >= cos( radius ) && catalog.magnitude( i ) < magnitudeLimit ) {
+            QVERIFY2( found.contains( i ), qPrintable( QString( "star %1 is missing" ).arg( i ) ) );
+            ++visible;
+        }
+    }
+
+    QVERIFY( found.size() >= visible );
+    if ( radius >= M_PI ) {
+        QCOMPARE( visible, m_starCount );
+        QCOMPARE( found.size(), m_starCount );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::StarCatalogTest )
+
+#include "StarCatalogTest.moc"
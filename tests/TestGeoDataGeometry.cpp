@@ -26,6 +26,9 @@ private Q_SLOTS:
     void deleteAndDetachTest1();
     void deleteAndDetachTest2();
     void deleteAndDetachTest3();
+    void significantNodes();
+    void significantNodesRing();
+    void significantNodesDetail();
 };
 
 void TestGeoDataGeometry::downcastPointTest_data()
@@ -85,6 +88,76 @@ void TestGeoDataGeometry::deleteAndDetachTest3()
     line2 << GeoDataCoordinates();
 }
 
+void TestGeoDataGeometry::significantNodes()
+{
+    // a straight line with a single spike in the middle
+    GeoDataLineString line;
+    for ( int i = 0; i <= 100; ++i ) {
+        line << GeoDataCoordinates( i * 0.1, i == 50 ? 0.5 : 0.0, 0.0, GeoDataCoordinates::Degree );
+    }
+
+    // level 1 is coarser than the spike, level 2 resolves it
+    QCOMPARE( line.significantNodes( 1 ), QVector<int>() << 0 << 100 );
+    QCOMPARE( line.significantNodes( 2 ), QVector<int>() << 0 << 49 << 50 << 51 << 100 );
+
+    // the collinear nodes are not needed at any level but the finest
+    QCOMPARE( line.significantNodes( 16 ), QVector<int>() << 0 << 49 << 50 << 51 << 100 );
+    QVERIFY( line.significantNodes( 17 ).isEmpty() );
+
+    // the nodes of a coarser level are always part of the finer ones
+    for ( int level = 1; level < 17; ++level ) {
+        const QVector<int> nodes = line.significantNodes( level );
+        const QVector<int> finer = line.significantNodes( level + 1 );
+        foreach ( int node, nodes ) {
+            QVERIFY( finer.isEmpty() || finer.contains( node ) );
+        }
+    }
+
+    // changes invalidate the cached levels
+    line << GeoDataCoordinates( 10.0, 5.0, 0.0, GeoDataCoordinates::Degree );
+    QVERIFY( line.significantNodes( 5 ).contains( 101 ) );
+    QVERIFY( line.significantNodes( 5 ).contains( 100 ) );
+}
+
+void TestGeoDataGeometry::significantNodesRing()
+{
+    // a densely sampled square
+    GeoDataLinearRing ring;
+    for ( int i = 0; i < 10; ++i ) {
+        ring << GeoDataCoordinates( i, 0.0, 0.0, GeoDataCoordinates::Degree );
+    }
+    for ( int i = 0; i < 10; ++i ) {
+        ring << GeoDataCoordinates( 10.0, i, 0.0, GeoDataCoordinates::Degree );
+    }
+    for ( int i = 0; i < 10; ++i ) {
+        ring << GeoDataCoordinates( 10.0 - i, 10.0, 0.0, GeoDataCoordinates::Degree );
+    }
+    for ( int i = 0; i < 10; ++i ) {
+        ring << GeoDataCoordinates( 0.0, 10.0 - i, 0.0, GeoDataCoordinates::Degree );
+    }
+
+    QCOMPARE( ring.significantNodes( 3 ), QVector<int>() << 0 << 10 << 20 << 30 << 39 );
+
+    // short or empty rings need all nodes
+    QCOMPARE( GeoDataLinearRing().significantNodes( 1 ), QVector<int>() );
+}
+
+void TestGeoDataGeometry::significantNodesDetail()
+{
+    // detail values from the data take precedence
+    GeoDataLineString line;
+    for ( int i = 0; i < 20; ++i ) {
+        GeoDataCoordinates coordinates( i, 0.0, 0.0, GeoDataCoordinates::Degree, i % 2 ? 9 : 2 );
+        line << coordinates;
+    }
+
+    const QVector<int> nodes = line.significantNodes( 5 );
+    QCOMPARE( nodes.size(), 11 );
+    QCOMPARE( nodes.first(), 0 );
+    QCOMPARE( nodes.last(), 19 );
+    QVERIFY( line.significantNodes( 9 ).isEmpty() );
+}
+
 QTEST_MAIN( TestGeoDataGeometry )
 #include "TestGeoDataGeometry.moc"
 
@@ -33,6 +33,7 @@ private Q_SLOTS:
     void initTestCase();
     void defaultConstructor();
     void interpolate();
+    void addPoint();
     void simpleParseTest();
     void removeBeforeTest();
     void removeAfterTest();
@@ -108,6 +109,40 @@ void TestGeoDataTrack::interpolate()
 "</Folder>"
 "</kml>" );
 
+void TestGeoDataTrack::addPoint()
+{
+    GeoDataTrack track;
+    track.setInterpolate( true );
+
+    const QDateTime start( QDate( 2014, 8, 16 ), QTime( 8, 0, 0 ), Qt::UTC );
+    for ( int i = 0; i < 1000; i += 2 ) {
+        track.addPoint( start.addSecs( i ), GeoDataCoordinates( i / 10.0, 0, 0, GeoDataCoordinates::Degree ) );
+    }
+    QCOMPARE( track.lineString()->size(), 500 );
+
+    // out of order points are inserted by time
+    track.addPoint( start.addSecs( 501 ), GeoDataCoordinates( 50.1, 0, 0, GeoDataCoordinates::Degree ) );
+    track.addPoint( start.addSecs( -1 ), GeoDataCoordinates( -0.1, 0, 0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( track.size(), 502 );
+    QCOMPARE( track.firstWhen(), start.addSecs( -1 ) );
+    QCOMPARE( track.lastWhen(), start.addSecs( 998 ) );
+    QCOMPARE( track.whenAt( 252 ), start.addSecs( 501 ) );
+    QCOMPARE( track.coordinatesAt( 252 ).longitude( GeoDataCoordinates::Degree ), 50.1 );
+
+    QCOMPARE( track.coordinatesAt( start.addSecs( 10 ) ).longitude( GeoDataCoordinates::Degree ), 1.0 );
+    QCOMPARE( track.coordinatesAt( start.addSecs( 998 ) ).longitude( GeoDataCoordinates::Degree ), 99.8 );
+    QVERIFY( qAbs( track.coordinatesAt( start.addMSecs( 3500 ) ).longitude( GeoDataCoordinates::Degree ) - 0.35 ) < 1e-9 );
+    QCOMPARE( track.coordinatesAt( start.addSecs( 999 ) ), GeoDataCoordinates() );
+
+    const GeoDataLineString *lineString = track.lineString();
+    QCOMPARE( lineString->size(), 502 );
+    QCOMPARE( lineString->at( 0 ).longitude( GeoDataCoordinates::Degree ), -0.1 );
+
+    track.addPoint( start.addSecs( 1000 ), GeoDataCoordinates( 10, 0, 0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( track.lineString()->size(), 503 );
+    QCOMPARE( track.lineString()->last().longitude( GeoDataCoordinates::Degree ), 10.0 );
+}
+
 void TestGeoDataTrack::simpleParseTest()
 {
     GeoDataDocument* dataDocument = parseKml( simpleExampleContent );
@@ -354,6 +389,9 @@ void TestGeoDataTrack::withoutTimeTest()
         QCOMPARE( coord.altitude(), 156.000000 );
     }
 
+    QVERIFY( !track->whenAt( 0 ).isValid() );
+    QVERIFY( !track->whenAt( 6 ).isValid() );
+
     delete dataDocument;
 }
 
@@ -0,0 +1,230 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "MarbleGlobal.h"
+#include "TileCreator.h"
+#include "TestUtils.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace Marble
+{
+
+// Two rows of four tiles, each filled with a color of its own.
+class ColorTileSource : public TileCreatorSource
+{
+public:
+    ColorTileSource() :
+        m_tileCount( 0 )
+    {
+    }
+
+    virtual QSize fullImageSize() const
+    {
+        return QSize( 4 * c_defaultTileSize, 2 * c_defaultTileSize );
+    }
+
+    virtual QImage tile( int n, int m, int tileLevel )
+    {
+        Q_UNUSED( tileLevel );
+        ++m_tileCount;
+        QImage tile( c_defaultTileSize, c_defaultTileSize, QImage::Format_RGB32 );
+        tile.fill( color( n, m ) );
+        return tile;
+    }
+
+    static QRgb color( int n, int m )
+    {
+        return qRgb( 100 * n, 50 * m, 0 );
+    }
+
+    int m_tileCount;
+};
+
+class TileCreatorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void createPyramid();
+    void resume();
+    void resumeLossy();
+    void netpbmSource_data();
+    void netpbmSource();
+
+private:
+    static void createTiles( TileCreatorSource *source, const QString &targetDir, bool resume );
+    static QByteArray netpbm( const QByteArray &header, int channels );
+    static QString tileName( const QString &targetDir, int level, int n, int m );
+};
+
+void TileCreatorTest::createTiles( TileCreatorSource *source, const QString &targetDir, bool resume )
+{
+    TileCreator creator( source, "false", targetDir );
+    creator.setTileFormat( "png" );
+    creator.setResume( resume );
+    creator.start();
+    QVERIFY( creator.wait( 60000 ) );
+}
+
+QString TileCreatorTest::tileName( const QString &targetDir, int level, int n, int m )
+{
+    return QString( "%1/%2/%3/%3_%4.png" ).arg( targetDir ).arg( level )
+            .arg( n, tileDigits, 10, QChar( '0' ) )
+            .arg( m, tileDigits, 10, QChar( '0' ) );
+}
+
+void TileCreatorTest::createPyramid()
+{
+    QTemporaryDir targetDir;
+    QVERIFY( targetDir.isValid() );
+
+    createTiles( new ColorTileSource, targetDir.path(), false );
+
+    for ( int n = 0; n < 2; ++n ) {
+        for ( int m = 0; m < 4; ++m ) {
+            QImage const tile( tileName( targetDir.path(), 1, n, m ) );
+            QCOMPARE( tile.size(), QSize( c_defaultTileSize, c_defaultTileSize ) );
+            QCOMPARE( tile.pixel( 10, 10 ), ColorTileSource::color( n, m ) );
+        }
+    }
+
+    // each tile of level 0 is made of four tiles of level 1
+    int const last = c_defaultTileSize - 1;
+    for ( int m = 0; m < 2; ++m ) {
+        QImage const tile( tileName( targetDir.path(), 0, 0, m ) );
+        QCOMPARE( tile.size(), QSize( c_defaultTileSize, c_defaultTileSize ) );
+        QCOMPARE( tile.pixel( 0, 0 ), ColorTileSource::color( 0, 2 * m ) );
+        QCOMPARE( tile.pixel( last, 0 ), ColorTileSource::color( 0, 2 * m + 1 ) );
+        QCOMPARE( tile.pixel( 0, last ), ColorTileSource::color( 1, 2 * m ) );
+        QCOMPARE( tile.pixel( last, last ), ColorTileSource::color( 1, 2 * m + 1 ) );
+    }
+
+    QCOMPARE( QDir( targetDir.path() + "/1/000000" ).entryList( QDir::Files ).size(), 4 );
+    QCOMPARE( QDir( targetDir.path() + "/1/000001" ).entryList( QDir::Files ).size(), 4 );
+    QCOMPARE( QDir( targetDir.path() + "/0/000000" ).entryList( QDir::Files ).size(), 2 );
+}
+
+void TileCreatorTest::resume()
+{
+    QTemporaryDir targetDir;
+    QVERIFY( targetDir.isValid() );
+
+    createTiles( new ColorTileSource, targetDir.path(), false );
+    QVERIFY( QFile::remove( tileName( targetDir.path(), 1, 1, 3 ) ) );
+    QVERIFY( QFile::remove( tileName( targetDir.path(), 0, 0, 1 ) ) );
+
+    // only the missing tile of the highest level is taken from the source
+    ColorTileSource *source = new ColorTileSource;
+    TileCreator creator( source, "false", targetDir.path() );
+    creator.setTileFormat( "png" );
+    creator.setResume( true );
+    creator.start();
+    QVERIFY( creator.wait( 60000 ) );
+    QCOMPARE( source->m_tileCount, 1 );
+
+    QImage const tile( tileName( targetDir.path(), 0, 0, 1 ) );
+    QCOMPARE( tile.pixel( c_defaultTileSize - 1, c_defaultTileSize - 1 ), ColorTileSource::color( 1, 3 ) );
+}
+
+void TileCreatorTest::resumeLossy()
+{
+    QTemporaryDir targetDir;
+    QVERIFY( targetDir.isValid() );
+
+    TileCreator first( new ColorTileSource, "false", targetDir.path() );
+    first.start();
+    QVERIFY( first.wait( 60000 ) );
+    QVERIFY( QFile::remove( targetDir.path() + "/0/000000/000000_000001.jpg" ) );
+
+    // jpeg tiles are not read back, the lower levels are built from the source
+    ColorTileSource *source = new ColorTileSource;
+    TileCreator creator( source, "false", targetDir.path() );
+    creator.setResume( true );
+    creator.start();
+    QVERIFY( creator.wait( 60000 ) );
+    QCOMPARE( source->m_tileCount, 8 );
+    QVERIFY( QFile::exists( targetDir.path() + "/0/000000/000000_000001.jpg" ) );
+}
+
+QByteArray TileCreatorTest::netpbm( const QByteArray &header, int channels )
+{
+    // Four by two tiles of level 1 in the colors of ColorTileSource
+    int const width = 4 * c_defaultTileSize;
+    int const height = 2 * c_defaultTileSize;
+    QByteArray data = header;
+    data.reserve( header.size() + width * height * channels );
+    for ( int y = 0; y < height; ++y ) {
+        for ( int x = 0; x < width; ++x ) {
+            QRgb const color = ColorTileSource::color( y / c_defaultTileSize, x / c_defaultTileSize );
+            if ( channels == 3 ) {
+                data += char( qRed( color ) );
+                data += char( qGreen( color ) );
+                data += char( qBlue( color ) );
+            } else {
+                data += char( qGray( color ) );
+            }
+        }
+    }
+    return data;
+}
+
+void TileCreatorTest::netpbmSource_data()
+{
+    QTest::addColumn<QByteArray>( "header" );
+    QTest::addColumn<int>( "channels" );
+
+    QByteArray const size = QByteArray::number( 4 * c_defaultTileSize ) + ' ' + QByteArray::number( 2 * c_defaultTileSize );
+    QTest::newRow( "ppm" ) << "P6\n" + size + "\n255\n" << 3;
+    QTest::newRow( "ppm with comments" ) << "P6 # created by a test\n" + size + "\n# maximum value\n255\t" << 3;
+    QTest::newRow( "pgm" ) << "P5\n" + size + "\n255\n" << 1;
+}
+
+void TileCreatorTest::netpbmSource()
+{
+    QFETCH( QByteArray, header );
+    QFETCH( int, channels );
+
+    QTemporaryDir sourceDir;
+    QVERIFY( sourceDir.isValid() );
+    QTemporaryDir targetDir;
+    QVERIFY( targetDir.isValid() );
+
+    QFile file( sourceDir.path() + "/source.ppm" );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QByteArray const data = netpbm( header, channels );
+    QCOMPARE( file.write( data ), qint64( data.size() ) );
+    file.close();
+
+    TileCreator creator( sourceDir.path(), "source.ppm", "false", targetDir.path() );
+    creator.setTileFormat( "png" );
+    creator.start();
+    QVERIFY( creator.wait( 60000 ) );
+
+    for ( int n = 0; n < 2; ++n ) {
+        for ( int m = 0; m < 4; ++m ) {
+            QRgb const color = ColorTileSource::color( n, m );
+            QRgb const expected = channels == 3 ? color : qRgb( qGray( color ), qGray( color ), qGray( color ) );
+            QImage const tile( tileName( targetDir.path(), 1, n, m ) );
+            QCOMPARE( tile.size(), QSize( c_defaultTileSize, c_defaultTileSize ) );
+            QCOMPARE( tile.pixel( 0, 0 ), expected );
+            QCOMPARE( tile.pixel( c_defaultTileSize - 1, c_defaultTileSize - 1 ), expected );
+        }
+    }
+    QVERIFY( QFile::exists( tileName( targetDir.path(), 0, 0, 1 ) ) );
+}
+
+}
+
+QTEST_MAIN( Marble::TileCreatorTest )
+
+#include "TileCreatorTest.moc"
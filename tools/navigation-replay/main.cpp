@@ -0,0 +1,97 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "MarbleMap.h"
+#include "NavigationReplayer.h"
+#include "NavigationTrace.h"
+
+#include <QApplication>
+#include <QStringList>
+
+#include <cstdio>
+
+using namespace Marble;
+
+/* example usage
+marble-qt --record-navigation=/tmp/slow-zoom.trace
+navigation-replay --repeat 5 /tmp/slow-zoom.trace
+*/
+
+void printUsage()
+{
+    fprintf( stderr, "Usage: navigation-replay [OPTIONS] TRACE\n"
+                     "Paints all frames of a navigation trace recorded with marble-qt --record-navigation\n"
+                     "as fast as possible and reports the paint times.\n"
+                     "      --help            display this help and exit\n"
+                     "      --repeat N        replay the trace N times, only the last run is reported\n"
+                     "      --wait-for-data   load all tiles of a frame before painting the next one\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+    // no windows are shown
+    if ( qgetenv( "QT_QPA_PLATFORM" ).isEmpty() ) {
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+    }
+
+    QApplication app( argc, argv );
+
+    QStringList const arguments = app.arguments();
+    int repeat = 1;
+    bool waitForData = false;
+    QString fileName;
+    for ( int i = 1; i < arguments.size(); ++i ) {
+        QString const argument = arguments.at( i );
+        if ( argument == "--help" ) {
+            printUsage();
+            return 0;
+        } else if ( argument == "--repeat" && i + 1 < arguments.size() ) {
+            repeat = qMax( 1, arguments.at( ++i ).toInt() );
+        } else if ( argument == "--wait-for-data" ) {
+            waitForData = true;
+        } else {
+            fileName = argument;
+        }
+    }
+
+    if ( fileName.isEmpty() ) {
+        printUsage();
+        return 1;
+    }
+
+    NavigationTrace trace;
+    if ( !trace.load( fileName ) ) {
+        fprintf( stderr, "Cannot load %s\n", qPrintable( fileName ) );
+        return 1;
+    }
+
+    MarbleMap map;
+    map.setViewContext( Still );
+    NavigationReplayer replayer( &map );
+    for ( int i = 0; i < repeat; ++i ) {
+        replayer.replay( trace, waitForData );
+    }
+
+    qreal total = 0.0;
+    foreach ( qreal time, replayer.frameTimes() ) {
+        total += time;
+    }
+
+    printf( "frames:            %d (recorded in %.1f s, replayed in %.1f s)\n",
+            replayer.frameTimes().size(), trace.duration() / 1000.0, total / 1000.0 );
+    printf( "paint time p50:    %.2f ms\n", replayer.percentile( 50 ) );
+    printf( "paint time p90:    %.2f ms\n", replayer.percentile( 90 ) );
+    printf( "paint time p99:    %.2f ms\n", replayer.percentile( 99 ) );
+    printf( "paint time max:    %.2f ms\n", replayer.percentile( 100 ) );
+    printf( "incomplete frames: %d\n", replayer.incompleteFrames() );
+    printf( "tile misses:       %d\n", replayer.tileMisses() );
+
+    return 0;
+}
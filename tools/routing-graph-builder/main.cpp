@@ -0,0 +1,115 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "RoutingGraph.h"
+#include "RoutingGraphBuilder.h"
+
+#include "GeoDataDocument.h"
+#include "MarbleDirs.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <cstdio>
+
+using namespace Marble;
+
+/* example usage
+routing-graph-builder baden-wuerttemberg.osm.zip
+routing-graph-builder --transport bicycle --method fastest baden-wuerttemberg.o5m
+*/
+
+void printUsage()
+{
+    fprintf( stderr, "Usage: routing-graph-builder [OPTIONS] EXTRACT\n"
+                     "Preprocesses an OpenStreetMap extract (.osm, .osm.zip or .o5m) into the routing graphs\n"
+                     "of the Offline Routing plugin.\n"
+                     "      --help              display this help and exit\n"
+                     "      --transport NAME    only build the graphs of motorcar, bicycle or foot\n"
+                     "      --method NAME       only build the graphs of the fastest or shortest routes\n"
+                     "      --output DIRECTORY  write the graphs to DIRECTORY instead of the local\n"
+                     "                          maps/earth/offline-routing/ directory\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+    QApplication app( argc, argv );
+
+    QStringList const arguments = app.arguments();
+    QStringList transports = QStringList() << "motorcar" << "bicycle" << "foot";
+    QStringList methods = QStringList() << "fastest" << "shortest";
+    QString directory = MarbleDirs::localPath() + "/maps/earth/offline-routing/";
+    QString fileName;
+    for ( int i = 1; i < arguments.size(); ++i ) {
+        QString const argument = arguments.at( i );
+        if ( argument == "--help" ) {
+            printUsage();
+            return 0;
+        } else if ( argument == "--transport" && i + 1 < arguments.size() ) {
+            transports = QStringList() << arguments.at( ++i );
+        } else if ( argument == "--method" && i + 1 < arguments.size() ) {
+            methods = QStringList() << arguments.at( ++i );
+        } else if ( argument == "--output" && i + 1 < arguments.size() ) {
+            directory = arguments.at( ++i ) + '/';
+        } else {
+            fileName = argument;
+        }
+    }
+
+    if ( fileName.isEmpty() ) {
+        printUsage();
+        return 1;
+    }
+
+    if ( !QDir().mkpath( directory ) ) {
+        fprintf( stderr, "Cannot create %s\n", qPrintable( directory ) );
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // the OSM parse runner plugin does the parsing, big extracts take a while
+    PluginManager pluginManager;
+    ParsingRunnerManager parser( &pluginManager );
+    GeoDataDocument *document = parser.openFile( fileName, UserDocument, 24 * 60 * 60 * 1000 );
+    if ( !document ) {
+        fprintf( stderr, "Cannot parse %s\n", qPrintable( fileName ) );
+        return 1;
+    }
+    printf( "Parsed %s in %.1f s\n", qPrintable( fileName ), timer.elapsed() / 1000.0 );
+
+    int result = 0;
+    foreach ( const QString &transport, transports ) {
+        foreach ( const QString &method, methods ) {
+            timer.restart();
+            RoutingGraphBuilder builder( transport, method );
+            builder.addDocument( document );
+            builder.contract();
+
+            QString const graphFile = directory + RoutingGraph::fileName( transport, method );
+            if ( !builder.save( graphFile ) ) {
+                fprintf( stderr, "Cannot write %s\n", qPrintable( graphFile ) );
+                result = 1;
+                continue;
+            }
+
+            printf( "Built %s with %d nodes and %d edges in %.1f s\n", qPrintable( graphFile ),
+                    builder.nodeCount(), builder.edgeCount(), timer.elapsed() / 1000.0 );
+        }
+    }
+
+    delete document;
+    return result;
+}
@@ -0,0 +1,325 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "TileRenderer.h"
+
+#include "AbstractFloatItem.h"
+#include "FileManager.h"
+#include "GeoPainter.h"
+#include "MarbleMap.h"
+#include "MarbleModel.h"
+#include "MarbleDebug.h"
+#include "RenderPlugin.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QSemaphore>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <cmath>
+
+namespace Marble
+{
+
+namespace
+{
+    // how long an idle worker blocks before it handles its own events
+    int const idleInterval = 100;
+}
+
+class RenderWorker;
+
+struct RenderJob
+{
+    int id;
+    TileRenderer::Request request;
+};
+
+class TileRendererPrivate
+{
+public:
+    TileRendererPrivate( TileRenderer *parent, const QString &mapThemeId, const QStringList &plugins );
+
+    bool takeJob( RenderJob *job );
+    bool isStopping() const;
+    int timeout() const;
+
+    void finishJob( int id, const QByteArray &data );
+
+    TileRenderer *const q;
+    QString const m_mapThemeId;
+    QStringList const m_plugins;
+    QList<RenderWorker*> m_workers;
+
+    // serializes the startup of the workers, see RenderWorker::run()
+    QSemaphore m_initialized;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobAvailable;
+    QQueue<RenderJob> m_jobs;
+    int m_nextId;
+    int m_pendingCount;
+    int m_timeout;
+    bool m_stopping;
+};
+
+class RenderWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit RenderWorker( TileRendererPrivate *renderer );
+
+Q_SIGNALS:
+    void jobFinished( int id, const QByteArray &data );
+
+protected:
+    void run();
+
+private:
+    static void waitForEvents( int msecs );
+    QByteArray render( MarbleMap &map, const TileRenderer::Request &request ) const;
+
+    TileRendererPrivate *const m_renderer;
+};
+
+TileRenderer::Request::Request() :
+    projection( Mercator ),
+    lon( 0.0 ),
+    lat( 0.0 ),
+    radius( 64 ),
+    size( 256, 256 ),
+    format( "png" )
+{
+    // nothing to do
+}
+
+TileRendererPrivate::TileRendererPrivate( TileRenderer *parent, const QString &mapThemeId, const QStringList &plugins ) :
+    q( parent ),
+    m_mapThemeId( mapThemeId ),
+    m_plugins( plugins ),
+    m_nextId( 0 ),
+    m_pendingCount( 0 ),
+    m_timeout( 10000 ),
+    m_stopping( false )
+{
+    // nothing to do
+}
+
+bool TileRendererPrivate::takeJob( RenderJob *job )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_jobs.isEmpty() && !m_stopping ) {
+        m_jobAvailable.wait( &m_mutex, idleInterval );
+    }
+
+    if ( m_jobs.isEmpty() || m_stopping ) {
+        return false;
+    }
+
+    *job = m_jobs.dequeue();
+    return true;
+}
+
+bool TileRendererPrivate::isStopping() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_stopping;
+}
+
+int TileRendererPrivate::timeout() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_timeout;
+}
+
+void TileRendererPrivate::finishJob( int id, const QByteArray &data )
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        --m_pendingCount;
+    }
+
+    emit q->rendered( id, data );
+}
+
+RenderWorker::RenderWorker( TileRendererPrivate *renderer ) :
+    QThread(),
+    m_renderer( renderer )
+{
+    // nothing to do
+}
+
+void RenderWorker::run()
+{
+    {
+        // Everything created here lives in this thread. Construction is
+        // serialized because the plugin manager and other function-local
+        // statics of the library are not safe to initialize concurrently.
+        MarbleModel model;
+        MarbleMap map( &model );
+        map.setMapThemeId( m_renderer->m_mapThemeId );
+        map.setViewContext( Still );
+        map.setMapQualityForViewContext( HighQuality, Still );
+        foreach ( RenderPlugin *plugin, map.renderPlugins() ) {
+            plugin->setEnabled( m_renderer->m_plugins.contains( plugin->nameId() ) );
+        }
+        foreach ( AbstractFloatItem *floatItem, map.floatItems() ) {
+            floatItem->setVisible( false );
+        }
+        m_renderer->m_initialized.release();
+
+        if ( map.mapThemeId() != m_renderer->m_mapThemeId ) {
+            mDebug() << "Cannot load map theme" << m_renderer->m_mapThemeId;
+        }
+
+        // the vector data of the theme is parsed in the background
+        QElapsedTimer timer;
+        timer.start();
+        while ( model.fileManager()->pendingFiles() > 0 && timer.elapsed() < m_renderer->timeout() ) {
+            waitForEvents( idleInterval );
+        }
+
+        RenderJob job;
+        while ( !m_renderer->isStopping() ) {
+            if ( m_renderer->takeJob( &job ) ) {
+                emit jobFinished( job.id, render( map, job.request ) );
+            } else {
+                // keeps finished downloads flowing into the tile cache
+                QCoreApplication::processEvents();
+            }
+        }
+    }
+
+    QCoreApplication::sendPostedEvents( 0, QEvent::DeferredDelete );
+}
+
+void RenderWorker::waitForEvents( int msecs )
+{
+    QCoreApplication::processEvents( QEventLoop::AllEvents, msecs );
+    QThread::msleep( 10 );
+}
+
+QByteArray RenderWorker::render( MarbleMap &map, const TileRenderer::Request &request ) const
+{
+    map.setSize( request.size );
+    map.setProjection( request.projection );
+    map.setRadius( request.radius );
+    map.centerOn( request.lon, request.lat );
+
+    QImage image( request.size, QImage::Format_ARGB32_Premultiplied );
+
+    // Tiles that are neither in memory nor on disk are downloaded
+    // asynchronously, repaint until they have all arrived.
+    QElapsedTimer timer;
+    timer.start();
+    forever {
+        image.fill( Qt::transparent );
+        {
+            GeoPainter painter( &image, map.viewport(), map.mapQuality() );
+            map.paint( painter, QRect() );
+        }
+
+        if ( map.renderStatus() == Complete || timer.elapsed() >= m_renderer->timeout() ) {
+            break;
+        }
+
+        waitForEvents( 50 );
+    }
+
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    if ( !image.save( &buffer, request.format.constData() ) ) {
+        mDebug() << "Cannot encode image as" << request.format;
+        data.clear();
+    }
+
+    return data;
+}
+
+TileRenderer::TileRenderer( const QString &mapThemeId, int threadCount, const QStringList &plugins, QObject *parent ) :
+    QObject( parent ),
+    d( new TileRendererPrivate( this, mapThemeId, plugins ) )
+{
+    for ( int i = 0; i < qMax( 1, threadCount ); ++i ) {
+        RenderWorker *worker = new RenderWorker( d );
+        connect( worker, SIGNAL(jobFinished(int,QByteArray)),
+                 this, SLOT(finishJob(int,QByteArray)), Qt::QueuedConnection );
+        d->m_workers << worker;
+        worker->start();
+        d->m_initialized.acquire();
+    }
+}
+
+TileRenderer::~TileRenderer()
+{
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_stopping = true;
+        d->m_jobAvailable.wakeAll();
+    }
+
+    foreach ( RenderWorker *worker, d->m_workers ) {
+        worker->wait();
+        delete worker;
+    }
+
+    delete d;
+}
+
+TileRenderer::Request TileRenderer::xyzTile( int zoom, int x, int y, int tileSize )
+{
+    // The Mercator map is 4 * radius wide, an XYZ level has 2^zoom tiles.
+    qreal const tileCount = qreal( 1 << zoom );
+
+    Request request;
+    request.projection = Mercator;
+    request.size = QSize( tileSize, tileSize );
+    request.radius = qRound( tileCount * tileSize / 4.0 );
+    request.lon = ( x + 0.5 ) / tileCount * 360.0 - 180.0;
+    request.lat = atan( sinh( M_PI * ( 1.0 - 2.0 * ( y + 0.5 ) / tileCount ) ) ) * RAD2DEG;
+    return request;
+}
+
+void TileRenderer::setTimeout( int msecs )
+{
+    QMutexLocker locker( &d->m_mutex );
+    d->m_timeout = msecs;
+}
+
+int TileRenderer::render( const Request &request )
+{
+    QMutexLocker locker( &d->m_mutex );
+    RenderJob job;
+    job.id = d->m_nextId++;
+    job.request = request;
+    d->m_jobs.enqueue( job );
+    ++d->m_pendingCount;
+    d->m_jobAvailable.wakeOne();
+    return job.id;
+}
+
+int TileRenderer::pendingCount() const
+{
+    QMutexLocker locker( &d->m_mutex );
+    return d->m_pendingCount;
+}
+
+}
+
+#include "moc_TileRenderer.cpp"
+#include "TileRenderer.moc"
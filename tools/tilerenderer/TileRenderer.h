@@ -0,0 +1,99 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_TILERENDERER_H
+#define MARBLE_TILERENDERER_H
+
+#include "MarbleGlobal.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QSize>
+#include <QStringList>
+
+namespace Marble
+{
+
+class TileRendererPrivate;
+
+/**
+ * Renders map images with a pool of worker threads.
+ *
+ * MarbleModel, its layers and the tile loaders are QObjects bound to the
+ * thread that created them, so each worker owns a MarbleModel and a MarbleMap
+ * of its own. An additional worker therefore costs a complete model: its own
+ * parsed copy of the theme's vector data and placemarks, a download manager
+ * and an in-memory tile cache. Only the tile cache on disk is shared, the
+ * storage policies of all workers serialize their writes to it.
+ */
+class TileRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Request
+    {
+        Request();
+
+        Projection projection;
+        qreal lon;
+        qreal lat;
+        int radius;
+        QSize size;
+        QByteArray format;
+    };
+
+    /**
+     * Creates @p threadCount workers showing @p mapThemeId. Only the render
+     * plugins in @p plugins are enabled, all float items are hidden.
+     */
+    TileRenderer( const QString &mapThemeId, int threadCount,
+                  const QStringList &plugins = QStringList(), QObject *parent = 0 );
+    ~TileRenderer();
+
+    /**
+     * Returns the request for the XYZ (slippy map) tile @p x, @p y at
+     * @p zoom, rendered @p tileSize pixels wide and high.
+     */
+    static Request xyzTile( int zoom, int x, int y, int tileSize = 256 );
+
+    /**
+     * Maximum time spent waiting for tiles and data of a single image in ms.
+     * Images are delivered incomplete once it passes. Defaults to 10 s.
+     */
+    void setTimeout( int msecs );
+
+    /**
+     * Queues @p request and returns its id. Thread safe.
+     */
+    int render( const Request &request );
+
+    /**
+     * Returns the number of queued and running requests.
+     */
+    int pendingCount() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted in the thread of the renderer once request @p id is done.
+     * @p data holds the encoded image, it is empty if encoding failed.
+     */
+    void rendered( int id, const QByteArray &data );
+
+private:
+    Q_PRIVATE_SLOT( d, void finishJob( int, const QByteArray & ) )
+
+    TileRendererPrivate * const d;
+    friend class TileRendererPrivate;
+};
+
+}
+
+#endif
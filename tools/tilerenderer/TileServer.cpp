@@ -0,0 +1,102 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "TileServer.h"
+
+#include "TileRenderer.h"
+
+#include <QHostAddress>
+#include <QRegExp>
+#include <QTcpSocket>
+
+namespace Marble
+{
+
+TileServer::TileServer( TileRenderer *renderer, int tileSize, QObject *parent ) :
+    QObject( parent ),
+    m_renderer( renderer ),
+    m_tileSize( tileSize )
+{
+    connect( &m_server, SIGNAL(newConnection()), this, SLOT(acceptConnection()) );
+    connect( m_renderer, SIGNAL(rendered(int,QByteArray)), this, SLOT(sendTile(int,QByteArray)) );
+}
+
+bool TileServer::listen( quint16 port )
+{
+    return m_server.listen( QHostAddress::Any, port );
+}
+
+void TileServer::acceptConnection()
+{
+    while ( m_server.hasPendingConnections() ) {
+        QTcpSocket *socket = m_server.nextPendingConnection();
+        connect( socket, SIGNAL(readyRead()), this, SLOT(readRequest()) );
+        connect( socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()) );
+    }
+}
+
+void TileServer::readRequest()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>( sender() );
+    if ( !socket || !socket->canReadLine() ) {
+        return;
+    }
+
+    // only the request line matters, headers are ignored
+    disconnect( socket, SIGNAL(readyRead()), this, SLOT(readRequest()) );
+    QString const requestLine = QString::fromLatin1( socket->readLine() ).trimmed();
+    QRegExp const tilePath( "^GET /(\\d+)/(\\d+)/(\\d+)\\.png(\\?\\S*)? HTTP/1\\.[01]$" );
+    if ( !tilePath.exactMatch( requestLine ) ) {
+        reply( socket, "404 Not Found", "text/plain", "Not Found\n" );
+        return;
+    }
+
+    int const zoom = tilePath.cap( 1 ).toInt();
+    int const x = tilePath.cap( 2 ).toInt();
+    int const y = tilePath.cap( 3 ).toInt();
+    if ( zoom > 20 || x >= ( 1 << zoom ) || y >= ( 1 << zoom ) ) {
+        reply( socket, "404 Not Found", "text/plain", "Not Found\n" );
+        return;
+    }
+
+    int const id = m_renderer->render( TileRenderer::xyzTile( zoom, x, y, m_tileSize ) );
+    m_pendingReplies.insert( id, socket );
+}
+
+void TileServer::sendTile( int id, const QByteArray &data )
+{
+    QPointer<QTcpSocket> const socket = m_pendingReplies.take( id );
+    if ( !socket ) {
+        // client went away, or the tile was requested by someone else
+        return;
+    }
+
+    if ( data.isEmpty() ) {
+        reply( socket, "500 Internal Server Error", "text/plain", "Rendering failed\n" );
+    } else {
+        reply( socket, "200 OK", "image/png", data );
+    }
+}
+
+void TileServer::reply( QTcpSocket *socket, const QByteArray &status,
+                        const QByteArray &contentType, const QByteArray &body )
+{
+    QByteArray header = "HTTP/1.0 " + status + "\r\n";
+    header += "Content-Type: " + contentType + "\r\n";
+    header += "Content-Length: " + QByteArray::number( body.size() ) + "\r\n";
+    header += "Connection: close\r\n\r\n";
+    socket->write( header );
+    socket->write( body );
+    socket->disconnectFromHost();
+}
+
+}
+
+#include "moc_TileServer.cpp"
@@ -0,0 +1,56 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#ifndef MARBLE_TILESERVER_H
+#define MARBLE_TILESERVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+namespace Marble
+{
+
+class TileRenderer;
+
+/**
+ * A minimal HTTP front end answering GET /zoom/x/y.png with XYZ tiles
+ * rendered by a TileRenderer. Each connection serves a single request.
+ */
+class TileServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TileServer( TileRenderer *renderer, int tileSize, QObject *parent = 0 );
+
+    bool listen( quint16 port );
+
+private Q_SLOTS:
+    void acceptConnection();
+    void readRequest();
+    void sendTile( int id, const QByteArray &data );
+
+private:
+    static void reply( QTcpSocket *socket, const QByteArray &status,
+                       const QByteArray &contentType, const QByteArray &body );
+
+    TileRenderer *const m_renderer;
+    int const m_tileSize;
+    QTcpServer m_server;
+    QHash<int, QPointer<QTcpSocket> > m_pendingReplies;
+};
+
+}
+
+#endif
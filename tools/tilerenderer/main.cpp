@@ -0,0 +1,158 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2026      agent <agent@local>
+//
+
+#include "TileRenderer.h"
+#include "TileServer.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QPoint>
+#include <QRegExp>
+#include <QThread>
+
+using namespace Marble;
+
+/* example usage
+tilerenderer --theme earth/openstreetmap/openstreetmap.dgml --tiles 4 --output /tmp/tiles
+tilerenderer --theme earth/bluemarble/bluemarble.dgml --threads 8 --serve 8080
+*/
+
+class TileWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    TileWriter( const QString &outputDirectory, int total ) :
+        m_outputDirectory( outputDirectory ),
+        m_total( total ),
+        m_written( 0 )
+    {
+        m_timer.start();
+    }
+
+    void addTile( int id, int zoom, int x, int y )
+    {
+        m_paths.insert( id, QString( "%1/%2/%3/%4.png" ).arg( m_outputDirectory ).arg( zoom ).arg( x ).arg( y ) );
+    }
+
+public Q_SLOTS:
+    void writeTile( int id, const QByteArray &data )
+    {
+        QString const path = m_paths.take( id );
+        QDir().mkpath( path.section( '/', 0, -2 ) );
+        QFile file( path );
+        if ( data.isEmpty() || !file.open( QIODevice::WriteOnly ) || file.write( data ) != data.size() ) {
+            qWarning() << "Cannot write" << path;
+        }
+
+        ++m_written;
+        if ( m_written % 100 == 0 || m_written == m_total ) {
+            qDebug() << m_written << "of" << m_total << "tiles rendered,"
+                     << qRound( m_written * 60000.0 / qMax<qint64>( 1, m_timer.elapsed() ) ) << "per minute";
+        }
+        if ( m_paths.isEmpty() ) {
+            QCoreApplication::quit();
+        }
+    }
+
+private:
+    QString const m_outputDirectory;
+    int const m_total;
+    int m_written;
+    QHash<int, QString> m_paths;
+    QElapsedTimer m_timer;
+};
+
+int main( int argc, char *argv[] )
+{
+    // rendering does not need a display, and unlike most others the offscreen
+    // platform supports the pixmaps some layers paint in the worker threads
+    if ( qgetenv( "QT_QPA_PLATFORM" ).isEmpty() ) {
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+    }
+
+    QApplication app( argc, argv );
+    app.setApplicationName( "tilerenderer" );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Renders map tiles with a pool of threads." );
+    parser.addHelpOption();
+    parser.addOptions( {
+        { "theme", "Map theme id, e.g. earth/openstreetmap/openstreetmap.dgml.", "id", "earth/openstreetmap/openstreetmap.dgml" },
+        { "threads", "Number of render threads, one per core by default.", "count", QString::number( QThread::idealThreadCount() ) },
+        { "tile-size", "Edge length of the tiles in pixels.", "pixels", "256" },
+        { "plugins", "Comma separated name ids of render plugins to enable.", "ids" },
+        { "timeout", "Maximum time to wait for the data of a tile in ms.", "msecs", "10000" },
+        { "tiles", "Render the XYZ tiles of a zoom level, optionally limited to a range.", "zoom[:x0-x1:y0-y1]" },
+        { "output", "Directory to write tiles to as zoom/x/y.png.", "directory", "." },
+        { "serve", "Serve tiles via HTTP as /zoom/x/y.png on the given port.", "port" }
+    } );
+    parser.process( app );
+
+    QStringList plugins;
+    if ( parser.isSet( "plugins" ) ) {
+        plugins = parser.value( "plugins" ).split( ',', QString::SkipEmptyParts );
+    }
+
+    int const tileSize = qMax( 1, parser.value( "tile-size" ).toInt() );
+    TileRenderer renderer( parser.value( "theme" ), parser.value( "threads" ).toInt(), plugins );
+    renderer.setTimeout( parser.value( "timeout" ).toInt() );
+
+    if ( parser.isSet( "serve" ) ) {
+        TileServer server( &renderer, tileSize );
+        if ( !server.listen( parser.value( "serve" ).toUShort() ) ) {
+            qWarning() << "Cannot listen on port" << parser.value( "serve" );
+            return 1;
+        }
+        return app.exec();
+    }
+
+    if ( !parser.isSet( "tiles" ) ) {
+        parser.showHelp( 1 );
+    }
+
+    QRegExp const range( "(\\d+)(:(\\d+)-(\\d+):(\\d+)-(\\d+))?" );
+    if ( !range.exactMatch( parser.value( "tiles" ) ) || range.cap( 1 ).toInt() > 20 ) {
+        qWarning() << "Invalid tile range" << parser.value( "tiles" );
+        return 1;
+    }
+
+    int const zoom = range.cap( 1 ).toInt();
+    int const maxIndex = ( 1 << zoom ) - 1;
+    QPoint topLeft( 0, 0 );
+    QPoint bottomRight( maxIndex, maxIndex );
+    if ( !range.cap( 2 ).isEmpty() ) {
+        topLeft = QPoint( range.cap( 3 ).toInt(), range.cap( 5 ).toInt() );
+        bottomRight = QPoint( qMin( maxIndex, range.cap( 4 ).toInt() ), qMin( maxIndex, range.cap( 6 ).toInt() ) );
+    }
+
+    int const total = ( bottomRight.x() - topLeft.x() + 1 ) * ( bottomRight.y() - topLeft.y() + 1 );
+    if ( total <= 0 ) {
+        qWarning() << "Empty tile range" << parser.value( "tiles" );
+        return 1;
+    }
+
+    TileWriter writer( parser.value( "output" ), total );
+    QObject::connect( &renderer, SIGNAL(rendered(int,QByteArray)), &writer, SLOT(writeTile(int,QByteArray)) );
+    for ( int x = topLeft.x(); x <= bottomRight.x(); ++x ) {
+        for ( int y = topLeft.y(); y <= bottomRight.y(); ++y ) {
+            writer.addTile( renderer.render( TileRenderer::xyzTile( zoom, x, y, tileSize ) ), zoom, x, y );
+        }
+    }
+
+    return app.exec();
+}
+
+#include "main.moc"